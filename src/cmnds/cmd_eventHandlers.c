@@ -185,6 +185,17 @@ static int EVENT_ParseEventName(const char *s) {
 	// WiFi state has single argument: HALWifiStatus_t
 	if (!stricmp(s, "WiFiState"))
 		return CMD_EVENT_WIFI_STATE;
+	// SSDP devices appearing, expiring and changing IP, location or boot ID
+	if (!stricmp(s, "SSDPNew"))
+		return CMD_EVENT_SSDP_NEW;
+	if (!stricmp(s, "SSDPLost"))
+		return CMD_EVENT_SSDP_LOST;
+	if (!stricmp(s, "SSDPChange"))
+		return CMD_EVENT_SSDP_CHANGE;
+	if (!stricmp(s, "PingAlarm"))
+		return CMD_EVENT_PING_ALARM;
+	if (!stricmp(s, "PingRecovered"))
+		return CMD_EVENT_PING_RECOVERED;
 	return CMD_EVENT_NONE;
 }
 static bool EVENT_EvaluateCondition(int code, int argument, int next) {
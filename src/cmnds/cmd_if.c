@@ -239,6 +239,8 @@ const char *CMD_ExpandConstant(const char *s, const char *stop, float *out) {
 }
 #if WINDOWS
 
+// hal_pins_win32.c
+void SIM_GeneratePinStatesDesc(char *o, int outLen);
 void SIM_GenerateChannelStatesDesc(char *o, int outLen) {
 	int role;
 	const  char *roleStr;
@@ -5,6 +5,7 @@
 #include <ctype.h>
 #include "cmd_local.h"
 #include "../driver/drv_ir.h"
+#include "../new_ping.h"
 
 #ifdef BK_LITTLEFS
 	#include "../littlefs/our_lfs.h"
@@ -133,6 +134,7 @@ static commandResult_t CMD_ClearAll(const void *context, const char *cmd, const
 	CHANNEL_ClearAllChannels();
 	CMD_ClearAllHandlers(0, 0, 0, 0);
 	RepeatingEvents_Cmd_ClearRepeatingEvents(0, 0, 0, 0); 
+	Ping_ClearTargets();
 #if defined(WINDOWS) || defined(PLATFORM_BL602) || defined(PLATFORM_BEKEN)
 	CMD_resetSVM(0, 0, 0, 0);
 #endif
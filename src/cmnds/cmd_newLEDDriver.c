@@ -94,6 +94,8 @@ void LED_ResetGlobalVariablesToDefaults() {
 	led_temperature_min = HASS_TEMPERATURE_MIN;
 	led_temperature_max = HASS_TEMPERATURE_MAX;
 	led_temperature_current = HASS_TEMPERATURE_MIN;
+	LED_UpdateFixedPoint();
+	LED_Effect_Stop();
 }
 
 bool LED_IsLedDriverChipRunning()
@@ -166,7 +168,6 @@ static void sendFullRGBCW_IfEnabled() {
 	MQTT_PublishMain_StringString_DeDuped(DEDUP_LED_FINALCOLOR_RGBCW,DEDUP_EXPIRE_TIME,"led_finalcolor_rgbcw",s, 0);
 }
 
-float led_rawLerpCurrent[5] = { 0 };
 float Mathf_MoveTowards(float cur, float tg, float dt) {
 	float rem = tg - cur;
 	if(abs(rem) < dt) {
@@ -177,14 +178,53 @@ float Mathf_MoveTowards(float cur, float tg, float dt) {
 	}
 	return cur + dt;
 }
+// Same as Mathf_MoveTowards, but in Q16, including the integer abs() there
+int LED_MoveTowardsQ16(int cur, int tg, int step) {
+	int rem = tg - cur;
+	if(((abs(rem) >> LED_Q16_SHIFT) << LED_Q16_SHIFT) < step) {
+		return tg;
+	}
+	if(rem < 0) {
+		return cur - step;
+	}
+	return cur + step;
+}
 // Colors are in 0-255 range.
 // This value determines how fast color can change.
 // 100 means that in one second color will go from 0 to 100
 // 200 means that in one second color will go from 0 to 200
 float led_lerpSpeedUnitsPerSecond = 200.f;
 
-float led_current_value_brightness = 0;
-float led_current_value_cold_or_warm = 0;
+// Everything done per frame (smooth transitions) is in Q16 fixed point,
+// BK7231 and others have no FPU. Float settings are converted to these
+// only when they change, in LED_UpdateFixedPoint.
+static int led_rawLerpCurrentQ16[5] = { 0 };
+static int led_finalColorsQ16[5] = { 0 };
+static int led_current_value_brightnessQ16 = 0;
+static int led_current_value_cold_or_warmQ16 = 0;
+static int led_lerpSpeedQ16 = 200 << LED_Q16_SHIFT;
+// Q32, so that full 255 still gives full 100 after truncation
+static int64_t led_colorScaleToChannelQ32 = 0;
+// g_brightness and temperature as 0-100 channel values
+static int led_value_brightness = 100;
+static int led_value_cold_or_warm = 0;
+// brightness curve factor (Q16) for each dimmer value, so powf is not
+// called on each dimmer change; made for given exponential mode and brightnessMult
+#define LED_BRIGHTNESS_LUT_SIZE 101
+static int led_brightnessLUT[LED_BRIGHTNESS_LUT_SIZE];
+static int led_brightnessLUTMode = -1;
+static float led_brightnessLUTMult = 0;
+
+static int LED_FloatToQ16(float f) {
+	// rounded, truncation would make exact values like 90.0 come out as 89
+	return (int)(f * (float)LED_Q16_ONE + 0.5f);
+}
+// Q16 color to 0-100 channel value. Brightness factor is rounded to Q16,
+// which can leave 229.5 (255 at 90%) a bit short, so give it 1/256 before truncating
+static int LED_Q16ToChannel(int q) {
+	q += LED_Q16_ONE >> 8;
+	return (int)(((int64_t)q * led_colorScaleToChannelQ32) >> (LED_Q16_SHIFT + 32));
+}
 
 void led_Save_finalRGBCW(byte* finalRGBCW) {
 #ifdef ENABLE_DRIVER_LED
@@ -203,12 +243,13 @@ void led_Save_finalRGBCW(byte* finalRGBCW) {
 void LED_RunQuickColorLerp(int deltaMS) {
 	int i;
 	int firstChannelIndex;
-	float deltaSeconds;
-	byte finalRGBCW[5];
+	byte finalRGBCW[5] = { 0, 0, 0, 0, 0 };
 	int maxPossibleIndexToSet;
 	int emulatedCool = -1;
 	int target_value_brightness = 0;
 	int target_value_cold_or_warm = 0;
+	int64_t step;
+	int chVal;
 
 	if (CFG_HasFlag(OBK_FLAG_LED_FORCE_MODE_RGB)) {
 		// only allow setting pwm 0, 1 and 2, force-skip 3 and 4
@@ -218,8 +259,11 @@ void LED_RunQuickColorLerp(int deltaMS) {
 		maxPossibleIndexToSet = 5;
 	}
 
-
-	deltaSeconds = deltaMS * 0.001f;
+	step = (int64_t)deltaMS * led_lerpSpeedQ16 / 1000;
+	// anything over full range just finishes lerp
+	if (step > (256 << LED_Q16_SHIFT)) {
+		step = 256 << LED_Q16_SHIFT;
+	}
 
 	// The color order is RGBCW.
 	// some people set RED to channel 0, and some of them set RED to channel 1
@@ -236,36 +280,36 @@ void LED_RunQuickColorLerp(int deltaMS) {
 	for(i = 0; i < 5; i++) {
 		// This is the most silly and primitive approach, but it works
 		// In future we might implement better lerp algorithms, use HUE, etc
-		led_rawLerpCurrent[i] = Mathf_MoveTowards(led_rawLerpCurrent[i],finalColors[i], deltaSeconds * led_lerpSpeedUnitsPerSecond);
+		led_rawLerpCurrentQ16[i] = LED_MoveTowardsQ16(led_rawLerpCurrentQ16[i], led_finalColorsQ16[i], step);
 	}
 
-	target_value_cold_or_warm = LED_GetTemperature0to1Range() * 100.0f;
+	target_value_cold_or_warm = led_value_cold_or_warm;
 	if (g_lightEnableAll) {
 		if (g_lightMode == Light_Temperature) {
-			target_value_brightness = g_brightness * 100.0f;
+			target_value_brightness = led_value_brightness;
 		}
 	}
 
-	led_current_value_brightness = Mathf_MoveTowards(led_current_value_brightness, target_value_brightness, deltaSeconds * led_lerpSpeedUnitsPerSecond);
-	led_current_value_cold_or_warm = Mathf_MoveTowards(led_current_value_cold_or_warm, target_value_cold_or_warm, deltaSeconds * led_lerpSpeedUnitsPerSecond);
+	led_current_value_brightnessQ16 = LED_MoveTowardsQ16(led_current_value_brightnessQ16, target_value_brightness << LED_Q16_SHIFT, step);
+	led_current_value_cold_or_warmQ16 = LED_MoveTowardsQ16(led_current_value_cold_or_warmQ16, target_value_cold_or_warm << LED_Q16_SHIFT, step);
 
 	// OBK_FLAG_LED_ALTERNATE_CW_MODE means we have a driver that takes one PWM for brightness and second for temperature
 	if(isCWMode() && CFG_HasFlag(OBK_FLAG_LED_ALTERNATE_CW_MODE)) {
-		CHANNEL_Set(firstChannelIndex, led_current_value_cold_or_warm, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
-		CHANNEL_Set(firstChannelIndex+1, led_current_value_brightness, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
+		CHANNEL_Set(firstChannelIndex, led_current_value_cold_or_warmQ16 >> LED_Q16_SHIFT, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
+		CHANNEL_Set(firstChannelIndex+1, led_current_value_brightnessQ16 >> LED_Q16_SHIFT, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
 	} else {
 		if(isCWMode()) { 
 			// In CW mode, user sets just two PWMs. So we have: PWM0 and PWM1 (or maybe PWM1 and PWM2)
 			// But we still have RGBCW internally
 			// So, we need to map. Map component 3 of RGBCW to first channel, and component 4 to second.
-			CHANNEL_Set(firstChannelIndex + 0, led_rawLerpCurrent[3] * g_cfg_colorScaleToChannel, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
-			CHANNEL_Set(firstChannelIndex + 1, led_rawLerpCurrent[4] * g_cfg_colorScaleToChannel, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
+			CHANNEL_Set(firstChannelIndex + 0, LED_Q16ToChannel(led_rawLerpCurrentQ16[3]), CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
+			CHANNEL_Set(firstChannelIndex + 1, LED_Q16ToChannel(led_rawLerpCurrentQ16[4]), CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
 		} else {
 			// This should work for both RGB and RGBCW
 			// This also could work for a SINGLE COLOR strips
 			for(i = 0; i < maxPossibleIndexToSet; i++) {
-				finalRGBCW[i] = led_rawLerpCurrent[i];
-				float chVal = led_rawLerpCurrent[i] * g_cfg_colorScaleToChannel;
+				finalRGBCW[i] = led_rawLerpCurrentQ16[i] >> LED_Q16_SHIFT;
+				chVal = LED_Q16ToChannel(led_rawLerpCurrentQ16[i]);
 				int channelToUse = firstChannelIndex + i;
 				// emulated cool is -1 by default, so this block will only execute
 				// if the cool emulation was enabled
@@ -277,10 +321,10 @@ void LED_RunQuickColorLerp(int deltaMS) {
 				else {
 					if (CFG_HasFlag(OBK_FLAG_LED_ALTERNATE_CW_MODE)) {
 						if (i == 3) {
-							chVal = led_current_value_cold_or_warm;
+							chVal = led_current_value_cold_or_warmQ16 >> LED_Q16_SHIFT;
 						}
 						else if (i == 4) {
-							chVal = led_current_value_brightness;
+							chVal = led_current_value_brightnessQ16 >> LED_Q16_SHIFT;
 						}
 					}
 					CHANNEL_Set(channelToUse, chVal, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
@@ -297,48 +341,108 @@ int exponential_mode = 0;
 int exponential_mode = 2;
 #endif
 
-float LED_BrightnessMapping(float raw, float brig) {
-	float final = 0;
+// brightness curve, color is multiplied by this
+static float LED_BrightnessCurve(float brig) {
+	float expo_base;
+	float expo_factor;
+	float expo_offset = 0.0;
+
 	// make brightness exponential:
 	if (exponential_mode == 0) {
-		final = raw * brig;
+		return brig;
+	}
+	if ((exponential_mode == 1) || (exponential_mode == 2)) {
+		expo_offset = 0.009f;
 	}
-	else if (g_brightness == 0.0f) {
+	if ((exponential_mode == 1) || (exponential_mode == 3)) {
+		expo_base = 1.2f;     // moderate exponential
+		expo_factor = 15.32f;
+		expo_offset -= 0.06609f;
+	}
+	else {
+		expo_base = 1.06f;    // full exponential
+		expo_factor = 74.115f;
+		expo_offset -= 0.013f;
+	}
+	return powf(expo_base, brig * expo_factor) / expo_factor + expo_offset;
+}
+float LED_BrightnessMapping(float raw, float brig) {
+	float final = 0;
+	if (exponential_mode != 0 && g_brightness == 0.0f) {
 		final = 0.0f;
 	}
 	else {
-		float expo_base;
-		float expo_factor;
-		float expo_offset = 0.0;
-		if ((exponential_mode == 1) || (exponential_mode == 2)) {
-			expo_offset = 0.009f;
-		}
-		if ((exponential_mode == 1) || (exponential_mode == 3)) {
-			expo_base = 1.2f;     // moderate exponential
-			expo_factor = 15.32f;
-			expo_offset -= 0.06609f;
-		}
-		else {
-			expo_base = 1.06f;    // full exponential
-			expo_factor = 74.115f;
-			expo_offset -= 0.013f;
-		}
-		final = raw * (powf(expo_base, brig * expo_factor) / expo_factor + expo_offset);
+		final = raw * LED_BrightnessCurve(brig);
 	}
 	if (final > 255.0f)
 		final = 255.0f;
 	return final;
 }
+static void LED_RebuildBrightnessLUT() {
+	int i;
+
+	for (i = 0; i < LED_BRIGHTNESS_LUT_SIZE; i++) {
+		led_brightnessLUT[i] = LED_FloatToQ16(LED_BrightnessCurve(i * g_cfg_brightnessMult));
+	}
+	led_brightnessLUTMode = exponential_mode;
+	led_brightnessLUTMult = g_cfg_brightnessMult;
+}
+// converts float settings to fixed point state, must be called after they change
+void LED_UpdateFixedPoint() {
+	if (led_brightnessLUTMode != exponential_mode || led_brightnessLUTMult != g_cfg_brightnessMult) {
+		LED_RebuildBrightnessLUT();
+	}
+	led_lerpSpeedQ16 = LED_FloatToQ16(led_lerpSpeedUnitsPerSecond);
+	led_colorScaleToChannelQ32 = (int64_t)((double)g_cfg_colorScaleToChannel * 4294967296.0 + 0.5);
+	led_value_brightness = g_brightness * 100.0f;
+	led_value_cold_or_warm = LED_GetTemperature0to1Range() * 100.0f;
+}
+static int LED_GetBrightnessFactorQ16() {
+	int idx;
+
+	if (exponential_mode != 0 && g_brightness == 0.0f) {
+		return 0;
+	}
+	// dimmer values always hit the table
+	if (g_cfg_brightnessMult > 0) {
+		idx = (int)(g_brightness / g_cfg_brightnessMult + 0.5f);
+		if (idx >= 0 && idx < LED_BRIGHTNESS_LUT_SIZE && idx * g_cfg_brightnessMult == g_brightness) {
+			return led_brightnessLUT[idx];
+		}
+	}
+	return LED_FloatToQ16(LED_BrightnessCurve(g_brightness));
+}
+// LED_BrightnessMapping(raw, g_brightness), but in Q16
+int LED_BrightnessMappingQ16(int rawQ16) {
+	int64_t final;
+
+	final = ((int64_t)rawQ16 * LED_GetBrightnessFactorQ16()) >> LED_Q16_SHIFT;
+	if (final > (255 << LED_Q16_SHIFT))
+		final = 255 << LED_Q16_SHIFT;
+	if (final < 0)
+		final = 0;
+	return (int)final;
+}
+
+// set while effect engine outputs a frame, it goes to output stage
+// instead of base colors, which stay as they were
+static const byte *led_effectFrame = 0;
 
 void apply_smart_light() {
 	int i;
 	int firstChannelIndex;
 	int channelToUse;
-	byte finalRGBCW[5];
+	byte finalRGBCW[5] = { 0, 0, 0, 0, 0 };
 	int maxPossibleIndexToSet;
 	int emulatedCool = -1;
 	int value_brightness = 0;
 	int value_cold_or_warm = 0;
+	int finalQ16;
+	int chVal;
+	int lightMode;
+
+	LED_UpdateFixedPoint();
+	lightMode = led_effectFrame ? Light_RGB : g_lightMode;
 
 	// The color order is RGBCW.
 	// some people set RED to channel 0, and some of them set RED to channel 1
@@ -362,10 +466,10 @@ void apply_smart_light() {
 	}
 
 	if (CFG_HasFlag(OBK_FLAG_LED_ALTERNATE_CW_MODE)) {
-		value_cold_or_warm = LED_GetTemperature0to1Range() * 100.0f;
+		value_cold_or_warm = led_value_cold_or_warm;
 		if (g_lightEnableAll) {
 			if (g_lightMode == Light_Temperature) {
-				value_brightness = g_brightness * 100.0f;
+				value_brightness = led_value_brightness;
 			}
 		}
 	}
@@ -374,11 +478,13 @@ void apply_smart_light() {
 		for(i = 0; i < 5; i++) {
 			finalColors[i] = 0;
 			finalRGBCW[i] = 0;
+			led_finalColorsQ16[i] = 0;
 		}
 		if(g_lightEnableAll) {
 			for(i = 3; i < 5; i++) {
 				finalColors[i] = baseColors[i] * g_brightness;
 				finalRGBCW[i] = baseColors[i] * g_brightness;
+				led_finalColorsQ16[i] = LED_FloatToQ16(finalColors[i]);
 			}
 		}
 		if(CFG_HasFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS) == false) {
@@ -387,34 +493,36 @@ void apply_smart_light() {
 		}
 	} else {
 		for(i = 0; i < maxPossibleIndexToSet; i++) {
-			float raw, final;
-
-			raw = baseColors[i];
-			final = 0.0f;
+			finalQ16 = 0;
 
 			if(g_lightEnableAll) {
-				final = LED_BrightnessMapping(raw, g_brightness);
+				if (led_effectFrame) {
+					finalQ16 = LED_BrightnessMappingQ16(led_effectFrame[i] << LED_Q16_SHIFT);
+				} else {
+					finalQ16 = LED_BrightnessMappingQ16(LED_FloatToQ16(baseColors[i]));
+				}
 			}
-			if(g_lightMode == Light_Temperature) {
+			if(lightMode == Light_Temperature) {
 				// skip channels 0, 1, 2
 				// (RGB)
 				if(i < 3)
 				{
-					final = 0;
+					finalQ16 = 0;
 				}
-			} else if(g_lightMode == Light_RGB) {
+			} else if(lightMode == Light_RGB) {
 				// skip channels 3, 4
 				if(i >= 3)
 				{
-					final = 0;
+					finalQ16 = 0;
 				}
 			} else {
 
 			}
-			finalColors[i] = final;
-			finalRGBCW[i] = final;
+			led_finalColorsQ16[i] = finalQ16;
+			finalColors[i] = finalQ16 * (1.0f / LED_Q16_ONE);
+			finalRGBCW[i] = finalQ16 >> LED_Q16_SHIFT;
 
-			int chVal = (int)(final * g_cfg_colorScaleToChannel);
+			chVal = LED_Q16ToChannel(finalQ16);
 			if (chVal > 100)
 				chVal = 100;
 
@@ -422,7 +530,7 @@ void apply_smart_light() {
 
 			// log printf with %f crashes N platform?
 			//ADDLOG_INFO(LOG_FEATURE_CMD, "apply_smart_light: ch %i raw is %f, bright %f, final %f, enableAll is %i",
-			//	channelToUse,raw,g_brightness,final,g_lightEnableAll);
+			//	channelToUse,baseColors[i],g_brightness,finalColors[i],g_lightEnableAll);
 
 			if(CFG_HasFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS) == false) {
 				if (isCWMode()) {
@@ -438,7 +546,7 @@ void apply_smart_light() {
 				} else {
 					// emulated cool is -1 by default, so this block will only execute
 					// if the cool emulation was enabled
-					if (channelToUse == emulatedCool && g_lightMode == Light_Temperature) {
+					if (channelToUse == emulatedCool && lightMode == Light_Temperature) {
 						CHANNEL_Set(firstChannelIndex + 0, chVal, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
 						CHANNEL_Set(firstChannelIndex + 1, chVal, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
 						CHANNEL_Set(firstChannelIndex + 2, chVal, CHANNEL_SET_FLAG_SKIP_MQTT | CHANNEL_SET_FLAG_SILENT);
@@ -462,6 +570,11 @@ void apply_smart_light() {
 		led_Save_finalRGBCW(finalRGBCW);
 	}
 
+	// effect frames change many times per second, don't save or publish them
+	if (led_effectFrame) {
+		return;
+	}
+
 	if(CFG_HasFlag(OBK_FLAG_LED_REMEMBERLASTSTATE)) {
 		HAL_FlashVars_SaveLED(g_lightMode,g_brightness / g_cfg_brightnessMult, led_temperature_current,baseColors[0],baseColors[1],baseColors[2],g_lightEnableAll);
 	}
@@ -586,6 +699,7 @@ OBK_Publish_Result LED_SendCurrentLightMode() {
 }
 void LED_SetTemperature0to1Range(float f) {
 	led_temperature_current = led_temperature_min + (led_temperature_max-led_temperature_min) * f;
+	LED_UpdateFixedPoint();
 }
 float LED_GetTemperature0to1Range() {
 	float f;
@@ -608,6 +722,7 @@ void LED_SetTemperature(int tmpInteger, bool bApply) {
 
 	baseColors[3] = (255.0f) * (1-f);
 	baseColors[4] = (255.0f) * f;
+	LED_UpdateFixedPoint();
 
 	if(bApply) {
 		if (CFG_HasFlag(OBK_FLAG_LED_AUTOENABLE_ON_ANY_ACTION)) {
@@ -936,6 +1051,12 @@ void LED_SetFinalRGBCW(byte *rgbcw) {
 		LED_SetFinalCW(rgbcw[3],rgbcw[4]);
 	}
 }
+// used by effects engine, see cmd_newLEDDriver_effects.c
+void LED_ApplyEffectFrame(byte *rgbcw) {
+	led_effectFrame = rgbcw;
+	apply_smart_light();
+	led_effectFrame = 0;
+}
 void LED_GetFinalChannels100(byte *rgbcw) {
 	rgbcw[0] = finalColors[0] * (100.0f / 255.0f);
 	rgbcw[1] = finalColors[1] * (100.0f / 255.0f);
@@ -1149,6 +1270,7 @@ static commandResult_t colorMult(const void *context, const char *cmd, const cha
         ADDLOG_DEBUG(LOG_FEATURE_CMD, " g_cfg_colorScaleToChannel (%s) received with args %s",cmd,args);
 
 		g_cfg_colorScaleToChannel = atof(args);
+		LED_UpdateFixedPoint();
 
 		return CMD_RES_OK;
 	//}
@@ -1159,6 +1281,7 @@ static commandResult_t brightnessMult(const void *context, const char *cmd, cons
         ADDLOG_DEBUG(LOG_FEATURE_CMD, " brightnessMult (%s) received with args %s",cmd,args);
 
 		g_cfg_brightnessMult = atof(args);
+		LED_UpdateFixedPoint();
 
 		return CMD_RES_OK;
 	//}
@@ -1202,6 +1325,7 @@ static commandResult_t lerpSpeed(const void *context, const char *cmd, const cha
 	Tokenizer_TokenizeString(args, 0);
 
 	led_lerpSpeedUnitsPerSecond = Tokenizer_GetArgFloat(0);
+	LED_UpdateFixedPoint();
 
 	return CMD_RES_OK;
 }
@@ -1348,6 +1472,8 @@ void NewLED_InitCommands(){
 	//cmddetail:"examples":"led_expoMode 4"}
     CMD_RegisterCommand("led_expoMode", "", exponentialMode, NULL, NULL);
 
+	LED_Effect_InitCommands();
+
 	// HSBColor 360,100,100 - red
 	// HSBColor 90,100,100 - green
 	// HSBColor	<hue>,<sat>,<bri> = set color by hue, saturation and brightness
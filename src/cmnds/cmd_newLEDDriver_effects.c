@@ -0,0 +1,291 @@
+
+#include "../logging/logging.h"
+#include "../new_pins.h"
+#include "../new_cfg.h"
+#include "cmd_public.h"
+#include "../obk_config.h"
+#include "cmd_local.h"
+
+// Native light effects. Effect is a frame function of time since start,
+// evaluated at most once per frame interval from the quick tick and
+// given to the LED driver with LED_ApplyEffectFrame, so brightness and
+// enable state still apply and nothing goes through command parser or flash.
+// Frames don't change base color, it comes back when effect is stopped.
+// One-shot effect ends with its last frame set as base color.
+// All math is integer, time comes only from tick deltas, so simulator
+// runs are deterministic.
+//
+// led_effect breathe 3000 FF0000
+// led_effect cycle 10000
+// led_effect sunrise 600000
+// led_effect off
+
+typedef struct ledEffectState_s {
+	// ms since effect start
+	int time;
+	int period;
+	byte a[3];
+	byte b[3];
+	// candle
+	unsigned int random;
+	int level;
+} ledEffectState_t;
+
+typedef struct ledEffect_s {
+	const char *name;
+	int defaultPeriod;
+	byte defaultA[3];
+	byte defaultB[3];
+	// finished after one period, last frame stays
+	byte bOneShot;
+	void (*frame)(ledEffectState_t *s, byte *out);
+} ledEffect_t;
+
+// out = a + (b - a) * t / 256
+static void LED_Effect_Mix(const byte *a, const byte *b, int t, byte *out) {
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		out[i] = a[i] + (((b[i] - a[i]) * t) >> 8);
+	}
+}
+static void LED_Effect_Scale(const byte *a, int level, byte *out) {
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		out[i] = (a[i] * level) >> 8;
+	}
+}
+// 0..256 progress of one-shot effect
+static int LED_Effect_Progress(ledEffectState_t *s) {
+	if (s->time >= s->period) {
+		return 256;
+	}
+	// long sunrise would overflow int
+	return (int)(((int64_t)s->time * 256) / s->period);
+}
+
+static void LED_Effect_Fade(ledEffectState_t *s, byte *out) {
+	LED_Effect_Mix(s->a, s->b, LED_Effect_Progress(s), out);
+}
+static void LED_Effect_Breathe(ledEffectState_t *s, byte *out) {
+	int phase, tri, level;
+
+	phase = s->time % s->period;
+	// triangle 0..256..0
+	tri = (phase * 512) / s->period;
+	if (tri > 256) {
+		tri = 512 - tri;
+	}
+	// squared, so it looks linear to eye, never fully off
+	level = 16 + (((tri * tri) >> 8) * (256 - 16) >> 8);
+	LED_Effect_Scale(s->a, level, out);
+}
+static void LED_Effect_Cycle(ledEffectState_t *s, byte *out) {
+	int hue, f;
+
+	// hue wheel in 6 segments of 256
+	hue = ((s->time % s->period) * 1536) / s->period;
+	f = hue & 0xff;
+	switch (hue >> 8) {
+	case 0: out[0] = 255; out[1] = f; out[2] = 0; break;
+	case 1: out[0] = 255 - f; out[1] = 255; out[2] = 0; break;
+	case 2: out[0] = 0; out[1] = 255; out[2] = f; break;
+	case 3: out[0] = 0; out[1] = 255 - f; out[2] = 255; break;
+	case 4: out[0] = f; out[1] = 0; out[2] = 255; break;
+	default: out[0] = 255; out[1] = 0; out[2] = 255 - f; break;
+	}
+}
+static void LED_Effect_Candle(ledEffectState_t *s, byte *out) {
+	int target;
+
+	// own generator, so it does not depend on rand() use elsewhere
+	s->random = s->random * 1103515245 + 12345;
+	target = 140 + ((s->random >> 16) % 117);
+	// follow target slowly, so it flickers instead of blinking
+	s->level = (s->level * 3 + target) >> 2;
+	LED_Effect_Scale(s->a, s->level, out);
+}
+static void LED_Effect_Sunrise(ledEffectState_t *s, byte *out) {
+	// night, deep red, orange, warm, then given color
+	static const byte steps[4][3] = {
+		{ 0, 0, 0 },
+		{ 96, 8, 0 },
+		{ 255, 80, 0 },
+		{ 255, 170, 70 },
+	};
+	int t, seg;
+
+	t = LED_Effect_Progress(s) * 4;
+	seg = t >> 8;
+	if (seg >= 4) {
+		memcpy(out, s->a, 3);
+	}
+	else if (seg == 3) {
+		LED_Effect_Mix(steps[3], s->a, t & 0xff, out);
+	}
+	else {
+		LED_Effect_Mix(steps[seg], steps[seg + 1], t & 0xff, out);
+	}
+}
+
+static const ledEffect_t g_effects[] = {
+	{ "fade", 2000, { 255, 0, 0 }, { 0, 0, 255 }, 1, LED_Effect_Fade },
+	{ "breathe", 4000, { 255, 255, 255 }, { 0, 0, 0 }, 0, LED_Effect_Breathe },
+	{ "cycle", 10000, { 255, 255, 255 }, { 0, 0, 0 }, 0, LED_Effect_Cycle },
+	{ "candle", 1000, { 255, 147, 41 }, { 0, 0, 0 }, 0, LED_Effect_Candle },
+	{ "sunrise", 600000, { 255, 255, 255 }, { 0, 0, 0 }, 1, LED_Effect_Sunrise },
+};
+#define LED_EFFECTS_COUNT (sizeof(g_effects) / sizeof(g_effects[0]))
+
+static const ledEffect_t *g_effect = 0;
+static ledEffectState_t g_effectState;
+// frame budget, frames are not computed more often than this
+static int g_effectFrameInterval = 20;
+static int g_effectTimeSinceFrame = 0;
+static byte g_effectLastFrame[3];
+static byte g_effectLastFrameValid = 0;
+
+int LED_Effect_IsRunning() {
+	return g_effect != 0;
+}
+const char *LED_Effect_GetName() {
+	if (g_effect == 0) {
+		return "off";
+	}
+	return g_effect->name;
+}
+void LED_Effect_Stop() {
+	if (g_effect == 0) {
+		return;
+	}
+	g_effect = 0;
+	apply_smart_light();
+}
+static void LED_Effect_OutputFrame() {
+	byte out[5] = { 0, 0, 0, 0, 0 };
+
+	g_effect->frame(&g_effectState, out);
+	// most frames of slow effects are the same
+	if (g_effectLastFrameValid && memcmp(out, g_effectLastFrame, 3) == 0) {
+		return;
+	}
+	memcpy(g_effectLastFrame, out, 3);
+	g_effectLastFrameValid = 1;
+	LED_ApplyEffectFrame(out);
+}
+void LED_Effect_RunQuickTick(int deltaMS) {
+	if (g_effect == 0) {
+		return;
+	}
+	// keep time, but don't turn on the light
+	g_effectState.time += deltaMS;
+	if (g_effect->bOneShot == 0 && g_effectState.time >= g_effectState.period) {
+		g_effectState.time %= g_effectState.period;
+	}
+	g_effectTimeSinceFrame += deltaMS;
+	if (LED_GetEnableAll() == 0) {
+		return;
+	}
+	if (g_effectTimeSinceFrame < g_effectFrameInterval) {
+		return;
+	}
+	// late ticks skip frames, they are not caught up
+	g_effectTimeSinceFrame = 0;
+	LED_Effect_OutputFrame();
+	if (g_effect->bOneShot && g_effectState.time >= g_effectState.period) {
+		ADDLOG_INFO(LOG_FEATURE_CMD, "Effect %s finished", g_effect->name);
+		g_effect = 0;
+		LED_SetFinalRGB(g_effectLastFrame[0], g_effectLastFrame[1], g_effectLastFrame[2]);
+	}
+}
+static int LED_Effect_ParseColor(const char *s, byte *out) {
+	int r, g, b;
+
+	if (*s == '#')
+		s++;
+	if (sscanf(s, "%02x%02x%02x", &r, &g, &b) != 3) {
+		return 0;
+	}
+	out[0] = r;
+	out[1] = g;
+	out[2] = b;
+	return 1;
+}
+// led_effect [Name|off] [PeriodMS] [ColorA] [ColorB]
+static commandResult_t CMD_LED_Effect(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	const ledEffect_t *e;
+	const char *name;
+	int i;
+
+	Tokenizer_TokenizeString(args, 0);
+
+	if (Tokenizer_GetArgsCount() < 1) {
+		ADDLOG_INFO(LOG_FEATURE_CMD, "Effect is %s", LED_Effect_GetName());
+		return CMD_RES_OK;
+	}
+	name = Tokenizer_GetArg(0);
+	if (!stricmp(name, "off") || !stricmp(name, "0")) {
+		LED_Effect_Stop();
+		return CMD_RES_OK;
+	}
+	e = 0;
+	for (i = 0; i < LED_EFFECTS_COUNT; i++) {
+		if (!stricmp(name, g_effects[i].name)) {
+			e = &g_effects[i];
+			break;
+		}
+	}
+	if (e == 0) {
+		ADDLOG_ERROR(LOG_FEATURE_CMD, "Unknown effect %s", name);
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	memset(&g_effectState, 0, sizeof(g_effectState));
+	g_effectState.period = e->defaultPeriod;
+	memcpy(g_effectState.a, e->defaultA, 3);
+	memcpy(g_effectState.b, e->defaultB, 3);
+	g_effectState.random = 0x1234;
+	g_effectState.level = 256;
+	if (Tokenizer_GetArgsCount() > 1) {
+		g_effectState.period = Tokenizer_GetArgInteger(1);
+		if (g_effectState.period < 1) {
+			g_effectState.period = 1;
+		}
+	}
+	if (Tokenizer_GetArgsCount() > 2 && !LED_Effect_ParseColor(Tokenizer_GetArg(2), g_effectState.a)) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	if (Tokenizer_GetArgsCount() > 3 && !LED_Effect_ParseColor(Tokenizer_GetArg(3), g_effectState.b)) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	g_effect = e;
+	// first frame at once
+	g_effectTimeSinceFrame = g_effectFrameInterval;
+	g_effectLastFrameValid = 0;
+	LED_Effect_RunQuickTick(0);
+	return CMD_RES_OK;
+}
+static commandResult_t CMD_LED_EffectFPS(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	int fps;
+
+	Tokenizer_TokenizeString(args, 0);
+
+	if (Tokenizer_GetArgsCount() < 1) {
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	fps = Tokenizer_GetArgIntegerRange(0, 1, 100);
+	g_effectFrameInterval = 1000 / fps;
+	return CMD_RES_OK;
+}
+void LED_Effect_InitCommands() {
+	//cmddetail:{"name":"led_effect","args":"[Name][PeriodMS][ColorA][ColorB]",
+	//cmddetail:"descr":"Starts native light effect: fade (ColorA to ColorB), breathe, cycle, candle or sunrise (ends at ColorA). Period is effect length or loop time in ms. 'led_effect off' stops it, no args prints current effect.",
+	//cmddetail:"fn":"CMD_LED_Effect","file":"cmnds/cmd_newLEDDriver_effects.c","requires":"",
+	//cmddetail:"examples":"led_effect breathe 3000 FF0000"}
+	CMD_RegisterCommand("led_effect", "", CMD_LED_Effect, NULL, NULL);
+	//cmddetail:{"name":"led_effectFPS","args":"[FramesPerSecond]",
+	//cmddetail:"descr":"Sets maximum frame rate of light effects, 1 to 100, default is 50",
+	//cmddetail:"fn":"CMD_LED_EffectFPS","file":"cmnds/cmd_newLEDDriver_effects.c","requires":"",
+	//cmddetail:"examples":"led_effectFPS 25"}
+	CMD_RegisterCommand("led_effectFPS", "", CMD_LED_EffectFPS, NULL, NULL);
+}
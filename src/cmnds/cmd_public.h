@@ -104,6 +104,15 @@ enum EventCode {
 
 	CMD_EVENT_CHANGE_NOPINGTIME,
 
+	// SSDP device registry, argument is last byte of device IP
+	CMD_EVENT_SSDP_NEW,
+	CMD_EVENT_SSDP_LOST,
+	CMD_EVENT_SSDP_CHANGE,
+
+	// ping monitor, argument is last byte of target IP
+	CMD_EVENT_PING_ALARM,
+	CMD_EVENT_PING_RECOVERED,
+
 	// must be lower than 256
 	CMD_EVENT_MAX_TYPES
 };
@@ -179,7 +188,25 @@ commandResult_t LED_SetBaseColor(const void* context, const char* cmd, const cha
 void LED_SetFinalCW(byte c, byte w);
 void LED_SetFinalRGB(byte r, byte g, byte b);
 float LED_BrightnessMapping(float raw, float brig);
+// fixed point (Q16, 1.0 is 65536) versions used by smooth transitions
+#define LED_Q16_SHIFT 16
+#define LED_Q16_ONE (1 << LED_Q16_SHIFT)
+int LED_BrightnessMappingQ16(int rawQ16);
+int LED_MoveTowardsQ16(int cur, int tg, int step);
+float Mathf_MoveTowards(float cur, float tg, float dt);
+void LED_UpdateFixedPoint();
 void LED_SetFinalRGBCW(byte* rgbcw);
+// RGB frame straight to output stage (brightness and enable still apply),
+// base colors and HSV are not changed, nothing is saved or published
+void LED_ApplyEffectFrame(byte* rgbcw);
+// outputs base colors again
+void apply_smart_light();
+// light effects engine
+void LED_Effect_InitCommands();
+void LED_Effect_RunQuickTick(int deltaMS);
+int LED_Effect_IsRunning();
+const char* LED_Effect_GetName();
+void LED_Effect_Stop();
 void LED_GetFinalChannels100(byte* rgbcw);
 void LED_GetFinalHSV(int* hsv);
 void LED_GetFinalRGBCW(byte* rgbcw);
@@ -19,13 +19,58 @@ static commandResult_t CMD_SendGET(const void *context, const char *cmd, const c
 	return CMD_RES_OK;
 }
 
+// HTTPClient_Config 3000 10000
+static commandResult_t CMD_HTTPClientConfig(const void *context, const char *cmd, const char *args, int cmdFlags){
+#if defined(PLATFORM_BEKEN) || defined(WINDOWS)
+	int timeout, keepAlive;
+
+	Tokenizer_TokenizeString(args, 0);
+	if(Tokenizer_GetArgsCount() < 1) {
+		HTTPClient_GetTimeouts(&timeout, &keepAlive);
+		ADDLOG_INFO(LOG_FEATURE_CMD, "HTTP client timeout %i ms, keep alive %i ms", timeout, keepAlive);
+		return CMD_RES_OK;
+	}
+	timeout = Tokenizer_GetArgInteger(0);
+	keepAlive = -1;
+	if(Tokenizer_GetArgsCount() > 1) {
+		keepAlive = Tokenizer_GetArgInteger(1);
+	}
+	HTTPClient_SetTimeouts(timeout, keepAlive);
+#endif
+	return CMD_RES_OK;
+}
+static commandResult_t CMD_HTTPClientStats(const void *context, const char *cmd, const char *args, int cmdFlags){
+#if defined(PLATFORM_BEKEN) || defined(WINDOWS)
+	httpclientStats_t *st = &g_httpclient_stats;
+
+	ADDLOG_INFO(LOG_FEATURE_CMD, "HTTP client: %i requests, %i failed, %i rejected, %i queued (max %i)",
+		st->requests, st->failures, st->rejected, HTTPClient_GetQueuedCount(), st->queueHighWater);
+	ADDLOG_INFO(LOG_FEATURE_CMD, "HTTP client: %i connections opened, %i reused, latency avg %i ms, max %i ms",
+		st->connectionsOpened, st->connectionsReused,
+		st->requests ? (int)(st->latencyTotalMs / st->requests) : 0, (int)st->latencyMaxMs);
+#endif
+	return CMD_RES_OK;
+}
 
 int CMD_InitSendCommands(){
+#if defined(PLATFORM_BEKEN) || defined(WINDOWS)
+	HTTPClient_Init();
+#endif
 	//cmddetail:{"name":"sendGet","args":"[TargetURL]",
 	//cmddetail:"descr":"Sends a HTTP GET request to target URL. May include GET arguments. Can be used to control devices by Tasmota HTTP protocol. Command supports argument expansion, so $CH11 changes to value of channel 11, etc, etc.",
 	//cmddetail:"fn":"CMD_SendGET","file":"cmnds/cmd_send.c","requires":"",
 	//cmddetail:"examples":""}
     CMD_RegisterCommand("sendGet", "", CMD_SendGET, NULL, NULL);
+	//cmddetail:{"name":"HTTPClient_Config","args":"[TimeoutMS] [KeepAliveMS]",
+	//cmddetail:"descr":"Sets timeout of sendGet requests and how long finished connections are kept open for reuse (0 disables keep-alive). Without arguments, prints current values.",
+	//cmddetail:"fn":"CMD_HTTPClientConfig","file":"cmnds/cmd_send.c","requires":"",
+	//cmddetail:"examples":"HTTPClient_Config 3000 10000"}
+    CMD_RegisterCommand("HTTPClient_Config", "", CMD_HTTPClientConfig, NULL, NULL);
+	//cmddetail:{"name":"HTTPClient_Stats","args":"",
+	//cmddetail:"descr":"Prints HTTP client worker pool counters - requests, failures, rejected because of full queue, reused connections and latency.",
+	//cmddetail:"fn":"CMD_HTTPClientStats","file":"cmnds/cmd_send.c","requires":"",
+	//cmddetail:"examples":""}
+    CMD_RegisterCommand("HTTPClient_Stats", "", CMD_HTTPClientStats, NULL, NULL);
 
     return 0;
 }
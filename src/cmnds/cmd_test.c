@@ -232,7 +232,7 @@ static commandResult_t testJSON(const void * context, const char *cmd, const cha
 
 		msg = cJSON_Print(root);
 		cJSON_Delete(root);
-		os_free(msg);
+		cJSON_free(msg);
 	}
 
 	ADDLOG_INFO(LOG_FEATURE_CMD, "testJSON has been tested! Total calls %i, reps now %i",totalCalls,repeats);
@@ -0,0 +1,27 @@
+#ifndef __CRC_H__
+#define __CRC_H__
+
+#include "new_common.h"
+
+// Table driven CRCs with incremental API.
+//
+// CRC8 is the config checksum - reflected, polynomial 0x8C, initial value 0,
+// bit exact with the original bitwise Tiny_CRC8 (including its sign extension
+// on platforms where char is signed, like simulator).
+// CRC32 is the usual IEEE one (zlib, Ethernet, PNG).
+//
+// Update functions can be called on consecutive parts of the data:
+//   crc = CRC8_Update(CRC8_Update(0, a, lenA), b, lenB) == CRC8 of a followed by b
+// Combine functions join checksums of two parts computed separately,
+// without touching the data again:
+//   CRC8_Combine(CRC8 of a, CRC8 of b, lenB) == CRC8 of a followed by b
+
+byte CRC8_Update(byte crc, const void *data, int length);
+byte CRC8_Combine(byte crcA, byte crcB, int lengthB);
+// original bit by bit implementation, reference for selftests
+byte CRC8_Bitwise(byte crc, const void *data, int length);
+
+uint32_t CRC32_Update(uint32_t crc, const void *data, int length);
+uint32_t CRC32_Combine(uint32_t crcA, uint32_t crcB, int lengthB);
+
+#endif /* __CRC_H__ */
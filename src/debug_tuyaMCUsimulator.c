@@ -1,6 +1,7 @@
 #ifdef WINDOWS
 
 #include "new_common.h"
+#include "driver/drv_uart.h"
 
 const char *dataToSimulate[] =
 {
@@ -84,7 +85,10 @@ const char *dataToSimulate[] =
 // TODO: place it better
 extern int g_bDoingUnitTestsNow;
 
+const char **g_simData = dataToSimulate;
 int g_totalStrings = sizeof(dataToSimulate) / sizeof(dataToSimulate[0]);
+// set by self tests, so data is fed even while doing unit tests
+int g_bSimDataFromTest = 0;
 
 int delay_between_packets = 20;
 int max_bytes_per_frame = 200;
@@ -92,6 +96,31 @@ int curString = 0;
 const char *curP = 0;
 int current_delay_to_wait_ms = 100;
 
+// Used by self tests to stream given hex strings to TuyaMCU UART,
+// at most bytesPerFrame at once, so packets get split between frames.
+// Pass count 0 to stop.
+void NewTuyaMCUSimulator_SetData(const char **data, int count, int bytesPerFrame) {
+	if (count <= 0) {
+		g_simData = dataToSimulate;
+		g_totalStrings = sizeof(dataToSimulate) / sizeof(dataToSimulate[0]);
+		g_bSimDataFromTest = 0;
+		max_bytes_per_frame = 200;
+	}
+	else {
+		g_simData = data;
+		g_totalStrings = count;
+		g_bSimDataFromTest = 1;
+		max_bytes_per_frame = bytesPerFrame;
+	}
+	curString = 0;
+	curP = 0;
+	current_delay_to_wait_ms = 0;
+}
+// returns true when whole data set given by test has been sent
+bool NewTuyaMCUSimulator_IsDone() {
+	return g_bSimDataFromTest == 0;
+}
+
 void NewTuyaMCUSimulator_RunQuickTick(int deltaMS) {
 	byte b;
 	int c_added = 0;
@@ -99,7 +128,7 @@ void NewTuyaMCUSimulator_RunQuickTick(int deltaMS) {
 	if (g_totalStrings <= 0) {
 		return;
 	}
-	if (g_bDoingUnitTestsNow) {
+	if (g_bDoingUnitTestsNow && g_bSimDataFromTest == 0) {
 		return;
 	}
 	if (current_delay_to_wait_ms > 0) {
@@ -107,7 +136,7 @@ void NewTuyaMCUSimulator_RunQuickTick(int deltaMS) {
 		return;
 	}
 	if (curP == 0) {
-		curP = dataToSimulate[curString];
+		curP = g_simData[curString];
 	}
 
 #if 1
@@ -140,7 +169,8 @@ void NewTuyaMCUSimulator_RunQuickTick(int deltaMS) {
 	}
 #endif
 	// make sure that buffer has free size
-	if (UART_GetDataSize() != 0) {
+	// (TuyaMCU parser keeps partial packets in buffer until they are complete)
+	if (UART_GetDataSize() + max_bytes_per_frame >= UART_GetBufferSize()) {
 		return;
 	}
 	while (*curP != 0) {
@@ -148,18 +178,23 @@ void NewTuyaMCUSimulator_RunQuickTick(int deltaMS) {
 			curP++;
 			continue;
 		}
-		c_added++;
 		if (c_added >= max_bytes_per_frame) {
 			break;
 		}
+		c_added++;
 		b = hexbyte(curP);
 		UART_AppendByteToCircularBuffer(b);
 		curP += 2;
 	}
 	if (*curP == 0) {
 		curString++;
-		if (curString >= g_totalStrings)
+		if (curString >= g_totalStrings) {
 			curString = 0;
+			// test data is sent only once
+			if (g_bSimDataFromTest) {
+				NewTuyaMCUSimulator_SetData(0, 0, 0);
+			}
+		}
 		curP = 0;
 		current_delay_to_wait_ms = delay_between_packets;
 	}
@@ -479,7 +479,7 @@ void BL_ProcessUpdate(float voltage, float current, float power)
 
                 MQTT_PublishMain_StringString(counter_mqttNames[2], msg, 0);
                 stat_updatesSent++;
-                os_free(msg);
+                cJSON_free(msg);
             }
 
             if (energyCounterMinutes != NULL)
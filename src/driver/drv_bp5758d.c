@@ -11,6 +11,7 @@
 #include "../hal/hal_pins.h"
 
 #include "drv_bp5758d.h"
+#include "drv_ledBus.h"
 
 // Some platforms have less pins than BK7231T.
 // For example, BL602 doesn't have pin number 26.
@@ -24,159 +25,90 @@ static int g_pin_clk = 0;
 static int g_pin_data = 1;
 #endif
 
-// Mapping between RGBCW to current BP5758D channels
-static byte g_channelOrder[5] = { 0, 1, 2, 3, 4 };
-
-const byte BP5758D_DELAY = 2;
 static byte g_chosenCurrent = BP5758D_14MA;
 
 // allow user to select current by index? maybe, not yet
 //static byte g_currentTable[] = { BP5758D_2MA, BP5758D_5MA, BP5758D_8MA, BP5758D_10MA, BP5758D_14MA, BP5758D_15MA, BP5758D_65MA, BP5758D_90MA };
 
-bool bIsSleeping = false; //Save sleep state of Lamp
+static void BP5758D_BuildFrame(ledBus_t *bus, const byte *values, ledBusFrame_t *frame) {
+	int i;
+	unsigned short cur_col_10[5];
+
+	for(i = 0; i < 5; i++){
+		// convert 0-255 to 0-1023
+		cur_col_10[i] = MAP(values[i], 0, 255, 0, 1023);
+	}
+
+	// If we receive 0 for all channels, we'll assume that the lightbulb is off, and activate BP5758d's sleep mode.
+	if (cur_col_10[0]==0 && cur_col_10[1]==0 && cur_col_10[2]==0 && cur_col_10[3]==0 && cur_col_10[4]==0) {
+		bus->bSleeping = 1;
+		LEDBus_Frame_Start(frame, BP5758D_ADDR_SETUP);		//Select B1: Output enable setup
+		LEDBus_Frame_Byte(frame, BP5758D_DISABLE_OUTPUTS_ALL);	//Set all outputs to OFF
+		LEDBus_Frame_Start(frame, BP5758D_ADDR_SLEEP);		//Enable sleep mode
+		return;
+	}
 
+	if(bus->bSleeping) {
+		bus->bSleeping = 0;				//No need to run it every time a val gets changed
+		LEDBus_Frame_Start(frame, BP5758D_ADDR_SETUP);		//Sleep mode gets disabled too since bits 5:6 get set to 01
+		LEDBus_Frame_Byte(frame, BP5758D_ENABLE_OUTPUTS_ALL);	//Set all outputs to ON
+	}
 
-static void BP5758D_Stop() {
-	HAL_PIN_SetOutputValue(g_pin_clk, 1);
-	usleep(BP5758D_DELAY);
-	HAL_PIN_SetOutputValue(g_pin_data, 1);
-	usleep(BP5758D_DELAY);
+	// Even though we could address changing channels only, in practice we observed that the lightbulb always sets all channels.
+	LEDBus_Frame_Start(frame, BP5758D_ADDR_OUT1_GL);
+	LEDBus_Frame_10Bit(frame, cur_col_10[0]); //Red
+	LEDBus_Frame_10Bit(frame, cur_col_10[1]); //Green
+	LEDBus_Frame_10Bit(frame, cur_col_10[2]); //Blue
+	LEDBus_Frame_10Bit(frame, cur_col_10[4]); //Cold
+	LEDBus_Frame_10Bit(frame, cur_col_10[3]); //Warm
 }
 
+static const ledBusProtocol_t g_bp5758d = {
+	"BP5758D",
+	0,
+	2,
+	{ 0, 1, 2, 3, 4 },
+	BP5758D_BuildFrame,
+};
 
-static void BP5758D_WriteByte(uint8_t value) {
-	int bit_idx;
-	bool bit;
+static ledBus_t g_bus;
 
-	for (bit_idx = 7; bit_idx >= 0; bit_idx--) {
-		bit = BIT_CHECK(value, bit_idx);
-		HAL_PIN_SetOutputValue(g_pin_data, bit);
-		usleep(BP5758D_DELAY);
-		HAL_PIN_SetOutputValue(g_pin_clk, 1);
-		usleep(BP5758D_DELAY);
-		HAL_PIN_SetOutputValue(g_pin_clk, 0);
-		usleep(BP5758D_DELAY);
-	}
-	// Wait for ACK
-	// TODO: pullup?
-	HAL_PIN_Setup_Input(g_pin_data);
-	HAL_PIN_SetOutputValue(g_pin_clk, 1);
-	usleep(BP5758D_DELAY);
-	HAL_PIN_SetOutputValue(g_pin_clk, 0);
-	usleep(BP5758D_DELAY);
-	HAL_PIN_Setup_Output(g_pin_data);
-}
+static void BP5758D_SendSetup(int bClearOutputs) {
+	ledBusFrame_t frame;
+	int i;
 
-static void BP5758D_Start(uint8_t addr) {
-	HAL_PIN_SetOutputValue(g_pin_data, 0);
-	usleep(BP5758D_DELAY);
-	HAL_PIN_SetOutputValue(g_pin_clk, 0);
-	usleep(BP5758D_DELAY);
-	BP5758D_WriteByte(addr);
+	LEDBus_Frame_Clear(&frame);
+	// For it's init sequence, BP5758D just sets all fields
+	LEDBus_Frame_Start(&frame, BP5758D_ADDR_SETUP);
+	// Output enabled: enable all outputs since we're using a RGBCW light
+	LEDBus_Frame_Byte(&frame, BP5758D_ENABLE_OUTPUTS_ALL);
+	// Set currents for OUT1-OUT5
+	for(i = 0; i < 5; i++) {
+		LEDBus_Frame_Byte(&frame, g_chosenCurrent);
+	}
+	if(bClearOutputs) {
+		// Set grayscale levels ouf all outputs to 0
+		for(i = 0; i < 10; i++) {
+			LEDBus_Frame_Byte(&frame, 0x00);
+		}
+	}
+	LEDBus_SendFrame(&g_bus, &frame);
+	// chip is awake now and might have different outputs than we think
+	g_bus.bSleeping = 0;
+	LEDBus_Invalidate(&g_bus);
 }
 
 static void BP5758D_SetCurrent(byte curVal) {
-	BP5758D_Stop();
-
-	usleep(BP5758D_DELAY);
-	
 	// here is a conversion from human-readable format to BP's format
 	g_chosenCurrent = (curVal>63) ? (curVal+34) : curVal;
 	// That assumed that user knows the strange BP notation
 	//g_chosenCurrent = curVal;
 
-    // For it's init sequence, BP5758D just sets all fields
-    BP5758D_Start(BP5758D_ADDR_SETUP);
-    // Output enabled: enable all outputs since we're using a RGBCW light
-    BP5758D_WriteByte(BP5758D_ENABLE_OUTPUTS_ALL);
-    // Set currents for OUT1-OUT5
-    BP5758D_WriteByte(g_chosenCurrent);
-    BP5758D_WriteByte(g_chosenCurrent);
-    BP5758D_WriteByte(g_chosenCurrent);
-    BP5758D_WriteByte(g_chosenCurrent);
-    BP5758D_WriteByte(g_chosenCurrent);
-    BP5758D_Stop();
-	usleep(BP5758D_DELAY);
-}
-static void BP5758D_PreInit() {
-	HAL_PIN_Setup_Output(g_pin_clk);
-	HAL_PIN_Setup_Output(g_pin_data);
-
-	BP5758D_Stop();
-
-	usleep(BP5758D_DELAY);
-
-    // For it's init sequence, BP5758D just sets all fields
-    BP5758D_Start(BP5758D_ADDR_SETUP);
-    // Output enabled: enable all outputs since we're using a RGBCW light
-    BP5758D_WriteByte(BP5758D_ENABLE_OUTPUTS_ALL);
-    // Set currents for OUT1-OUT5
-    BP5758D_WriteByte(g_chosenCurrent); //TODO: Make this configurable from webapp / console
-    BP5758D_WriteByte(g_chosenCurrent);
-    BP5758D_WriteByte(g_chosenCurrent);
-    BP5758D_WriteByte(g_chosenCurrent);
-    BP5758D_WriteByte(g_chosenCurrent);
-    // Set grayscale levels ouf all outputs to 0
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_WriteByte(0x00);
-    BP5758D_Stop();
+	BP5758D_SendSetup(0);
 }
 
-
-
 void BP5758D_Write(byte *rgbcw) {
-	int i;
-	unsigned short cur_col_10[5];
-
-	for(i = 0; i < 5; i++){
-		// convert 0-255 to 0-1023
-		//cur_col_10[i] = rgbcw[g_channelOrder[i]] * 4;
-		cur_col_10[i] = MAP(rgbcw[g_channelOrder[i]], 0, 255, 0, 1023);
-
-	}
-
-	// If we receive 0 for all channels, we'll assume that the lightbulb is off, and activate BP5758d's sleep mode.
-	if (cur_col_10[0]==0 && cur_col_10[1]==0 && cur_col_10[2]==0 && cur_col_10[3]==0 && cur_col_10[4]==0) {
-		bIsSleeping = true;
-		BP5758D_Start(BP5758D_ADDR_SETUP); 		//Select B1: Output enable setup
-		BP5758D_WriteByte(BP5758D_DISABLE_OUTPUTS_ALL); //Set all outputs to OFF
-		BP5758D_Stop(); 				//Stop transmission since we have to set Sleep mode (can probably be removed)
-		BP5758D_Start(BP5758D_ADDR_SLEEP); 		//Enable sleep mode
-		BP5758D_Stop();
-		return;
-	}
-
-	if(bIsSleeping) {
-		bIsSleeping = false;				//No need to run it every time a val gets changed
-		BP5758D_Start(BP5758D_ADDR_SETUP);		//Sleep mode gets disabled too since bits 5:6 get set to 01
-		BP5758D_WriteByte(BP5758D_ENABLE_OUTPUTS_ALL);	//Set all outputs to ON
-		BP5758D_Stop();
-	}
-
-	// Even though we could address changing channels only, in practice we observed that the lightbulb always sets all channels.
-	BP5758D_Start(BP5758D_ADDR_OUT1_GL);
-	// Brigtness values are transmitted as two bytes. The light-bulb accepts a 10-bit integer (0-1023) as an input value.
-	// The first 5bits of this input are transmitted in second byte, the second 5bits in the first byte.
-	BP5758D_WriteByte((uint8_t)(cur_col_10[0] & 0x1F));  //Red
-	BP5758D_WriteByte((uint8_t)(cur_col_10[0] >> 5));
-	BP5758D_WriteByte((uint8_t)(cur_col_10[1] & 0x1F)); //Green
-	BP5758D_WriteByte((uint8_t)(cur_col_10[1] >> 5));
-	BP5758D_WriteByte((uint8_t)(cur_col_10[2] & 0x1F)); //Blue
-	BP5758D_WriteByte((uint8_t)(cur_col_10[2] >> 5));
-	BP5758D_WriteByte((uint8_t)(cur_col_10[4] & 0x1F)); //Cold
-	BP5758D_WriteByte((uint8_t)(cur_col_10[4] >> 5));
-	BP5758D_WriteByte((uint8_t)(cur_col_10[3] & 0x1F)); //Warm
-	BP5758D_WriteByte((uint8_t)(cur_col_10[3] >> 5));
-
-	BP5758D_Stop();
+	LEDBus_WriteRGBCW(&g_bus, rgbcw);
 }
 
 // see drv_bp5758d.h for sample values
@@ -248,18 +180,18 @@ static commandResult_t BP5758D_Map(const void *context, const char *cmd, const c
 
 	if(Tokenizer_GetArgsCount()==0) {
 		ADDLOG_DEBUG(LOG_FEATURE_CMD, "BP5758D_Map current order is %i %i %i    %i %i! ",
-			(int)g_channelOrder[0],(int)g_channelOrder[1],(int)g_channelOrder[2],(int)g_channelOrder[3],(int)g_channelOrder[4]);
+			(int)g_bus.channelOrder[0],(int)g_bus.channelOrder[1],(int)g_bus.channelOrder[2],(int)g_bus.channelOrder[3],(int)g_bus.channelOrder[4]);
 		return 0;
 	}
 
-	g_channelOrder[0] = Tokenizer_GetArgIntegerRange(0, 0, 4);
-	g_channelOrder[1] = Tokenizer_GetArgIntegerRange(1, 0, 4);
-	g_channelOrder[2] = Tokenizer_GetArgIntegerRange(2, 0, 4);
-	g_channelOrder[3] = Tokenizer_GetArgIntegerRange(3, 0, 4);
-	g_channelOrder[4] = Tokenizer_GetArgIntegerRange(4, 0, 4);
+	g_bus.channelOrder[0] = Tokenizer_GetArgIntegerRange(0, 0, 4);
+	g_bus.channelOrder[1] = Tokenizer_GetArgIntegerRange(1, 0, 4);
+	g_bus.channelOrder[2] = Tokenizer_GetArgIntegerRange(2, 0, 4);
+	g_bus.channelOrder[3] = Tokenizer_GetArgIntegerRange(3, 0, 4);
+	g_bus.channelOrder[4] = Tokenizer_GetArgIntegerRange(4, 0, 4);
 
 	ADDLOG_DEBUG(LOG_FEATURE_CMD, "BP5758D_Map new order is %i %i %i    %i %i! ",
-		(int)g_channelOrder[0],(int)g_channelOrder[1],(int)g_channelOrder[2],(int)g_channelOrder[3],(int)g_channelOrder[4]);
+		(int)g_bus.channelOrder[0],(int)g_bus.channelOrder[1],(int)g_bus.channelOrder[2],(int)g_bus.channelOrder[3],(int)g_bus.channelOrder[4]);
 
 	return CMD_RES_OK;
 }
@@ -275,7 +207,8 @@ void BP5758D_Init() {
 	g_pin_clk = PIN_FindPinIndexForRole(IOR_BP5758D_CLK,g_pin_clk);
 	g_pin_data = PIN_FindPinIndexForRole(IOR_BP5758D_DAT,g_pin_data);
 
-    BP5758D_PreInit();
+	LEDBus_Init(&g_bus, &g_bp5758d, g_pin_clk, g_pin_data);
+	BP5758D_SendSetup(1);
 
 	//cmddetail:{"name":"BP5758D_RGBCW","args":"[HexColor]",
 	//cmddetail:"descr":"Don't use it. It's for direct access of BP5758D driver. You don't need it because LED driver automatically calls it, so just use led_basecolor_rgb",
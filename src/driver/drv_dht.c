@@ -56,7 +56,7 @@ void DHT_OnPinsConfigChanged() {
 		if (g_dhts) {
 			for (i = 0; i < PLATFORM_GPIO_MAX; i++) {
 				if (g_dhts[i]) {
-					free(g_dhts[i]);
+					DHT_Destroy(g_dhts[i]);
 					g_dhts[i] = 0;
 				}
 			}
@@ -78,12 +78,28 @@ void DHT_OnPinsConfigChanged() {
 		}
 		else {
 			if (g_dhts[i] != 0) {
-				free(g_dhts[i]);
+				DHT_Destroy(g_dhts[i]);
 				g_dhts[i] = 0;
 			}
 		}
 	}
 }
+dht_t *DHT_FindForPin(int pin) {
+	if (g_dhts == 0)
+		return 0;
+	return g_dhts[pin];
+}
+void DHT_RunQuickTick(int t_diff) {
+	int i;
+
+	if (g_dhts == 0)
+		return;
+	for (i = 0; i < PLATFORM_GPIO_MAX; i++) {
+		if (g_dhts[i]) {
+			DHT_Tick(g_dhts[i], t_diff);
+		}
+	}
+}
 void DHT_OnEverySecond() {
 	int i;
 
@@ -108,7 +124,7 @@ void DHT_OnEverySecond() {
 		}
 		else {
 			if (g_dhts[i] != 0) {
-				free(g_dhts[i]);
+				DHT_Destroy(g_dhts[i]);
 				g_dhts[i] = 0;
 			}
 		}
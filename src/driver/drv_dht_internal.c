@@ -82,8 +82,15 @@ void DHT_begin(dht_t *dht, uint8_t usec);
 float DHT_computeHeatIndexInternal(dht_t *dht, float temperature, float percentHumidity,
 	bool isFahrenheit);
 bool DHT_read(dht_t *dht, bool force);
+bool DHT_readBlocking(dht_t *dht);
 uint32_t DHT_expectPulse(dht_t *dht, bool level);
 
+// sensor being captured on given pin, used by ISR
+static dht_t *g_pulseTargets[PLATFORM_GPIO_MAX];
+
+// no response within that time after releasing the line means timeout
+#define DHT_CAPTURE_TIMEOUT_MS 20
+
 
 /*!
  *  @brief  Converts Celcius to Fahrenheit
@@ -101,6 +108,8 @@ float convertCtoF(float c) { return c * 1.8 + 32; }
  */
 float convertFtoC(float f) { return (f - 32) * 0.55555; }
 
+static void DHT_OnPulseEdge(int index, int level, uint32_t time);
+
 dht_t *DHT_Create(byte pin, byte type) {
 	dht_t *ret;
 
@@ -114,9 +123,26 @@ dht_t *DHT_Create(byte pin, byte type) {
 	ret->_maxcycles = 10000;
 
 	DHT_begin(ret, 55);
+	// platforms that can't timestamp edges in microseconds refuse capture,
+	// then sensor is read by blocking read from the start
+	if (HAL_PIN_AttachPulseCapture(pin, DHT_OnPulseEdge) == 0) {
+		ret->bNoPulseCapture = 1;
+	} else {
+		HAL_PIN_DetachPulseCapture(pin);
+	}
 
 	return ret;
 }
+void DHT_Destroy(dht_t *dht) {
+	if (dht->state == DHT_STATE_CAPTURE) {
+		HAL_PIN_DetachPulseCapture(dht->_pin);
+		g_pulseTargets[dht->_pin] = 0;
+	} else if (dht->state == DHT_STATE_START) {
+		// don't leave the line pulled low
+		HAL_PIN_Setup_Input_Pullup(dht->_pin);
+	}
+	free(dht);
+}
 /*!
  *  @brief  Read temperature
  *  @param  S
@@ -278,7 +304,6 @@ float DHT_computeHeatIndexInternal(dht_t *dht, float temperature, float percentH
  *	@return float value
  */
 bool DHT_read(dht_t *dht, bool force) {
-	byte *data = dht->data;
 	// Check if sensor was read less than two seconds ago and return early
 	// to use last reading.
 	uint32_t currenttime = Time_getUpTimeSeconds();
@@ -287,16 +312,124 @@ bool DHT_read(dht_t *dht, bool force) {
 	}
 	dht->_lastreadtime = currenttime;
 
-#if WINDOWS
-	dht->_lastresult = true;
+	if (dht->bNoPulseCapture) {
+		return DHT_readBlocking(dht);
+	}
+	// Non-blocking read: start signal is sent here, edges are timestamped
+	// by ISR and decoded in DHT_Tick. Until then, last result is kept.
+	if (dht->state == DHT_STATE_IDLE) {
+		HAL_PIN_Setup_Output(dht->_pin);
+		HAL_PIN_SetOutputValue(dht->_pin, false);
+		dht->stateTime = 0;
+		dht->state = DHT_STATE_START;
+	}
+	return dht->_lastresult;
+}
+
+// NOTE: ISR
+static void DHT_OnPulseEdge(int index, int level, uint32_t time) {
+	dht_t *dht = g_pulseTargets[index];
+
+	if (dht == 0 || dht->edgeCount >= DHT_MAX_EDGES)
+		return;
+	dht->edgeTimes[dht->edgeCount] = time;
+	dht->edgeLevels[dht->edgeCount] = level;
+	dht->edgeCount++;
+}
+
+int DHT_DecodePulses(const uint32_t *times, const byte *levels, int count, byte *data) {
+	int first, i;
+	uint32_t lowTime, highTime;
+
 	data[0] = data[1] = data[2] = data[3] = data[4] = 0;
-	// temp 19
-	data[2] = 19;
-	// humidity 67.8
-	data[0] = 67;
-	data[1] = 0;
-	return true;
-#endif
+	// Skip our own release edge, sensor answers with a low pulse
+	for (first = 0; first < count; first++) {
+		if (levels[first] == 0)
+			break;
+	}
+	if (count - first < DHT_RESPONSE_EDGES)
+		return DHT_DECODE_TIMEOUT;
+	// levels must alternate, otherwise an edge was lost
+	for (i = first + 1; i < first + DHT_RESPONSE_EDGES; i++) {
+		if (levels[i] == levels[i - 1])
+			return DHT_DECODE_TIMEOUT;
+	}
+	// ~80us low, ~80us high, then every bit is ~50us low and variable high.
+	// Like in the blocking read, high longer than low means 1.
+	// Unsigned subtraction copes with timer wrap.
+	for (i = 0; i < 40; ++i) {
+		int ofs = first + 2 + i * 2;
+		lowTime = times[ofs + 1] - times[ofs];
+		highTime = times[ofs + 2] - times[ofs + 1];
+		data[i / 8] <<= 1;
+		if (highTime > lowTime) {
+			data[i / 8] |= 1;
+		}
+	}
+	if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF))
+		return DHT_DECODE_CHECKSUM;
+	return DHT_DECODE_OK;
+}
+
+static void DHT_FinishCapture(dht_t *dht) {
+	byte data[5];
+	int res;
+
+	HAL_PIN_DetachPulseCapture(dht->_pin);
+	g_pulseTargets[dht->_pin] = 0;
+	dht->state = DHT_STATE_IDLE;
+	dht->statReads++;
+
+	res = DHT_DecodePulses(dht->edgeTimes, dht->edgeLevels, dht->edgeCount, data);
+	if (res == DHT_DECODE_OK) {
+		memcpy(dht->data, data, sizeof(data));
+		dht->_lastresult = true;
+		return;
+	}
+	if (res == DHT_DECODE_CHECKSUM) {
+		dht->statChecksumErrors++;
+		addLogAdv(LOG_INFO, LOG_FEATURE_DHT, "DHT pin %i checksum failure! (%i/%i reads failed checksum)",
+			(int)dht->_pin, dht->statChecksumErrors, dht->statReads);
+	} else {
+		dht->statTimeouts++;
+		addLogAdv(LOG_INFO, LOG_FEATURE_DHT, "DHT pin %i timeout, got %i edges (%i/%i reads timed out)",
+			(int)dht->_pin, (int)dht->edgeCount, dht->statTimeouts, dht->statReads);
+	}
+	dht->_lastresult = false;
+}
+
+void DHT_Tick(dht_t *dht, int t_diff) {
+	if (dht->state == DHT_STATE_IDLE)
+		return;
+	dht->stateTime += t_diff;
+	if (dht->state == DHT_STATE_START) {
+		// data sheets say at least 18ms for DHT11 and at least 1ms for others
+		if (dht->stateTime < ((dht->_type == DHT11 || dht->_type == DHT12) ? 20 : 2))
+			return;
+		dht->edgeCount = 0;
+		g_pulseTargets[dht->_pin] = dht;
+		if (HAL_PIN_AttachPulseCapture(dht->_pin, DHT_OnPulseEdge) == 0) {
+			g_pulseTargets[dht->_pin] = 0;
+			dht->bNoPulseCapture = 1;
+			dht->state = DHT_STATE_IDLE;
+			HAL_PIN_Setup_Input_Pullup(dht->_pin);
+			addLogAdv(LOG_INFO, LOG_FEATURE_DHT, "DHT pin %i can't capture pulses, using blocking read", (int)dht->_pin);
+			return;
+		}
+		dht->stateTime = 0;
+		dht->state = DHT_STATE_CAPTURE;
+		// End the start signal, sensor will answer
+		HAL_PIN_Setup_Input_Pullup(dht->_pin);
+		return;
+	}
+	if (dht->edgeCount >= DHT_RESPONSE_EDGES + 1 || dht->stateTime >= DHT_CAPTURE_TIMEOUT_MS) {
+		DHT_FinishCapture(dht);
+	}
+}
+
+bool DHT_readBlocking(dht_t *dht) {
+	byte *data = dht->data;
+
 	// Reset 40 bits of received data to zero.
 	data[0] = data[1] = data[2] = data[3] = data[4] = 0;
 
@@ -5,6 +5,20 @@
 #define DHT22 22
 #define AM2301 21
 
+// response (falling, rising, falling) and 40 bits (rising, falling), plus final release
+#define DHT_MAX_EDGES 88
+#define DHT_RESPONSE_EDGES 83
+
+#define DHT_STATE_IDLE		0
+// host keeps line low, waiting for start time to pass
+#define DHT_STATE_START		1
+// line released, ISR is collecting edge timestamps
+#define DHT_STATE_CAPTURE	2
+
+#define DHT_DECODE_OK		0
+#define DHT_DECODE_TIMEOUT	1
+#define DHT_DECODE_CHECKSUM	2
+
 typedef struct dht_s { 
 	byte data[5];
 	byte _pin, _type;
@@ -12,9 +26,27 @@ typedef struct dht_s {
 	bool _lastresult;
 	uint8_t pullTime; // Time (in usec) to pull up data line before reading
 
+	// non-blocking acquisition, used when HAL can capture pulses
+	byte state;
+	byte bNoPulseCapture;
+	// ms spent in current state
+	uint32_t stateTime;
+	volatile byte edgeCount;
+	byte edgeLevels[DHT_MAX_EDGES];
+	uint32_t edgeTimes[DHT_MAX_EDGES];
+	// statistics
+	int statReads;
+	int statChecksumErrors;
+	int statTimeouts;
 } dht_t;
 
 dht_t *DHT_Create(byte pin, byte type);
 float DHT_readHumidity(dht_t *dht, bool force);
 float DHT_readTemperature(dht_t *dht, bool S, bool force);
+// advances non-blocking acquisition, call from quick tick
+void DHT_Tick(dht_t *dht, int t_diff);
+void DHT_Destroy(dht_t *dht);
+// decodes 40 bits from edge timestamps (any monotonic timebase), returns DHT_DECODE_*
+int DHT_DecodePulses(const uint32_t *times, const byte *levels, int count, byte *data);
+dht_t *DHT_FindForPin(int pin);
 
@@ -0,0 +1,328 @@
+#include "../new_common.h"
+#include "../new_pins.h"
+#include "../logging/logging.h"
+#include "../hal/hal_pins.h"
+#include "drv_ledBus.h"
+
+void usleep(int r) //delay function do 10*r nops, because rtos_delay_milliseconds is too much
+{
+#ifdef WIN32
+	// not possible on Windows port
+#else
+  for(volatile int i=0; i<r; i++)
+    __asm__("nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop");
+#endif
+}
+
+void LEDBus_Frame_Clear(ledBusFrame_t *frame) {
+	frame->count = 0;
+	frame->size = 0;
+}
+void LEDBus_Frame_Start(ledBusFrame_t *frame, byte addr) {
+	if(frame->count >= LEDBUS_MAX_TRANSACTIONS) {
+		addLogAdv(LOG_ERROR, LOG_FEATURE_CMD, "LEDBus: too many transactions in frame");
+		return;
+	}
+	frame->lengths[frame->count] = 0;
+	frame->count++;
+	LEDBus_Frame_Byte(frame, addr);
+}
+void LEDBus_Frame_Byte(ledBusFrame_t *frame, byte b) {
+	if(frame->count == 0 || frame->size >= LEDBUS_MAX_FRAME_BYTES) {
+		addLogAdv(LOG_ERROR, LOG_FEATURE_CMD, "LEDBus: frame overflow");
+		return;
+	}
+	frame->data[frame->size++] = b;
+	frame->lengths[frame->count - 1]++;
+}
+void LEDBus_Frame_10Bit(ledBusFrame_t *frame, int value) {
+	// The chip accepts a 10-bit integer (0-1023) as an input value.
+	// The first 5bits of this input are transmitted in second byte, the second 5bits in the first byte.
+	LEDBus_Frame_Byte(frame, (byte)(value & 0x1F));
+	LEDBus_Frame_Byte(frame, (byte)(value >> 5));
+}
+int LEDBus_Frame_Equals(const ledBusFrame_t *a, const ledBusFrame_t *b) {
+	if(a->count != b->count || a->size != b->size)
+		return 0;
+	if(memcmp(a->lengths, b->lengths, a->count))
+		return 0;
+	if(memcmp(a->data, b->data, a->size))
+		return 0;
+	return 1;
+}
+
+// Generic bit-bang of START, bytes (each followed by ACK clock), STOP.
+// Lines are only touched through ops, so the same timing is used for
+// real pins and for the capture backend.
+typedef struct ledBusPinOps_s {
+	void (*setClk)(ledBus_t *bus, int level);
+	void (*setData)(ledBus_t *bus, int level);
+	// releases data line, so chip can ACK
+	void (*releaseData)(ledBus_t *bus);
+	// drives data line low again after ACK
+	void (*reclaimData)(ledBus_t *bus);
+} ledBusPinOps_t;
+
+static void LEDBus_BitBang(ledBus_t *bus, const ledBusPinOps_t *ops, const byte *data, int len) {
+	int delay = bus->protocol->delay;
+	int i, bit;
+
+	// START - data falls while clock is high
+	ops->setData(bus, 0);
+	usleep(delay);
+	ops->setClk(bus, 0);
+	usleep(delay);
+	for(i = 0; i < len; i++) {
+		for(bit = 7; bit >= 0; bit--) {
+			ops->setData(bus, BIT_CHECK(data[i], bit) ? 1 : 0);
+			usleep(delay);
+			ops->setClk(bus, 1);
+			usleep(delay);
+			ops->setClk(bus, 0);
+			usleep(delay);
+		}
+		// ACK clock, we don't check ACK, chips work fine without it
+		ops->releaseData(bus);
+		ops->setClk(bus, 1);
+		usleep(delay);
+		ops->setClk(bus, 0);
+		usleep(delay);
+		ops->reclaimData(bus);
+	}
+	// STOP - data rises while clock is high
+	ops->setData(bus, 0);
+	usleep(delay);
+	ops->setClk(bus, 1);
+	usleep(delay);
+	ops->setData(bus, 1);
+	usleep(delay);
+}
+
+// GPIO backend
+static void LEDBus_GPIO_SetLine(ledBus_t *bus, int pin, int level) {
+	if(bus->protocol->bOpenDrain) {
+		if(level) {
+			HAL_PIN_Setup_Input_Pullup(pin);
+		} else {
+			HAL_PIN_Setup_Output(pin);
+			HAL_PIN_SetOutputValue(pin, 0);
+		}
+	} else {
+		HAL_PIN_SetOutputValue(pin, level);
+	}
+}
+static void LEDBus_GPIO_SetClk(ledBus_t *bus, int level) {
+	LEDBus_GPIO_SetLine(bus, bus->pin_clk, level);
+}
+static void LEDBus_GPIO_SetData(ledBus_t *bus, int level) {
+	LEDBus_GPIO_SetLine(bus, bus->pin_data, level);
+}
+static void LEDBus_GPIO_ReleaseData(ledBus_t *bus) {
+	if(bus->protocol->bOpenDrain) {
+		HAL_PIN_Setup_Input_Pullup(bus->pin_data);
+	} else {
+		// TODO: pullup?
+		HAL_PIN_Setup_Input(bus->pin_data);
+	}
+}
+static void LEDBus_GPIO_ReclaimData(ledBus_t *bus) {
+	if(bus->protocol->bOpenDrain == 0) {
+		HAL_PIN_Setup_Output(bus->pin_data);
+	}
+	LEDBus_GPIO_SetLine(bus, bus->pin_data, 0);
+}
+static const ledBusPinOps_t g_gpioOps = {
+	LEDBus_GPIO_SetClk,
+	LEDBus_GPIO_SetData,
+	LEDBus_GPIO_ReleaseData,
+	LEDBus_GPIO_ReclaimData,
+};
+static void LEDBus_GPIO_Setup(ledBus_t *bus) {
+	if(bus->protocol->bOpenDrain) {
+		HAL_PIN_SetOutputValue(bus->pin_data, 0);
+		HAL_PIN_SetOutputValue(bus->pin_clk, 0);
+		HAL_PIN_Setup_Input_Pullup(bus->pin_data);
+		HAL_PIN_Setup_Input_Pullup(bus->pin_clk);
+	} else {
+		HAL_PIN_Setup_Output(bus->pin_clk);
+		HAL_PIN_Setup_Output(bus->pin_data);
+		HAL_PIN_SetOutputValue(bus->pin_clk, 1);
+		usleep(bus->protocol->delay);
+		HAL_PIN_SetOutputValue(bus->pin_data, 1);
+		usleep(bus->protocol->delay);
+	}
+}
+static void LEDBus_GPIO_Transaction(ledBus_t *bus, const byte *data, int len) {
+	LEDBus_BitBang(bus, &g_gpioOps, data, len);
+}
+const ledBusBackend_t g_ledBusBackend_GPIO = {
+	"GPIO",
+	LEDBus_GPIO_Setup,
+	LEDBus_GPIO_Transaction,
+};
+
+#if WINDOWS
+// Capture backend - records line changes, so tests can check the waveform
+#define LEDBUS_CAPTURE_MAX_SAMPLES 16384
+
+static byte g_capture[LEDBUS_CAPTURE_MAX_SAMPLES];
+static int g_captureCount = 0;
+static byte g_captureLines = 3;
+
+static void LEDBus_Capture_Set(byte mask, int level) {
+	byte next;
+
+	next = level ? (g_captureLines | mask) : (g_captureLines & ~mask);
+	if(next == g_captureLines)
+		return;
+	g_captureLines = next;
+	if(g_captureCount < LEDBUS_CAPTURE_MAX_SAMPLES) {
+		g_capture[g_captureCount++] = next;
+	}
+}
+static void LEDBus_Capture_SetClk(ledBus_t *bus, int level) {
+	LEDBus_Capture_Set(1, level);
+}
+static void LEDBus_Capture_SetData(ledBus_t *bus, int level) {
+	LEDBus_Capture_Set(2, level);
+}
+static void LEDBus_Capture_ReleaseData(ledBus_t *bus) {
+	// pulled up, no chip to ACK
+	LEDBus_Capture_Set(2, 1);
+}
+static void LEDBus_Capture_ReclaimData(ledBus_t *bus) {
+	LEDBus_Capture_Set(2, 0);
+}
+static const ledBusPinOps_t g_captureOps = {
+	LEDBus_Capture_SetClk,
+	LEDBus_Capture_SetData,
+	LEDBus_Capture_ReleaseData,
+	LEDBus_Capture_ReclaimData,
+};
+static void LEDBus_Capture_Setup(ledBus_t *bus) {
+	LEDBus_Capture_Set(1, 1);
+	LEDBus_Capture_Set(2, 1);
+}
+static void LEDBus_Capture_Transaction(ledBus_t *bus, const byte *data, int len) {
+	LEDBus_BitBang(bus, &g_captureOps, data, len);
+}
+const ledBusBackend_t g_ledBusBackend_Capture = {
+	"Capture",
+	LEDBus_Capture_Setup,
+	LEDBus_Capture_Transaction,
+};
+void LEDBus_Capture_Reset() {
+	g_captureCount = 0;
+}
+int LEDBus_Capture_GetSamplesCount() {
+	return g_captureCount;
+}
+int LEDBus_Capture_Decode(ledBusFrame_t *out) {
+	int i;
+	byte prev, cur;
+	int bits = 0;
+	// -1 means we are outside of transaction
+	int bitCount = -1;
+	int errors = 0;
+
+	LEDBus_Frame_Clear(out);
+	// lines are idle high before first capture
+	prev = 3;
+	for(i = 0; i < g_captureCount; i++) {
+		cur = g_capture[i];
+		if((prev & 1) && (cur & 1)) {
+			// data changed while clock is high - START or STOP
+			if(!(cur & 2)) {
+				if(bitCount != -1)
+					errors++;
+				bitCount = 0;
+				bits = 0;
+				// address byte will open new transaction
+				if(out->count >= LEDBUS_MAX_TRANSACTIONS) {
+					errors++;
+				} else {
+					out->lengths[out->count] = 0;
+					out->count++;
+				}
+			} else {
+				// STOP is preceded by single clock pulse which was counted as bit
+				if(bitCount != 1)
+					errors++;
+				bitCount = -1;
+			}
+		} else if(!(prev & 1) && (cur & 1) && bitCount >= 0) {
+			// clock rising edge, data is sampled, 9th clock is ACK
+			if(bitCount < 8) {
+				bits = (bits << 1) | ((cur & 2) ? 1 : 0);
+				bitCount++;
+			} else {
+				if(out->count == 0 || out->size >= LEDBUS_MAX_FRAME_BYTES) {
+					errors++;
+				} else {
+					out->data[out->size++] = bits;
+					out->lengths[out->count - 1]++;
+				}
+				bitCount = 0;
+				bits = 0;
+			}
+		}
+		prev = cur;
+	}
+	if(bitCount != -1)
+		errors++;
+	return errors;
+}
+#endif
+
+static const ledBusBackend_t *g_defaultBackend = &g_ledBusBackend_GPIO;
+
+void LEDBus_SetDefaultBackend(const ledBusBackend_t *backend) {
+	g_defaultBackend = backend;
+}
+void LEDBus_Init(ledBus_t *bus, const ledBusProtocol_t *protocol, int pin_clk, int pin_data) {
+	// keep mapping set by user if driver is restarted
+	if(bus->protocol != protocol) {
+		memcpy(bus->channelOrder, protocol->defaultOrder, sizeof(bus->channelOrder));
+	}
+	bus->protocol = protocol;
+	bus->backend = g_defaultBackend;
+	bus->pin_clk = pin_clk;
+	bus->pin_data = pin_data;
+	bus->bSleeping = 0;
+	bus->bLastFrameValid = 0;
+	bus->framesSent = 0;
+	bus->framesSkipped = 0;
+	bus->backend->setup(bus);
+}
+void LEDBus_SendFrame(ledBus_t *bus, const ledBusFrame_t *frame) {
+	int i;
+	int ofs = 0;
+
+	for(i = 0; i < frame->count; i++) {
+		bus->backend->transaction(bus, frame->data + ofs, frame->lengths[i]);
+		ofs += frame->lengths[i];
+	}
+}
+void LEDBus_Invalidate(ledBus_t *bus) {
+	bus->bLastFrameValid = 0;
+}
+int LEDBus_WriteRGBCW(ledBus_t *bus, const byte *rgbcw) {
+	byte values[5];
+	ledBusFrame_t frame;
+	int i;
+
+	for(i = 0; i < 5; i++) {
+		values[i] = rgbcw[bus->channelOrder[i]];
+	}
+	LEDBus_Frame_Clear(&frame);
+	bus->protocol->buildFrame(bus, values, &frame);
+	if(bus->bLastFrameValid && LEDBus_Frame_Equals(&frame, &bus->lastFrame)) {
+		bus->framesSkipped++;
+		return 0;
+	}
+	LEDBus_SendFrame(bus, &frame);
+	bus->lastFrame = frame;
+	bus->bLastFrameValid = 1;
+	bus->framesSent++;
+	return 1;
+}
@@ -0,0 +1,92 @@
+#ifndef __DRV_LEDBUS_H__
+#define __DRV_LEDBUS_H__
+
+#include "../new_common.h"
+
+// Shared engine for two-wire (I2C-like) LED drivers: BP5758D, BP1658CJ, SM2135.
+// Chip driver provides a protocol descriptor, the engine builds the whole
+// RGBCW frame at once, skips it if it's the same as last sent one
+// and emits it through a pluggable backend (GPIO bit-bang, capture for tests).
+
+#define LEDBUS_MAX_FRAME_BYTES		32
+#define LEDBUS_MAX_TRANSACTIONS		4
+
+// Frame is a list of transactions, every transaction is START, bytes, STOP.
+// First byte of transaction is the chip address.
+typedef struct ledBusFrame_s {
+	byte data[LEDBUS_MAX_FRAME_BYTES];
+	byte lengths[LEDBUS_MAX_TRANSACTIONS];
+	byte count;
+	byte size;
+} ledBusFrame_t;
+
+struct ledBus_s;
+
+typedef struct ledBusProtocol_s {
+	const char *name;
+	// lines are never driven high, only released to pull-up (SM2135)
+	byte bOpenDrain;
+	// bit-bang half period, in usleep units
+	byte delay;
+	// default mapping between RGBCW and chip outputs
+	byte defaultOrder[5];
+	// fills frame for values already remapped to chip output order
+	void (*buildFrame)(struct ledBus_s *bus, const byte *values, ledBusFrame_t *frame);
+} ledBusProtocol_t;
+
+typedef struct ledBusBackend_s {
+	const char *name;
+	// called once by LEDBus_Init, lines should end up idle (high)
+	void (*setup)(struct ledBus_s *bus);
+	// sends single transaction
+	void (*transaction)(struct ledBus_s *bus, const byte *data, int len);
+} ledBusBackend_t;
+
+typedef struct ledBus_s {
+	const ledBusProtocol_t *protocol;
+	const ledBusBackend_t *backend;
+	int pin_clk;
+	int pin_data;
+	byte channelOrder[5];
+	// chip specific state used by buildFrame
+	byte currentRGB;
+	byte currentCW;
+	byte bSleeping;
+	ledBusFrame_t lastFrame;
+	byte bLastFrameValid;
+	int framesSent;
+	int framesSkipped;
+} ledBus_t;
+
+extern const ledBusBackend_t g_ledBusBackend_GPIO;
+#if WINDOWS
+extern const ledBusBackend_t g_ledBusBackend_Capture;
+#endif
+
+// backend used by LEDBus_Init, GPIO by default
+void LEDBus_SetDefaultBackend(const ledBusBackend_t *backend);
+void LEDBus_Init(ledBus_t *bus, const ledBusProtocol_t *protocol, int pin_clk, int pin_data);
+// remaps, builds and sends frame, returns 0 if frame was skipped because nothing changed
+int LEDBus_WriteRGBCW(ledBus_t *bus, const byte *rgbcw);
+// sends frame without touching last frame cache
+void LEDBus_SendFrame(ledBus_t *bus, const ledBusFrame_t *frame);
+// next LEDBus_WriteRGBCW will be sent even if colors are the same
+void LEDBus_Invalidate(ledBus_t *bus);
+
+// frame building helpers for protocol descriptors
+void LEDBus_Frame_Clear(ledBusFrame_t *frame);
+void LEDBus_Frame_Start(ledBusFrame_t *frame, byte addr);
+void LEDBus_Frame_Byte(ledBusFrame_t *frame, byte b);
+// 10-bit value as two bytes, lower 5 bits first (BP5758D, BP1658CJ)
+void LEDBus_Frame_10Bit(ledBusFrame_t *frame, int value);
+int LEDBus_Frame_Equals(const ledBusFrame_t *a, const ledBusFrame_t *b);
+
+#if WINDOWS
+// waveform recorded by capture backend, one sample per line change, bit 0 - clk, bit 1 - data
+void LEDBus_Capture_Reset();
+int LEDBus_Capture_GetSamplesCount();
+// decodes recorded waveform back to transactions, returns number of decoding errors
+int LEDBus_Capture_Decode(ledBusFrame_t *out);
+#endif
+
+#endif /* __DRV_LEDBUS_H__ */
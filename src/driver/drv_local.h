@@ -40,6 +40,11 @@ void BP1658CJ_RunFrame();
 void BP1658CJ_OnChannelChanged(int ch, int value);
 
 void SM16703P_Init();
+void SM16703P_RunQuickTick();
+void SM16703P_Shutdown();
+void UCS1912_Init();
+void UCS1912_RunQuickTick();
+void UCS1912_Shutdown();
 
 void BL_Shared_Init();
 void BL_ProcessUpdate(float voltage, float current, float power);
@@ -13,6 +13,7 @@
 #include "../httpserver/new_http.h"
 #include "drv_public.h"
 #include "drv_ssdp.h"
+#include "../perf.h"
 
 const char* sensor_mqttNames[OBK_NUM_MEASUREMENTS] = {
 	"voltage",
@@ -60,9 +61,13 @@ typedef struct driver_s {
 	void (*stopFunc)();
 	void (*onChannelChanged)(int ch, int val);
 	bool bLoaded;
+	// filled by DRV_PrepareRegistry, case insensitive hash of name
+	unsigned int nameHash;
+	driverStats_t stats;
+	// time spent in every second and quick tick hooks
+	perfSection_t perf;
 } driver_t;
 
-
 // startDriver BL0937
 static driver_t g_drivers[] = {
 
@@ -72,14 +77,14 @@ static driver_t g_drivers[] = {
 #endif
 
 #ifdef ENABLE_BASIC_DRIVERS
-	{ "NTP",		NTP_Init,			NTP_OnEverySecond,			NTP_AppendInformationToHTTPIndexPage, NULL, NULL, NULL, false },
+	{ "NTP",		NTP_Init,			NTP_OnEverySecond,			NTP_AppendInformationToHTTPIndexPage, NTP_RunQuickTick, NTP_Stop, NULL, false },
 	{ "TESTPOWER",	Test_Power_Init,	 Test_Power_RunFrame,		BL09XX_AppendInformationToHTTPIndexPage, NULL, NULL, NULL, false },
 	{ "TESTLED",	Test_LED_Driver_Init, Test_LED_Driver_RunFrame, NULL, NULL, NULL, Test_LED_Driver_OnChannelChanged, false },
 	{ "HTTPButtons",	DRV_InitHTTPButtons, NULL, NULL, NULL, NULL, NULL, false },
 #endif
 
 #if ENABLE_I2C
-	{ "I2C",		DRV_I2C_Init,		DRV_I2C_EverySecond,		NULL, NULL, NULL, NULL, false },
+	{ "I2C",		DRV_I2C_Init,		NULL,						NULL, NULL, DRV_I2C_Shutdown, NULL, false },
 #endif
 
 #ifdef ENABLE_DRIVER_BL0942
@@ -95,10 +100,11 @@ static driver_t g_drivers[] = {
 #endif
 
 #if PLATFORM_BEKEN	
-	{ "SM16703P",	SM16703P_Init,		NULL,						NULL, NULL, NULL, NULL, false },
 	{ "IR",			DRV_IR_Init,		 NULL,						NULL, DRV_IR_RunFrame, NULL, NULL, false },
 #endif
 #if defined(PLATFORM_BEKEN) || defined(WINDOWS)	
+	{ "SM16703P",	SM16703P_Init,		NULL,						NULL, SM16703P_RunQuickTick, SM16703P_Shutdown, NULL, false },
+	{ "UCS1912",	UCS1912_Init,		NULL,						NULL, UCS1912_RunQuickTick, UCS1912_Shutdown, NULL, false },
 	{ "DDP",		DRV_DDP_Init,		NULL,						NULL, DRV_DDP_RunFrame, DRV_DDP_Shutdown, NULL, false },
 	{ "SSDP",		DRV_SSDP_Init,		DRV_SSDP_RunEverySecond,	NULL, DRV_SSDP_RunQuickTick, DRV_SSDP_Shutdown, NULL, false },
 	{ "PWMToggler",	DRV_InitPWMToggler, NULL, DRV_Toggler_AppendInformationToHTTPIndexPage, NULL, NULL, NULL, false },
@@ -113,19 +119,106 @@ static driver_t g_drivers[] = {
 
 };
 
-static const int g_numDrivers = sizeof(g_drivers) / sizeof(g_drivers[0]);
+#define DRV_TABLE_SIZE (sizeof(g_drivers) / sizeof(g_drivers[0]))
+
+static const int g_numDrivers = DRV_TABLE_SIZE;
+
+// Compact lists of loaded drivers, one per hook, so ticks don't have to
+// walk whole table checking bLoaded and NULL pointers.
+// Rebuilt by DRV_RebuildHookLists on every start/stop.
+static driver_t* g_everySecondList[DRV_TABLE_SIZE + 1];
+static driver_t* g_quickTickList[DRV_TABLE_SIZE + 1];
+static driver_t* g_channelChangedList[DRV_TABLE_SIZE + 1];
+static int g_everySecondCount = 0;
+static int g_quickTickCount = 0;
+static int g_channelChangedCount = 0;
+static bool g_bRegistryReady = false;
+
+static unsigned int DRV_HashName(const char* name) {
+	// FNV-1a, case insensitive, because driver names are compared with stricmp
+	unsigned int h = 2166136261u;
+	char c;
+
+	while (*name) {
+		c = *name;
+		if (c >= 'A' && c <= 'Z') {
+			c += 'a' - 'A';
+		}
+		h ^= (byte)c;
+		h *= 16777619u;
+		name++;
+	}
+	return h;
+}
+static void DRV_PrepareRegistry() {
+	int i;
 
-bool DRV_IsRunning(const char* name) {
+	if (g_bRegistryReady) {
+		return;
+	}
+	for (i = 0; i < g_numDrivers; i++) {
+		g_drivers[i].nameHash = DRV_HashName(g_drivers[i].name);
+	}
+	g_bRegistryReady = true;
+}
+static int DRV_FindDriver(const char* name) {
+	unsigned int hash;
 	int i;
 
+	DRV_PrepareRegistry();
+	hash = DRV_HashName(name);
 	for (i = 0; i < g_numDrivers; i++) {
-		if (g_drivers[i].bLoaded) {
-			if (!stricmp(name, g_drivers[i].name)) {
-				return true;
-			}
+		// hash is only a fast reject, name must still match
+		if (g_drivers[i].nameHash == hash && !stricmp(name, g_drivers[i].name)) {
+			return i;
 		}
 	}
-	return false;
+	return -1;
+}
+static void DRV_RebuildHookLists() {
+	int i;
+	int everySecond, quickTick, channelChanged;
+
+	everySecond = quickTick = channelChanged = 0;
+	for (i = 0; i < g_numDrivers; i++) {
+		if (g_drivers[i].bLoaded == false) {
+			continue;
+		}
+		if (g_drivers[i].onEverySecond) {
+			g_everySecondList[everySecond++] = &g_drivers[i];
+		}
+		if (g_drivers[i].runQuickTick) {
+			g_quickTickList[quickTick++] = &g_drivers[i];
+		}
+		if (g_drivers[i].onChannelChanged) {
+			g_channelChangedList[channelChanged++] = &g_drivers[i];
+		}
+	}
+	g_everySecondCount = everySecond;
+	g_quickTickCount = quickTick;
+	g_channelChangedCount = channelChanged;
+}
+
+bool DRV_IsRunning(const char* name) {
+	int i;
+
+	i = DRV_FindDriver(name);
+	if (i == -1) {
+		return false;
+	}
+	return g_drivers[i].bLoaded;
+}
+bool DRV_GetStats(const char* name, driverStats_t* out) {
+	int i;
+
+	i = DRV_FindDriver(name);
+	if (i == -1) {
+		return false;
+	}
+	*out = g_drivers[i].stats;
+	out->timeTotalMs = (int)(g_drivers[i].perf.totalUs / 1000);
+	out->timeMaxUs = g_drivers[i].perf.maxUs;
+	return true;
 }
 
 static SemaphoreHandle_t g_mutex = 0;
@@ -148,46 +241,52 @@ void DRV_Mutex_Free() {
 }
 void DRV_OnEverySecond() {
 	int i;
+	uint32_t start;
+	driver_t* drv;
 
 	if (DRV_Mutex_Take(100) == false) {
 		return;
 	}
-	for (i = 0; i < g_numDrivers; i++) {
-		if (g_drivers[i].bLoaded) {
-			if (g_drivers[i].onEverySecond != 0) {
-				g_drivers[i].onEverySecond();
-			}
-		}
+	for (i = 0; i < g_everySecondCount; i++) {
+		drv = g_everySecondList[i];
+		PERF_BEGIN(start);
+		drv->onEverySecond();
+		drv->stats.everySecondCalls++;
+		PERF_End(&drv->perf, start);
 	}
 	DRV_Mutex_Free();
 }
 void DRV_RunQuickTick() {
 	int i;
+	uint32_t start;
+	driver_t* drv;
 
+	if (g_quickTickCount == 0) {
+		return;
+	}
 	if (DRV_Mutex_Take(0) == false) {
 		return;
 	}
-	for (i = 0; i < g_numDrivers; i++) {
-		if (g_drivers[i].bLoaded) {
-			if (g_drivers[i].runQuickTick != 0) {
-				g_drivers[i].runQuickTick();
-			}
-		}
+	for (i = 0; i < g_quickTickCount; i++) {
+		drv = g_quickTickList[i];
+		PERF_BEGIN(start);
+		drv->runQuickTick();
+		drv->stats.quickTickCalls++;
+		PERF_End(&drv->perf, start);
 	}
 	DRV_Mutex_Free();
 }
 void DRV_OnChannelChanged(int channel, int iVal) {
 	int i;
+	driver_t* drv;
 
 	//if(DRV_Mutex_Take(100)==false) {
 	//	return;
 	//}
-	for (i = 0; i < g_numDrivers; i++) {
-		if (g_drivers[i].bLoaded) {
-			if (g_drivers[i].onChannelChanged != 0) {
-				g_drivers[i].onChannelChanged(channel, iVal);
-			}
-		}
+	for (i = 0; i < g_channelChangedCount; i++) {
+		drv = g_channelChangedList[i];
+		drv->onChannelChanged(channel, iVal);
+		drv->stats.channelChangedCalls++;
 	}
 	//DRV_Mutex_Free();
 }
@@ -206,20 +305,18 @@ void DRV_StopDriver(const char* name) {
 	if (DRV_Mutex_Take(100) == false) {
 		return;
 	}
-	for (i = 0; i < g_numDrivers; i++) {
-		if (!stricmp(g_drivers[i].name, name)) {
-			if (g_drivers[i].bLoaded) {
-				if (g_drivers[i].stopFunc != 0) {
-					g_drivers[i].stopFunc();
-				}
-				g_drivers[i].bLoaded = false;
-				addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Drv %s has been stopped.\n", name);
-				break;
-			}
-			else {
-				addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Drv %s is not running.\n", name);
-				break;
+	i = DRV_FindDriver(name);
+	if (i != -1) {
+		if (g_drivers[i].bLoaded) {
+			if (g_drivers[i].stopFunc != 0) {
+				g_drivers[i].stopFunc();
 			}
+			g_drivers[i].bLoaded = false;
+			DRV_RebuildHookLists();
+			addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Drv %s has been stopped.\n", name);
+		}
+		else {
+			addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Drv %s is not running.\n", name);
 		}
 	}
 	DRV_Mutex_Free();
@@ -232,22 +329,21 @@ void DRV_StartDriver(const char* name) {
 		return;
 	}
 	bStarted = 0;
-	for (i = 0; i < g_numDrivers; i++) {
-		if (!stricmp(g_drivers[i].name, name)) {
-			if (g_drivers[i].bLoaded) {
-				addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Drv %s is already loaded.\n", name);
-				bStarted = 1;
-				break;
-
-			}
-			else {
-				g_drivers[i].initFunc();
-				g_drivers[i].bLoaded = true;
-				addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Started %s.\n", name);
-				bStarted = 1;
-				break;
-			}
+	i = DRV_FindDriver(name);
+	if (i != -1) {
+		if (g_drivers[i].bLoaded) {
+			addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Drv %s is already loaded.\n", name);
 		}
+		else {
+			g_drivers[i].initFunc();
+			g_drivers[i].bLoaded = true;
+			memset(&g_drivers[i].stats, 0, sizeof(g_drivers[i].stats));
+			PERF_ResetSection(&g_drivers[i].perf);
+			PERF_Register(&g_drivers[i].perf, g_drivers[i].name);
+			DRV_RebuildHookLists();
+			addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Started %s.\n", name);
+		}
+		bStarted = 1;
 	}
 	if (!bStarted) {
 		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Driver %s is not known in this build.\n", name);
@@ -288,6 +384,28 @@ static commandResult_t DRV_Stop(const void* context, const char* cmd, const char
 	DRV_StopDriver(Tokenizer_GetArg(0));
 	return CMD_RES_OK;
 }
+static commandResult_t DRV_Stats(const void* context, const char* cmd, const char* args, int cmdFlags) {
+	int i;
+	driverStats_t st;
+
+	for (i = 0; i < g_numDrivers; i++) {
+		if (g_drivers[i].bLoaded == false) {
+			continue;
+		}
+		DRV_GetStats(g_drivers[i].name, &st);
+		if (HAL_HasTimeUs() == 0) {
+			addLogAdv(LOG_INFO, LOG_FEATURE_CMD, "%s: %i secs, %i ticks, %i ch changes, time unsupported\n",
+				g_drivers[i].name, st.everySecondCalls, st.quickTickCalls, st.channelChangedCalls);
+			continue;
+		}
+		addLogAdv(LOG_INFO, LOG_FEATURE_CMD, "%s: %i secs, %i ticks, %i ch changes, total %i ms, max %i us\n",
+			g_drivers[i].name, st.everySecondCalls, st.quickTickCalls, st.channelChangedCalls,
+			st.timeTotalMs, st.timeMaxUs);
+	}
+	addLogAdv(LOG_INFO, LOG_FEATURE_CMD, "Hooks: %i every second, %i quick tick, %i channel change\n",
+		g_everySecondCount, g_quickTickCount, g_channelChangedCount);
+	return CMD_RES_OK;
+}
 
 void DRV_Generic_Init() {
 	//cmddetail:{"name":"startDriver","args":"[DriverName]",
@@ -300,6 +418,11 @@ void DRV_Generic_Init() {
 	//cmddetail:"fn":"DRV_Stop","file":"driver/drv_main.c","requires":"",
 	//cmddetail:"examples":""}
 	CMD_RegisterCommand("stopDriver", "", DRV_Stop, NULL, NULL);
+	//cmddetail:{"name":"driverStats","args":"",
+	//cmddetail:"descr":"Prints call counts and time spent for every running driver",
+	//cmddetail:"fn":"DRV_Stats","file":"driver/drv_main.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("driverStats", "", DRV_Stats, NULL, NULL);
 }
 void DRV_AppendInformationToHTTPIndexPage(http_request_t* request) {
 	int i, j;
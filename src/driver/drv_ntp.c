@@ -11,6 +11,7 @@
 #include "../httpserver/new_http.h"
 #include "../logging/logging.h"
 #include "../ota/ota.h"
+#include "../hal/hal_generic.h"
 
 #include "drv_ntp.h"
 
@@ -46,23 +47,115 @@ typedef struct
 
 } ntp_packet;              // Total: 384 bits or 48 bytes.
 
-#define MAKE_WORD(hi, lo) hi << 8 | lo
-
 // NTP time since 1900 to unix time (since 1970)
 // Number of seconds to ad
-#define NTP_OFFSET 2208988800L
+#define NTP_OFFSET 2208988800LL
+#define NTP_PORT 123
+
+// Each poll is a burst of requests. Sample with shortest round trip is used,
+// because its offset is least disturbed by queuing on the way.
+#define NTP_BURST_SAMPLES 4
+// in ms, how long to wait for each reply
+#define NTP_REPLY_TIMEOUT 1500
+// in seconds, poll interval is doubled while clock keeps up and halved when it does not
+#define NTP_MIN_POLL 64
+#define NTP_MAX_POLL 1024
+// in us, bigger offsets are stepped, smaller ones are slewed
+#define NTP_STEP_THRESHOLD 128000
+// in us, clock that has drifted less than that since last poll is stable
+#define NTP_STABLE_THRESHOLD 4000
+// in ppb, rate at which offset is slewed, and limit of drift correction
+#define NTP_MAX_SLEW 500000
+#define NTP_MAX_DRIFT 500000
+// clock corrections are accumulated in ms * ppb, which is 1/1000000 of us
+#define NTP_FRAC_PER_US 1000000LL
 
 static int g_ntp_socket = 0;
 static struct sockaddr_in g_address;
 static int adrLen;
-// in seconds, before next retry
+// in seconds, before next poll
 static int g_ntp_delay = 5;
-// current time
-static unsigned int g_time;
+// in seconds, without jitter
+static int g_pollInterval = NTP_MIN_POLL;
 static bool g_synced;
 // time offset (time zone?) in seconds
 static int g_timeOffsetSeconds;
 
+// UTC time in us since 1970, valid at g_clockTick (HAL_GetTimeMs).
+// It's advanced by tick counter, corrected by drift and by slew in progress.
+static long long g_clockUs;
+static unsigned int g_clockTick;
+// part of correction below 1 us, in 1/NTP_FRAC_PER_US of us
+static long long g_clockFrac;
+// tick counter frequency error, in ppb, positive when it runs slow
+static int g_driftPpb;
+// offset not slewed yet, in 1/NTP_FRAC_PER_US of us
+static long long g_slewLeft;
+
+// burst in progress
+static int g_burstSent;
+static bool g_bWaitingForReply;
+static unsigned int g_requestTick;
+// our time when request was sent, also sent as its transmit time,
+// server echoes it back as origin, so stale replies can be told apart
+static long long g_requestT1;
+static uint32_t g_requestTag_s;
+static uint32_t g_requestTag_f;
+// -1 if there is no sample yet
+static long long g_bestDelay;
+static long long g_bestOffset;
+
+// last sample that was applied, in us
+static long long g_lastOffset;
+static long long g_lastDelay;
+static unsigned int g_lastSyncTick;
+
+static long long NTP_Abs(long long x) {
+	return x < 0 ? -x : x;
+}
+static void NTP_UpdateClock() {
+	unsigned int now, elapsed;
+	long long corr, slew;
+
+	now = HAL_GetTimeMs();
+	elapsed = now - g_clockTick;
+	if (elapsed == 0)
+		return;
+	g_clockTick = now;
+	corr = (long long)elapsed * g_driftPpb + g_clockFrac;
+	if (g_slewLeft != 0) {
+		slew = (long long)elapsed * NTP_MAX_SLEW;
+		if (slew > NTP_Abs(g_slewLeft))
+			slew = NTP_Abs(g_slewLeft);
+		if (g_slewLeft < 0)
+			slew = -slew;
+		g_slewLeft -= slew;
+		corr += slew;
+	}
+	g_clockUs += (long long)elapsed * 1000 + corr / NTP_FRAC_PER_US;
+	g_clockFrac = corr % NTP_FRAC_PER_US;
+}
+// UTC, in us since 1970
+static long long NTP_GetTimeUs() {
+	NTP_UpdateClock();
+	return g_clockUs;
+}
+// NTP timestamp (seconds since 1900 and 32 bit fraction) to unix time in us
+static long long NTP_ToUnixUs(uint32_t sec, uint32_t frac) {
+	long long s = sec;
+
+	// era 1 starts in 2036
+	if (s < NTP_OFFSET)
+		s += 0x100000000LL;
+	return (s - NTP_OFFSET) * 1000000 + (((long long)frac * 1000000) >> 32);
+}
+// us with sign, as seconds with 6 decimal digits
+static const char *NTP_FormatUs(char *buf, long long us) {
+	sprintf(buf, "%s%u.%06u", us < 0 ? "-" : "",
+		(unsigned int)(NTP_Abs(us) / 1000000), (unsigned int)(NTP_Abs(us) % 1000000));
+	return buf;
+}
+
 int NTP_GetTimesZoneOfsSeconds()
 {
     return g_timeOffsetSeconds;
@@ -89,7 +182,7 @@ commandResult_t NTP_SetTimeZoneOfs(const void *context, const char *cmd, const c
 	else {
 		g_timeOffsetSeconds = Tokenizer_GetArgInteger(0) * 60 * 60;
 	}
-    addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"NTP offset set, wait for next ntp packet to apply changes\n");
+    addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"NTP offset set to %i seconds\n", g_timeOffsetSeconds);
     return CMD_RES_OK;
 }
 
@@ -111,10 +204,37 @@ commandResult_t NTP_SetServer(const void *context, const char *cmd, const char *
 
 //Display settings used by the NTP driver
 commandResult_t NTP_Info(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	char offsetStr[24];
+	char delayStr[24];
+
     addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Server=%s, Time offset=%d\n", CFG_GetNTPServer(), g_timeOffsetSeconds);
+	addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Synced=%i, last offset=%ss, round trip=%ss, drift=%i ppb, poll=%is, next in %is\n",
+		g_synced, NTP_FormatUs(offsetStr, g_lastOffset), NTP_FormatUs(delayStr, g_lastDelay),
+		g_driftPpb, g_pollInterval, g_ntp_delay);
     return CMD_RES_OK;
 }
 
+//Set time by hand, for devices that can't reach server
+commandResult_t NTP_SetTime(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	Tokenizer_TokenizeString(args, 0);
+	if (Tokenizer_GetArgsCount() < 1) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "ntp_setTime: requires UTC unix time\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	NTP_UpdateClock();
+	g_clockUs = (long long)strtoul(Tokenizer_GetArg(0), 0, 10) * 1000000;
+	g_slewLeft = 0;
+	g_synced = true;
+	addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Time set to %u\n", NTP_GetCurrentTimeWithoutOffset());
+	return CMD_RES_OK;
+}
+
+//Poll server now
+commandResult_t NTP_Sync(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	g_ntp_delay = 0;
+	return CMD_RES_OK;
+}
+
 void NTP_Init() {
 
 	//cmddetail:{"name":"ntp_timeZoneOfs","args":"[Value]",
@@ -123,28 +243,59 @@ void NTP_Init() {
 	//cmddetail:"examples":""}
     CMD_RegisterCommand("ntp_timeZoneOfs","",NTP_SetTimeZoneOfs, NULL, NULL);
 	//cmddetail:{"name":"ntp_setServer","args":"[ServerIP]",
-	//cmddetail:"descr":"Sets the NTP server",
+	//cmddetail:"descr":"Sets the NTP server. Port other than 123 can be given as IP:port",
 	//cmddetail:"fn":"NTP_SetServer","file":"driver/drv_ntp.c","requires":"",
 	//cmddetail:"examples":""}
     CMD_RegisterCommand("ntp_setServer", "", NTP_SetServer, NULL, NULL);
 	//cmddetail:{"name":"ntp_info","args":"",
-	//cmddetail:"descr":"Display NTP related settings",
+	//cmddetail:"descr":"Display NTP related settings, last measured offset and round trip, clock drift and poll interval",
 	//cmddetail:"fn":"NTP_Info","file":"driver/drv_ntp.c","requires":"",
 	//cmddetail:"examples":""}
     CMD_RegisterCommand("ntp_info", "", NTP_Info, NULL, NULL);
+	//cmddetail:{"name":"ntp_sync","args":"",
+	//cmddetail:"descr":"Polls NTP server now, without waiting for poll interval",
+	//cmddetail:"fn":"NTP_Sync","file":"driver/drv_ntp.c","requires":"",
+	//cmddetail:"examples":""}
+    CMD_RegisterCommand("ntp_sync", "", NTP_Sync, NULL, NULL);
+	//cmddetail:{"name":"ntp_setTime","args":"[UnixTimeUTC]",
+	//cmddetail:"descr":"Sets time by hand, for devices with no access to NTP server. Next successful poll overrides it.",
+	//cmddetail:"fn":"NTP_SetTime","file":"driver/drv_ntp.c","requires":"",
+	//cmddetail:"examples":"ntp_setTime 1700000000"}
+    CMD_RegisterCommand("ntp_setTime", "", NTP_SetTime, NULL, NULL);
 
     addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "NTP driver initialized with server=%s, offset=%d\n", CFG_GetNTPServer(), g_timeOffsetSeconds);
     g_synced = false;
+	g_clockUs = 0;
+	g_clockFrac = 0;
+	g_clockTick = HAL_GetTimeMs();
+	g_driftPpb = 0;
+	g_slewLeft = 0;
+	g_lastOffset = 0;
+	g_lastDelay = 0;
+	g_pollInterval = NTP_MIN_POLL;
+	g_ntp_delay = 5;
+
+	ClockEvents_Init();
 }
 
 unsigned int NTP_GetCurrentTime() {
-    return g_time;
+    return NTP_GetTimeUs() / 1000000 + g_timeOffsetSeconds;
 }
 unsigned int NTP_GetCurrentTimeWithoutOffset() {
-	return g_time - g_timeOffsetSeconds;
+	return NTP_GetTimeUs() / 1000000;
+}
+long long NTP_GetCurrentTimeMs() {
+	return NTP_GetTimeUs() / 1000 + g_timeOffsetSeconds * 1000LL;
+}
+long long NTP_GetCurrentTimeMsWithoutOffset() {
+	return NTP_GetTimeUs() / 1000;
+}
+int NTP_GetDriftPpb() {
+	return g_driftPpb;
+}
+int NTP_GetPollInterval() {
+	return g_pollInterval;
 }
-
-
 
 void NTP_Shutdown() {
     if(g_ntp_socket != 0) {
@@ -155,17 +306,57 @@ void NTP_Shutdown() {
 #endif
     }
     g_ntp_socket = 0;
-    // can attempt in next 10 seconds
+	g_bWaitingForReply = false;
+    // can attempt in next 60 seconds
     g_ntp_delay = 60;
 }
-void NTP_SendRequest(bool bBlocking) {
-    byte *ptr;
-	const char *adrString;
-    //int i, recv_len;
-    //char buf[64];
-    ntp_packet packet = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static bool NTP_OpenSocket() {
+	char adrString[64];
+	char *port;
+#if WINDOWS
+	u_long nonBlocking = 1;
+#endif
 
+    //create a UDP socket
+    if ((g_ntp_socket=socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP )) == -1)
+    {
+        g_ntp_socket = 0;
+        addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"NTP_OpenSocket: failed to create socket");
+        return false;
+    }
+    // https://github.com/tuya/tuya-iotos-embeded-sdk-wifi-ble-bk7231t/blob/5e28e1f9a1a9d88425f3fd4b658e895a8ee7b83b/platforms/bk7231t/tuya_os_adapter/src/system/tuya_hal_network.c
+    //
+#if WINDOWS
+	if (ioctlsocket(g_ntp_socket, FIONBIO, &nonBlocking)) {
+#else
+	if (fcntl(g_ntp_socket, F_SETFL, O_NONBLOCK)) {
+#endif
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"NTP_OpenSocket: failed to make socket non-blocking!\n");
+	}
+
+	if (CFG_GetNTPServer() == 0 || CFG_GetNTPServer()[0] == 0) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "NTP_OpenSocket: somehow ntp server in config was empty, setting non-empty");
+		CFG_SetNTPServer(DEFAULT_NTP_SERVER);
+	}
+	strcpy_safe(adrString, CFG_GetNTPServer(), sizeof(adrString));
+	port = strchr(adrString, ':');
+	if (port) {
+		*port = 0;
+		port++;
+	}
+
+    memset((char *) &g_address, 0, sizeof(g_address));
     adrLen = sizeof(g_address);
+    g_address.sin_family = AF_INET;
+    g_address.sin_addr.s_addr = inet_addr(adrString);
+    g_address.sin_port = htons(port ? atoi(port) : NTP_PORT);
+	return true;
+}
+static void NTP_SendRequest() {
+    byte *ptr;
+	long long t1;
+    ntp_packet packet;
+
     memset( &packet, 0, sizeof( ntp_packet ) );
     ptr = (byte*)&packet;
     // Initialize values needed to form NTP request
@@ -180,28 +371,11 @@ void NTP_SendRequest(bool bBlocking) {
     ptr[14]  = 49;
     ptr[15]  = 52;
 
-
-    //create a UDP socket
-    if ((g_ntp_socket=socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP )) == -1)
-    {
-        g_ntp_socket = 0;
-        addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"NTP_SendRequest: failed to create socket");
-        return;
-    }
-
-    memset((char *) &g_address, 0, sizeof(g_address));
-
-	adrString = CFG_GetNTPServer();
-	if (adrString == 0 || adrString[0] == 0) {
-		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "NTP_SendRequest: somehow ntp server in config was empty, setting non-empty");
-		CFG_SetNTPServer(DEFAULT_NTP_SERVER);
-		adrString = CFG_GetNTPServer();
-	}
-
-    g_address.sin_family = AF_INET;
-    g_address.sin_addr.s_addr = inet_addr(adrString);
-    g_address.sin_port = htons(123);
-
+	t1 = NTP_GetTimeUs();
+	g_requestTag_s = htonl((uint32_t)(t1 / 1000000 + NTP_OFFSET));
+	g_requestTag_f = htonl((uint32_t)(((t1 % 1000000) << 32) / 1000000));
+	packet.txTm_s = g_requestTag_s;
+	packet.txTm_f = g_requestTag_f;
 
     // Send the message to server:
     if(sendto(g_ntp_socket, &packet, sizeof(packet), 0,
@@ -210,87 +384,133 @@ void NTP_SendRequest(bool bBlocking) {
         NTP_Shutdown();
         return;
     }
-
-    // https://github.com/tuya/tuya-iotos-embeded-sdk-wifi-ble-bk7231t/blob/5e28e1f9a1a9d88425f3fd4b658e895a8ee7b83b/platforms/bk7231t/tuya_os_adapter/src/system/tuya_hal_network.c
-    //
-    if(bBlocking == false) {
-#if WINDOWS
-#else
-        if(fcntl(g_ntp_socket, F_SETFL, O_NONBLOCK)) {
-            addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"NTP_SendRequest: failed to make socket non-blocking!\n");
-        }
-#endif
-    }
-
-    // can attempt in next 10 seconds
-    g_ntp_delay = 10;
+	g_requestT1 = t1;
+	g_requestTick = HAL_GetTimeMs();
+	g_bWaitingForReply = true;
+	g_burstSent++;
 }
-void NTP_CheckForReceive() {
-    byte *ptr;
-    int i, recv_len;
-    //struct tm * ptm;
-    unsigned short highWord;
-    unsigned short lowWord;
-    unsigned int secsSince1900;
-    struct tm *ltm;
-    ntp_packet packet = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-    ptr = (byte*)&packet;
+static void NTP_ApplySample(long long offset, long long delay) {
+	char offsetStr[24];
+	unsigned int interval;
+	long long err;
+	time_t localTime;
+	struct tm *ltm;
+
+	NTP_UpdateClock();
+	if (g_synced == false || NTP_Abs(offset) > NTP_STEP_THRESHOLD) {
+		// too far to slew, jump there
+		g_clockUs += offset;
+		g_slewLeft = 0;
+		g_pollInterval = NTP_MIN_POLL;
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Clock stepped by %ss\n", NTP_FormatUs(offsetStr, offset));
+	}
+	else {
+		// part of offset is what was not slewed yet, rest has built up
+		// since last poll, because tick counter runs too fast or too slow
+		err = offset - g_slewLeft / NTP_FRAC_PER_US;
+		interval = g_clockTick - g_lastSyncTick;
+		// forced polls come too soon for that, offset measured would be mostly noise
+		if (interval >= NTP_MIN_POLL * 1000 / 2) {
+			// only half of it, so single noisy sample does not swing it much
+			g_driftPpb += (int)(err * 1000000 / interval / 2);
+			if (g_driftPpb > NTP_MAX_DRIFT)
+				g_driftPpb = NTP_MAX_DRIFT;
+			if (g_driftPpb < -NTP_MAX_DRIFT)
+				g_driftPpb = -NTP_MAX_DRIFT;
+		}
+		g_slewLeft = offset * NTP_FRAC_PER_US;
+		if (NTP_Abs(err) < NTP_STABLE_THRESHOLD) {
+			if (g_pollInterval < NTP_MAX_POLL)
+				g_pollInterval *= 2;
+		}
+		else if (g_pollInterval > NTP_MIN_POLL) {
+			g_pollInterval /= 2;
+		}
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Slewing by %ss, drift %i ppb\n", NTP_FormatUs(offsetStr, offset), g_driftPpb);
+	}
+	g_lastOffset = offset;
+	g_lastDelay = delay;
+	g_lastSyncTick = g_clockTick;
+	g_synced = true;
+	// +-1/8 of interval, so devices powered on together do not keep polling together
+	g_ntp_delay = g_pollInterval - g_pollInterval / 8 + rand() % (g_pollInterval / 4 + 1);
+
+	localTime = (time_t)NTP_GetCurrentTime();
+	ltm = localtime(&localTime);
+	addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"Local Time : %04d/%02d/%02d %02d:%02d:%02d, next poll in %is\n",
+		ltm->tm_year+1900, ltm->tm_mon+1, ltm->tm_mday, ltm->tm_hour, ltm->tm_min, ltm->tm_sec, g_ntp_delay);
+}
+// sends next request of burst, or uses best sample when burst is done
+static void NTP_NextSample() {
+	if (g_burstSent < NTP_BURST_SAMPLES) {
+		NTP_SendRequest();
+		return;
+	}
+	NTP_Shutdown();
+	if (g_bestDelay < 0) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "No reply from %s\n", CFG_GetNTPServer());
+		return;
+	}
+	NTP_ApplySample(g_bestOffset, g_bestDelay);
+}
+static void NTP_StartBurst() {
+	if (NTP_OpenSocket() == false) {
+		// try again later
+		g_ntp_delay = 60;
+		return;
+	}
+	g_burstSent = 0;
+	g_bestDelay = -1;
+	NTP_SendRequest();
+}
+static void NTP_CheckForReceive() {
+    int recv_len;
+	long long t2, t3, t4, offset, delay;
+	char offsetStr[24];
+	char delayStr[24];
+    ntp_packet packet;
 
     // Receive the server's response:
-    i = sizeof(packet);
-#if 0
-    recv_len = recvfrom(g_ntp_socket, ptr, i, 0,
-         (struct sockaddr*)&g_address, &adrLen);
-#else
-    recv_len = recv(g_ntp_socket, ptr, i, 0);
-#endif
-
-    if(recv_len < 0){
-        addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"NTP_CheckForReceive: Error while receiving server's msg\n");
+    recv_len = recv(g_ntp_socket, (char*)&packet, sizeof(packet), 0);
+    if(recv_len < (int)sizeof(packet)){
+		// nothing yet
         return;
     }
-    highWord = MAKE_WORD(ptr[40], ptr[41]);
-    lowWord = MAKE_WORD(ptr[42], ptr[43]);
-    // combine the four bytes (two words) into a long integer
-    // this is NTP time (seconds since Jan 1 1900):
-    secsSince1900 = highWord << 16 | lowWord;
-    addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"Seconds since Jan 1 1900 = %u\n",secsSince1900);
-
-    g_time = secsSince1900 - NTP_OFFSET;
-    g_time += g_timeOffsetSeconds;
-    addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"Unix time  : %u\n",g_time);
-    ltm = localtime((time_t*)&g_time);
-    addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"Local Time : %04d/%02d/%02d %02d:%02d:%02d\n",
-            ltm->tm_year+1900, ltm->tm_mon+1, ltm->tm_mday, ltm->tm_hour, ltm->tm_min, ltm->tm_sec);
-    g_synced = true;
-#if 0
-    //ptm = localtime (&g_time);
-    ptm = gmtime(&g_time);
-    if(ptm == 0) {
-        addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"gmtime somehow returned 0\n");
-    } else {
-        addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"gmtime => tm_year: %i\n",ptm->tm_year);
-        addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"gmtime => tm_mon: %i\n",ptm->tm_mon);
-        addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"gmtime => tm_mday: %i\n",ptm->tm_mday);
-        addLogAdv(LOG_INFO, LOG_FEATURE_NTP,"gmtime => tm_hour: %i\n",ptm->tm_hour  );
-    }
-#endif
-    NTP_Shutdown();
-
-}
-
-void NTP_SendRequest_BlockingMode() {
-    NTP_Shutdown();
-    NTP_SendRequest(true);
-    NTP_CheckForReceive();
-
+	t4 = NTP_GetTimeUs();
+	if (packet.origTm_s != g_requestTag_s || packet.origTm_f != g_requestTag_f) {
+		addLogAdv(LOG_DEBUG, LOG_FEATURE_NTP, "NTP_CheckForReceive: reply is not for last request, ignored\n");
+		return;
+	}
+	g_bWaitingForReply = false;
+	// server mode, alarm leap indicator (not synced) or stratum 0 (kiss of death)
+	if ((packet.li_vn_mode & 7) != 4 || (packet.li_vn_mode >> 6) == 3 || packet.stratum == 0) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "NTP_CheckForReceive: server is not synced, sample ignored\n");
+		NTP_NextSample();
+		return;
+	}
+	t2 = NTP_ToUnixUs(ntohl(packet.rxTm_s), ntohl(packet.rxTm_f));
+	t3 = NTP_ToUnixUs(ntohl(packet.txTm_s), ntohl(packet.txTm_f));
+	// time spent on the way there and back is assumed to be the same
+	offset = ((t2 - g_requestT1) + (t3 - t4)) / 2;
+	delay = (t4 - g_requestT1) - (t3 - t2);
+	if (delay < 0)
+		delay = 0;
+	addLogAdv(LOG_DEBUG, LOG_FEATURE_NTP, "Sample %i: offset %ss, round trip %ss\n", g_burstSent,
+		NTP_FormatUs(offsetStr, offset), NTP_FormatUs(delayStr, delay));
+	if (g_bestDelay < 0 || delay < g_bestDelay) {
+		g_bestDelay = delay;
+		g_bestOffset = offset;
+	}
+	NTP_NextSample();
 }
 
-
 void NTP_OnEverySecond()
 {
-    g_time++;
-
+	// clock runs on its own once it's set, with or without WiFi
+	if (g_synced) {
+		ClockEvents_RunEverySecond(NTP_GetCurrentTimeWithoutOffset());
+	}
+	ClockEvents_SaveChanges(false);
     if(Main_IsConnectedToWiFi()==0)
     {
         return;
@@ -305,31 +525,41 @@ void NTP_OnEverySecond()
         return;
     }
 #endif
-    if(g_ntp_socket == 0) {
-        // if no socket, this is a reconnect delay
-        if(g_ntp_delay > 0) {
-            g_ntp_delay--;
-            return;
-        }
-        NTP_SendRequest(false);
-    } else {
-        NTP_CheckForReceive();
-        // if socket exists, this is a disconnect timeout
-        if(g_ntp_delay > 0) {
-            g_ntp_delay--;
-            if(g_ntp_delay<=0) {
-                // disconnect and force reconnect
-                NTP_Shutdown();
-            }
-        }
+    if(g_ntp_socket != 0) {
+		// burst in progress, it's handled in quick tick
+		return;
+	}
+    if(g_ntp_delay > 0) {
+        g_ntp_delay--;
+        return;
     }
+	NTP_StartBurst();
+}
+// reply time is taken here, so it's accurate to the quick tick period
+void NTP_RunQuickTick()
+{
+	if (g_ntp_socket == 0 || g_bWaitingForReply == false) {
+		return;
+	}
+	NTP_CheckForReceive();
+	if (g_bWaitingForReply && HAL_GetTimeMs() - g_requestTick > NTP_REPLY_TIMEOUT) {
+		g_bWaitingForReply = false;
+		NTP_NextSample();
+	}
+}
+void NTP_Stop()
+{
+	NTP_Shutdown();
+	ClockEvents_Shutdown();
 }
 
 void NTP_AppendInformationToHTTPIndexPage(http_request_t* request)
 {
     struct tm *ltm;
+	time_t localTime;
 
-    ltm = localtime((time_t*)&g_time);
+	localTime = (time_t)NTP_GetCurrentTime();
+    ltm = localtime(&localTime);
 
     if (g_synced == true)
         hprintf255(request, "<h5>NTP (%s): Local Time: %04d/%02d/%02d %02d:%02d:%02d </h5>",
@@ -342,4 +572,3 @@ bool NTP_IsTimeSynced()
 {
     return g_synced;
 }
-
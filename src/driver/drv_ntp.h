@@ -5,9 +5,29 @@
 
 void NTP_Init();
 void NTP_OnEverySecond();
+void NTP_RunQuickTick();
+void NTP_Stop();
 // returns number of seconds passed after 1900
 unsigned int NTP_GetCurrentTime();
 unsigned int NTP_GetCurrentTimeWithoutOffset();
+// same, in milliseconds
+long long NTP_GetCurrentTimeMs();
+long long NTP_GetCurrentTimeMsWithoutOffset();
+// estimated tick counter frequency error, in ppb, positive when it runs slow
+int NTP_GetDriftPpb();
+// in seconds, without jitter
+int NTP_GetPollInterval();
+
+// clock and cron events, see drv_ntp_events.c
+void ClockEvents_Init();
+// called every second while time is known, with UTC time
+void ClockEvents_RunEverySecond(unsigned int now);
+void ClockEvents_Shutdown();
+// writes changed events and time of last run, which is rate limited unless forced
+void ClockEvents_SaveChanges(bool bForce);
+// UTC time of next run of event, 0 if there is none
+unsigned int ClockEvents_GetNextRun(int id);
+int ClockEvents_GetCount();
 void NTP_AppendInformationToHTTPIndexPage(http_request_t* request);
 bool NTP_IsTimeSynced();
 int NTP_GetTimesZoneOfsSeconds();
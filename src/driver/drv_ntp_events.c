@@ -0,0 +1,882 @@
+// Clock events - commands run at given local time, scheduled by NTP driver.
+// Kinds of them:
+// - time of day on selected week days:	addClockEvent 07:30 Mon-Fri 1 POWER ON
+// - sunrise or sunset, +- minutes:		addClockEvent sunset-15 * 2 POWER ON
+// - cron style:							addCronEvent 3 */15 8-18 * * 1-5 toggleChannel 1
+// Next run (UTC) of every event is kept in binary heap, so each second only
+// the earliest one is compared with current time, and event that has run
+// costs O(log n) to reschedule. Events are saved to LittleFS, a second after
+// last change, so a script adding many of them writes flash once. Time of last
+// run is kept in separate file, so missed runs can be done after reboot, if
+// event asks for it. It is written at most once per CLOCK_LASTRUN_SAVE_INTERVAL
+// (and on clock step or driver stop), so after power loss runs from that last
+// interval may be caught up again.
+
+#include "../new_common.h"
+#include "../new_cfg.h"
+// Commands register, execution API and cmd tokenizer
+#include "../cmnds/cmd_public.h"
+#include "../logging/logging.h"
+#include "../littlefs/our_lfs.h"
+
+#include "drv_ntp.h"
+
+#include <math.h>
+
+#define CLOCK_EVENT_TIME	0
+#define CLOCK_EVENT_SUNRISE	1
+#define CLOCK_EVENT_SUNSET	2
+#define CLOCK_EVENT_CRON	3
+
+// what to do with runs missed while device was off or clock was not set
+#define CLOCK_CATCHUP_SKIP	0
+// run once, no matter how many were missed
+#define CLOCK_CATCHUP_ONCE	1
+// run every missed one, up to CLOCK_MAX_CATCHUP
+#define CLOCK_CATCHUP_ALL	2
+#define CLOCK_MAX_CATCHUP	24
+
+// how far next run is searched for, 29 Feb on Monday is rare
+#define CLOCK_SEARCH_DAYS	(366 * 8)
+// in seconds, bigger change of time is a clock step, not a late tick
+#define CLOCK_MAX_STEP		60
+
+#define CLOCK_EVENTS_FILE	"clockEvents.bat"
+#define CLOCK_LASTRUN_FILE	"clockLastRun.txt"
+// in seconds
+#define CLOCK_LASTRUN_SAVE_INTERVAL	3600
+
+typedef struct clockEvent_s {
+	int id;
+	byte type;
+	byte catchUp;
+	byte second;
+	// bit 0 is Sunday
+	byte weekDays;
+	uint64_t minutes;
+	uint32_t hours;
+	// bits 1 to 31
+	uint32_t days;
+	// bits 1 to 12
+	unsigned short months;
+	// cron - when both day of month and week day are given, any of them matches
+	byte bDayOr;
+	// for sunrise and sunset, in minutes
+	short sunOffset;
+	// as given by user, without ID and command, for listing and saving
+	char *spec;
+	char *command;
+	// UTC, 0 if it will never run
+	unsigned int nextRun;
+	// -1 if not in heap
+	int heapIndex;
+	struct clockEvent_s *next;
+} clockEvent_t;
+
+static clockEvent_t *g_clockEvents = 0;
+// min heap of events by nextRun
+static clockEvent_t **g_clockHeap = 0;
+static int g_clockHeapCount = 0;
+static int g_clockHeapSize = 0;
+// UTC of last tick, 0 before first one after time was set
+static unsigned int g_clockLastNow = 0;
+// time zone offset next runs were computed for
+static int g_clockTimeZone = 0;
+// UTC of last run of event with catch up, saved
+static unsigned int g_clockLastRun = 0;
+// g_clockLastRun as it was last written
+static unsigned int g_clockLastRunSaved = 0;
+// set while saved events are loaded, so they are not saved again
+static bool g_clockLoading = false;
+// events changed, they are saved on next second
+static bool g_clockEventsDirty = false;
+static float g_latitude = 0;
+static float g_longitude = 0;
+static bool g_bHasLocation = false;
+
+static const char *g_weekDayNames[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+static const char *g_monthNames[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+// days since 1970-01-01 to date and back, valid for any date
+static void Clock_CivilFromDays(int z, int *y, int *m, int *d) {
+	int era, doe, yoe, doy, mp;
+
+	z += 719468;
+	era = (z >= 0 ? z : z - 146096) / 146097;
+	doe = z - era * 146097;
+	yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	mp = (5 * doy + 2) / 153;
+	*d = doy - (153 * mp + 2) / 5 + 1;
+	*m = mp < 10 ? mp + 3 : mp - 9;
+	*y = yoe + era * 400 + (*m <= 2);
+}
+static int Clock_DaysFromCivil(int y, int m, int d) {
+	int era, yoe, doy, doe;
+
+	y -= m <= 2;
+	era = (y >= 0 ? y : y - 399) / 400;
+	yoe = y - era * 400;
+	doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+// 1970-01-01 was Thursday
+static int Clock_WeekDay(int days) {
+	return (days + 4) % 7;
+}
+
+// Sunrise or sunset in minutes after UTC midnight of given day,
+// returns false if sun does not rise or set on that day.
+// Algorithm from Almanac for Computers, 1990, accurate to a minute or two.
+static bool Clock_GetSunTime(int days, bool bSunrise, int *minutes) {
+	const double rad = 3.14159265358979 / 180.0;
+	int y, m, d, n;
+	double lngHour, t, M, L, RA, sinDec, cosDec, cosH, H, T, UT;
+
+	Clock_CivilFromDays(days, &y, &m, &d);
+	n = days - Clock_DaysFromCivil(y, 1, 1) + 1;
+	lngHour = g_longitude / 15.0;
+	t = n + ((bSunrise ? 6.0 : 18.0) - lngHour) / 24.0;
+	// sun's mean anomaly and true longitude
+	M = 0.9856 * t - 3.289;
+	L = M + 1.916 * sin(M * rad) + 0.020 * sin(2 * M * rad) + 282.634;
+	L = fmod(L + 360.0, 360.0);
+	// right ascension, in same quadrant as L, in hours
+	RA = atan(0.91764 * tan(L * rad)) / rad;
+	RA = fmod(RA + 360.0, 360.0);
+	RA += floor(L / 90.0) * 90.0 - floor(RA / 90.0) * 90.0;
+	RA /= 15.0;
+	// declination and local hour angle, for official zenith of 90 deg 50'
+	sinDec = 0.39782 * sin(L * rad);
+	cosDec = cos(asin(sinDec));
+	cosH = (cos(90.833 * rad) - sinDec * sin(g_latitude * rad)) / (cosDec * cos(g_latitude * rad));
+	if (cosH > 1.0 || cosH < -1.0)
+		return false;
+	H = acos(cosH) / rad;
+	if (bSunrise)
+		H = 360.0 - H;
+	H /= 15.0;
+	T = H + RA - 0.06571 * t - 6.622;
+	UT = fmod(T - lngHour + 48.0, 24.0);
+	*minutes = (int)(UT * 60.0 + 0.5);
+	return true;
+}
+
+static bool Clock_DayMatches(clockEvent_t *ev, int days) {
+	int y, m, d;
+	bool bDay, bWeekDay;
+
+	Clock_CivilFromDays(days, &y, &m, &d);
+	if ((ev->months & (1u << m)) == 0)
+		return false;
+	bDay = (ev->days & (1u << d)) != 0;
+	bWeekDay = (ev->weekDays & (1u << Clock_WeekDay(days))) != 0;
+	if (ev->bDayOr)
+		return bDay || bWeekDay;
+	return bDay && bWeekDay;
+}
+// first run after given UTC time, 0 if there is none
+static unsigned int Clock_GetNextRun(clockEvent_t *ev, unsigned int after) {
+	int tz = NTP_GetTimesZoneOfsSeconds();
+	unsigned int local, run;
+	int days, sod, h, m, s, i, sun;
+
+	local = after + tz + 1;
+	days = local / 86400;
+	sod = local % 86400;
+	if (ev->type == CLOCK_EVENT_SUNRISE || ev->type == CLOCK_EVENT_SUNSET) {
+		if (g_bHasLocation == false)
+			return 0;
+		// sun time is computed for UTC day, which may be day before local one
+		for (i = -1; i < CLOCK_SEARCH_DAYS; i++) {
+			if (Clock_GetSunTime(days + i, ev->type == CLOCK_EVENT_SUNRISE, &sun) == false)
+				continue;
+			run = (days + i) * 86400 + sun * 60 + ev->sunOffset * 60;
+			if (run <= after)
+				continue;
+			if ((ev->weekDays & (1u << Clock_WeekDay((run + tz) / 86400))) == 0)
+				continue;
+			return run;
+		}
+		return 0;
+	}
+	for (i = 0; i < CLOCK_SEARCH_DAYS; i++, days++, sod = 0) {
+		if (Clock_DayMatches(ev, days) == false)
+			continue;
+		for (h = sod / 3600; h < 24; h++) {
+			if ((ev->hours & (1u << h)) == 0)
+				continue;
+			for (m = (h == sod / 3600) ? (sod / 60) % 60 : 0; m < 60; m++) {
+				if (((ev->minutes >> m) & 1) == 0)
+					continue;
+				s = h * 3600 + m * 60 + ev->second;
+				if (s < sod)
+					continue;
+				return days * 86400 + s - tz;
+			}
+		}
+	}
+	return 0;
+}
+
+static void Clock_HeapSwap(int a, int b) {
+	clockEvent_t *tmp;
+
+	tmp = g_clockHeap[a];
+	g_clockHeap[a] = g_clockHeap[b];
+	g_clockHeap[b] = tmp;
+	g_clockHeap[a]->heapIndex = a;
+	g_clockHeap[b]->heapIndex = b;
+}
+static void Clock_HeapUp(int i) {
+	while (i > 0 && g_clockHeap[(i - 1) / 2]->nextRun > g_clockHeap[i]->nextRun) {
+		Clock_HeapSwap(i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
+static void Clock_HeapDown(int i) {
+	int c;
+
+	while ((c = i * 2 + 1) < g_clockHeapCount) {
+		if (c + 1 < g_clockHeapCount && g_clockHeap[c + 1]->nextRun < g_clockHeap[c]->nextRun)
+			c++;
+		if (g_clockHeap[i]->nextRun <= g_clockHeap[c]->nextRun)
+			break;
+		Clock_HeapSwap(i, c);
+		i = c;
+	}
+}
+static void Clock_HeapRemove(clockEvent_t *ev) {
+	int i = ev->heapIndex;
+
+	if (i < 0)
+		return;
+	ev->heapIndex = -1;
+	g_clockHeapCount--;
+	if (i == g_clockHeapCount)
+		return;
+	g_clockHeap[i] = g_clockHeap[g_clockHeapCount];
+	g_clockHeap[i]->heapIndex = i;
+	Clock_HeapUp(i);
+	Clock_HeapDown(g_clockHeap[i]->heapIndex);
+}
+static void Clock_HeapAdd(clockEvent_t *ev) {
+	clockEvent_t **n;
+
+	if (ev->nextRun == 0)
+		return;
+	if (g_clockHeapCount == g_clockHeapSize) {
+		n = (clockEvent_t**)malloc(sizeof(clockEvent_t*) * (g_clockHeapSize + 8));
+		if (n == 0) {
+			addLogAdv(LOG_ERROR, LOG_FEATURE_NTP, "Clock_HeapAdd: failed to malloc\n");
+			return;
+		}
+		if (g_clockHeap) {
+			memcpy(n, g_clockHeap, sizeof(clockEvent_t*) * g_clockHeapCount);
+			free(g_clockHeap);
+		}
+		g_clockHeap = n;
+		g_clockHeapSize += 8;
+	}
+	ev->heapIndex = g_clockHeapCount;
+	g_clockHeap[g_clockHeapCount++] = ev;
+	Clock_HeapUp(ev->heapIndex);
+}
+// computes all next runs again, after time step or time zone change
+static void Clock_Reschedule(unsigned int now) {
+	clockEvent_t *ev;
+
+	g_clockHeapCount = 0;
+	for (ev = g_clockEvents; ev; ev = ev->next) {
+		ev->heapIndex = -1;
+		ev->nextRun = now ? Clock_GetNextRun(ev, now) : 0;
+		Clock_HeapAdd(ev);
+	}
+	g_clockTimeZone = NTP_GetTimesZoneOfsSeconds();
+}
+
+static void Clock_SetDirty() {
+	if (g_clockLoading == false)
+		g_clockEventsDirty = true;
+}
+static void Clock_SaveLastRun() {
+#ifdef BK_LITTLEFS
+	char line[32];
+
+	g_clockLastRunSaved = g_clockLastRun;
+	if (lfs_present() == false)
+		return;
+	snprintf(line, sizeof(line), "%u\r\n", g_clockLastRun);
+	lfs_file_open(&lfs, &file, CLOCK_LASTRUN_FILE, LFS_O_RDWR | LFS_O_CREAT);
+	lfs_file_truncate(&lfs, &file, 0);
+	lfs_file_write(&lfs, &file, line, strlen(line));
+	lfs_file_close(&lfs, &file);
+#endif
+}
+static void Clock_Save() {
+#ifdef BK_LITTLEFS
+	clockEvent_t *ev;
+	char line[64];
+
+	g_clockEventsDirty = false;
+	if (lfs_present() == false)
+		return;
+	lfs_file_open(&lfs, &file, CLOCK_EVENTS_FILE, LFS_O_RDWR | LFS_O_CREAT);
+	lfs_file_truncate(&lfs, &file, 0);
+	if (g_bHasLocation) {
+		snprintf(line, sizeof(line), "ntp_setLatlong %f %f\r\n", g_latitude, g_longitude);
+		lfs_file_write(&lfs, &file, line, strlen(line));
+	}
+	for (ev = g_clockEvents; ev; ev = ev->next) {
+		if (ev->type == CLOCK_EVENT_CRON) {
+			snprintf(line, sizeof(line), "addCronEvent %i ", ev->id);
+			lfs_file_write(&lfs, &file, line, strlen(line));
+			lfs_file_write(&lfs, &file, ev->spec, strlen(ev->spec));
+			lfs_file_write(&lfs, &file, " ", 1);
+		}
+		else {
+			lfs_file_write(&lfs, &file, "addClockEvent ", 14);
+			lfs_file_write(&lfs, &file, ev->spec, strlen(ev->spec));
+			snprintf(line, sizeof(line), " %i ", ev->id);
+			lfs_file_write(&lfs, &file, line, strlen(line));
+		}
+		lfs_file_write(&lfs, &file, ev->command, strlen(ev->command));
+		lfs_file_write(&lfs, &file, "\r\n", 2);
+		if (ev->catchUp != CLOCK_CATCHUP_SKIP) {
+			snprintf(line, sizeof(line), "clockEventCatchUp %i %s\r\n", ev->id,
+				ev->catchUp == CLOCK_CATCHUP_ONCE ? "once" : "all");
+			lfs_file_write(&lfs, &file, line, strlen(line));
+		}
+	}
+	lfs_file_close(&lfs, &file);
+#endif
+}
+void ClockEvents_SaveChanges(bool bForce) {
+	if (g_clockEventsDirty) {
+		Clock_Save();
+	}
+	if (g_clockLastRun == g_clockLastRunSaved)
+		return;
+	if (bForce || g_clockLastRun - g_clockLastRunSaved >= CLOCK_LASTRUN_SAVE_INTERVAL) {
+		Clock_SaveLastRun();
+	}
+}
+
+static int Clock_FindName(const char *s, const char **names, int namesCount) {
+	int i;
+
+	for (i = 0; i < namesCount; i++) {
+		if (!wal_strnicmp(s, names[i], 3))
+			return i;
+	}
+	return -1;
+}
+// parses cron field, like "*", "5", "1-5", "*/15", "8-18/2", "Mon-Fri" or list of them,
+// names, if given, stand for numbers from min up
+static bool Clock_ParseField(const char *s, int min, int max, const char **names, int namesCount, uint64_t *mask) {
+	int a, b, step, i, n;
+	char *end;
+
+	*mask = 0;
+	while (*s) {
+		step = 1;
+		if (*s == '*') {
+			a = min;
+			b = max;
+			s++;
+		}
+		else {
+			i = Clock_FindName(s, names, namesCount);
+			if (i >= 0) {
+				a = min + i;
+				s += 3;
+			}
+			else {
+				a = strtol(s, &end, 10);
+				if (end == s)
+					return false;
+				s = end;
+			}
+			b = a;
+			if (*s == '-') {
+				s++;
+				i = Clock_FindName(s, names, namesCount);
+				if (i >= 0) {
+					b = min + i;
+					s += 3;
+				}
+				else {
+					b = strtol(s, &end, 10);
+					if (end == s)
+						return false;
+					s = end;
+				}
+			}
+		}
+		if (*s == '/') {
+			step = strtol(s + 1, &end, 10);
+			if (end == s + 1 || step <= 0)
+				return false;
+			s = end;
+		}
+		if (a < min || b > max || a > b)
+			return false;
+		for (n = a; n <= b; n += step) {
+			*mask |= 1ULL << n;
+		}
+		if (*s == ',')
+			s++;
+		else if (*s)
+			return false;
+	}
+	return *mask != 0;
+}
+// addClockEvent also takes week days as flags, like 0x7F, cron always takes numbers
+static bool Clock_ParseWeekDays(const char *s, bool bAllowFlags, byte *weekDays) {
+	uint64_t mask;
+
+	if (bAllowFlags && *s >= '0' && *s <= '9') {
+		// flags, bit 0 is Sunday
+		*weekDays = strtol(s, 0, 0) & 0x7F;
+		return *weekDays != 0;
+	}
+	// 7 is Sunday as well
+	if (Clock_ParseField(s, 0, 7, g_weekDayNames, 7, &mask) == false)
+		return false;
+	*weekDays = (mask | (mask >> 7)) & 0x7F;
+	return true;
+}
+
+static clockEvent_t *Clock_FindEvent(int id) {
+	clockEvent_t *ev;
+
+	for (ev = g_clockEvents; ev; ev = ev->next) {
+		if (ev->id == id)
+			return ev;
+	}
+	return 0;
+}
+static void Clock_FreeEvent(clockEvent_t *ev) {
+	free(ev->spec);
+	free(ev->command);
+	free(ev);
+}
+static bool Clock_RemoveEvent(int id) {
+	clockEvent_t **p;
+	clockEvent_t *ev;
+
+	for (p = &g_clockEvents; *p; p = &(*p)->next) {
+		if ((*p)->id == id) {
+			ev = *p;
+			*p = ev->next;
+			Clock_HeapRemove(ev);
+			Clock_FreeEvent(ev);
+			return true;
+		}
+	}
+	return false;
+}
+// takes ownership of event, replaces one with same ID
+static void Clock_AddEvent(clockEvent_t *ev, const char *spec, const char *command) {
+	clockEvent_t *old;
+
+	old = Clock_FindEvent(ev->id);
+	ev->spec = strdup(spec);
+	ev->command = strdup(command);
+	if (ev->spec == 0 || ev->command == 0) {
+		addLogAdv(LOG_ERROR, LOG_FEATURE_NTP, "Clock_AddEvent: failed to malloc\n");
+		Clock_FreeEvent(ev);
+		return;
+	}
+	if (old) {
+		// same one again, from autoexec.bat, nothing to save
+		if (old->type == ev->type && !strcmp(old->spec, ev->spec) && !strcmp(old->command, ev->command)) {
+			Clock_FreeEvent(ev);
+			return;
+		}
+		ev->catchUp = old->catchUp;
+		Clock_RemoveEvent(ev->id);
+	}
+	ev->heapIndex = -1;
+	ev->next = g_clockEvents;
+	g_clockEvents = ev;
+	ev->nextRun = g_clockLastNow ? Clock_GetNextRun(ev, g_clockLastNow) : 0;
+	Clock_HeapAdd(ev);
+	Clock_SetDirty();
+}
+
+// copies next word, returns rest of line after it, or 0 if there was no word;
+// time fields are split by white space only, since tokenizer splits also on commas
+static const char *Clock_GetWord(const char *s, char *o, int maxSize) {
+	int len;
+
+	while (*s == ' ' || *s == '\t')
+		s++;
+	if (*s == 0)
+		return 0;
+	len = 0;
+	while (*s && *s != ' ' && *s != '\t') {
+		if (len < maxSize - 1)
+			o[len++] = *s;
+		s++;
+	}
+	o[len] = 0;
+	while (*s == ' ' || *s == '\t')
+		s++;
+	return s;
+}
+
+// addClockEvent [Time] [WeekDays] [ID] [Command]
+// addClockEvent 07:30 Mon-Fri 1 POWER ON
+// addClockEvent sunset+10 0x7F 2 POWER OFF
+static commandResult_t CMD_AddClockEvent(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	clockEvent_t *ev;
+	char when[16];
+	char days[32];
+	char id[12];
+	char spec[48];
+	int h, m, s;
+
+	args = Clock_GetWord(args, when, sizeof(when));
+	if (args)
+		args = Clock_GetWord(args, days, sizeof(days));
+	if (args)
+		args = Clock_GetWord(args, id, sizeof(id));
+	if (args == 0 || *args == 0) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "addClockEvent: requires 4 arguments\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	ev = (clockEvent_t*)malloc(sizeof(clockEvent_t));
+	if (ev == 0) {
+		return CMD_RES_ERROR;
+	}
+	memset(ev, 0, sizeof(clockEvent_t));
+	if (!wal_strnicmp(when, "sunrise", 7) || !wal_strnicmp(when, "sunset", 6)) {
+		ev->type = (when[3] == 'r' || when[3] == 'R') ? CLOCK_EVENT_SUNRISE : CLOCK_EVENT_SUNSET;
+		ev->sunOffset = atoi(when + (ev->type == CLOCK_EVENT_SUNRISE ? 7 : 6));
+	}
+	else {
+		s = 0;
+		if (sscanf(when, "%i:%i:%i", &h, &m, &s) < 2 || h < 0 || h > 23 || m < 0 || m > 59 || s < 0 || s > 59) {
+			addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "addClockEvent: bad time %s, use HH:MM, HH:MM:SS, sunrise or sunset+-minutes\n", when);
+			free(ev);
+			return CMD_RES_BAD_ARGUMENT;
+		}
+		ev->type = CLOCK_EVENT_TIME;
+		ev->hours = 1u << h;
+		ev->minutes = 1ULL << m;
+		ev->second = s;
+		ev->days = 0xFFFFFFFE;
+		ev->months = 0x1FFE;
+	}
+	if (Clock_ParseWeekDays(days, true, &ev->weekDays) == false) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "addClockEvent: bad week days %s\n", days);
+		free(ev);
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	ev->id = atoi(id);
+	snprintf(spec, sizeof(spec), "%s %s", when, days);
+	Clock_AddEvent(ev, spec, args);
+	return CMD_RES_OK;
+}
+// addCronEvent [ID] [Minute] [Hour] [DayOfMonth] [Month] [DayOfWeek] [Command]
+// addCronEvent 3 */15 8-18 * * Mon-Fri toggleChannel 1
+static commandResult_t CMD_AddCronEvent(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	clockEvent_t *ev;
+	char fields[6][32];
+	uint64_t mask = 0;
+	bool bOk;
+	char spec[96];
+	int i;
+
+	for (i = 0; i < 6 && args; i++) {
+		args = Clock_GetWord(args, fields[i], sizeof(fields[i]));
+	}
+	if (args == 0 || *args == 0) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "addCronEvent: requires 7 arguments\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	ev = (clockEvent_t*)malloc(sizeof(clockEvent_t));
+	if (ev == 0) {
+		return CMD_RES_ERROR;
+	}
+	memset(ev, 0, sizeof(clockEvent_t));
+	ev->type = CLOCK_EVENT_CRON;
+	ev->id = atoi(fields[0]);
+	bOk = Clock_ParseField(fields[1], 0, 59, 0, 0, &ev->minutes);
+	bOk = bOk && Clock_ParseField(fields[2], 0, 23, 0, 0, &mask);
+	ev->hours = mask;
+	bOk = bOk && Clock_ParseField(fields[3], 1, 31, 0, 0, &mask);
+	ev->days = mask;
+	bOk = bOk && Clock_ParseField(fields[4], 1, 12, g_monthNames, 12, &mask);
+	ev->months = mask;
+	bOk = bOk && Clock_ParseWeekDays(fields[5], false, &ev->weekDays);
+	if (bOk == false) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "addCronEvent: bad time fields\n");
+		free(ev);
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	// like in cron, restricted day of month and week day are alternatives
+	ev->bDayOr = strcmp(fields[3], "*") && strcmp(fields[5], "*");
+	snprintf(spec, sizeof(spec), "%s %s %s %s %s", fields[1], fields[2], fields[3], fields[4], fields[5]);
+	Clock_AddEvent(ev, spec, args);
+	return CMD_RES_OK;
+}
+static commandResult_t CMD_RemoveClockEvent(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	Tokenizer_TokenizeString(args, 0);
+	if (Tokenizer_GetArgsCount() < 1) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "removeClockEvent: requires ID\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	if (Clock_RemoveEvent(Tokenizer_GetArgInteger(0)) == false) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	Clock_SetDirty();
+	return CMD_RES_OK;
+}
+static commandResult_t CMD_ClearClockEvents(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	ClockEvents_Shutdown();
+	Clock_SetDirty();
+	return CMD_RES_OK;
+}
+static commandResult_t CMD_ListClockEvents(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	clockEvent_t *ev;
+
+	for (ev = g_clockEvents; ev; ev = ev->next) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Clock event ID %i, %s, next run %u, command %s\n",
+			ev->id, ev->spec, ev->nextRun, ev->command);
+	}
+	return CMD_RES_OK;
+}
+// clockEventCatchUp [ID] [skip/once/all]
+static commandResult_t CMD_ClockEventCatchUp(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	clockEvent_t *ev;
+	const char *policy;
+
+	Tokenizer_TokenizeString(args, 0);
+	if (Tokenizer_GetArgsCount() < 2) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "clockEventCatchUp: requires ID and skip, once or all\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	ev = Clock_FindEvent(Tokenizer_GetArgInteger(0));
+	if (ev == 0) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	policy = Tokenizer_GetArg(1);
+	if (!stricmp(policy, "once")) {
+		ev->catchUp = CLOCK_CATCHUP_ONCE;
+	}
+	else if (!stricmp(policy, "all")) {
+		ev->catchUp = CLOCK_CATCHUP_ALL;
+	}
+	else {
+		ev->catchUp = CLOCK_CATCHUP_SKIP;
+	}
+	Clock_SetDirty();
+	return CMD_RES_OK;
+}
+// ntp_setLatlong [Latitude] [Longitude]
+static commandResult_t CMD_SetLatlong(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	Tokenizer_TokenizeString(args, 0);
+	if (Tokenizer_GetArgsCount() < 2) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "ntp_setLatlong: requires latitude and longitude\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	g_latitude = Tokenizer_GetArgFloat(0);
+	g_longitude = Tokenizer_GetArgFloat(1);
+	g_bHasLocation = true;
+	Clock_Reschedule(g_clockLastNow);
+	Clock_SetDirty();
+	return CMD_RES_OK;
+}
+
+static void Clock_RunEvent(clockEvent_t *ev) {
+	addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Running clock event %i: %s\n", ev->id, ev->command);
+	CMD_ExecuteCommand(ev->command, COMMAND_FLAG_SOURCE_SCRIPT);
+}
+// runs events missed between two times, as each of them asks for
+static void Clock_CatchUp(unsigned int from, unsigned int now) {
+	clockEvent_t *ev;
+	unsigned int t;
+	int missed;
+	bool bRan = false;
+
+	for (ev = g_clockEvents; ev; ev = ev->next) {
+		if (ev->catchUp == CLOCK_CATCHUP_SKIP)
+			continue;
+		t = from;
+		missed = 0;
+		while (missed < CLOCK_MAX_CATCHUP) {
+			t = Clock_GetNextRun(ev, t);
+			if (t == 0 || t > now)
+				break;
+			missed++;
+			if (ev->catchUp == CLOCK_CATCHUP_ONCE)
+				break;
+		}
+		if (missed) {
+			addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Clock event %i missed %i runs\n", ev->id, missed);
+			if (ev->catchUp == CLOCK_CATCHUP_ONCE)
+				missed = 1;
+			while (missed--) {
+				Clock_RunEvent(ev);
+			}
+			bRan = true;
+		}
+	}
+	if (bRan) {
+		// clock step is rare, no need to wait
+		g_clockLastRun = now;
+		Clock_SaveLastRun();
+	}
+}
+
+void ClockEvents_RunEverySecond(unsigned int now) {
+	clockEvent_t *ev;
+	bool bRanCatchUp = false;
+
+	if (g_clockLastNow == 0) {
+		// time was just set, after boot or when driver was started
+		if (g_clockLastRun && g_clockLastRun < now) {
+			Clock_CatchUp(g_clockLastRun, now);
+		}
+		Clock_Reschedule(now);
+	}
+	else if (now < g_clockLastNow) {
+		// clock went back, what was run will run again
+		Clock_Reschedule(now);
+	}
+	else if (now - g_clockLastNow > CLOCK_MAX_STEP) {
+		// clock went forward, what was skipped is missed
+		Clock_CatchUp(g_clockLastNow, now);
+		Clock_Reschedule(now);
+	}
+	else if (g_clockTimeZone != NTP_GetTimesZoneOfsSeconds()) {
+		// wall clock moved, with time zone or DST
+		Clock_Reschedule(g_clockLastNow);
+	}
+	g_clockLastNow = now;
+
+	while (g_clockHeapCount > 0 && g_clockHeap[0]->nextRun <= now) {
+		ev = g_clockHeap[0];
+		ev->nextRun = Clock_GetNextRun(ev, now);
+		if (ev->nextRun == 0) {
+			Clock_HeapRemove(ev);
+		}
+		else {
+			Clock_HeapDown(0);
+		}
+		if (ev->catchUp != CLOCK_CATCHUP_SKIP)
+			bRanCatchUp = true;
+		// command may add or remove events, so heap is fixed up before
+		Clock_RunEvent(ev);
+	}
+	if (bRanCatchUp) {
+		// written later, by ClockEvents_SaveChanges
+		g_clockLastRun = now;
+	}
+}
+unsigned int ClockEvents_GetNextRun(int id) {
+	clockEvent_t *ev = Clock_FindEvent(id);
+
+	return ev ? ev->nextRun : 0;
+}
+int ClockEvents_GetCount() {
+	clockEvent_t *ev;
+	int c = 0;
+
+	for (ev = g_clockEvents; ev; ev = ev->next) {
+		c++;
+	}
+	return c;
+}
+void ClockEvents_Shutdown() {
+	clockEvent_t *ev;
+
+	ClockEvents_SaveChanges(true);
+	while (g_clockEvents) {
+		ev = g_clockEvents;
+		g_clockEvents = ev->next;
+		Clock_FreeEvent(ev);
+	}
+	g_clockHeapCount = 0;
+	g_clockLastNow = 0;
+}
+void ClockEvents_Init() {
+#ifdef BK_LITTLEFS
+	byte *data;
+	char *line, *next;
+#endif
+
+	//cmddetail:{"name":"addClockEvent","args":"[Time][WeekDays][ID][Command]",
+	//cmddetail:"descr":"Runs command at given local time, on given week days (flags with bit 0 as Sunday, or names like Mon-Fri,Sun, or * for every day). Time is HH:MM, HH:MM:SS, or sunrise/sunset with optional offset in minutes, like sunset-15 (needs ntp_setLatlong). Event with same ID is replaced. Events are saved to LittleFS.",
+	//cmddetail:"fn":"CMD_AddClockEvent","file":"driver/drv_ntp_events.c","requires":"",
+	//cmddetail:"examples":"addClockEvent 07:30 Mon-Fri 1 POWER ON"}
+	CMD_RegisterCommand("addClockEvent", "", CMD_AddClockEvent, NULL, NULL);
+	//cmddetail:{"name":"addCronEvent","args":"[ID][Minute][Hour][DayOfMonth][Month][DayOfWeek][Command]",
+	//cmddetail:"descr":"Runs command at local times given like in crontab, fields support *, lists, ranges and steps",
+	//cmddetail:"fn":"CMD_AddCronEvent","file":"driver/drv_ntp_events.c","requires":"",
+	//cmddetail:"examples":"addCronEvent 3 */15 8-18 * * Mon-Fri toggleChannel 1"}
+	CMD_RegisterCommand("addCronEvent", "", CMD_AddCronEvent, NULL, NULL);
+	//cmddetail:{"name":"removeClockEvent","args":"[ID]",
+	//cmddetail:"descr":"Removes clock or cron event with given ID",
+	//cmddetail:"fn":"CMD_RemoveClockEvent","file":"driver/drv_ntp_events.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("removeClockEvent", "", CMD_RemoveClockEvent, NULL, NULL);
+	//cmddetail:{"name":"clearClockEvents","args":"",
+	//cmddetail:"descr":"Removes all clock and cron events",
+	//cmddetail:"fn":"CMD_ClearClockEvents","file":"driver/drv_ntp_events.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("clearClockEvents", "", CMD_ClearClockEvents, NULL, NULL);
+	//cmddetail:{"name":"listClockEvents","args":"",
+	//cmddetail:"descr":"Lists clock and cron events, with time of next run",
+	//cmddetail:"fn":"CMD_ListClockEvents","file":"driver/drv_ntp_events.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("listClockEvents", "", CMD_ListClockEvents, NULL, NULL);
+	//cmddetail:{"name":"clockEventCatchUp","args":"[ID][skip/once/all]",
+	//cmddetail:"descr":"Sets what is done with runs of event missed while device was off or had no time: skipped (default), run once, or all run (up to 24)",
+	//cmddetail:"fn":"CMD_ClockEventCatchUp","file":"driver/drv_ntp_events.c","requires":"",
+	//cmddetail:"examples":"clockEventCatchUp 1 once"}
+	CMD_RegisterCommand("clockEventCatchUp", "", CMD_ClockEventCatchUp, NULL, NULL);
+	//cmddetail:{"name":"ntp_setLatlong","args":"[Latitude][Longitude]",
+	//cmddetail:"descr":"Sets device location, for sunrise and sunset clock events",
+	//cmddetail:"fn":"CMD_SetLatlong","file":"driver/drv_ntp_events.c","requires":"",
+	//cmddetail:"examples":"ntp_setLatlong 52.23 21.01"}
+	CMD_RegisterCommand("ntp_setLatlong", "", CMD_SetLatlong, NULL, NULL);
+
+	ClockEvents_Shutdown();
+	g_clockLastRun = 0;
+	g_clockLastRunSaved = 0;
+#ifdef BK_LITTLEFS
+	if (lfs_present() == false)
+		return;
+	data = LFS_ReadFile(CLOCK_LASTRUN_FILE);
+	if (data) {
+		g_clockLastRun = strtoul((char*)data, 0, 10);
+		g_clockLastRunSaved = g_clockLastRun;
+		free(data);
+	}
+	data = LFS_ReadFile(CLOCK_EVENTS_FILE);
+	if (data == 0)
+		return;
+	g_clockLoading = true;
+	for (line = (char*)data; line && *line; line = next) {
+		next = strchr(line, '\n');
+		if (next) {
+			*next = 0;
+			next++;
+		}
+		if (*line && line[strlen(line) - 1] == '\r') {
+			line[strlen(line) - 1] = 0;
+		}
+		if (*line && *line != '#') {
+			CMD_ExecuteCommand(line, 0);
+		}
+	}
+	g_clockLoading = false;
+	g_clockLastRunSaved = g_clockLastRun;
+	free(data);
+	addLogAdv(LOG_INFO, LOG_FEATURE_NTP, "Loaded %i clock events\n", ClockEvents_GetCount());
+#endif
+}
@@ -0,0 +1,475 @@
+// pixel strip drivers are registered only on Beken and simulator, see drv_main.c
+#if defined(PLATFORM_BEKEN) || defined(WINDOWS)
+
+#include "../new_common.h"
+#include "../new_pins.h"
+#include "../logging/logging.h"
+#include "../hal/hal_pins.h"
+#include "../hal/hal_generic.h"
+#include "drv_pixelBus.h"
+#include <ctype.h>
+
+#if PLATFORM_BEKEN
+#include "include.h"
+#include "arm_arch.h"
+#include "gpio_pub.h"
+#include "gpio.h"
+#endif
+
+// Bit-bang fallback for platforms without SPI in HAL, calibrated delays from
+// old SM16703P and UCS1912 drivers. Simulator has SPI, so there it's only compiled.
+#if WINDOWS
+#define SM16703P_SLEEP_300
+#define SM16703P_SLEEP_900
+#define UCS1912_SLEEP_250
+#define UCS1912_SLEEP_1000
+#else
+#define SM16703P_SLEEP_300	__asm__("nop\nnop\nnop");
+#define SM16703P_SLEEP_900	__asm__("nop\nnop\nnop\nnop\nnop\nnop\nnop");
+#define UCS1912_SLEEP_250	__asm__("nop\nnop");
+#define UCS1912_SLEEP_1000	__asm__("nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop");
+#endif
+
+#if PLATFORM_BEKEN
+// NOTE: #define REG_WRITE(addr, _data) 	(*((volatile UINT32 *)(addr)) = (_data))
+// gpio_output is too slow for these pulses
+#define PIXELBUS_SET_HIGH REG_WRITE(gpio_cfg_addr, reg_val_HIGH);
+#define PIXELBUS_SET_LOW REG_WRITE(gpio_cfg_addr, reg_val_LOW);
+#else
+#define PIXELBUS_SET_HIGH HAL_PIN_SetOutputValue(pin, 1);
+#define PIXELBUS_SET_LOW HAL_PIN_SetOutputValue(pin, 0);
+#endif
+
+#define PIXELBUS_SEND_BIT(var,pos,SLEEP_SHORT,SLEEP_LONG) \
+	if(((var) & (1<<(pos)))) { PIXELBUS_SET_HIGH; SLEEP_LONG; PIXELBUS_SET_LOW; SLEEP_SHORT; } \
+	else { PIXELBUS_SET_HIGH; SLEEP_SHORT; PIXELBUS_SET_LOW; SLEEP_LONG; }
+
+#define PIXELBUS_SEND_BYTES(data,len,SLEEP_SHORT,SLEEP_LONG) \
+	for(i = 0; i < len; i++) { \
+		b = data[i]; \
+		PIXELBUS_SEND_BIT(b,7,SLEEP_SHORT,SLEEP_LONG); \
+		PIXELBUS_SEND_BIT(b,6,SLEEP_SHORT,SLEEP_LONG); \
+		PIXELBUS_SEND_BIT(b,5,SLEEP_SHORT,SLEEP_LONG); \
+		PIXELBUS_SEND_BIT(b,4,SLEEP_SHORT,SLEEP_LONG); \
+		PIXELBUS_SEND_BIT(b,3,SLEEP_SHORT,SLEEP_LONG); \
+		PIXELBUS_SEND_BIT(b,2,SLEEP_SHORT,SLEEP_LONG); \
+		PIXELBUS_SEND_BIT(b,1,SLEEP_SHORT,SLEEP_LONG); \
+		PIXELBUS_SEND_BIT(b,0,SLEEP_SHORT,SLEEP_LONG); \
+	}
+
+// SM16703P: 0 is 300ns high + 900ns low, 1 is 900ns high + 300ns low.
+// That is also within WS2812/WS2812B tolerance, so those strips work as well (with GRB order).
+const pixelBusProtocol_t g_pixelBusProtocol_SM16703P = {
+	"SM16703P",
+	300, 900, 1200,
+	300,
+	// datasheet says 80us, newer WS2812B need 280us
+	300000,
+	"RGB",
+};
+// UCS1912: 0 is 250ns high, 1 is 1000ns high, 1250ns per bit
+const pixelBusProtocol_t g_pixelBusProtocol_UCS1912 = {
+	"UCS1912",
+	250, 1000, 1250,
+	250,
+	24000,
+	"RGB",
+};
+
+static int PixelBus_Round(int ns, int unit) {
+	return (ns + unit / 2) / unit;
+}
+// symbol is high for given number of SPI bits, then low
+static unsigned int PixelBus_Symbol(int bits, int high) {
+	return ((1u << high) - 1) << (bits - high);
+}
+void PixelBus_Init(pixelBus_t *bus, const pixelBusProtocol_t *protocol, int pin) {
+	unsigned int s0, s1, v;
+	int n, i, bit;
+
+	PixelBus_Shutdown(bus);
+	memset(bus, 0, sizeof(*bus));
+	bus->protocol = protocol;
+	bus->pin = pin;
+	n = PixelBus_Round(protocol->period, protocol->spiBitNs);
+	bus->symbolBits = n;
+	s0 = PixelBus_Symbol(n, PixelBus_Round(protocol->t0h, protocol->spiBitNs));
+	s1 = PixelBus_Symbol(n, PixelBus_Round(protocol->t1h, protocol->spiBitNs));
+	// table for 4 data bits, MSB first, so byte is encoded with two lookups
+	for (i = 0; i < 16; i++) {
+		v = 0;
+		for (bit = 3; bit >= 0; bit--) {
+			v = (v << n) | ((i & (1 << bit)) ? s1 : s0);
+		}
+		bus->nibbles[i] = v;
+	}
+	bus->bSPI = HAL_SPI_Init(pin, 1000000000 / protocol->spiBitNs);
+	if (bus->bSPI == 0) {
+		HAL_PIN_Setup_Output(pin);
+		HAL_PIN_SetOutputValue(pin, 0);
+	}
+	addLogAdv(LOG_INFO, LOG_FEATURE_CMD, "PixelBus: %s on pin %i, %i SPI bits per bit, %s",
+		protocol->name, pin, n, bus->bSPI ? "SPI" : "GPIO");
+}
+static int PixelBus_SetOrder(pixelBus_t *bus, const char *order) {
+	static const char *colors = "RGBW";
+	const char *p;
+	byte tmp[4];
+	int i;
+
+	for (i = 0; order[i]; i++) {
+		p = strchr(colors, toupper((unsigned char)order[i]));
+		if (i >= 4 || p == 0) {
+			return 0;
+		}
+		tmp[i] = p - colors;
+	}
+	if (i < 3) {
+		return 0;
+	}
+	memcpy(bus->order, tmp, i);
+	bus->bpp = i;
+	return 1;
+}
+// reset time as whole zero bytes after frame
+static int PixelBus_GetResetBytes(pixelBus_t *bus) {
+	int byteNs;
+
+	byteNs = bus->protocol->spiBitNs * 8;
+	return (bus->protocol->reset + byteNs - 1) / byteNs;
+}
+static int PixelBus_GetTxSize(pixelBus_t *bus) {
+	// bit-bang sends bytes in wire order
+	if (bus->bSPI == 0) {
+		return bus->count * bus->bpp;
+	}
+	// leading zero byte makes sure line is low before first bit
+	return 1 + bus->count * bus->bpp * bus->symbolBits + PixelBus_GetResetBytes(bus);
+}
+int PixelBus_Setup(pixelBus_t *bus, int count, const char *order) {
+	int txSize;
+
+	if (bus->protocol == 0) {
+		return 0;
+	}
+	if (order == 0 || *order == 0) {
+		order = bus->protocol->defaultOrder;
+	}
+	if (count < 1 || PixelBus_SetOrder(bus, order) == 0) {
+		addLogAdv(LOG_ERROR, LOG_FEATURE_CMD, "PixelBus: bad setup, %i pixels, order %s", count, order);
+		return 0;
+	}
+	// can't free buffer which is being sent
+	if (PixelBus_IsBusy(bus)) {
+		HAL_SPI_Deinit();
+		HAL_SPI_Init(bus->pin, 1000000000 / bus->protocol->spiBitNs);
+	}
+	os_free(bus->pixels);
+	os_free(bus->tx[0]);
+	os_free(bus->tx[1]);
+	bus->count = count;
+	txSize = PixelBus_GetTxSize(bus);
+	bus->pixels = (byte*)os_malloc(count * bus->bpp);
+	bus->tx[0] = (byte*)os_malloc(txSize);
+	// bit-bang sends whole frame in one go, second buffer is not needed
+	bus->tx[1] = bus->bSPI ? (byte*)os_malloc(txSize) : 0;
+	bus->bPending = 0;
+	if (bus->pixels == 0 || bus->tx[0] == 0 || (bus->bSPI && bus->tx[1] == 0)) {
+		addLogAdv(LOG_ERROR, LOG_FEATURE_CMD, "PixelBus: no memory for %i pixels", count);
+		PixelBus_Shutdown(bus);
+		return 0;
+	}
+	memset(bus->pixels, 0, count * bus->bpp);
+	return 1;
+}
+void PixelBus_Shutdown(pixelBus_t *bus) {
+	if (bus->bSPI) {
+		HAL_SPI_Deinit();
+		bus->bSPI = 0;
+	}
+	os_free(bus->pixels);
+	os_free(bus->tx[0]);
+	os_free(bus->tx[1]);
+	bus->pixels = 0;
+	bus->tx[0] = 0;
+	bus->tx[1] = 0;
+	bus->count = 0;
+	bus->bPending = 0;
+}
+void PixelBus_SetPixel(pixelBus_t *bus, int index, byte r, byte g, byte b, byte w) {
+	byte *p;
+
+	if (index < 0 || index >= bus->count) {
+		return;
+	}
+	p = bus->pixels + index * bus->bpp;
+	p[0] = r;
+	p[1] = g;
+	p[2] = b;
+	if (bus->bpp > 3) {
+		p[3] = w;
+	}
+}
+void PixelBus_Fill(pixelBus_t *bus, byte r, byte g, byte b, byte w) {
+	int i;
+
+	for (i = 0; i < bus->count; i++) {
+		PixelBus_SetPixel(bus, i, r, g, b, w);
+	}
+}
+int PixelBus_Encode(pixelBus_t *bus, const byte *pixels, byte *out) {
+	int n = bus->symbolBits;
+	int i, j, shift;
+	byte *o = out;
+	uint64_t v;
+	byte c;
+	int resetBytes;
+
+	*o++ = 0;
+	for (i = 0; i < bus->count; i++) {
+		for (j = 0; j < bus->bpp; j++) {
+			c = pixels[bus->order[j]];
+			// 8 data bits give exactly n SPI bytes
+			v = ((uint64_t)bus->nibbles[c >> 4] << (4 * n)) | bus->nibbles[c & 0xf];
+			for (shift = 8 * (n - 1); shift >= 0; shift -= 8) {
+				*o++ = (byte)(v >> shift);
+			}
+		}
+		pixels += bus->bpp;
+	}
+	resetBytes = PixelBus_GetResetBytes(bus);
+	memset(o, 0, resetBytes);
+	o += resetBytes;
+	return o - out;
+}
+int PixelBus_IsBusy(pixelBus_t *bus) {
+	if (bus->bSPI == 0) {
+		return 0;
+	}
+	return HAL_SPI_IsBusy();
+}
+// puts pixels in wire order, for bit-bang
+static int PixelBus_Order(pixelBus_t *bus, const byte *pixels, byte *out) {
+	byte *o = out;
+	int i, j;
+
+	for (i = 0; i < bus->count; i++) {
+		for (j = 0; j < bus->bpp; j++) {
+			*o++ = pixels[bus->order[j]];
+		}
+		pixels += bus->bpp;
+	}
+	return o - out;
+}
+// for platforms without SPI support in HAL, frame is sent with interrupts masked (on Beken),
+// line stays low after it, so strip latches it
+static void PixelBus_BitBang(pixelBus_t *bus, const byte *data, int len) {
+	int i;
+	byte b;
+#if PLATFORM_BEKEN
+	volatile UINT32 *gpio_cfg_addr;
+	UINT32 id;
+	UINT32 reg_val_HIGH;
+	UINT32 reg_val_LOW;
+	GLOBAL_INT_DECLARATION();
+
+	id = bus->pin;
+#if (CFG_SOC_NAME != SOC_BK7231)
+	if (id >= GPIO32)
+		id += 16;
+#endif // (CFG_SOC_NAME != SOC_BK7231)
+	gpio_cfg_addr = (volatile UINT32 *)(REG_GPIO_CFG_BASE_ADDR + id * 4);
+	// only output value bit changes, rest of pin config is kept
+	reg_val_LOW = REG_READ(gpio_cfg_addr) & ~GCFG_OUTPUT_BIT;
+	reg_val_HIGH = reg_val_LOW | GCFG_OUTPUT_BIT;
+
+	GLOBAL_INT_DISABLE();
+#else
+	int pin = bus->pin;
+#endif
+	if (bus->protocol == &g_pixelBusProtocol_UCS1912) {
+		PIXELBUS_SEND_BYTES(data, len, UCS1912_SLEEP_250, UCS1912_SLEEP_1000);
+	}
+	else {
+		PIXELBUS_SEND_BYTES(data, len, SM16703P_SLEEP_300, SM16703P_SLEEP_900);
+	}
+#if PLATFORM_BEKEN
+	GLOBAL_INT_RESTORE();
+#endif
+}
+static void PixelBus_StartSending(pixelBus_t *bus, int index) {
+	bus->txSending = index;
+	bus->framesSent++;
+	HAL_SPI_Send(bus->tx[index], bus->txLen);
+}
+int PixelBus_Show(pixelBus_t *bus) {
+	int next;
+
+	if (bus->pixels == 0) {
+		return 0;
+	}
+	if (bus->bSPI == 0) {
+		bus->txLen = PixelBus_Order(bus, bus->pixels, bus->tx[0]);
+		bus->framesSent++;
+		PixelBus_BitBang(bus, bus->tx[0], bus->txLen);
+		return 1;
+	}
+	// never touch buffer that is being sent
+	next = !bus->txSending;
+	bus->txLen = PixelBus_Encode(bus, bus->pixels, bus->tx[next]);
+	if (PixelBus_IsBusy(bus)) {
+		if (bus->bPending) {
+			bus->framesDropped++;
+		}
+		bus->bPending = 1;
+		return 0;
+	}
+	bus->bPending = 0;
+	PixelBus_StartSending(bus, next);
+	return 1;
+}
+void PixelBus_RunQuickTick(pixelBus_t *bus) {
+	if (bus->bPending == 0 || PixelBus_IsBusy(bus)) {
+		return;
+	}
+	bus->bPending = 0;
+	PixelBus_StartSending(bus, !bus->txSending);
+}
+
+// [NumPixels] [Order]
+commandResult_t PixelBus_CmdSetup(pixelBus_t *bus, const char *args) {
+	Tokenizer_TokenizeString(args, 0);
+
+	if (Tokenizer_GetArgsCount() < 1) {
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	if (PixelBus_Setup(bus, Tokenizer_GetArgInteger(0), Tokenizer_GetArgsCount() > 1 ? Tokenizer_GetArg(1) : 0) == 0) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	return CMD_RES_OK;
+}
+// [Index|all] [R] [G] [B] [W]
+commandResult_t PixelBus_CmdSetPixel(pixelBus_t *bus, const char *args) {
+	const char *index;
+	byte r, g, b, w;
+
+	Tokenizer_TokenizeString(args, 0);
+
+	if (Tokenizer_GetArgsCount() < 4) {
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	index = Tokenizer_GetArg(0);
+	r = Tokenizer_GetArgIntegerRange(1, 0, 255);
+	g = Tokenizer_GetArgIntegerRange(2, 0, 255);
+	b = Tokenizer_GetArgIntegerRange(3, 0, 255);
+	w = 0;
+	if (Tokenizer_GetArgsCount() > 4) {
+		w = Tokenizer_GetArgIntegerRange(4, 0, 255);
+	}
+	if (!stricmp(index, "all")) {
+		PixelBus_Fill(bus, r, g, b, w);
+	}
+	else {
+		PixelBus_SetPixel(bus, atoi(index), r, g, b, w);
+	}
+	return CMD_RES_OK;
+}
+// hex bytes in framebuffer order, from first pixel, then shows them
+commandResult_t PixelBus_CmdSendHex(pixelBus_t *bus, const char *args) {
+	int i, size, val;
+	char tmp[3];
+
+	if (bus->pixels == 0) {
+		return CMD_RES_ERROR;
+	}
+	size = bus->count * bus->bpp;
+	for (i = 0; i < size && args[0] && args[1]; i++) {
+		tmp[0] = *args++;
+		tmp[1] = *args++;
+		tmp[2] = 0;
+		if (sscanf(tmp, "%x", &val) != 1) {
+			ADDLOG_ERROR(LOG_FEATURE_CMD, "PixelBus: no hex value in %s", tmp);
+			return CMD_RES_BAD_ARGUMENT;
+		}
+		bus->pixels[i] = val;
+	}
+	PixelBus_Show(bus);
+	return CMD_RES_OK;
+}
+
+#if WINDOWS
+int PixelBus_DecodeSPI(const pixelBusProtocol_t *protocol, const byte *data, int len, byte *out, int maxOut) {
+	// datasheets allow 150ns in each pulse
+	int tolerance = 150;
+	int i, level, prev;
+	int high, low;
+	int bits, bitCount, count;
+
+	high = 0;
+	low = 0;
+	bits = 0;
+	bitCount = 0;
+	count = 0;
+	prev = 0;
+	// walk SPI bits, measuring high and low time of each pulse in ns
+	for (i = 0; i <= len * 8; i++) {
+		// one extra low bit at the end closes last pulse
+		level = (i < len * 8) ? (data[i >> 3] >> (7 - (i & 7))) & 1 : 0;
+		if (level && prev == 0 && high) {
+			// rising edge ends previous bit
+			if (high + low < protocol->period - tolerance || high + low > protocol->period + tolerance) {
+				return -1;
+			}
+			if (abs(high - protocol->t1h) <= tolerance) {
+				bits = (bits << 1) | 1;
+			}
+			else if (abs(high - protocol->t0h) <= tolerance) {
+				bits = bits << 1;
+			}
+			else {
+				return -1;
+			}
+			if (++bitCount == 8) {
+				if (count >= maxOut) {
+					return -1;
+				}
+				out[count++] = bits;
+				bits = 0;
+				bitCount = 0;
+			}
+			high = 0;
+			low = 0;
+		}
+		if (level) {
+			high += protocol->spiBitNs;
+		}
+		else if (high) {
+			low += protocol->spiBitNs;
+		}
+		prev = level;
+	}
+	// last bit ends with reset, so its low time is long
+	if (high) {
+		if (low < protocol->reset) {
+			return -1;
+		}
+		if (abs(high - protocol->t1h) <= tolerance) {
+			bits = (bits << 1) | 1;
+		}
+		else if (abs(high - protocol->t0h) <= tolerance) {
+			bits = bits << 1;
+		}
+		else {
+			return -1;
+		}
+		bitCount++;
+	}
+	if (bitCount != 8 || count >= maxOut) {
+		return -1;
+	}
+	out[count++] = bits;
+	return count;
+}
+#endif
+
+#endif
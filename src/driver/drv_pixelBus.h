@@ -0,0 +1,87 @@
+#ifndef __DRV_PIXELBUS_H__
+#define __DRV_PIXELBUS_H__
+
+#include "../new_common.h"
+#include "../cmnds/cmd_public.h"
+
+// Shared engine for one-wire addressable pixel strips: SM16703P (and WS2812,
+// which accepts the same timing), UCS1912.
+// Every data bit is encoded as a few SPI bits (short or long high pulse),
+// whole strip is encoded from framebuffer at once and sent in background
+// by SPI DMA, so interrupts are never masked. There are two encoded buffers,
+// next frame is encoded while previous one is still being sent.
+// SPI DMA is available on BK7231N when strip is on P16 (SPI MOSI). BK7231T,
+// or any other pin, bit-bangs with calibrated delays instead, with interrupts
+// masked for the whole frame.
+
+typedef struct pixelBusProtocol_s {
+	const char *name;
+	// timings in ns
+	short t0h;
+	short t1h;
+	short period;
+	// SPI bit time, pulses are rounded to this
+	short spiBitNs;
+	// low time that latches data
+	int reset;
+	// wire order of colors, like "GRB" or "RGBW"
+	const char *defaultOrder;
+} pixelBusProtocol_t;
+
+extern const pixelBusProtocol_t g_pixelBusProtocol_SM16703P;
+extern const pixelBusProtocol_t g_pixelBusProtocol_UCS1912;
+
+typedef struct pixelBus_s {
+	const pixelBusProtocol_t *protocol;
+	int pin;
+	int count;
+	// bytes per pixel, 3 or 4
+	byte bpp;
+	// for each wire position, index of color (0 - R, 1 - G, 2 - B, 3 - W)
+	byte order[4];
+	// SPI bits per data bit and encoding of each 4 data bits
+	byte symbolBits;
+	unsigned int nibbles[16];
+	// framebuffer, in RGB(W) order
+	byte *pixels;
+	// encoded frames, with bit-bang only tx[0] with bytes in wire order
+	byte *tx[2];
+	int txLen;
+	// buffer being sent
+	byte txSending;
+	// encoded frame waits for previous one to finish
+	byte bPending;
+	byte bSPI;
+	int framesSent;
+	// frames replaced by newer ones before they could be sent
+	int framesDropped;
+} pixelBus_t;
+
+void PixelBus_Init(pixelBus_t *bus, const pixelBusProtocol_t *protocol, int pin);
+// allocates buffers for given number of pixels, order NULL means protocol default
+int PixelBus_Setup(pixelBus_t *bus, int count, const char *order);
+void PixelBus_Shutdown(pixelBus_t *bus);
+void PixelBus_SetPixel(pixelBus_t *bus, int index, byte r, byte g, byte b, byte w);
+void PixelBus_Fill(pixelBus_t *bus, byte r, byte g, byte b, byte w);
+// encodes framebuffer and sends it, or queues it if previous frame is still being sent
+// returns 1 if sending has started
+int PixelBus_Show(pixelBus_t *bus);
+int PixelBus_IsBusy(pixelBus_t *bus);
+// sends queued frame
+void PixelBus_RunQuickTick(pixelBus_t *bus);
+// encodes pixels in framebuffer order, returns encoded length
+int PixelBus_Encode(pixelBus_t *bus, const byte *pixels, byte *out);
+
+// command handlers shared by chip drivers
+commandResult_t PixelBus_CmdSetup(pixelBus_t *bus, const char *args);
+commandResult_t PixelBus_CmdSetPixel(pixelBus_t *bus, const char *args);
+commandResult_t PixelBus_CmdSendHex(pixelBus_t *bus, const char *args);
+
+#if WINDOWS
+// decodes SPI stream back to bytes (wire order), checks that every pulse is
+// within protocol tolerance and that frame ends with reset,
+// returns number of bytes, or -1 on timing error
+int PixelBus_DecodeSPI(const pixelBusProtocol_t *protocol, const byte *data, int len, byte *out, int maxOut);
+#endif
+
+#endif /* __DRV_PIXELBUS_H__ */
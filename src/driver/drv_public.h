@@ -31,10 +31,21 @@ extern const char* counter_mqttNames[];
 extern const char* counter_devClasses[];
 extern int g_dhtsCount;
 
+// runtime counters of single driver, reset on startDriver
+typedef struct driverStats_s {
+	int everySecondCalls;
+	int quickTickCalls;
+	int channelChangedCalls;
+	// time spent in every second and quick tick hooks, from driver profiler section
+	int timeTotalMs;
+	int timeMaxUs;
+} driverStats_t;
+
 void DRV_Generic_Init();
 void DRV_AppendInformationToHTTPIndexPage(http_request_t* request);
 void DRV_OnEverySecond();
 void DHT_OnEverySecond();
+void DHT_RunQuickTick(int t_diff);
 void DHT_OnPinsConfigChanged();
 void DRV_RunQuickTick();
 void DRV_StartDriver(const char* name);
@@ -42,6 +53,8 @@ void DRV_StopDriver(const char* name);
 // right now only used by simulator
 void DRV_ShutdownAllDrivers();
 bool DRV_IsRunning(const char* name);
+// copies counters of given driver, returns false if driver is not known in this build
+bool DRV_GetStats(const char* name, driverStats_t* out);
 void DRV_OnChannelChanged(int channel, int iVal);
 void SM2135_Write(byte* rgbcw);
 void BP5758D_Write(byte* rgbcw);
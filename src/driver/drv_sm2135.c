@@ -11,6 +11,7 @@
 #include "../hal/hal_pins.h"
 
 #include "drv_sm2135.h"
+#include "drv_ledBus.h"
 
 // Some platforms have less pins than BK7231T.
 // For example, BL602 doesn't have pin number 26.
@@ -24,115 +25,61 @@ static int g_pin_clk = 0;
 static int g_pin_data = 1;
 #endif
 
-static int g_current_setting_cw = SM2135_20MA;
-static int g_current_setting_rgb = SM2135_20MA;
-// Mapping between RGBCW to current SM2135 channels
-static byte g_channelOrder[5] = { 2, 1, 0, 4, 3 };
-
-static void SM2135_SetLow(uint8_t pin) {
-	HAL_PIN_Setup_Output(pin);
-	HAL_PIN_SetOutputValue(pin, 0);
-}
-
-static void SM2135_SetHigh(uint8_t pin) {
-	HAL_PIN_Setup_Input_Pullup(pin);
-}
-
-static bool SM2135_PreInit(void) {
-	HAL_PIN_SetOutputValue(g_pin_data, 0);
-	HAL_PIN_SetOutputValue(g_pin_clk, 0);
-	SM2135_SetHigh(g_pin_data);
-	SM2135_SetHigh(g_pin_clk);
-	return (!((HAL_PIN_ReadDigitalInput(g_pin_data) == 0 || HAL_PIN_ReadDigitalInput(g_pin_clk) == 0)));
-}
-
-static bool SM2135_WriteByte(uint8_t value) {
-	uint8_t curr;
-	uint8_t ack;
-
-	for (curr = 0X80; curr != 0; curr >>= 1) {
-		if (curr & value) {
-			SM2135_SetHigh(g_pin_data);
-		} else {
-			SM2135_SetLow(g_pin_data);
-		}
-		SM2135_SetHigh(g_pin_clk);
-		usleep(SM2135_DELAY);
-		SM2135_SetLow(g_pin_clk);
-	}
-	// get Ack or Nak
-	SM2135_SetHigh(g_pin_data);
-	SM2135_SetHigh(g_pin_clk);
-	usleep(SM2135_DELAY / 2);
-	ack = HAL_PIN_ReadDigitalInput(g_pin_data);
-	SM2135_SetLow(g_pin_clk);
-	usleep(SM2135_DELAY / 2);
-	SM2135_SetLow(g_pin_data);
-	return (0 == ack);
-}
-
-static bool SM2135_Start(uint8_t addr) {
-	SM2135_SetLow(g_pin_data);
-	usleep(SM2135_DELAY);
-	SM2135_SetLow(g_pin_clk);
-	return SM2135_WriteByte(addr);
-}
-
-static void SM2135_Stop(void) {
-	SM2135_SetLow(g_pin_data);
-	usleep(SM2135_DELAY);
-	SM2135_SetHigh(g_pin_clk);
-	usleep(SM2135_DELAY);
-	SM2135_SetHigh(g_pin_data);
-	usleep(SM2135_DELAY);
-}
-
-void SM2135_Write(byte *rgbcw) {
+static void SM2135_BuildFrame(ledBus_t *bus, const byte *values, ledBusFrame_t *frame) {
 	int i;
 	int bRGB;
 
 	if(CFG_HasFlag(OBK_FLAG_SM2135_SEPARATE_MODES)) {
 		bRGB = 0;
 		for(i = 0; i < 3; i++){
-			if(rgbcw[g_channelOrder[i]]!=0) {
+			if(values[i]!=0) {
 				bRGB = 1;
 				break;
 			}
 		}
 		if(bRGB) {
-			SM2135_Start(SM2135_ADDR_MC);
-			SM2135_WriteByte(g_current_setting_rgb);
-			SM2135_WriteByte(SM2135_RGB);
-			SM2135_WriteByte(rgbcw[g_channelOrder[0]]);
-			SM2135_WriteByte(rgbcw[g_channelOrder[1]]);
-			SM2135_WriteByte(rgbcw[g_channelOrder[2]]); 
-			SM2135_Stop();
+			LEDBus_Frame_Start(frame, SM2135_ADDR_MC);
+			LEDBus_Frame_Byte(frame, bus->currentRGB);
+			LEDBus_Frame_Byte(frame, SM2135_RGB);
+			LEDBus_Frame_Byte(frame, values[0]);
+			LEDBus_Frame_Byte(frame, values[1]);
+			LEDBus_Frame_Byte(frame, values[2]);
 		} else {
-			SM2135_Start(SM2135_ADDR_MC);
-			SM2135_WriteByte(g_current_setting_cw);
-			SM2135_WriteByte(SM2135_CW);
-			SM2135_Stop();
-			usleep(SM2135_DELAY);
-
-			SM2135_Start(SM2135_ADDR_C);
-			SM2135_WriteByte(rgbcw[g_channelOrder[3]]);
-			SM2135_WriteByte(rgbcw[g_channelOrder[4]]); 
-			SM2135_Stop();
+			LEDBus_Frame_Start(frame, SM2135_ADDR_MC);
+			LEDBus_Frame_Byte(frame, bus->currentCW);
+			LEDBus_Frame_Byte(frame, SM2135_CW);
 
+			LEDBus_Frame_Start(frame, SM2135_ADDR_C);
+			LEDBus_Frame_Byte(frame, values[3]);
+			LEDBus_Frame_Byte(frame, values[4]);
 		}
 	} else {
-		SM2135_Start(SM2135_ADDR_MC);
-		SM2135_WriteByte(g_current_setting_rgb);
-		SM2135_WriteByte(SM2135_RGB);
-		SM2135_WriteByte(rgbcw[g_channelOrder[0]]);
-		SM2135_WriteByte(rgbcw[g_channelOrder[1]]);
-		SM2135_WriteByte(rgbcw[g_channelOrder[2]]); 
-		SM2135_WriteByte(rgbcw[g_channelOrder[3]]); 
-		SM2135_WriteByte(rgbcw[g_channelOrder[4]]); 
-		SM2135_Stop();
+		LEDBus_Frame_Start(frame, SM2135_ADDR_MC);
+		LEDBus_Frame_Byte(frame, bus->currentRGB);
+		LEDBus_Frame_Byte(frame, SM2135_RGB);
+		LEDBus_Frame_Byte(frame, values[0]);
+		LEDBus_Frame_Byte(frame, values[1]);
+		LEDBus_Frame_Byte(frame, values[2]);
+		LEDBus_Frame_Byte(frame, values[3]);
+		LEDBus_Frame_Byte(frame, values[4]);
 	}
 }
 
+static const ledBusProtocol_t g_sm2135 = {
+	"SM2135",
+	1,
+	SM2135_DELAY,
+	{ 2, 1, 0, 4, 3 },
+	SM2135_BuildFrame,
+};
+
+// currents are part of every frame, so they are kept only in bus state
+static ledBus_t g_bus;
+
+void SM2135_Write(byte *rgbcw) {
+	LEDBus_WriteRGBCW(&g_bus, rgbcw);
+}
+
 static commandResult_t SM2135_RGBCW(const void *context, const char *cmd, const char *args, int flags){
 	const char *c = args;
 	byte col[5] = { 0, 0, 0, 0, 0 };
@@ -184,25 +131,25 @@ static commandResult_t SM2135_Map(const void *context, const char *cmd, const ch
 
 	if(Tokenizer_GetArgsCount()==0) {
 		ADDLOG_DEBUG(LOG_FEATURE_CMD, "SM2135_Map current order is %i %i %i    %i %i! ",
-			(int)g_channelOrder[0],(int)g_channelOrder[1],(int)g_channelOrder[2],(int)g_channelOrder[3],(int)g_channelOrder[4]);
+			(int)g_bus.channelOrder[0],(int)g_bus.channelOrder[1],(int)g_bus.channelOrder[2],(int)g_bus.channelOrder[3],(int)g_bus.channelOrder[4]);
 		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
 	}
 
-	g_channelOrder[0] = Tokenizer_GetArgIntegerRange(0, 0, 4);
-	g_channelOrder[1] = Tokenizer_GetArgIntegerRange(1, 0, 4);
-	g_channelOrder[2] = Tokenizer_GetArgIntegerRange(2, 0, 4);
-	g_channelOrder[3] = Tokenizer_GetArgIntegerRange(3, 0, 4);
-	g_channelOrder[4] = Tokenizer_GetArgIntegerRange(4, 0, 4);
+	g_bus.channelOrder[0] = Tokenizer_GetArgIntegerRange(0, 0, 4);
+	g_bus.channelOrder[1] = Tokenizer_GetArgIntegerRange(1, 0, 4);
+	g_bus.channelOrder[2] = Tokenizer_GetArgIntegerRange(2, 0, 4);
+	g_bus.channelOrder[3] = Tokenizer_GetArgIntegerRange(3, 0, 4);
+	g_bus.channelOrder[4] = Tokenizer_GetArgIntegerRange(4, 0, 4);
 
 	ADDLOG_DEBUG(LOG_FEATURE_CMD, "SM2135_Map new order is %i %i %i    %i %i! ",
-		(int)g_channelOrder[0],(int)g_channelOrder[1],(int)g_channelOrder[2],(int)g_channelOrder[3],(int)g_channelOrder[4]);
+		(int)g_bus.channelOrder[0],(int)g_bus.channelOrder[1],(int)g_bus.channelOrder[2],(int)g_bus.channelOrder[3],(int)g_bus.channelOrder[4]);
 
 	return CMD_RES_OK;
 }
 
 static void SM2135_SetCurrent(int curValRGB, int curValCW) {
-	g_current_setting_rgb = curValRGB;
-	g_current_setting_cw = curValCW;
+	g_bus.currentRGB = curValRGB;
+	g_bus.currentCW = curValCW;
 }
 
 static commandResult_t SM2135_Current(const void *context, const char *cmd, const char *args, int flags){
@@ -211,7 +158,7 @@ static commandResult_t SM2135_Current(const void *context, const char *cmd, cons
 	Tokenizer_TokenizeString(args,0);
 
 	if(Tokenizer_GetArgsCount()<=1) {
-		ADDLOG_DEBUG(LOG_FEATURE_CMD, "SM2135_Current: requires 2 arguments [RGB,CW]. Current value is: %i %i!\n",g_current_setting_rgb,g_current_setting_cw);
+		ADDLOG_DEBUG(LOG_FEATURE_CMD, "SM2135_Current: requires 2 arguments [RGB,CW]. Current value is: %i %i!\n",(int)g_bus.currentRGB,(int)g_bus.currentCW);
 		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
 	}
 	valRGB = Tokenizer_GetArgInteger(0);
@@ -225,11 +172,15 @@ static commandResult_t SM2135_Current(const void *context, const char *cmd, cons
 // SM2135_RGBCW FF00000000
 void SM2135_Init() {
 
-    SM2135_PreInit();
-
 	g_pin_clk = PIN_FindPinIndexForRole(IOR_SM2135_CLK,g_pin_clk);
 	g_pin_data = PIN_FindPinIndexForRole(IOR_SM2135_DAT,g_pin_data);
 
+	// first start, currents set by user are kept if driver is restarted
+	if (g_bus.protocol == 0) {
+		SM2135_SetCurrent(SM2135_20MA, SM2135_20MA);
+	}
+	LEDBus_Init(&g_bus, &g_sm2135, g_pin_clk, g_pin_data);
+
 	//cmddetail:{"name":"SM2135_RGBCW","args":"[HexColor]",
 	//cmddetail:"descr":"Don't use it. It's for direct access of SM2135 driver. You don't need it because LED driver automatically calls it, so just use led_basecolor_rgb",
 	//cmddetail:"fn":"SM2135_RGBCW","file":"driver/drv_sm2135.c","requires":"",
@@ -48,66 +48,332 @@ static char *advert_message = NULL;
 int advert_maxlen = 0;
 static char *udp_msgbuf = NULL;
 #define UDP_MSGBUF_LEN 500
+#define SSDP_MAX_PACKETS_PER_TICK 8
 static char *notify_message = NULL;
 int notify_maxlen = 0;
 static char *http_message = NULL;
 int http_message_len = 0;
 
 
-#define MAX_OBK_DEVICES 40
+// Registry of devices heard on SSDP - NOTIFY from others, and replies to our M-SEARCH.
+// Devices are kept in hash table by USN uuid (or by IP, if there is no USN),
+// so each received packet costs single bucket lookup, no matter how many
+// devices there are. Each one is forgotten after its max-age (OpenBeken ones
+// after OBK_DEVICE_TIMEOUT, they NOTIFY every 30 seconds) and on ssdp:byebye.
+// Changes go to event handlers (SSDPNew, SSDPLost, SSDPChange) and
+// to small ring of events, read by /api/ssdp/events?since=seq.
+#define SSDP_MAX_DEVICES 40
+#define SSDP_HASH_SIZE 16
 #define OBK_DEVICE_TIMEOUT 60
+#define SSDP_DEFAULT_MAX_AGE 1800
+#define SSDP_MAX_EVENTS 16
 
-typedef struct OBK_DEVICE_tag{
+#define SSDP_EVENT_NEW 0
+#define SSDP_EVENT_LOST 1
+#define SSDP_EVENT_CHANGE 2
+
+typedef struct ssdpDevice_s {
+    uint32_t hash;
+    // as in sin_addr, network order
+    uint32_t ip;
+    // seconds left until device is forgotten
+    int timeout;
+    int maxAge;
+    // BOOTID.UPNP.ORG, changes when device restarts, -1 if not given
+    int bootId;
+    byte bObk;
+    char uuid[40];
+    char server[32];
+    char location[64];
+    // last device type (urn:...:device:...) seen in NT or ST
+    char type[64];
+    struct ssdpDevice_s *next;
+} ssdpDevice_t;
+
+typedef struct ssdpEvent_s {
+    unsigned int seq;
+    byte kind;
     uint32_t ip;
-    int timeout; // seconds
-} OBK_DEVICE;
+    char uuid[40];
+} ssdpEvent_t;
 
-OBK_DEVICE obkDevices[MAX_OBK_DEVICES];
+static ssdpDevice_t *g_ssdpDevices[SSDP_HASH_SIZE];
+static int g_ssdpDevicesCount = 0;
+static ssdpEvent_t g_ssdpEvents[SSDP_MAX_EVENTS];
+// sequence number of last event, first one is 1
+static unsigned int g_ssdpEventSeq = 0;
 
-static void obkDeviceTick(uint32_t ip){
+static const char *g_ssdpEventNames[] = { "new", "lost", "change" };
+
+static uint32_t SSDP_Hash(const char *uuid, uint32_t ip) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
     int i;
-    for (i = 0; i < MAX_OBK_DEVICES; i++){
-        if (obkDevices[i].ip == ip){
-            obkDevices[i].timeout = OBK_DEVICE_TIMEOUT;
-            addLogAdv(LOG_EXTRADEBUG, LOG_FEATURE_HTTP,"SSDP obk device still present 0x%08x",ip);
-            break;
+
+    if (*uuid) {
+        while (*uuid) {
+            h = (h ^ (byte)*uuid++) * 16777619u;
+        }
+    }
+    else {
+        for (i = 0; i < 4; i++) {
+            h = (h ^ ((ip >> (i * 8)) & 0xFF)) * 16777619u;
+        }
+    }
+    return h;
+}
+
+static void SSDP_FormatIP(uint32_t ip, char *o) {
+    sprintf(o, "%d.%d.%d.%d", ip & 0xff, (ip & 0xff00) >> 8, (ip & 0xff0000) >> 16, (ip & 0xff000000) >> 24);
+}
+
+static void SSDP_AddEvent(byte kind, ssdpDevice_t *d) {
+    static const byte codes[] = { CMD_EVENT_SSDP_NEW, CMD_EVENT_SSDP_LOST, CMD_EVENT_SSDP_CHANGE };
+    ssdpEvent_t *ev;
+    char ipStr[16];
+
+    g_ssdpEventSeq++;
+    ev = &g_ssdpEvents[g_ssdpEventSeq % SSDP_MAX_EVENTS];
+    ev->seq = g_ssdpEventSeq;
+    ev->kind = kind;
+    ev->ip = d->ip;
+    strcpy(ev->uuid, d->uuid);
+    SSDP_FormatIP(d->ip, ipStr);
+    addLogAdv(LOG_DEBUG, LOG_FEATURE_HTTP, "SSDP device %s %s %s", g_ssdpEventNames[kind], ipStr, d->uuid);
+    EventHandlers_FireEvent(codes[kind], ntohl(d->ip) & 0xFF);
+}
+
+static ssdpDevice_t *SSDP_FindDevice(const char *uuid, uint32_t ip, uint32_t hash) {
+    ssdpDevice_t *d;
+
+    for (d = g_ssdpDevices[hash % SSDP_HASH_SIZE]; d; d = d->next) {
+        if (d->hash != hash)
+            continue;
+        if (*uuid ? !strcmp(d->uuid, uuid) : (d->uuid[0] == 0 && d->ip == ip))
+            return d;
+    }
+    return 0;
+}
+
+static void SSDP_RemoveDevice(ssdpDevice_t *d, bool bFireEvent) {
+    ssdpDevice_t **p;
+
+    for (p = &g_ssdpDevices[d->hash % SSDP_HASH_SIZE]; *p; p = &(*p)->next) {
+        if (*p == d) {
+            *p = d->next;
+            g_ssdpDevicesCount--;
+            if (bFireEvent)
+                SSDP_AddEvent(SSDP_EVENT_LOST, d);
+            free(d);
+            return;
         }
     }
+}
+
+// when table is full, other device closest to expiry makes room for new one.
+// OpenBeken ones always expire sooner (OBK_DEVICE_TIMEOUT), so they are
+// evicted only for another OpenBeken device, when there is nothing else.
+// Returns false if new device has to be ignored.
+static bool SSDP_EvictDevice(bool bForObk) {
+    ssdpDevice_t *d, *oldest = 0, *oldestObk = 0;
+    int i;
 
-    if (i == MAX_OBK_DEVICES){
-        for (i = 0; i < MAX_OBK_DEVICES; i++){
-            if (obkDevices[i].ip == 0){
-                obkDevices[i].ip = ip;
-                obkDevices[i].timeout = OBK_DEVICE_TIMEOUT;
-                addLogAdv(LOG_EXTRADEBUG, LOG_FEATURE_HTTP,"SSDP new obk device 0x%08x",ip);
-                break;
+    for (i = 0; i < SSDP_HASH_SIZE; i++) {
+        for (d = g_ssdpDevices[i]; d; d = d->next) {
+            if (d->bObk) {
+                if (oldestObk == 0 || d->timeout < oldestObk->timeout)
+                    oldestObk = d;
+            }
+            else if (oldest == 0 || d->timeout < oldest->timeout) {
+                oldest = d;
             }
         }
     }
+    if (oldest == 0 && bForObk)
+        oldest = oldestObk;
+    if (oldest == 0)
+        return false;
+    SSDP_RemoveDevice(oldest, true);
+    return true;
 }
 
-static void obkDeviceList(){
-    for (int i = 0; i < MAX_OBK_DEVICES; i++){
-        if (obkDevices[i].ip != 0){
-            addLogAdv(LOG_INFO, LOG_FEATURE_HTTP,"obk device 0x%08x", obkDevices[i].ip);
+static void SSDP_ClearDevices() {
+    ssdpDevice_t *d;
+    int i;
+
+    for (i = 0; i < SSDP_HASH_SIZE; i++) {
+        while (g_ssdpDevices[i]) {
+            d = g_ssdpDevices[i];
+            g_ssdpDevices[i] = d->next;
+            free(d);
         }
     }
+    g_ssdpDevicesCount = 0;
 }
 
+// copies value of header, without leading spaces, returns false if there is none,
+// quotes, backslashes and control chars are replaced, so value can go to JSON as is
+static bool SSDP_GetHeader(const char *msg, const char *name, char *o, int maxSize) {
+    const char *p;
+    int nameLen = strlen(name);
+    int len;
+
+    for (p = strchr(msg, '\n'); p; p = strchr(p, '\n')) {
+        p++;
+        if (wal_strnicmp(p, name, nameLen) || p[nameLen] != ':')
+            continue;
+        p += nameLen + 1;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        len = 0;
+        while (*p && *p != '\r' && *p != '\n') {
+            if (len < maxSize - 1)
+                o[len++] = (*p < ' ' || *p == '"' || *p == '\\') ? '_' : *p;
+            p++;
+        }
+        o[len] = 0;
+        return true;
+    }
+    *o = 0;
+    return false;
+}
+
+// updates registry with NOTIFY or M-SEARCH reply
+static void SSDP_OnDevicePacket(const char *msg, uint32_t ip) {
+    ssdpDevice_t *d;
+    char uuid[40];
+    char buf[64];
+    const char *p;
+    uint32_t hash;
+    bool bNew, bChanged;
+    int i, maxAge, bootId;
+
+    // USN is like uuid:e427ce1a-3e80-43d0-ad6f-89ec42e46363::upnp:rootdevice
+    SSDP_GetHeader(msg, "USN", buf, sizeof(buf));
+    uuid[0] = 0;
+    if (!wal_strnicmp(buf, "uuid:", 5)) {
+        for (i = 0, p = buf + 5; *p && *p != ':' && i < sizeof(uuid) - 1; i++, p++) {
+            uuid[i] = *p;
+        }
+        uuid[i] = 0;
+    }
+    // our own NOTIFY, looped back
+    if (!strcmp(uuid, g_ssdp_uuid)) {
+        return;
+    }
+    hash = SSDP_Hash(uuid, ip);
+    d = SSDP_FindDevice(uuid, ip, hash);
+
+    SSDP_GetHeader(msg, "NTS", buf, sizeof(buf));
+    if (!stricmp(buf, "ssdp:byebye")) {
+        if (d) {
+            SSDP_RemoveDevice(d, true);
+        }
+        return;
+    }
+    if (d == 0) {
+        if (g_ssdpDevicesCount >= SSDP_MAX_DEVICES) {
+            SSDP_GetHeader(msg, "SERVER", buf, sizeof(buf));
+            if (SSDP_EvictDevice(strstr(buf, "OpenBk") != 0) == false) {
+                return;
+            }
+        }
+        d = (ssdpDevice_t*)malloc(sizeof(ssdpDevice_t));
+        if (d == 0) {
+            addLogAdv(LOG_ERROR, LOG_FEATURE_HTTP, "SSDP: failed to malloc device");
+            return;
+        }
+        memset(d, 0, sizeof(ssdpDevice_t));
+        d->hash = hash;
+        d->ip = ip;
+        d->bootId = -1;
+        strcpy(d->uuid, uuid);
+        d->next = g_ssdpDevices[hash % SSDP_HASH_SIZE];
+        g_ssdpDevices[hash % SSDP_HASH_SIZE] = d;
+        g_ssdpDevicesCount++;
+        bNew = true;
+        bChanged = false;
+    }
+    else {
+        bNew = false;
+        bChanged = d->ip != ip;
+        d->ip = ip;
+    }
+
+    SSDP_GetHeader(msg, "SERVER", d->server, sizeof(d->server));
+    d->bObk = strstr(d->server, "OpenBk") != 0;
+    SSDP_GetHeader(msg, "LOCATION", buf, sizeof(d->location));
+    if (strcmp(buf, d->location)) {
+        bChanged |= d->location[0] != 0;
+        strcpy(d->location, buf);
+    }
+    bootId = -1;
+    if (SSDP_GetHeader(msg, "BOOTID.UPNP.ORG", buf, sizeof(buf))) {
+        bootId = atoi(buf);
+    }
+    if (bootId != d->bootId) {
+        bChanged |= d->bootId != -1;
+        d->bootId = bootId;
+    }
+    // NOTIFY has NT, M-SEARCH reply has ST
+    if (SSDP_GetHeader(msg, "NT", buf, sizeof(buf)) || SSDP_GetHeader(msg, "ST", buf, sizeof(buf))) {
+        if (!wal_strnicmp(buf, "urn:", 4) && strstr(buf, ":device:")) {
+            strcpy(d->type, buf);
+        }
+    }
+    maxAge = SSDP_DEFAULT_MAX_AGE;
+    if (SSDP_GetHeader(msg, "CACHE-CONTROL", buf, sizeof(buf)) && (p = strstr(buf, "max-age")) != 0) {
+        p += 7;
+        while (*p == ' ' || *p == '=')
+            p++;
+        maxAge = atoi(p);
+    }
+    d->maxAge = maxAge;
+    d->timeout = d->bObk ? OBK_DEVICE_TIMEOUT : maxAge;
+
+    if (d->timeout <= 0) {
+        SSDP_RemoveDevice(d, bNew == false);
+        return;
+    }
+    if (d->bObk) {
+        addLogAdv(LOG_EXTRADEBUG, LOG_FEATURE_HTTP, "SSDP obk device 0x%08x", ip);
+    }
+    if (bNew) {
+        SSDP_AddEvent(SSDP_EVENT_NEW, d);
+    }
+    else if (bChanged) {
+        SSDP_AddEvent(SSDP_EVENT_CHANGE, d);
+    }
+}
+static void obkDeviceList(){
+    ssdpDevice_t *d;
+    char ipStr[16];
+    int i;
 
+    for (i = 0; i < SSDP_HASH_SIZE; i++) {
+        for (d = g_ssdpDevices[i]; d; d = d->next) {
+            SSDP_FormatIP(d->ip, ipStr);
+            addLogAdv(LOG_INFO, LOG_FEATURE_HTTP, "%s device %s %s %s, %i s left", d->bObk ? "obk" : "ssdp",
+                ipStr, d->uuid, d->server, d->timeout);
+        }
+    }
+}
+
+// OpenBeken devices only, as before
 static int http_rest_get_devicelist(http_request_t* request) {
+    ssdpDevice_t *d;
+    char ipStr[16];
+    int i, count = 0;
+
 	http_setup(request, httpMimeTypeJson);
 	hprintf255(request, "[");
-    int count = 0;
-    for (int i = 0; i < MAX_OBK_DEVICES; i++){
-        if (obkDevices[i].ip != 0){
+    for (i = 0; i < SSDP_HASH_SIZE; i++) {
+        for (d = g_ssdpDevices[i]; d; d = d->next) {
+            if (!d->bObk)
+                continue;
             if (count) hprintf255(request,",");
-            hprintf255(request,"{\"ip\":\"%d.%d.%d.%d\"}", 
-                obkDevices[i].ip & 0xff,
-                (obkDevices[i].ip & 0xff00)>>8,
-                (obkDevices[i].ip & 0xff0000) >> 16,
-                (obkDevices[i].ip & 0xff000000) >> 24
-                );
+            SSDP_FormatIP(d->ip, ipStr);
+            hprintf255(request, "{\"ip\":\"%s\"}", ipStr);
             count++;
         }
     }
@@ -116,6 +382,56 @@ static int http_rest_get_devicelist(http_request_t* request) {
 	return 0;
 }
 
+static int http_rest_get_ssdp_devices(http_request_t* request) {
+    ssdpDevice_t *d;
+    char ipStr[16];
+    int i, count = 0;
+
+	http_setup(request, httpMimeTypeJson);
+	hprintf255(request, "[");
+    for (i = 0; i < SSDP_HASH_SIZE; i++) {
+        for (d = g_ssdpDevices[i]; d; d = d->next) {
+            if (count) hprintf255(request,",");
+            SSDP_FormatIP(d->ip, ipStr);
+            hprintf255(request, "{\"ip\":\"%s\",\"uuid\":\"%s\",\"obk\":%i,\"server\":\"%s\",",
+                ipStr, d->uuid, d->bObk, d->server);
+            hprintf255(request, "\"location\":\"%s\",", d->location);
+            hprintf255(request, "\"type\":\"%s\",\"bootId\":%i,\"maxAge\":%i,\"expiresIn\":%i}",
+                d->type, d->bootId, d->maxAge, d->timeout);
+            count++;
+        }
+    }
+	hprintf255(request, "]\n");
+	poststr(request, NULL);
+	return 0;
+}
+
+// events after given sequence number, "missed" is set when some were
+// already overwritten, then client should read whole list again
+static int http_rest_get_ssdp_events(http_request_t* request) {
+    ssdpEvent_t *ev;
+    char ipStr[16];
+    unsigned int since, seq, first, start;
+    int bMissed;
+
+    since = http_getRequestArgInteger(request, "since");
+    first = g_ssdpEventSeq > SSDP_MAX_EVENTS ? g_ssdpEventSeq - SSDP_MAX_EVENTS + 1 : 1;
+    // since from before our restart is also too old
+    bMissed = since + 1 < first || since > g_ssdpEventSeq;
+    start = bMissed ? first : since + 1;
+	http_setup(request, httpMimeTypeJson);
+    hprintf255(request, "{\"seq\":%u,\"missed\":%i,\"events\":[", g_ssdpEventSeq, bMissed);
+    for (seq = start; seq <= g_ssdpEventSeq; seq++) {
+        ev = &g_ssdpEvents[seq % SSDP_MAX_EVENTS];
+        SSDP_FormatIP(ev->ip, ipStr);
+        hprintf255(request, "%s{\"seq\":%u,\"event\":\"%s\",\"ip\":\"%s\",\"uuid\":\"%s\"}",
+            seq > start ? "," : "", seq, g_ssdpEventNames[ev->kind], ipStr, ev->uuid);
+    }
+	hprintf255(request, "]}\n");
+	poststr(request, NULL);
+	return 0;
+}
+
 ///////////////////////////////
 // private functions, only used by the public functions...
 
@@ -402,6 +718,43 @@ static commandResult_t Cmd_obkDeviceList(const void *context, const char *cmd, c
     return CMD_RES_OK;
 }
 
+static const char search_template[] = 
+"M-SEARCH * HTTP/1.1\r\n" \
+"HOST: 239.255.255.250:1900\r\n" \
+"MAN: \"ssdp:discover\"\r\n" \
+"MX: 2\r\n" \
+"ST: %s\r\n" \
+"USER-AGENT: OpenBk\r\n" \
+"\r\n" \
+;
+
+static commandResult_t Cmd_SSDP_Search(const void *context, const char *cmd, const char *args, int cmdFlags){
+    struct sockaddr_in multicastaddr;
+    char msg[160];
+    int nbytes;
+
+    if (g_ssdp_socket_receive <= 0){
+    	addLogAdv(LOG_ERROR, LOG_FEATURE_HTTP,"ssdp_search: no socket");
+        return CMD_RES_ERROR;
+    }
+    Tokenizer_TokenizeString(args, 0);
+    snprintf(msg, sizeof(msg), search_template,
+        Tokenizer_GetArgsCount() >= 1 ? Tokenizer_GetArg(0) : "ssdp:all");
+
+    memset(&multicastaddr, 0, sizeof(multicastaddr));
+    multicastaddr.sin_family = AF_INET;
+    multicastaddr.sin_addr.s_addr = inet_addr(ssdp_group);
+    multicastaddr.sin_port = htons(ssdp_port);
+    // replies come back to our socket, unicast, as "HTTP/1.1 200 OK"
+    nbytes = sendto(g_ssdp_socket_receive, msg, strlen(msg), 0,
+        (struct sockaddr*) &multicastaddr, sizeof(multicastaddr));
+    if (nbytes <= 0){
+	    addLogAdv(LOG_INFO, LOG_FEATURE_HTTP,"ssdp_search: failed to send");
+        return CMD_RES_ERROR;
+    }
+    return CMD_RES_OK;
+}
+
 ///////////////////////////////////////////////
 // public functions, only used in drv_main
 
@@ -414,7 +767,7 @@ void DRV_SSDP_Init()
         return;
     }
 
-    memset(obkDevices, 0, sizeof(obkDevices));
+    SSDP_ClearDevices();
 
     addLogAdv(LOG_INFO, LOG_FEATURE_HTTP,"DRV_SSDP_Init");
     // like "e427ce1a-3e80-43d0-ad6f-89ec42e46363";
@@ -434,8 +787,15 @@ void DRV_SSDP_Init()
 	//cmddetail:"fn":"Cmd_obkDeviceList","file":"driver/drv_ssdp.c","requires":"",
 	//cmddetail:"examples":""}
     CMD_RegisterCommand("obkDeviceList", "", Cmd_obkDeviceList, NULL, NULL);
+	//cmddetail:{"name":"ssdp_search","args":"[OptionalSearchTarget]",
+	//cmddetail:"descr":"Multicasts SSDP M-SEARCH (for ssdp:all by default), replies are added to the SSDP device list",
+	//cmddetail:"fn":"Cmd_SSDP_Search","file":"driver/drv_ssdp.c","requires":"",
+	//cmddetail:"examples":"ssdp_search upnp:rootdevice"}
+    CMD_RegisterCommand("ssdp_search", "", Cmd_SSDP_Search, NULL, NULL);
 
     HTTP_RegisterCallback("/obkdevicelist", HTTP_GET, http_rest_get_devicelist);
+    HTTP_RegisterCallback("/api/ssdp/devices", HTTP_GET, http_rest_get_ssdp_devices);
+    HTTP_RegisterCallback("/api/ssdp/events", HTTP_GET, http_rest_get_ssdp_events);
 
     DRV_SSDP_Active = 1;
 }
@@ -453,21 +813,23 @@ void DRV_SSDP_RunEverySecond() {
         ssdp_timercount = 0;
     }
 
-    for (int i = 0; i < MAX_OBK_DEVICES; i++){
-        if (obkDevices[i].timeout){
-            obkDevices[i].timeout --;
-            if (!obkDevices[i].timeout){
-                obkDevices[i].ip = 0;
+    for (int i = 0; i < SSDP_HASH_SIZE; i++){
+        ssdpDevice_t **p = &g_ssdpDevices[i];
+        while (*p){
+            ssdpDevice_t *d = *p;
+            d->timeout--;
+            if (d->timeout <= 0){
+                // removal unlinks it, *p is next one
+                SSDP_RemoveDevice(d, true);
+            } else {
+                p = &d->next;
             }
         }
     }
 }
 
-void DRV_SSDP_RunQuickTick() {
-
-	if (g_ssdp_socket_receive <= 0) {
-		return ;
-	}
+// returns 0 if there was nothing to read
+static int DRV_SSDP_ReceivePacket() {
     // now just enter a read-print loop
     //
     struct sockaddr_in addr;
@@ -489,7 +851,7 @@ void DRV_SSDP_RunQuickTick() {
     udp_msgbuf[UDP_MSGBUF_LEN] = 0;
     if (nbytes <= 0) {
         //addLogAdv(LOG_INFO, LOG_FEATURE_HTTP,"nothing\n");
-        return ;
+        return 0;
     }
     // just so we can terminate for print
     if (nbytes >= UDP_MSGBUF_LEN){
@@ -519,21 +881,24 @@ void DRV_SSDP_RunQuickTick() {
     // our NOTIFTY like:
     //"NOTIFY * HTTP/1.1\r\n" 
     //"SERVER: OpenBk\r\n" 
-    if (!strncmp(udp_msgbuf, "NOTIFY", 6)){
-        const char *p = udp_msgbuf;
-        while (*p && *p != '\n'){
-            p++;
-        }
-        if (*p == '\n'){
-            p++;
-            if (!strncmp(p, "SERVER: OpenBk", 14)){
-                addLogAdv(LOG_EXTRADEBUG, LOG_FEATURE_HTTP,"NOTIFY from a peer device");
-                // add the device to the device list, or set timeout to 0
-                obkDeviceTick(*(uint32_t *)(&((struct sockaddr_in *)&addr)->sin_addr));
-            }
-        }
+    // or reply to our M-SEARCH, "HTTP/1.1 200 OK"
+    if (!strncmp(udp_msgbuf, "NOTIFY", 6) || !strncmp(udp_msgbuf, "HTTP/1.1 200", 12)){
+        SSDP_OnDevicePacket(udp_msgbuf, addr.sin_addr.s_addr);
     }
+    return 1;
+}
+
+void DRV_SSDP_RunQuickTick() {
+    int i;
 
+	if (g_ssdp_socket_receive <= 0) {
+		return ;
+	}
+    // on busy network there can be many packets queued, drain some each tick
+    for (i = 0; i < SSDP_MAX_PACKETS_PER_TICK; i++){
+        if (!DRV_SSDP_ReceivePacket())
+            break;
+    }
 }
 
 
@@ -562,6 +927,11 @@ void DRV_SSDP_Shutdown(){
         free(http_message);
         http_message = NULL;
     }
+    SSDP_ClearDevices();
+}
+
+int DRV_SSDP_GetDevicesCount(){
+    return g_ssdpDevicesCount;
 }
 
 // end public
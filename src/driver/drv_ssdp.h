@@ -5,3 +5,5 @@ extern void DRV_SSDP_Init();
 extern void DRV_SSDP_RunEverySecond();
 extern void DRV_SSDP_RunQuickTick();
 extern void DRV_SSDP_Shutdown();
+// devices currently in SSDP registry
+extern int DRV_SSDP_GetDevicesCount();
@@ -116,22 +116,15 @@ typedef struct rtcc_s {
     uint32_t      valid;
 } rtcc_t;
 
-typedef struct tuyaMCUMapping_s {
-    // internal Tuya variable index
-    int fnId;
-    // target channel
-    int channel;
-    // data point type (one of the DP_TYPE_xxx defines)
-    int dpType;
-    // store last channel value to avoid sending it again
-    int prevValue;
-    // TODO
-    //int mode;
-    // list
-    struct tuyaMCUMapping_s *next;
-} tuyaMCUMapping_t;
-
-tuyaMCUMapping_t *g_tuyaMappings = 0;
+// Mappings are kept in one compact array (so they can be dumped and reloaded
+// as a single block) and are looked up through two direct-indexed tables,
+// by dpId and by channel. Tables hold slot index + 1 (0 means not mapped)
+// and are rebuilt every time the mappings change.
+static tuyaMCUMapping_t *g_tuyaMappings = 0;
+static int g_tuyaMappingsCount = 0;
+static int g_tuyaMappingsAllocated = 0;
+static short g_tuyaMappingByDpId[TUYAMCU_MAX_DPID];
+static short g_tuyaMappingByChannel[CHANNEL_MAX];
 
 /**
  * Dimmer range
@@ -162,45 +155,108 @@ static bool self_processing_mode = true;
 static bool state_updated = false;
 static int g_sendQueryStatePackets = 0;
 
-tuyaMCUMapping_t *TuyaMCU_FindDefForID(int fnId) {
+static void TuyaMCU_RebuildMappingTables() {
+    int i;
     tuyaMCUMapping_t *cur;
 
-    cur = g_tuyaMappings;
-    while(cur) {
-        if(cur->fnId == fnId)
-            return cur;
-        cur = cur->next;
+    memset(g_tuyaMappingByDpId, 0, sizeof(g_tuyaMappingByDpId));
+    memset(g_tuyaMappingByChannel, 0, sizeof(g_tuyaMappingByChannel));
+    // if more than one dpId maps to the same channel, the last one added wins
+    for(i = 0; i < g_tuyaMappingsCount; i++) {
+        cur = &g_tuyaMappings[i];
+        g_tuyaMappingByDpId[cur->fnId] = i + 1;
+        if(cur->channel >= 0 && cur->channel < CHANNEL_MAX) {
+            g_tuyaMappingByChannel[cur->channel] = i + 1;
+        }
     }
-    return 0;
+}
+
+tuyaMCUMapping_t *TuyaMCU_FindDefForID(int fnId) {
+    int slot;
+
+    if(fnId < 0 || fnId >= TUYAMCU_MAX_DPID)
+        return 0;
+    slot = g_tuyaMappingByDpId[fnId];
+    if(slot == 0)
+        return 0;
+    return &g_tuyaMappings[slot - 1];
 }
 
 tuyaMCUMapping_t *TuyaMCU_FindDefForChannel(int channel) {
-    tuyaMCUMapping_t *cur;
+    int slot;
+
+    if(channel < 0 || channel >= CHANNEL_MAX)
+        return 0;
+    slot = g_tuyaMappingByChannel[channel];
+    if(slot == 0)
+        return 0;
+    return &g_tuyaMappings[slot - 1];
+}
 
-    cur = g_tuyaMappings;
-    while(cur) {
-        if(cur->channel == channel)
-            return cur;
-        cur = cur->next;
+static bool TuyaMCU_ReserveMappings(int count) {
+    tuyaMCUMapping_t *n;
+
+    if(count <= g_tuyaMappingsAllocated)
+        return true;
+    // grow in small steps, there are rarely more than a few dozens of dpIds
+    count = (count + 7) & ~7;
+    n = (tuyaMCUMapping_t*)realloc(g_tuyaMappings, count * sizeof(tuyaMCUMapping_t));
+    if(n == 0) {
+        addLogAdv(LOG_ERROR, LOG_FEATURE_TUYAMCU,"TuyaMCU: failed to allocate %i mappings\n", count);
+        return false;
     }
-    return 0;
+    g_tuyaMappings = n;
+    g_tuyaMappingsAllocated = count;
+    return true;
 }
 
-void TuyaMCU_MapIDToChannel(int fnId, int dpType, int channel) {
+bool TuyaMCU_MapIDToChannel(int fnId, int dpType, int channel) {
     tuyaMCUMapping_t *cur;
 
+    if(fnId < 0 || fnId >= TUYAMCU_MAX_DPID) {
+        addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"TuyaMCU_MapIDToChannel: dpId %i is out of range\n", fnId);
+        return false;
+    }
     cur = TuyaMCU_FindDefForID(fnId);
 
     if(cur == 0) {
-        cur = (tuyaMCUMapping_t*)malloc(sizeof(tuyaMCUMapping_t));
+        if(TuyaMCU_ReserveMappings(g_tuyaMappingsCount + 1) == false)
+            return false;
+        cur = &g_tuyaMappings[g_tuyaMappingsCount];
+        g_tuyaMappingsCount++;
         cur->fnId = fnId;
         cur->dpType = dpType;
         cur->prevValue = 0;
-        cur->next = g_tuyaMappings;
-        g_tuyaMappings = cur;
     }
 
     cur->channel = channel;
+
+    TuyaMCU_RebuildMappingTables();
+    return true;
+}
+
+const tuyaMCUMapping_t *TuyaMCU_GetMappings(int *count) {
+    *count = g_tuyaMappingsCount;
+    return g_tuyaMappings;
+}
+
+bool TuyaMCU_SetMappings(const tuyaMCUMapping_t *mappings, int count) {
+    int i;
+
+    for(i = 0; i < count; i++) {
+        if(mappings[i].fnId < 0 || mappings[i].fnId >= TUYAMCU_MAX_DPID) {
+            addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"TuyaMCU_SetMappings: dpId %i is out of range\n", mappings[i].fnId);
+            return false;
+        }
+    }
+    if(TuyaMCU_ReserveMappings(count) == false)
+        return false;
+    if(count > 0) {
+        memcpy(g_tuyaMappings, mappings, count * sizeof(tuyaMCUMapping_t));
+    }
+    g_tuyaMappingsCount = count;
+    TuyaMCU_RebuildMappingTables();
+    return true;
 }
 
 
@@ -208,73 +264,122 @@ void TuyaMCU_MapIDToChannel(int fnId, int dpType, int channel) {
 // 55AA     00      00      0000   xx   00
 
 #define MIN_TUYAMCU_PACKET_SIZE (2+1+1+2+1)
+#define TUYAMCU_HEADER_SIZE (2+1+1+2)
+
+// Incremental TuyaMCU frame parser.
+// Bytes are only peeked from the UART ring buffer until the frame is complete,
+// and the parser remembers how far it got, so a partially received frame
+// is not rescanned from its start every time we are called.
+// A frame is consumed from the ring buffer only after its checksum matches.
+// On bad checksum (or impossible length) only the leading 0x55 is dropped
+// and parsing resumes, so we resync on the next 0x55AA, even if it
+// was inside the corrupted frame.
+typedef struct tuyaMCUParser_s {
+	// number of bytes of current frame already checked (peek offset)
+	int pos;
+	// total frame size, known after header is received, 0 otherwise
+	int len;
+	// running checksum of bytes [0, pos)
+	byte checksum;
+} tuyaMCUParser_t;
+
+static tuyaMCUParser_t g_tuyaParser;
+static tuyaMCUParserStats_t g_tuyaParserStats;
+
+static void TuyaMCU_ResetParser() {
+	memset(&g_tuyaParser, 0, sizeof(g_tuyaParser));
+	memset(&g_tuyaParserStats, 0, sizeof(g_tuyaParserStats));
+}
+void TuyaMCU_GetParserStats(tuyaMCUParserStats_t *out) {
+	*out = g_tuyaParserStats;
+}
+// drops first byte of current frame candidate and restarts parsing from the next one
+static void TuyaMCU_Parser_Resync() {
+	UART_ConsumeBytes(1);
+	g_tuyaParser.pos = 0;
+	g_tuyaParser.len = 0;
+	g_tuyaParser.checksum = 0;
+}
+static void TuyaMCU_Parser_LogSkipped(int c_garbage_consumed, const char *printfSkipDebug) {
+	if(c_garbage_consumed > 0){
+		addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"Consumed %i unwanted non-header byte in Tuya MCU buffer\n", c_garbage_consumed);
+		addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"Skipped data (part) %s\n", printfSkipDebug);
+	}
+}
 int UART_TryToGetNextTuyaPacket(byte *out, int maxSize) {
-    int cs;
-    int len, i;
-    int c_garbage_consumed = 0;
-    byte a, b, version, command, lena, lenb;
-    char printfSkipDebug[256];
-    char buffer2[8];
-
-    printfSkipDebug[0] = 0;
-
-    cs = UART_GetDataSize();
-
-    if(cs < MIN_TUYAMCU_PACKET_SIZE) {
-        return 0;
-    }
-    // skip garbage data (should not happen)
-    while(cs > 0) {
-        a = UART_GetNextByte(0);
-        b = UART_GetNextByte(1);
-        if(a != 0x55 || b != 0xAA) {
-            UART_ConsumeBytes(1);
-            if(c_garbage_consumed + 2 < sizeof(printfSkipDebug)) {
-                snprintf(buffer2, sizeof(buffer2),"%02X ",a);
-                strcat_safe(printfSkipDebug,buffer2,sizeof(printfSkipDebug));
-            }
-            c_garbage_consumed++;
-            cs--;
-        } else {
-            break;
-        }
-    }
-    if(c_garbage_consumed > 0){
-        addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"Consumed %i unwanted non-header byte in Tuya MCU buffer\n", c_garbage_consumed);
-        addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"Skipped data (part) %s\n", printfSkipDebug);
-    }
-    if(cs < MIN_TUYAMCU_PACKET_SIZE) {
-        return 0;
-    }
-    a = UART_GetNextByte(0);
-    b = UART_GetNextByte(1);
-    if(a != 0x55 || b != 0xAA) {
-        return 0;
-    }
-    version = UART_GetNextByte(2);
-    command = UART_GetNextByte(3);
-    lena = UART_GetNextByte(4); // hi
-    lenb = UART_GetNextByte(5); // lo
-    len = lenb | lena >> 8;
-    // now check if we have received whole packet
-    len += 2 + 1 + 1 + 2 + 1; // header 2 bytes, version, command, lenght, chekcusm
-    if(cs >= len) {
-        int ret;
-        // can packet fit into the buffer?
-        if(len <= maxSize) {
-            for(i = 0; i < len; i++) {
-                out[i] = UART_GetNextByte(i);
-            }
-            ret = len;
-        } else {
-            addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"TuyaMCU packet too large, %i > %i\n", len, maxSize);
-            ret = 0;
-        }
-        // consume whole packet (but don't touch next one, if any)
-        UART_ConsumeBytes(len);
-        return ret;
-    }
-    return 0;
+	int cs;
+	int len, i;
+	int c_garbage_consumed = 0;
+	byte b;
+	char printfSkipDebug[256];
+	char buffer2[8];
+
+	printfSkipDebug[0] = 0;
+
+	cs = UART_GetDataSize();
+
+	while(g_tuyaParser.pos < cs) {
+		b = UART_GetNextByte(g_tuyaParser.pos);
+		if(g_tuyaParser.pos == 0 && b != 0x55) {
+			// skip garbage data (should not happen)
+			if(c_garbage_consumed + 2 < sizeof(printfSkipDebug)) {
+				snprintf(buffer2, sizeof(buffer2),"%02X ",b);
+				strcat_safe(printfSkipDebug,buffer2,sizeof(printfSkipDebug));
+			}
+			c_garbage_consumed++;
+			g_tuyaParserStats.bytesSkipped++;
+			UART_ConsumeBytes(1);
+			cs--;
+			continue;
+		}
+		if(g_tuyaParser.pos == 1 && b != 0xAA) {
+			// lonely 0x55, current byte will be checked again as a header start
+			c_garbage_consumed++;
+			g_tuyaParserStats.bytesSkipped++;
+			TuyaMCU_Parser_Resync();
+			cs--;
+			continue;
+		}
+		if(g_tuyaParser.len != 0 && g_tuyaParser.pos == g_tuyaParser.len - 1) {
+			// last byte is a checksum
+			if(b != g_tuyaParser.checksum) {
+				addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"TuyaMCU bad checksum, expected %i and got %i, resyncing\n",
+					(int)g_tuyaParser.checksum,(int)b);
+				g_tuyaParserStats.framesBad++;
+				TuyaMCU_Parser_Resync();
+				cs--;
+				continue;
+			}
+			len = g_tuyaParser.len;
+			for(i = 0; i < len; i++) {
+				out[i] = UART_GetNextByte(i);
+			}
+			// consume whole packet (but don't touch next one, if any)
+			UART_ConsumeBytes(len);
+			g_tuyaParser.pos = 0;
+			g_tuyaParser.len = 0;
+			g_tuyaParser.checksum = 0;
+			g_tuyaParserStats.framesGood++;
+			TuyaMCU_Parser_LogSkipped(c_garbage_consumed, printfSkipDebug);
+			return len;
+		}
+		g_tuyaParser.checksum += b;
+		g_tuyaParser.pos++;
+		if(g_tuyaParser.pos == TUYAMCU_HEADER_SIZE) {
+			// length is big endian
+			g_tuyaParser.len = (UART_GetNextByte(4) << 8) | UART_GetNextByte(5);
+			g_tuyaParser.len += MIN_TUYAMCU_PACKET_SIZE;
+			// can packet fit into the buffer?
+			if(g_tuyaParser.len > maxSize) {
+				addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"TuyaMCU packet too large, %i > %i\n", g_tuyaParser.len, maxSize);
+				g_tuyaParserStats.framesDropped++;
+				TuyaMCU_Parser_Resync();
+				cs--;
+			}
+		}
+	}
+	TuyaMCU_Parser_LogSkipped(c_garbage_consumed, printfSkipDebug);
+	return 0;
 }
 
 
@@ -609,7 +714,9 @@ commandResult_t TuyaMCU_LinkTuyaMCUOutputToChannel(const void *context, const ch
 		channelID = Tokenizer_GetArgInteger(2);
 	}
 	
-    TuyaMCU_MapIDToChannel(dpId, dpType, channelID);
+    if(TuyaMCU_MapIDToChannel(dpId, dpType, channelID) == false) {
+        return CMD_RES_BAD_ARGUMENT;
+    }
 
     return CMD_RES_OK;
 }
@@ -1093,7 +1200,7 @@ void TuyaMCU_ProcessIncoming(const byte *data, int len) {
         return;
     }
     version = data[2];
-    checkLen = data[5] | data[4] >> 8;
+    checkLen = data[5] | data[4] << 8;
     checkLen = checkLen + 2 + 1 + 1 + 2 + 1;
     if(checkLen != len) {
         addLogAdv(LOG_INFO, LOG_FEATURE_TUYAMCU,"TuyaMCU_ProcessIncoming: discarding packet bad expected len, expected %i and got len %i\n",checkLen,len);
@@ -1267,6 +1374,9 @@ void TuyaMCU_RunFrame() {
 		" self_processing_mode = %i, wifi_state_valid = %i, wifi_state_timer=%i\n",
 		(int)heartbeat_valid,(int)product_information_valid,(int)self_processing_mode,
 		(int)wifi_state_valid,(int)wifi_state_timer);
+	addLogAdv(LOG_EXTRADEBUG, LOG_FEATURE_TUYAMCU,"TuyaMCU frames good = %i, bad = %i, dropped = %i, skipped bytes = %i\n",
+		g_tuyaParserStats.framesGood,g_tuyaParserStats.framesBad,
+		g_tuyaParserStats.framesDropped,g_tuyaParserStats.bytesSkipped);
 	
     while (1)
     {
@@ -1388,6 +1498,7 @@ void TuyaMCU_Init()
 {
     UART_InitUART(g_baudRate);
     UART_InitReceiveRingBuffer(256);
+    TuyaMCU_ResetParser();
     // uartSendHex 55AA0008000007
 	//cmddetail:{"name":"tuyaMcu_testSendTime","args":"",
 	//cmddetail:"descr":"Sends a example date by TuyaMCU to clock/callendar MCU",
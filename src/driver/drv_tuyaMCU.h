@@ -7,3 +7,35 @@ void TuyaMCU_OnChannelChanged(int channel,int iVal);
 void TuyaMCU_Send_RawBuffer(byte *data, int len);
 bool TuyaMCU_IsChannelUsedByTuyaMCU(int channelIndex);
 
+// dpId is a single byte in TuyaMCU protocol
+#define TUYAMCU_MAX_DPID 256
+
+typedef struct tuyaMCUMapping_s {
+	// internal Tuya variable index
+	int fnId;
+	// target channel
+	int channel;
+	// data point type (one of the DP_TYPE_xxx defines)
+	int dpType;
+	// store last channel value to avoid sending it again
+	int prevValue;
+} tuyaMCUMapping_t;
+
+bool TuyaMCU_MapIDToChannel(int fnId, int dpType, int channel);
+// whole mapping table as a single block, eg. for saving it and loading it back
+const tuyaMCUMapping_t *TuyaMCU_GetMappings(int *count);
+bool TuyaMCU_SetMappings(const tuyaMCUMapping_t *mappings, int count);
+
+typedef struct tuyaMCUParserStats_s {
+	// frames with valid checksum, passed to TuyaMCU_ProcessIncoming
+	int framesGood;
+	// frames rejected due to checksum mismatch
+	int framesBad;
+	// frames that were too large for the receive buffer
+	int framesDropped;
+	// non-header bytes skipped while looking for 0x55AA
+	int bytesSkipped;
+} tuyaMCUParserStats_t;
+
+void TuyaMCU_GetParserStats(tuyaMCUParserStats_t *out);
+
@@ -105,6 +105,7 @@ void UART_InitReceiveRingBuffer(int size){
 	memset(g_recvBuf,0,size);
 	g_recvBufSize = size;
 	g_recvBufIn = 0;
+	g_recvBufOut = 0;
 }
 int UART_GetDataSize()
 {
@@ -118,16 +119,19 @@ int UART_GetDataSize()
 
     return remain_buf_size;
 }
+int UART_GetBufferSize() {
+	return g_recvBufSize;
+}
 byte UART_GetNextByte(int index) {
 	int realIndex = g_recvBufOut + index;
-	if(realIndex > g_recvBufSize)
+	if(realIndex >= g_recvBufSize)
 		realIndex -= g_recvBufSize;
 
 	return g_recvBuf[realIndex];
 }
 void UART_ConsumeBytes(int idx) {
 	g_recvBufOut += idx;
-	if(g_recvBufOut > g_recvBufSize)
+	if(g_recvBufOut >= g_recvBufSize)
 		g_recvBufOut -= g_recvBufSize;
 }
 
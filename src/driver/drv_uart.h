@@ -3,6 +3,7 @@
 
 void UART_InitReceiveRingBuffer(int size);
 int UART_GetDataSize();
+int UART_GetBufferSize();
 byte UART_GetNextByte(int index);
 void UART_ConsumeBytes(int idx);
 void UART_AppendByteToCircularBuffer(int rc);
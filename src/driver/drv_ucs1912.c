@@ -1,3 +1,5 @@
+#if defined(PLATFORM_BEKEN) || defined(WINDOWS)
+
 #include "../new_common.h"
 #include "../new_pins.h"
 #include "../new_cfg.h"
@@ -7,80 +9,74 @@
 #include "../logging/logging.h"
 #include "../hal/hal_pins.h"
 #include "../httpserver/new_http.h"
+#include "drv_pixelBus.h"
 
 // UCS1912 is 12 channels each.
-// We send 96 bits. 96 / 8 = 12. Send byte per each channel. 
-
-// values in ns
-#define UCS1912_T0H	250
-#define UCS1912_T0L	1000
-
-#define UCS1912_T1H	1000
-#define UCS1912_T1L	250
+// We send 96 bits. 96 / 8 = 12. Send byte per each channel.
+// So by default strip is set up as 4 RGB pixels per chip.
 
 // Those times differ from WS2812B, from what I can see...
-
 // Sending one bit to UCS1912 takes 1250ns.
-// So sending 96 bits would take 96 * 1250 = 120000ns = 0.12ms 
-
-#define UCS1912_RESET 24000
-
-static int g_pin_di = 0;
-
+// So sending 96 bits would take 96 * 1250 = 120000ns = 0.12ms
+// Timings are in g_pixelBusProtocol_UCS1912, bits are sent by pixel bus.
 
-#define UCS1912_SLEEP_250	__asm__("nop\nnop");
-#define UCS1912_SLEEP_1000	__asm__("nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop");
+static pixelBus_t g_bus;
 
-#define UCS1912_SEND_T0 HAL_PIN_SetOutputValue(g_pin_di,true); UCS1912_SLEEP_250; HAL_PIN_SetOutputValue(g_pin_di,false); UCS1912_SLEEP_1000;
-#define UCS1912_SEND_T1 HAL_PIN_SetOutputValue(g_pin_di,true); UCS1912_SLEEP_1000; HAL_PIN_SetOutputValue(g_pin_di,false); UCS1912_SLEEP_250;
-
-#ifndef CHECK_BIT
-#define CHECK_BIT(var,pos) ((var) & (1<<(pos)))
-#endif
-
-#define UCS1912_SEND_BIT(var,pos) if(((var) & (1<<(pos)))) { UCS1912_SEND_T1; } else { UCS1912_SEND_T0; };
-
-static void UCS1912_Send(byte *data, int dataSize){
-	int i;
-	byte b;
-
-	for(i = 0; i < dataSize; i++) {
-		b = data[i];
-		UCS1912_SEND_BIT(b,0);
-		UCS1912_SEND_BIT(b,1);
-		UCS1912_SEND_BIT(b,2);
-		UCS1912_SEND_BIT(b,3);
-		UCS1912_SEND_BIT(b,4);
-		UCS1912_SEND_BIT(b,5);
-		UCS1912_SEND_BIT(b,6);
-		UCS1912_SEND_BIT(b,7);
-	}
-}
 static commandResult_t UCS1912_Test(const void *context, const char *cmd, const char *args, int flags){
-	byte test[12];
 	int i;
 
-	for(i = 0; i < 12; i++){
-		test[i] = rand();
+	for(i = 0; i < g_bus.count; i++){
+		PixelBus_SetPixel(&g_bus, i, rand(), rand(), rand(), rand());
 	}
-	UCS1912_Send(test,12);
+	PixelBus_Show(&g_bus);
 
 	return CMD_RES_OK;
 }
+static commandResult_t UCS1912_InitForLEDCount(const void *context, const char *cmd, const char *args, int flags) {
+	return PixelBus_CmdSetup(&g_bus, args);
+}
+static commandResult_t UCS1912_SetPixel(const void *context, const char *cmd, const char *args, int flags) {
+	return PixelBus_CmdSetPixel(&g_bus, args);
+}
+static commandResult_t UCS1912_Show(const void *context, const char *cmd, const char *args, int flags) {
+	PixelBus_Show(&g_bus);
+	return CMD_RES_OK;
+}
+void UCS1912_RunQuickTick() {
+	PixelBus_RunQuickTick(&g_bus);
+}
+void UCS1912_Shutdown() {
+	PixelBus_Shutdown(&g_bus);
+}
 
 // startDriver UCS1912
 void UCS1912_Init() {
+	int pin;
 
-
-	g_pin_di = PIN_FindPinIndexForRole(IOR_UCS1912_DIN,g_pin_di);
-
-	HAL_PIN_Setup_Output(g_pin_di);
+	pin = PIN_FindPinIndexForRole(IOR_UCS1912_DIN, 0);
+	PixelBus_Init(&g_bus, &g_pixelBusProtocol_UCS1912, pin);
+	PixelBus_Setup(&g_bus, 4, 0);
 
 	//cmddetail:{"name":"UCS1912_Test","args":"",
-	//cmddetail:"descr":"",
+	//cmddetail:"descr":"Sets random colors on all pixels and shows them",
 	//cmddetail:"fn":"UCS1912_Test","file":"driver/drv_ucs1912.c","requires":"",
 	//cmddetail:"examples":""}
     CMD_RegisterCommand("UCS1912_Test", "", UCS1912_Test, NULL, NULL);
+	//cmddetail:{"name":"UCS1912_Init","args":"[NumberOfPixels][Order]",
+	//cmddetail:"descr":"Sets number of RGB(W) pixels (4 per chip) and color order",
+	//cmddetail:"fn":"UCS1912_InitForLEDCount","file":"driver/drv_ucs1912.c","requires":"",
+	//cmddetail:"examples":"UCS1912_Init 40"}
+	CMD_RegisterCommand("UCS1912_Init", "", UCS1912_InitForLEDCount, NULL, NULL);
+	//cmddetail:{"name":"UCS1912_SetPixel","args":"[IndexOrAll][R][G][B][W]",
+	//cmddetail:"descr":"Sets pixel color in framebuffer, use UCS1912_Show to send it",
+	//cmddetail:"fn":"UCS1912_SetPixel","file":"driver/drv_ucs1912.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("UCS1912_SetPixel", "", UCS1912_SetPixel, NULL, NULL);
+	//cmddetail:{"name":"UCS1912_Show","args":"",
+	//cmddetail:"descr":"Sends framebuffer to chips",
+	//cmddetail:"fn":"UCS1912_Show","file":"driver/drv_ucs1912.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("UCS1912_Show", "", UCS1912_Show, NULL, NULL);
 }
 
-
+#endif
@@ -107,5 +107,57 @@ int HAL_Configuration_SaveConfigMemory(void *src, int dataLen){
     return dataLen;
 }
 
+// config partition is erased sector by sector, and SaveConfigMemory erases only
+// the sectors config fits in, so journal must not go past the first one
+#define CONFIG_AREA_MAX_SIZE 0x1000
 
+int HAL_Configuration_GetConfigAreaSize() {
+	bk_logic_partition_t *pt = bk_flash_get_info(BK_PARTITION_NET_PARAM);
+
+	if (pt == 0) {
+		return 0;
+	}
+	if (pt->partition_length < CONFIG_AREA_MAX_SIZE) {
+		return pt->partition_length;
+	}
+	return CONFIG_AREA_MAX_SIZE;
+}
+int HAL_Configuration_ReadConfigArea(int offset, void *target, int dataLen) {
+	UINT32 status;
+	DD_HANDLE flash_handle;
+	bk_logic_partition_t *pt = bk_flash_get_info(BK_PARTITION_NET_PARAM);
 
+	if (offset < 0 || offset + dataLen > HAL_Configuration_GetConfigAreaSize()) {
+		return 0;
+	}
+	hal_flash_lock();
+	flash_handle = ddev_open(FLASH_DEV_NAME, &status, 0);
+	ddev_read(flash_handle, (char *)target, dataLen, pt->partition_start_addr + offset);
+	ddev_close(flash_handle);
+	hal_flash_unlock();
+	return dataLen;
+}
+int HAL_Configuration_WriteConfigArea(int offset, const void *src, int dataLen) {
+	BaseType_t taken;
+
+	if (offset < 0 || offset + dataLen > HAL_Configuration_GetConfigAreaSize()) {
+		return 0;
+	}
+	if (!config_mutex) {
+		config_mutex = xSemaphoreCreateMutex( );
+	}
+	taken = xSemaphoreTake( config_mutex, 100 );
+
+	// no erase, target must be still erased after last SaveConfigMemory
+	hal_flash_lock();
+	bk_flash_enable_security(FLASH_PROTECT_NONE);
+	bk_flash_write(BK_PARTITION_NET_PARAM, offset, (uint8_t *)src, dataLen);
+	bk_flash_enable_security(FLASH_PROTECT_ALL);
+	hal_flash_unlock();
+
+	if (taken == pdTRUE)
+		xSemaphoreGive( config_mutex );
+
+	ADDLOG_DEBUG(LOG_FEATURE_CFG, "HAL_Configuration_WriteConfigArea: wrote %d bytes at %d", dataLen, offset);
+	return dataLen;
+}
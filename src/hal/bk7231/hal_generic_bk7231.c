@@ -1,8 +1,200 @@
-
+#include "../../new_common.h"
 
 // from wlan_ui.c
 void bk_reboot(void);
 
 void HAL_RebootModule() {
 	bk_reboot();
-}
\ No newline at end of file
+}
+
+#if PLATFORM_BK7231N
+
+#include "include.h"
+#include "arm_arch.h"
+#include "bk_timer_pub.h"
+#include "drv_model_pub.h"
+#include "../../beken378/driver/pwm/bk_timer.h"
+
+// BKTIMER0 is used by IR driver. Timers 0-2 count 26 MHz clock up to end value,
+// this one wraps every second and counts seconds in interrupt.
+#define HAL_US_TIMER			BKTIMER2
+#define HAL_US_TIMER_PERIOD		1000000
+#define HAL_US_TIMER_MHZ		26
+// counter value that is just after wrap, see HAL_GetTimeUs
+#define HAL_US_TIMER_WRAP_WINDOW	(1000 * HAL_US_TIMER_MHZ)
+
+static volatile uint32_t g_usTimerSeconds;
+static uint32_t g_usTimerLast;
+// 0 - not started yet, 1 - running, -1 - timer couldn't be started
+static int g_usTimerState;
+
+static void HAL_UsTimer_ISR(UINT8 arg) {
+	g_usTimerSeconds++;
+}
+static void HAL_UsTimer_Start() {
+	timer_param_t params = {
+		(unsigned char)HAL_US_TIMER,
+		(unsigned char)1,
+		HAL_US_TIMER_PERIOD,
+		HAL_UsTimer_ISR
+	};
+	UINT32 chan = HAL_US_TIMER;
+
+	g_usTimerState = -1;
+	if (sddev_control((char *)TIMER_DEV_NAME, CMD_TIMER_INIT_PARAM_US, &params) != 0)
+		return;
+	if (sddev_control((char *)TIMER_DEV_NAME, CMD_TIMER_UNIT_ENABLE, &chan) != 0)
+		return;
+	g_usTimerState = 1;
+}
+static uint32_t HAL_UsTimer_ReadCount() {
+	int timeout = 1000;
+
+	// latch counter of given timer (index in bits 2-3) and wait until it can be read
+	REG_WRITE(TIMER0_2_READ_CTL, (HAL_US_TIMER << 2) | 1);
+	while ((REG_READ(TIMER0_2_READ_CTL) & 1) && --timeout) {
+	}
+	return REG_READ(TIMER0_2_READ_VALUE);
+}
+int HAL_HasTimeUs() {
+	if (g_usTimerState == 0) {
+		HAL_UsTimer_Start();
+	}
+	return g_usTimerState == 1;
+}
+uint32_t HAL_GetTimeUs() {
+	uint32_t sec, cnt, now;
+
+	if (HAL_HasTimeUs() == 0)
+		return 0;
+	do {
+		sec = g_usTimerSeconds;
+		cnt = HAL_UsTimer_ReadCount();
+	} while (sec != g_usTimerSeconds);
+	now = sec * HAL_US_TIMER_PERIOD + cnt / HAL_US_TIMER_MHZ;
+	// counter has just wrapped, but its interrupt wasn't handled yet
+	// (interrupts are masked or we are called from other ISR)
+	if (cnt < HAL_US_TIMER_WRAP_WINDOW && (int32_t)(now - g_usTimerLast) < 0) {
+		now += HAL_US_TIMER_PERIOD;
+	}
+	g_usTimerLast = now;
+	return now;
+}
+
+#else
+
+// BK7231T timers have no readable counter, so there is no microsecond time
+int HAL_HasTimeUs() {
+	return 0;
+}
+uint32_t HAL_GetTimeUs() {
+	return 0;
+}
+
+#endif
+uint32_t HAL_GetTimeMs() {
+	return rtos_get_time();
+}
+
+#if PLATFORM_BK7231N
+
+#include "spi_pub.h"
+#include "general_dma_pub.h"
+#include "../../beken378/driver/spi/spi.h"
+#include "../../beken378/driver/general_dma/general_dma.h"
+
+// SPI master TX only, MOSI is fixed to P16, GDMA feeds SPI data register
+#define HAL_SPI_MOSI_PIN	16
+#define HAL_SPI_DMA_CHANNEL	GDMA_CHANNEL_3
+
+static byte g_spiOpen;
+static volatile byte g_spiBusy;
+
+// NOTE: ISR
+static void HAL_SPI_DMAFinished(UINT32 param) {
+	g_spiBusy = 0;
+}
+static void HAL_SPI_DMAEnable(int enable) {
+	GDMA_CFG_ST en_cfg;
+	UINT32 reg;
+
+	reg = REG_READ(SPI_CONFIG);
+	if (enable)
+		reg |= SPI_TX_EN;
+	else
+		reg &= ~SPI_TX_EN;
+	REG_WRITE(SPI_CONFIG, reg);
+	en_cfg.channel = HAL_SPI_DMA_CHANNEL;
+	en_cfg.param = enable;
+	sddev_control(GDMA_DEV_NAME, CMD_GDMA_SET_DMA_ENABLE, &en_cfg);
+}
+int HAL_SPI_Init(int pin, int bitRateHz) {
+	if (pin != HAL_SPI_MOSI_PIN)
+		return 0;
+	if (g_spiOpen)
+		HAL_SPI_Deinit();
+	// mode 0, 8 bit, MSB first, line idles low between frames
+	if (bk_spi_master_init(bitRateHz, SPI_MODE_0 | SPI_MSB) != 0)
+		return 0;
+	g_spiOpen = 1;
+	g_spiBusy = 0;
+	return 1;
+}
+void HAL_SPI_Deinit() {
+	if (g_spiOpen == 0)
+		return;
+	HAL_SPI_DMAEnable(0);
+	bk_spi_master_deinit();
+	g_spiOpen = 0;
+	g_spiBusy = 0;
+}
+void HAL_SPI_Send(const byte *data, int len) {
+	GDMACFG_TPYES_ST init_cfg;
+	GDMA_CFG_ST en_cfg;
+
+	if (g_spiOpen == 0 || len <= 0)
+		return;
+	HAL_SPI_DMAEnable(0);
+
+	memset(&init_cfg, 0, sizeof(init_cfg));
+	init_cfg.dstdat_width = 8;
+	init_cfg.srcdat_width = 32;
+	init_cfg.dstptr_incr = 0;
+	init_cfg.srcptr_incr = 1;
+	init_cfg.src_start_addr = (void *)data;
+	init_cfg.dst_start_addr = (void *)SPI_DAT;
+	init_cfg.channel = HAL_SPI_DMA_CHANNEL;
+	init_cfg.prio = 0;
+	init_cfg.u.type4.src_loop_start_addr = (void *)data;
+	init_cfg.u.type4.src_loop_end_addr = (void *)(data + len);
+	init_cfg.fin_handler = HAL_SPI_DMAFinished;
+	init_cfg.src_module = GDMA_X_SRC_DTCM_RD_REQ;
+	init_cfg.dst_module = GDMA_X_DST_GSPI_TX_REQ;
+	sddev_control(GDMA_DEV_NAME, CMD_GDMA_CFG_TYPE4, &init_cfg);
+
+	en_cfg.channel = HAL_SPI_DMA_CHANNEL;
+	en_cfg.param = len;
+	sddev_control(GDMA_DEV_NAME, CMD_GDMA_SET_TRANS_LENGTH, &en_cfg);
+
+	g_spiBusy = 1;
+	HAL_SPI_DMAEnable(1);
+}
+int HAL_SPI_IsBusy() {
+	return g_spiBusy;
+}
+
+#else
+
+// BK7231T SDK has no GDMA request line for SPI TX, pixel bus bit-bangs there
+int HAL_SPI_Init(int pin, int bitRateHz) {
+	return 0;
+}
+void HAL_SPI_Deinit() {
+}
+void HAL_SPI_Send(const byte *data, int len) {
+}
+int HAL_SPI_IsBusy() {
+	return 0;
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include "../../new_cfg.h"
 #include "../../new_pins.h"
 //#include "../../new_pins.h"
+#include "../hal_pins.h"
+#include "../hal_generic.h"
 #include <gpio_pub.h>
 
 #include "../../beken378/func/include/net_param_pub.h"
@@ -11,6 +13,7 @@
 #include "../../beken378/func/user_driver/BkDriverI2c.h"
 #include "../../beken378/driver/i2c/i2c1.h"
 #include "../../beken378/driver/gpio/gpio.h"
+#include "BkDriverGpio.h"
 
 //100hz to 20000hz according to tuya code
 #define PWM_FREQUENCY_SLOW 600 //Slow frequency for LED Drivers requiring slower PWM Freq
@@ -144,4 +147,54 @@ void HAL_PIN_PWM_Update(int index, int value) {
 
 unsigned int HAL_GetGPIOPin(int index) {
 	return index;
+}
+
+static HAL_PIN_EdgeCallback_t g_edgeCallbacks[PLATFORM_GPIO_MAX];
+static HAL_PIN_EdgeCallback_t g_pulseCallbacks[PLATFORM_GPIO_MAX];
+
+// NOTE: ISR
+// BK7231 can't trigger on both edges, so after every edge the opposite one is armed
+static void HAL_PIN_EdgeInterrupt(unsigned char index) {
+	int level = bk_gpio_input(index);
+
+	gpio_int_enable(index, level ? IRQ_TRIGGER_FALLING_EDGE : IRQ_TRIGGER_RISING_EDGE, HAL_PIN_EdgeInterrupt);
+	if(g_pulseCallbacks[index]) {
+		g_pulseCallbacks[index](index, level, HAL_GetTimeUs());
+	}
+	if(g_edgeCallbacks[index]) {
+		g_edgeCallbacks[index](index, level, rtos_get_time());
+	}
+}
+int HAL_PIN_AttachEdgeInterrupt(int index, HAL_PIN_EdgeCallback_t cb) {
+	if(index < 0 || index >= PLATFORM_GPIO_MAX)
+		return 0;
+	g_edgeCallbacks[index] = cb;
+	gpio_int_enable(index, bk_gpio_input(index) ? IRQ_TRIGGER_FALLING_EDGE : IRQ_TRIGGER_RISING_EDGE, HAL_PIN_EdgeInterrupt);
+	return 1;
+}
+void HAL_PIN_DetachEdgeInterrupt(int index) {
+	if(index < 0 || index >= PLATFORM_GPIO_MAX)
+		return;
+	g_edgeCallbacks[index] = 0;
+	if(g_pulseCallbacks[index] == 0) {
+		gpio_int_disable(index);
+	}
+}
+// Same edge interrupt, timestamped by hardware timer (BK7231N only, see HAL_HasTimeUs)
+int HAL_PIN_AttachPulseCapture(int index, HAL_PIN_EdgeCallback_t cb) {
+	if(index < 0 || index >= PLATFORM_GPIO_MAX)
+		return 0;
+	if(HAL_HasTimeUs() == 0)
+		return 0;
+	g_pulseCallbacks[index] = cb;
+	gpio_int_enable(index, bk_gpio_input(index) ? IRQ_TRIGGER_FALLING_EDGE : IRQ_TRIGGER_RISING_EDGE, HAL_PIN_EdgeInterrupt);
+	return 1;
+}
+void HAL_PIN_DetachPulseCapture(int index) {
+	if(index < 0 || index >= PLATFORM_GPIO_MAX)
+		return;
+	g_pulseCallbacks[index] = 0;
+	if(g_edgeCallbacks[index] == 0) {
+		gpio_int_disable(index);
+	}
 }
\ No newline at end of file
@@ -56,6 +56,17 @@ int HAL_Configuration_SaveConfigMemory(void *src, int dataLen){
 
 
 
+// config is stored as a blob, so there is no journal
+int HAL_Configuration_GetConfigAreaSize() {
+	return 0;
+}
+int HAL_Configuration_ReadConfigArea(int offset, void *target, int dataLen) {
+	return 0;
+}
+int HAL_Configuration_WriteConfigArea(int offset, const void *src, int dataLen) {
+	return 0;
+}
+
 #endif // PLATFORM_XR809
 
 
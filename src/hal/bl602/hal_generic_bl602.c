@@ -2,6 +2,7 @@
 
 #include "../../new_common.h"
 #include <hal_sys.h>
+#include <bl_timer.h>
 
 void HAL_RebootModule() {
 
@@ -9,4 +10,15 @@ void HAL_RebootModule() {
 
 }
 
+int HAL_HasTimeUs() {
+	return 1;
+}
+uint32_t HAL_GetTimeUs() {
+	return bl_timer_now_us();
+}
+uint32_t HAL_GetTimeMs() {
+	return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+
 #endif // PLATFORM_XR809
\ No newline at end of file
@@ -7,6 +7,9 @@
 
 #include "bl_gpio.h"
 #include <bl_pwm.h>
+#include <bl_timer.h>
+#include <hal_gpio.h>
+#include <bl602_glb.h>
 
 int BL_FindPWMForPin(int index){
 	return index % 5;
@@ -96,4 +99,53 @@ unsigned int HAL_GetGPIOPin(int index) {
 	return index;
 }
 
+int HAL_PIN_AttachEdgeInterrupt(int index, HAL_PIN_EdgeCallback_t cb) {
+	// not implemented yet, pin will be polled
+	return 0;
+}
+void HAL_PIN_DetachEdgeInterrupt(int index) {
+
+}
+
+static HAL_PIN_EdgeCallback_t g_pulseCallbacks[GLB_GPIO_PIN_MAX];
+// SDK keeps a list of handlers and has no way to remove one, so every pin is registered once
+static byte g_pulseHandlerRegistered[GLB_GPIO_PIN_MAX];
+
+// NOTE: ISR
+// BL602 triggers on one edge only, so after every edge the opposite one is armed
+static void HAL_PIN_PulseInterrupt(void *arg) {
+	int index = (int)arg;
+	uint32_t time = bl_timer_now_us();
+	uint8_t level;
+
+	bl_gpio_input_get(index, &level);
+	GLB_Set_GPIO_IntMod(index, GLB_GPIO_INT_CONTROL_ASYNC, level ? GLB_GPIO_INT_TRIG_NEG_PULSE : GLB_GPIO_INT_TRIG_POS_PULSE);
+	if(g_pulseCallbacks[index]) {
+		g_pulseCallbacks[index](index, level, time);
+	}
+}
+int HAL_PIN_AttachPulseCapture(int index, HAL_PIN_EdgeCallback_t cb) {
+	uint8_t level;
+
+	if(index < 0 || index >= GLB_GPIO_PIN_MAX)
+		return 0;
+	g_pulseCallbacks[index] = cb;
+	bl_gpio_input_get(index, &level);
+	if(g_pulseHandlerRegistered[index] == 0) {
+		g_pulseHandlerRegistered[index] = 1;
+		hal_gpio_register_handler(HAL_PIN_PulseInterrupt, index, GLB_GPIO_INT_CONTROL_ASYNC,
+			level ? GLB_GPIO_INT_TRIG_NEG_PULSE : GLB_GPIO_INT_TRIG_POS_PULSE, (void*)index);
+	} else {
+		GLB_Set_GPIO_IntMod(index, GLB_GPIO_INT_CONTROL_ASYNC, level ? GLB_GPIO_INT_TRIG_NEG_PULSE : GLB_GPIO_INT_TRIG_POS_PULSE);
+		bl_gpio_intmask(index, 0);
+	}
+	return 1;
+}
+void HAL_PIN_DetachPulseCapture(int index) {
+	if(index < 0 || index >= GLB_GPIO_PIN_MAX)
+		return;
+	bl_gpio_intmask(index, 1);
+	g_pulseCallbacks[index] = 0;
+}
+
 #endif
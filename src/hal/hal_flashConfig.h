@@ -12,4 +12,12 @@ int HAL_Configuration_ReadConfigMemory(void *target, int dataLen);
 int HAL_Configuration_SaveConfigMemory(void *src, int dataLen);
 void HAL_Configuration_GenerateMACForThisModule(unsigned char *out);
 
+// Raw access to flash area holding config, used by config journal in new_cfg.c.
+// Returns 0 size on platforms which store config as a blob (easyflash, fdcm),
+// then whole config is always saved with HAL_Configuration_SaveConfigMemory.
+// SaveConfigMemory erases whole area, WriteConfigArea only writes to erased flash.
+int HAL_Configuration_GetConfigAreaSize();
+int HAL_Configuration_ReadConfigArea(int offset, void *target, int dataLen);
+int HAL_Configuration_WriteConfigArea(int offset, const void *src, int dataLen);
+
 
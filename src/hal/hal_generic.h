@@ -1,2 +1,32 @@
+#ifndef __HAL_GENERIC_H__
+#define __HAL_GENERIC_H__
+
+#include "../new_common.h"
 
 void HAL_RebootModule();
+// Free running microsecond counter (wraps around), used by profiler.
+// Backed by hardware timer, HAL_HasTimeUs returns 0 on platforms
+// that don't have one, then HAL_GetTimeUs always returns 0.
+int HAL_HasTimeUs();
+uint32_t HAL_GetTimeUs();
+// Free running millisecond counter (wraps around after 49 days), scheduler
+// time on every platform, used where time must be kept for long.
+uint32_t HAL_GetTimeMs();
+
+// Background (DMA) SPI transmit on a single data pin, used by pixel strips
+// (WS2812 and similar), where each data bit is sent as a few SPI bits.
+// HAL_SPI_Init returns 0 if platform can't do it, then caller has to bit-bang.
+// Implemented by Beken (DMA on BK7231N, MOSI pin only) and simulator HALs.
+int HAL_SPI_Init(int pin, int bitRateHz);
+// also stops transfer in progress
+void HAL_SPI_Deinit();
+// data must stay untouched until HAL_SPI_IsBusy returns 0
+void HAL_SPI_Send(const byte *data, int len);
+int HAL_SPI_IsBusy();
+#if WINDOWS
+// last data sent by simulated SPI, returns its length
+int SIM_GetSPIData(const byte **data, int *bitRateHz);
+void SIM_ClearSPIData();
+#endif
+
+#endif /* __HAL_GENERIC_H__ */
@@ -10,6 +10,16 @@ void HAL_PIN_PWM_Start(int index);
 void HAL_PIN_PWM_Update(int index, int value);
 int HAL_PIN_CanThisPinBePWM(int index);
 const char* HAL_PIN_GetPinNameAlias(int index);
+// Called from ISR on every edge, with raw pin level and time in ms (same timebase as rtos_get_time)
+typedef void (*HAL_PIN_EdgeCallback_t)(int index, int level, uint32_t time);
+// Returns 1 if edge interrupt was attached, 0 if it's not supported (pin must be polled)
+int HAL_PIN_AttachEdgeInterrupt(int index, HAL_PIN_EdgeCallback_t cb);
+void HAL_PIN_DetachEdgeInterrupt(int index);
+// Same callback, but time is in microseconds (free running, wraps around), for decoding short pulse trains (DHT)
+// Returns 1 if capture was attached, 0 if platform can't timestamp edges precisely enough
+// (BK7231T, which has no microsecond timer - see HAL_HasTimeUs).
+int HAL_PIN_AttachPulseCapture(int index, HAL_PIN_EdgeCallback_t cb);
+void HAL_PIN_DetachPulseCapture(int index);
 
 /// @brief Get the actual GPIO pin for the pin index.
 /// @param index 
@@ -42,5 +42,16 @@ int HAL_Configuration_SaveConfigMemory(void* src, int dataLen) {
 	return dataLen;
 }
 
+// size of area at FLASH_CONFIG_ADDR is not known, so journal is not used here
+int HAL_Configuration_GetConfigAreaSize() {
+	return 0;
+}
+int HAL_Configuration_ReadConfigArea(int offset, void *target, int dataLen) {
+	return 0;
+}
+int HAL_Configuration_WriteConfigArea(int offset, const void *src, int dataLen) {
+	return 0;
+}
+
 #endif
 
@@ -1,9 +1,52 @@
 #if defined(PLATFORM_W800) || defined(PLATFORM_W600) 
 
-#include "wm_include.h"
+#include "../../new_common.h"
 
 void HAL_RebootModule() {
     tls_sys_reset();
 }
 
+#if PLATFORM_W600
+#include "core_cm3.h"
+#define HAL_TICK_LOAD()		(SysTick->LOAD)
+#define HAL_TICK_VALUE()	(SysTick->VAL)
+#else
+#include "csi_core.h"
+#define HAL_TICK_LOAD()		csi_coret_get_load()
+#define HAL_TICK_VALUE()	csi_coret_get_value()
+#endif
+
+// counter value that is just after reload, see HAL_GetTimeUs
+#define HAL_TICK_WRAP_WINDOW(load)	((load) / 8)
+
+static uint32_t g_tickTimeLast;
+
+int HAL_HasTimeUs() {
+    return 1;
+}
+// scheduler ticks, and time within current tick from system tick timer
+// (SysTick on W600, CORET on W800), which counts down from load to 0
+uint32_t HAL_GetTimeUs() {
+    uint32_t ticks, load, val, elapsed, usPerTick, now;
+
+    do {
+        ticks = xTaskGetTickCount();
+        val = HAL_TICK_VALUE();
+    } while (ticks != xTaskGetTickCount());
+    load = HAL_TICK_LOAD();
+    elapsed = load - val;
+    usPerTick = portTICK_PERIOD_MS * 1000;
+    now = ticks * usPerTick + (uint32_t)((uint64_t)elapsed * usPerTick / (load + 1));
+    // timer has just reloaded, but tick interrupt wasn't handled yet
+    if (elapsed < HAL_TICK_WRAP_WINDOW(load) && (int32_t)(now - g_tickTimeLast) < 0) {
+        now += usPerTick;
+    }
+    g_tickTimeLast = now;
+    return now;
+}
+uint32_t HAL_GetTimeMs() {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+
 #endif
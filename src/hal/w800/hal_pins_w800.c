@@ -2,6 +2,7 @@
 
 #include "../../new_common.h"
 #include "../../logging/logging.h"
+#include "../hal_generic.h"
 
 #include "wm_include.h"
 
@@ -188,4 +189,46 @@ void HAL_PIN_PWM_Update(int index, int value) {
 unsigned int HAL_GetGPIOPin(int index) {
 	return g_pins[index].code;
 }
+
+int HAL_PIN_AttachEdgeInterrupt(int index, HAL_PIN_EdgeCallback_t cb) {
+	// not implemented yet, pin will be polled
+	return 0;
+}
+void HAL_PIN_DetachEdgeInterrupt(int index) {
+
+}
+
+static HAL_PIN_EdgeCallback_t g_pulseCallbacks[sizeof(g_pins) / sizeof(g_pins[0])];
+
+// NOTE: ISR
+static void HAL_PIN_PulseInterrupt(void *arg) {
+	int index = (int)arg;
+	uint32_t time = HAL_GetTimeUs();
+	int pin = g_pins[index].code;
+
+	if (tls_get_gpio_irq_status(pin) == 0)
+		return;
+	tls_clr_gpio_irq_status(pin);
+	if (g_pulseCallbacks[index]) {
+		g_pulseCallbacks[index](index, tls_gpio_read(pin), time);
+	}
+}
+// W800/W600 can trigger on both edges, time comes from system tick timer (see HAL_GetTimeUs)
+int HAL_PIN_AttachPulseCapture(int index, HAL_PIN_EdgeCallback_t cb) {
+	int pin;
+
+	if (IsPinIndexOk(index) == 0)
+		return 0;
+	pin = g_pins[index].code;
+	g_pulseCallbacks[index] = cb;
+	tls_gpio_isr_register(pin, HAL_PIN_PulseInterrupt, (void*)index);
+	tls_gpio_irq_enable(pin, WM_GPIO_IRQ_TRIG_DOUBLE_EDGE);
+	return 1;
+}
+void HAL_PIN_DetachPulseCapture(int index) {
+	if (IsPinIndexOk(index) == 0)
+		return;
+	tls_gpio_irq_disable(g_pins[index].code);
+	g_pulseCallbacks[index] = 0;
+}
 #endif
@@ -2,9 +2,27 @@
 
 #include "../hal_flashConfig.h"
 #include "../../logging/logging.h"
+#include "flash_pub.h"
 
 // TODO
 #define MY_ADDR_OF_BK_PARTITION_NET_PARAM 0x1e1000
+// one sector, like on BK7231
+#define MY_CONFIG_AREA_SIZE 0x1000
+
+static void HAL_Configuration_EraseRestOfArea(int start) {
+	char erased[64];
+	int len;
+
+	memset(erased, 0xFF, sizeof(erased));
+	while (start < MY_CONFIG_AREA_SIZE) {
+		len = MY_CONFIG_AREA_SIZE - start;
+		if (len > sizeof(erased)) {
+			len = sizeof(erased);
+		}
+		flash_write(erased, len, MY_ADDR_OF_BK_PARTITION_NET_PARAM + start);
+		start += len;
+	}
+}
 
 int HAL_Configuration_ReadConfigMemory(void *target, int dataLen){
 	//FILE *f;
@@ -38,10 +56,45 @@ int HAL_Configuration_SaveConfigMemory(void *src, int dataLen){
 	//}
 
 	flash_write(src, dataLen, MY_ADDR_OF_BK_PARTITION_NET_PARAM);
+	// real flash has whole sector erased, so clear journal part too
+	HAL_Configuration_EraseRestOfArea(dataLen);
 
     return dataLen;
 }
 
+int HAL_Configuration_GetConfigAreaSize() {
+	return MY_CONFIG_AREA_SIZE;
+}
+int HAL_Configuration_ReadConfigArea(int offset, void *target, int dataLen) {
+	if (offset < 0 || offset + dataLen > MY_CONFIG_AREA_SIZE) {
+		return 0;
+	}
+	flash_read(target, dataLen, MY_ADDR_OF_BK_PARTITION_NET_PARAM + offset);
+	return dataLen;
+}
+int HAL_Configuration_WriteConfigArea(int offset, const void *src, int dataLen) {
+	char chunk[64];
+	int done, len, i;
+
+	if (offset < 0 || offset + dataLen > MY_CONFIG_AREA_SIZE) {
+		return 0;
+	}
+	// like real flash, writing can only clear bits, so writes to area
+	// that was not erased are caught by config selftests
+	for (done = 0; done < dataLen; done += len) {
+		len = dataLen - done;
+		if (len > sizeof(chunk)) {
+			len = sizeof(chunk);
+		}
+		flash_read(chunk, len, MY_ADDR_OF_BK_PARTITION_NET_PARAM + offset + done);
+		for (i = 0; i < len; i++) {
+			chunk[i] &= ((const char*)src)[done + i];
+		}
+		flash_write(chunk, len, MY_ADDR_OF_BK_PARTITION_NET_PARAM + offset + done);
+	}
+	return dataLen;
+}
+
 
 
 
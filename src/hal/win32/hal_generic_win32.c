@@ -1,9 +1,70 @@
 #ifdef WINDOWS
 
+#include "../../new_common.h"
+
+int rtos_get_time();
 
 void HAL_RebootModule() {
 
 
 }
 
-#endif // WINDOWS
\ No newline at end of file
+int HAL_HasTimeUs() {
+	return 1;
+}
+uint32_t HAL_GetTimeUs() {
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+
+	if (freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&freq);
+	}
+	QueryPerformanceCounter(&now);
+	// split to avoid overflow of counter * 1000000
+	return (uint32_t)((now.QuadPart / freq.QuadPart) * 1000000
+		+ (now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart);
+}
+// simulated time, so selftests can run days in seconds
+uint32_t HAL_GetTimeMs() {
+	return rtos_get_time();
+}
+
+// Simulated SPI keeps copy of last transfer for selftests and is busy
+// for as long as real transfer would take, in simulated time
+static byte *g_spiData = 0;
+static int g_spiLen = 0;
+static int g_spiBitRate = 0;
+static int g_spiBusyUntil = 0;
+
+int HAL_SPI_Init(int pin, int bitRateHz) {
+	g_spiBitRate = bitRateHz;
+	g_spiBusyUntil = 0;
+	return 1;
+}
+void HAL_SPI_Deinit() {
+	g_spiBusyUntil = 0;
+}
+void HAL_SPI_Send(const byte *data, int len) {
+	free(g_spiData);
+	g_spiData = (byte*)malloc(len);
+	memcpy(g_spiData, data, len);
+	g_spiLen = len;
+	// round up to whole ms
+	g_spiBusyUntil = rtos_get_time() + (int)(((long long)len * 8 * 1000 + g_spiBitRate - 1) / g_spiBitRate);
+}
+int HAL_SPI_IsBusy() {
+	return rtos_get_time() < g_spiBusyUntil;
+}
+int SIM_GetSPIData(const byte **data, int *bitRateHz) {
+	*data = g_spiData;
+	*bitRateHz = g_spiBitRate;
+	return g_spiLen;
+}
+void SIM_ClearSPIData() {
+	free(g_spiData);
+	g_spiData = 0;
+	g_spiLen = 0;
+	g_spiBusyUntil = 0;
+}
+
+#endif // WINDOWS
@@ -18,12 +18,25 @@ int g_simulatedPinStates[PLATFORM_GPIO_MAX];
 int g_simulatedPWMs[PLATFORM_GPIO_MAX];
 simulatedPinMode_t g_pinModes[PLATFORM_GPIO_MAX];
 int g_simulatedADCValues[PLATFORM_GPIO_MAX];
+static HAL_PIN_EdgeCallback_t g_edgeCallbacks[PLATFORM_GPIO_MAX];
+static HAL_PIN_EdgeCallback_t g_pulseCallbacks[PLATFORM_GPIO_MAX];
+#define SIM_MAX_PULSES 128
+// simulated device answer (like DHT), played when pin is released to pull-up
+static int g_pulseResponsePin = -1;
+static int g_pulseResponse[SIM_MAX_PULSES];
+static int g_pulseResponseCount = 0;
+
+int rtos_get_time();
 
 void SIM_Hack_ClearSimulatedPinRoles() {
 	memset(g_simulatedPinStates, 0, sizeof(g_simulatedPinStates));
 	memset(g_simulatedPWMs, 0, sizeof(g_simulatedPWMs));
 	memset(g_pinModes, 0, sizeof(g_pinModes));
 	memset(g_simulatedADCValues, 0, sizeof(g_simulatedADCValues));
+	memset(g_edgeCallbacks, 0, sizeof(g_edgeCallbacks));
+	memset(g_pulseCallbacks, 0, sizeof(g_pulseCallbacks));
+	g_pulseResponsePin = -1;
+	g_pulseResponseCount = 0;
 }
 
 static int adcToGpio[] = {
@@ -58,8 +71,71 @@ int HAL_ADC_Read(int pinNumber) {
 	return g_simulatedADCValues[pinNumber];
 }
 void SIM_SetSimulatedPinValue(int pinIndex, bool bHigh) {
+	bHigh = bHigh ? 1 : 0;
+	if (g_edgeCallbacks[pinIndex] && g_simulatedPinStates[pinIndex] != bHigh) {
+		g_edgeCallbacks[pinIndex](pinIndex, bHigh, rtos_get_time());
+	}
 	g_simulatedPinStates[pinIndex] = bHigh;
 }
+// Injects a sequence of edges, as if they were coming from interrupt.
+// Edge i happens delays[i] ms after the previous one (first one is relative to now),
+// so bouncing contacts and click timings can be reproduced exactly.
+// Pin is left in the last level. Pins without edge interrupt just get the last level.
+void SIM_InjectPinEdges(int pinIndex, const int *levels, const int *delays, int count) {
+	int i;
+	uint32_t time;
+
+	time = rtos_get_time();
+	for (i = 0; i < count; i++) {
+		time += delays[i];
+		if (g_edgeCallbacks[pinIndex]) {
+			g_edgeCallbacks[pinIndex](pinIndex, levels[i] ? 1 : 0, time);
+		}
+	}
+	if (count > 0) {
+		g_simulatedPinStates[pinIndex] = levels[count - 1] ? 1 : 0;
+	}
+}
+int HAL_PIN_AttachEdgeInterrupt(int index, HAL_PIN_EdgeCallback_t cb) {
+	g_edgeCallbacks[index] = cb;
+	return 1;
+}
+void HAL_PIN_DetachEdgeInterrupt(int index) {
+	g_edgeCallbacks[index] = 0;
+}
+// Sets a pulse train that simulated device sends every time the pin is released
+// to pull-up while pulse capture is attached. durations_us[i] is time between edges,
+// first one is measured from release, first edge is falling. Count 0 removes the device.
+void SIM_SetPinPulseResponse(int pinIndex, const int *durations_us, int count) {
+	if (count > SIM_MAX_PULSES)
+		count = SIM_MAX_PULSES;
+	g_pulseResponsePin = pinIndex;
+	g_pulseResponseCount = count;
+	memcpy(g_pulseResponse, durations_us, count * sizeof(int));
+}
+static void SIM_PlayPulseResponse(int index) {
+	int i;
+	int level;
+	uint32_t time;
+
+	if (g_pulseCallbacks[index] == 0 || g_pulseResponsePin != index)
+		return;
+	time = rtos_get_time() * 1000;
+	level = 1;
+	for (i = 0; i < g_pulseResponseCount; i++) {
+		time += g_pulseResponse[i];
+		level = !level;
+		g_pulseCallbacks[index](index, level, time);
+	}
+	g_simulatedPinStates[index] = level;
+}
+int HAL_PIN_AttachPulseCapture(int index, HAL_PIN_EdgeCallback_t cb) {
+	g_pulseCallbacks[index] = cb;
+	return 1;
+}
+void HAL_PIN_DetachPulseCapture(int index) {
+	g_pulseCallbacks[index] = 0;
+}
 bool SIM_GetSimulatedPinValue(int pinIndex) {
 	return g_simulatedPinStates[pinIndex];
 }
@@ -190,6 +266,7 @@ int HAL_PIN_ReadDigitalInput(int index) {
 }
 void HAL_PIN_Setup_Input_Pullup(int index) {
 	g_pinModes[index] = SIM_PIN_INPUT_PULLUP;
+	SIM_PlayPulseResponse(index);
 }
 void HAL_PIN_Setup_Input(int index) {
 	g_pinModes[index] = SIM_PIN_INPUT;
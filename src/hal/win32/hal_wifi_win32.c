@@ -46,7 +46,8 @@ int WiFI_SetMacAddress(char *mac) {
 
 }
 void WiFI_GetMacAddress(char *mac) {
-
+	// same as HAL_GetMACStr, so pages do not show stack garbage
+	memset(mac, 0, 6);
 }
 
 void HAL_PrintNetworkInfo() {
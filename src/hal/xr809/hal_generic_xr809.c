@@ -1,5 +1,8 @@
 #ifdef PLATFORM_XR809
 
+#include "../../new_common.h"
+#include "driver/chip/hal_chip.h"
+
 void HAL_WDG_Reboot();
 
 void HAL_RebootModule() {
@@ -8,4 +11,36 @@ void HAL_RebootModule() {
 	HAL_WDG_Reboot();
 }
 
+int HAL_HasTimeUs() {
+	return 1;
+}
+// counter value that is just after reload, see HAL_GetTimeUs
+#define HAL_TICK_WRAP_WINDOW(load)	((load) / 8)
+
+static uint32_t g_tickTimeLast;
+
+// scheduler ticks, and time within current tick from SysTick, which counts down from load to 0
+uint32_t HAL_GetTimeUs() {
+	uint32_t ticks, load, val, elapsed, usPerTick, now;
+
+	do {
+		ticks = OS_GetTicks();
+		val = SysTick->VAL;
+	} while (ticks != OS_GetTicks());
+	load = SysTick->LOAD;
+	elapsed = load - val;
+	usPerTick = 1000000 / OS_HZ;
+	now = ticks * usPerTick + (uint32_t)((uint64_t)elapsed * usPerTick / (load + 1));
+	// timer has just reloaded, but tick interrupt wasn't handled yet
+	if (elapsed < HAL_TICK_WRAP_WINDOW(load) && (int32_t)(now - g_tickTimeLast) < 0) {
+		now += usPerTick;
+	}
+	g_tickTimeLast = now;
+	return now;
+}
+uint32_t HAL_GetTimeMs() {
+	return OS_TicksToMSecs(OS_GetTicks());
+}
+
+
 #endif // PLATFORM_XR809
\ No newline at end of file
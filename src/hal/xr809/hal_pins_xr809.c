@@ -2,6 +2,7 @@
 
 #include "../../new_common.h"
 #include "../../logging/logging.h"
+#include "../hal_generic.h"
 
 #include "driver/chip/hal_gpio.h"
 
@@ -30,6 +31,8 @@ static xr809pin_t g_xrPins[] = {
 };
 int g_numXRPins = sizeof(g_xrPins) / sizeof(g_xrPins[0]);
 
+static HAL_PIN_EdgeCallback_t g_pulseCallbacks[sizeof(g_xrPins) / sizeof(g_xrPins[0])];
+
 static void PIN_XR809_GetPortPinForIndex(int index, int *xr_port, int *xr_pin) {
 	if(index < 0 || index >= g_numXRPins) {
 		*xr_port = 0;
@@ -80,7 +83,7 @@ void HAL_PIN_Setup_Input_Pullup(int index) {
 	PIN_XR809_GetPortPinForIndex(index, &xr_port, &xr_pin);
 
 	param.driving = GPIO_DRIVING_LEVEL_1;
-	param.mode = GPIOx_Pn_F0_INPUT;
+	param.mode = (index >= 0 && index < g_numXRPins && g_pulseCallbacks[index]) ? GPIOx_Pn_F6_EINT : GPIOx_Pn_F0_INPUT;
 	param.pull = GPIO_PULL_UP;
 	HAL_GPIO_Init(xr_port, xr_pin, &param);
 }
@@ -133,5 +136,56 @@ unsigned int HAL_GetGPIOPin(int index) {
 	return xr_pin;
 }
 
+int HAL_PIN_AttachEdgeInterrupt(int index, HAL_PIN_EdgeCallback_t cb) {
+	// not implemented yet, pin will be polled
+	return 0;
+}
+void HAL_PIN_DetachEdgeInterrupt(int index) {
+
+}
+
+// NOTE: ISR
+static void HAL_PIN_PulseInterrupt(void *arg) {
+	int index = (int)arg;
+	uint32_t time = HAL_GetTimeUs();
+
+	if (g_pulseCallbacks[index]) {
+		g_pulseCallbacks[index](index, HAL_PIN_ReadDigitalInput(index), time);
+	}
+}
+// XR809 can trigger on both edges, time comes from SysTick (see HAL_GetTimeUs)
+int HAL_PIN_AttachPulseCapture(int index, HAL_PIN_EdgeCallback_t cb) {
+	int xr_port; // eg GPIO_PORT_A
+	int xr_pin; // eg. GPIO_PIN_20
+	GPIO_IrqParam irq;
+
+	if(index < 0 || index >= g_numXRPins)
+		return 0;
+	PIN_XR809_GetPortPinForIndex(index, &xr_port, &xr_pin);
+
+	g_pulseCallbacks[index] = cb;
+	// pin must be in EINT mode to raise interrupts, input setup keeps it while capture is attached
+	HAL_PIN_Setup_Input_Pullup(index);
+	irq.event = GPIO_IRQ_EVT_BOTH_EDGE;
+	irq.callback = HAL_PIN_PulseInterrupt;
+	irq.arg = (void*)index;
+	if (HAL_GPIO_EnableIRQ(xr_port, xr_pin, &irq) != HAL_OK) {
+		g_pulseCallbacks[index] = 0;
+		return 0;
+	}
+	return 1;
+}
+void HAL_PIN_DetachPulseCapture(int index) {
+	int xr_port; // eg GPIO_PORT_A
+	int xr_pin; // eg. GPIO_PIN_20
+
+	if(index < 0 || index >= g_numXRPins)
+		return;
+	PIN_XR809_GetPortPinForIndex(index, &xr_port, &xr_pin);
+
+	HAL_GPIO_DisableIRQ(xr_port, xr_pin);
+	g_pulseCallbacks[index] = 0;
+}
+
 #endif
 
@@ -437,8 +437,9 @@ int httpclient_recv(httpclient_t *client, char *buf, int min_len, int max_len, i
     if (ret > 0) {
         *p_read_len = ret;
     } else if (ret == 0) {
-        //timeout
-        return 0;
+        // timeout, don't let callers spin on empty reads
+        ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "Timeout.\r\n");
+        return ERROR_HTTP_CONN;
     } else if (-1 == ret) {
         ADDLOG_INFO(LOG_FEATURE_HTTP_CLIENT, "Connection closed.\r\n");
         return ERROR_HTTP_CONN;
@@ -733,6 +734,7 @@ int httpclient_response_parse(httpclient_t *client, char *data, int len, uint32_
     len -= (crlf_pos + 2);
 
     client_data->is_chunked = false;
+    client_data->is_closing = false;
 
     /* Now get headers */
     while (true) {
@@ -784,6 +786,10 @@ int httpclient_response_parse(httpclient_t *client, char *data, int len, uint32_
                     client_data->response_content_len = 0;
                     client_data->retrieve_len = 0;
                 }
+            } else if (!stricmp(key, "Connection")) {
+                if (!stricmp(value, "close")) {
+                    client_data->is_closing = true;
+                }
             }
             os_memmove(data, &data[crlf_pos + 2], len - (crlf_pos + 2) + 1); /* Be sure to move NULL-terminating char as well */
             len -= (crlf_pos + 2);
@@ -989,9 +995,157 @@ iotx_err_t iotx_post(
 //
 //    	ADDLOG_INFO(LOG_FEATURE_HTTP_CLIENT, s);
 //}
-static void httprequest_thread( beken_thread_arg_t arg )
+//////////////////////////////////////
+// worker pool
+//
+// Requests are queued and served by HTTPCLIENT_POOL_WORKERS long living threads,
+// so a burst of webhooks doesn't create a thread per request.
+// When a response was fully read and server didn't ask to close, the connection
+// is parked in idle list and next request to the same host:port skips the TCP handshake.
+
+typedef struct httpclientIdleConn_s {
+    uintptr_t handle;
+    int port;
+    uint32_t since;
+    char host[HTTPCLIENT_MAX_HOST_LEN];
+} httpclientIdleConn_t;
+
+static httprequest_t *g_pool_queue[HTTPCLIENT_POOL_QUEUE_SIZE];
+static int g_pool_queueFirst = 0;
+static int g_pool_queueCount = 0;
+static httpclientIdleConn_t g_pool_idle[HTTPCLIENT_POOL_WORKERS];
+static SemaphoreHandle_t g_pool_mutex;
+static int g_pool_workersStarted = 0;
+// used for requests that don't provide response buffer, response must still be read out
+static char g_pool_scratch[HTTPCLIENT_POOL_WORKERS][HTTPCLIENT_CHUNK_SIZE];
+static int g_httpclient_requestTimeout = 10000;
+static int g_httpclient_keepAlive = 5000;
+httpclientStats_t g_httpclient_stats;
+
+#define HTTPCLIENT_POOL_IDLE_POLL_MS    20
+#define HTTPCLIENT_POOL_LOCK_TIMEOUT    1000
+
+void HTTPClient_SetTimeouts(int requestTimeoutMs, int keepAliveMs) {
+    if (requestTimeoutMs > 0) {
+        g_httpclient_requestTimeout = requestTimeoutMs;
+    }
+    if (keepAliveMs >= 0) {
+        g_httpclient_keepAlive = keepAliveMs;
+    }
+}
+void HTTPClient_GetTimeouts(int *requestTimeoutMs, int *keepAliveMs) {
+    *requestTimeoutMs = g_httpclient_requestTimeout;
+    *keepAliveMs = g_httpclient_keepAlive;
+}
+int HTTPClient_GetQueuedCount() {
+    return g_pool_queueCount;
+}
+static void httpclient_closeHandle(uintptr_t handle) {
+    utils_network_t net;
+
+    iotx_net_init(&net, "", 0, 0);
+    net.handle = handle;
+    net.doDisconnect(&net);
+}
+// returns connection to given host:port from idle list, or 0
+static uintptr_t httpclient_pool_takeIdle(const char *host, int port) {
+    int i;
+    uintptr_t handle;
+
+    handle = 0;
+    if (xSemaphoreTake(g_pool_mutex, HTTPCLIENT_POOL_LOCK_TIMEOUT) != pdTRUE) {
+        return 0;
+    }
+    for (i = 0; i < HTTPCLIENT_POOL_WORKERS; i++) {
+        if (g_pool_idle[i].handle && g_pool_idle[i].port == port && !strcmp(g_pool_idle[i].host, host)) {
+            handle = g_pool_idle[i].handle;
+            g_pool_idle[i].handle = 0;
+            break;
+        }
+    }
+    xSemaphoreGive(g_pool_mutex);
+
+    if (handle && !HAL_TCP_IsIdleAlive(handle)) {
+        ADDLOG_INFO(LOG_FEATURE_HTTP_CLIENT, "kept alive connection to %s:%i was closed by server", host, port);
+        httpclient_closeHandle(handle);
+        handle = 0;
+    }
+    return handle;
+}
+static void httpclient_pool_putIdle(const char *host, int port, uintptr_t handle) {
+    int i;
+    int best;
+    uintptr_t evicted;
+
+    evicted = handle;
+    if (g_httpclient_keepAlive > 0 && xSemaphoreTake(g_pool_mutex, HTTPCLIENT_POOL_LOCK_TIMEOUT) == pdTRUE) {
+        // free slot or the oldest one
+        best = 0;
+        for (i = 0; i < HTTPCLIENT_POOL_WORKERS; i++) {
+            if (g_pool_idle[i].handle == 0) {
+                best = i;
+                break;
+            }
+            if (g_pool_idle[i].since < g_pool_idle[best].since) {
+                best = i;
+            }
+        }
+        evicted = g_pool_idle[best].handle;
+        g_pool_idle[best].handle = handle;
+        g_pool_idle[best].port = port;
+        g_pool_idle[best].since = utils_time_get_ms();
+        strcpy_safe(g_pool_idle[best].host, host, sizeof(g_pool_idle[best].host));
+        xSemaphoreGive(g_pool_mutex);
+    }
+    if (evicted) {
+        httpclient_closeHandle(evicted);
+    }
+}
+static void httpclient_pool_expireIdle() {
+    int i;
+    uint32_t now;
+    uintptr_t expired;
+
+    now = utils_time_get_ms();
+    for (i = 0; i < HTTPCLIENT_POOL_WORKERS; i++) {
+        expired = 0;
+        if (xSemaphoreTake(g_pool_mutex, HTTPCLIENT_POOL_LOCK_TIMEOUT) != pdTRUE) {
+            return;
+        }
+        if (g_pool_idle[i].handle && now - g_pool_idle[i].since >= g_httpclient_keepAlive) {
+            expired = g_pool_idle[i].handle;
+            g_pool_idle[i].handle = 0;
+        }
+        xSemaphoreGive(g_pool_mutex);
+        if (expired) {
+            httpclient_closeHandle(expired);
+        }
+    }
+}
+static httprequest_t *httpclient_pool_pop() {
+    httprequest_t *request;
+
+    request = 0;
+    if (xSemaphoreTake(g_pool_mutex, HTTPCLIENT_POOL_LOCK_TIMEOUT) != pdTRUE) {
+        return 0;
+    }
+    if (g_pool_queueCount > 0) {
+        request = g_pool_queue[g_pool_queueFirst];
+        g_pool_queueFirst = (g_pool_queueFirst + 1) % HTTPCLIENT_POOL_QUEUE_SIZE;
+        g_pool_queueCount--;
+    }
+    xSemaphoreGive(g_pool_mutex);
+    return request;
+}
+static int httprequest_callback(httprequest_t *request, int state) {
+    request->state = state;
+    if (request->data_callback) {
+        return request->data_callback(request);
+    }
+    return 0;
+}
+static void httprequest_run(httprequest_t *request, char *scratch)
 {
-    httprequest_t *request = (httprequest_t *)arg;
     iotx_time_t timer;
     int ret = 0;
     char host[HTTPCLIENT_MAX_HOST_LEN] = { 0 };
@@ -1000,155 +1154,219 @@ static void httprequest_thread( beken_thread_arg_t arg )
     const char *header = request->header;
     int port = request->port;
     const char *ca_crt = request->ca_crt;
-    //uint32_t timeout = request->timeout;
     httpclient_data_t *client_data = &request->client_data;
     int method = request->method;
     int timeout_ms = request->timeout;
-
-    //addLog("start request thread\r\n");
-    //rtos_delay_milliseconds(500);
-
+    int bReused;
+    int bConnected;
+    int bScratch;
+    int bKeep;
+    int bFailed;
+    uint32_t filled;
+    uint32_t startTime;
+    uint32_t latency;
+
+    startTime = utils_time_get_ms();
+    bKeep = 0;
+    bFailed = 0;
+    bReused = 0;
+    bConnected = 0;
 
     if (header && header[0]){
         HTTPClient_SetCustomHeader(client, header);  //Sets the custom header if needed.
     }
 
-    //addLog("after HTTPClient_SetCustomHeader\r\n");
-    //rtos_delay_milliseconds(500);
-
-
-    request->state = 0;
-
-    if (0 == client->net.handle) {
-        //Establish connection if no.
-        //addLog("before httpclient_parse_host\r\n");
-        //rtos_delay_milliseconds(500);
-    	ret = httpclient_parse_host(url, host, &port, sizeof(host));
-
-        if (ret != SUCCESS_RETURN){
-            request->state = -1;
-            if (request->data_callback){
-                request->data_callback(request);
-            }
-            goto exit;
-        }
-
-    	ADDLOG_INFO(LOG_FEATURE_HTTP_CLIENT, "host: '%s', port: %d", host, port);
-        //rtos_delay_milliseconds(500);
-
-    	iotx_net_init(&client->net, host, port, ca_crt);
-        //addLog("after iotx_net_init\r\n");
-        //rtos_delay_milliseconds(500);
-
-    	ret = httpclient_connect(client);
-        //addLog("after httpclient_connect %d\r\n", ret);
-        //rtos_delay_milliseconds(500);
-    	if (0 != ret) {
-            ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "httpclient_connect is error,ret = %d", ret);
-            httpclient_close(client);
-            request->state = -1;
-            if (request->data_callback){
-                request->data_callback(request);
-            }
-            goto exit;
-    	}
+    // response must be read out even if nobody wants it, otherwise lwip will fail at lwip_close
+    // and it won't free socket, also it must be read to keep connection alive
+    bScratch = (client_data->response_buf == NULL || client_data->response_buf_len == 0);
+    if (bScratch) {
+        client_data->response_buf = scratch;
+        client_data->response_buf_len = HTTPCLIENT_CHUNK_SIZE;
+    }
 
-        ret = httpclient_send_request(client, url, method, client_data);
-        if (0 != ret) {
-            ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "httpclient_send_request is error,ret = %d", ret);
-            httpclient_close(client);
-            request->state = -1;
-            if (request->data_callback){
-                request->data_callback(request);
-            }
-            goto exit;
-        }
+    ret = httpclient_parse_host(url, host, &port, sizeof(host));
+    if (ret != SUCCESS_RETURN){
+        bFailed = 1;
+        httprequest_callback(request, -1);
+        goto exit;
     }
-    //addLog("httpclient_connect ret = %d", ret);
-    //rtos_delay_milliseconds(500);
-    request->state = 0;  // start
-    request->client_data.response_buf_filled = 0;
-    if (request->data_callback){
-        request->data_callback(request);
+
+    iotx_net_init(&client->net, host, port, ca_crt);
+    // there is no TLS, so only plain connections are reused
+    if (ca_crt == 0) {
+        client->net.handle = httpclient_pool_takeIdle(host, port);
     }
+    bReused = client->net.handle != 0;
 
     iotx_time_init(&timer);
     utils_time_countdown_ms(&timer, timeout_ms);
 
-    //addLog("rx buflen %d", client_data->response_buf_len);
-    //rtos_delay_milliseconds(500);
-
-    if ((NULL != client_data->response_buf)
-         || (0 != client_data->response_buf_len)) {
-        do {
+    while (1) {
+        if (client->net.handle == 0) {
+            ADDLOG_INFO(LOG_FEATURE_HTTP_CLIENT, "host: '%s', port: %d", host, port);
+            ret = httpclient_connect(client);
+            if (0 != ret) {
+                ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "httpclient_connect is error,ret = %d", ret);
+                httpclient_close(client);
+                bFailed = 1;
+                httprequest_callback(request, -1);
+                goto exit;
+            }
+            bConnected = 1;
+        }
+        client_data->is_more = 0;
+        ret = httpclient_send_request(client, url, method, client_data);
+        if (0 == ret) {
             // parse headers, fill client_data->response_buf up to max client_data->response_buf_len-1
             ret = httpclient_recv_response(client, iotx_time_left(&timer), client_data);
-            //addLog("httpclient_recv_response is ret = %d is_more %d", ret, client_data->is_more);
-            //rtos_delay_milliseconds(500);
-            if (ret < 0) {
-                ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "httpclient_recv_response is error,ret = %d", ret);
-                httpclient_close(client);
-                request->state = -2;
-                if (request->data_callback){
-                    request->data_callback(request);
-                }
-                // close & leave
+        }
+        if (ret >= 0) {
+            break;
+        }
+        httpclient_close(client);
+        // server could have dropped kept alive connection right before we used it, try once with a fresh one
+        if (bReused) {
+            ADDLOG_INFO(LOG_FEATURE_HTTP_CLIENT, "reused connection failed, reconnecting");
+            bReused = 0;
+            continue;
+        }
+        ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "httpclient request failed, ret = %d", ret);
+        bFailed = 1;
+        httprequest_callback(request, -2);
+        goto exit;
+    }
+
+    // start, callback doesn't get any data yet
+    filled = client_data->response_buf_filled;
+    client_data->response_buf_filled = 0;
+    httprequest_callback(request, 0);
+    client_data->response_buf_filled = filled;
+    while (1) {
+        if (bScratch == 0) {
+            if (httprequest_callback(request, 1)) {
+                // abort on user request
                 break;
             }
-            request->state = 1;
-            if (request->data_callback){
-                //addLog("calling callback");
-                //rtos_delay_milliseconds(500);
-                if (request->data_callback(request)){
-                    // abort on user request
-                    // close & leave
-                    break;
-                }
-            }
-        } while (client_data->is_more);
-    } else {
-		// must read out somewhere data, otherwise lwip will fail at lwip_close and it wont free socket
-		// and then it will soon run out of the sockets and break networking
-		int c_read;
-		int ret;
-		c_read = 0;
-		do {
-			ret = client->net.doRead(&client->net, host, sizeof(host), iotx_time_left(&timer));
-			if(ret>0)
-				c_read += ret;
-		} while(ret > 0);
-        ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "httpclient - no response buff, skipped %i",c_read);
+        }
+        if (!client_data->is_more) {
+            // whole response has been read, connection is in sync and may be reused
+            bKeep = !client_data->is_chunked && client_data->response_content_len != (uint32_t)-1
+                && !client_data->is_closing && ca_crt == 0;
+            break;
+        }
+        ret = httpclient_recv_response(client, iotx_time_left(&timer), client_data);
+        if (ret < 0) {
+            ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "httpclient_recv_response is error,ret = %d", ret);
+            bFailed = 1;
+            httprequest_callback(request, -2);
+            break;
+        }
     }
 exit:
-    //addLog("close http channel");
-    httpclient_close(client);
-    request->state = 2;  // complete
-    request->client_data.response_buf_filled = 0;
-    if (request->data_callback){
-        request->data_callback(request);
+    if (bKeep) {
+        httpclient_pool_putIdle(host, port, client->net.handle);
+        client->net.handle = 0;
+    } else {
+        httpclient_close(client);
+    }
+    if (bScratch) {
+        client_data->response_buf = 0;
+        client_data->response_buf_len = 0;
+    }
+    latency = utils_time_get_ms() - startTime;
+    if (xSemaphoreTake(g_pool_mutex, HTTPCLIENT_POOL_LOCK_TIMEOUT) == pdTRUE) {
+        g_httpclient_stats.requests++;
+        if (bFailed) {
+            g_httpclient_stats.failures++;
+        }
+        if (bReused) {
+            g_httpclient_stats.connectionsReused++;
+        } else if (bConnected) {
+            g_httpclient_stats.connectionsOpened++;
+        }
+        g_httpclient_stats.latencyTotalMs += latency;
+        if (latency > g_httpclient_stats.latencyMaxMs) {
+            g_httpclient_stats.latencyMaxMs = latency;
+        }
+        xSemaphoreGive(g_pool_mutex);
     }
+    request->client_data.response_buf_filled = 0;
+    httprequest_callback(request, 2);  // complete
 	// free if required
 	httpclient_freeMemory(request);
-    // remove this thread
-    rtos_delete_thread( NULL );
-    return;
 }
+static void httpclient_worker_thread( beken_thread_arg_t arg )
+{
+    char *scratch = (char*)arg;
+    httprequest_t *request;
+
+    while (1) {
+        request = httpclient_pool_pop();
+        if (request == 0) {
+            httpclient_pool_expireIdle();
+            rtos_delay_milliseconds(HTTPCLIENT_POOL_IDLE_POLL_MS);
+            continue;
+        }
+        httprequest_run(request, scratch);
+    }
+}
+// called with g_pool_mutex taken, so only one caller can start workers
+static int httpclient_pool_start() {
+    OSStatus err;
+    int i;
 
+    for (i = 0; i < HTTPCLIENT_POOL_WORKERS; i++) {
+        err = rtos_create_thread( NULL, BEKEN_APPLICATION_PRIORITY,
+									"httprequest",
+									(beken_thread_function_t)httpclient_worker_thread,
+									0x800,
+									(beken_thread_arg_t)g_pool_scratch[i] );
+        if(err != kNoErr)
+        {
+           ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "create \"httprequest\" thread failed!\r\n");
+           // pool will work with less workers, unless there are none
+           if (i == 0) {
+               return -1;
+           }
+           break;
+        }
+    }
+    g_pool_workersStarted = 1;
+    return 0;
+}
+void HTTPClient_Init() {
+    if (g_pool_mutex == 0) {
+        g_pool_mutex = xSemaphoreCreateMutex();
+    }
+}
 
 //////////////////////////////////////
 // our async stuff
 int HTTPClient_Async_SendGeneric(httprequest_t *request){
-    OSStatus err = kNoErr;
-    err = rtos_create_thread( NULL, BEKEN_APPLICATION_PRIORITY,
-									"httprequest",
-									(beken_thread_function_t)httprequest_thread,
-									0x800,
-									(beken_thread_arg_t)request );
-    if(err != kNoErr)
-    {
-       ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "create \"httprequest\" thread failed!\r\n");
-       return -1;
+    if (g_pool_mutex == 0) {
+        ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "HTTPClient_Async_SendGeneric: HTTPClient_Init was not called");
+        return -1;
+    }
+    if (xSemaphoreTake(g_pool_mutex, HTTPCLIENT_POOL_LOCK_TIMEOUT) != pdTRUE) {
+        return -1;
+    }
+    // workers are started on first request, most devices never send any
+    if (g_pool_workersStarted == 0 && httpclient_pool_start()) {
+        xSemaphoreGive(g_pool_mutex);
+        return -1;
+    }
+    if (g_pool_queueCount >= HTTPCLIENT_POOL_QUEUE_SIZE) {
+        g_httpclient_stats.rejected++;
+        xSemaphoreGive(g_pool_mutex);
+        ADDLOG_ERROR(LOG_FEATURE_HTTP_CLIENT, "HTTPClient_Async_SendGeneric: queue full, request for %s rejected", request->url);
+        return -1;
+    }
+    g_pool_queue[(g_pool_queueFirst + g_pool_queueCount) % HTTPCLIENT_POOL_QUEUE_SIZE] = request;
+    g_pool_queueCount++;
+    if (g_pool_queueCount > g_httpclient_stats.queueHighWater) {
+        g_httpclient_stats.queueHighWater = g_pool_queueCount;
     }
+    xSemaphoreGive(g_pool_mutex);
 
     return 0;
 }
@@ -1215,8 +1433,12 @@ int HTTPClient_Async_SendGet(const char *url_in){
 	request->port = 80;//HTTP_PORT;
 	request->url = url;
 	request->method = HTTPCLIENT_GET;
-	request->timeout = 10000;
-	HTTPClient_Async_SendGeneric(request);
+	request->timeout = g_httpclient_requestTimeout;
+	if(HTTPClient_Async_SendGeneric(request)) {
+		// queue is full, request is still ours
+		httpclient_freeMemory(request);
+		return 1;
+	}
 
 
     return 0;
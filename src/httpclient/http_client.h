@@ -81,6 +81,7 @@ typedef struct {
     char *post_buf; /**< User data to be posted. */
     char *response_buf; /**< Buffer to store the response data. */
     uint32_t response_buf_filled; /** how much real data in response_buff */
+    bool is_closing; /**< Server has sent "Connection: close", connection can't be kept alive. */
 } httpclient_data_t;
 
 // should the library call free( ) on request struct when done?
@@ -148,10 +149,40 @@ typedef struct httprequest_t_tag{
  * }
  * @endcode
  */
+// creates worker pool lock, must be called once before any request is sent
+void HTTPClient_Init();
 int HTTPClient_Async_SendGeneric(httprequest_t *request);
 int HTTPClient_Async_SendGet(const char *url_in);
 void HTTPClient_SetCustomHeader(httpclient_t *client, const char *header);
 
+/**
+ * Async requests are queued and served by a small fixed pool of worker threads.
+ * Finished connections are kept open for a while and reused by the next request
+ * to the same host:port. When the queue is full, HTTPClient_Async_SendGeneric
+ * returns an error and the caller still owns the request.
+ */
+#define HTTPCLIENT_POOL_WORKERS       2
+#define HTTPCLIENT_POOL_QUEUE_SIZE    8
+
+typedef struct httpclientStats_s {
+    int requests;           /**< Requests completed, both ok and failed. */
+    int failures;           /**< Requests that failed to connect, send or receive. */
+    int rejected;           /**< Requests not queued, because the queue was full. */
+    int connectionsOpened;
+    int connectionsReused;
+    int queueHighWater;
+    uint32_t latencyTotalMs;
+    uint32_t latencyMaxMs;
+} httpclientStats_t;
+
+// updated by workers with pool lock taken
+extern httpclientStats_t g_httpclient_stats;
+
+// default timeout for HTTPClient_Async_SendGet and idle connection lifetime
+void HTTPClient_SetTimeouts(int requestTimeoutMs, int keepAliveMs);
+void HTTPClient_GetTimeouts(int *requestTimeoutMs, int *keepAliveMs);
+int HTTPClient_GetQueuedCount();
+
 #ifdef __cplusplus
 }
 #endif
@@ -191,7 +191,7 @@ int32_t HAL_TCP_Read(uintptr_t fd, char *buf, uint32_t len, uint32_t timeout_ms)
 #else
     int ret, err_code,data_over;
     uint32_t len_recv;
-    uint64_t t_end, t_left;
+    uint64_t t_end, t_left, t_now;
     fd_set sets;
     struct timeval timeout;
 
@@ -202,17 +202,19 @@ int32_t HAL_TCP_Read(uintptr_t fd, char *buf, uint32_t len, uint32_t timeout_ms)
     data_over = 0;
 
     do {
-        t_left = utils_time_left(t_end, utils_time_get_ms());
-/*        if (0 == t_left && bk_http_ptr->do_data == 0) {
+        t_now = utils_time_get_ms();
+        if (t_now >= t_end) {
+            // timeout, caller gets 0 if nothing was received
             break;
-        }*/
+        }
+        t_left = t_end - t_now;
         FD_ZERO( &sets );
         FD_SET(fd, &sets);
 
         timeout.tv_sec = t_left / 1000;
         timeout.tv_usec = (t_left % 1000) * 1000;
 
-        ret = select(fd + 1, &sets, NULL, NULL, NULL);
+        ret = select(fd + 1, &sets, NULL, NULL, &timeout);
         if ( FD_ISSET( fd, &sets ) )
         {
             if (ret > 0) {
@@ -264,6 +266,24 @@ int32_t HAL_TCP_Read(uintptr_t fd, char *buf, uint32_t len, uint32_t timeout_ms)
 }
 
 /*** TCP connection ***/
+// Checks kept-alive connection before it's reused. Idle connection must not be readable,
+// if it is, then server has closed it (or sent garbage) and it can't be used anymore.
+int HAL_TCP_IsIdleAlive(uintptr_t fd)
+{
+    fd_set sets;
+    struct timeval timeout;
+
+    FD_ZERO( &sets );
+    FD_SET(fd, &sets);
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 0;
+
+    if (select(fd + 1, &sets, NULL, NULL, &timeout) != 0) {
+        return 0;
+    }
+    return 1;
+}
+
 int read_tcp(utils_network_pt pNetwork, char *buffer, uint32_t len, uint32_t timeout_ms)
 {
     return HAL_TCP_Read(pNetwork->handle, buffer, len, timeout_ms);
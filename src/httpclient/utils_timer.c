@@ -87,8 +87,12 @@ void utils_time_countdown_ms(iotx_time_t *timer, uint32_t millisecond)
 
 uint32_t utils_time_get_ms(void)
 {
-
+#ifdef WINDOWS
+    // simulator hal_machw_time is already in miliseconds
+    return hal_machw_time();
+#else
     return hal_machw_time()/1000;
+#endif
 }
 
 uint64_t utils_time_left(uint64_t t_end, uint64_t t_now)
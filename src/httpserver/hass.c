@@ -4,6 +4,7 @@
 #include "../logging/logging.h"
 #include "../hal/hal_wifi.h"
 #include "../driver/drv_public.h"
+#include "../mem_pool.h"
 
 /*
 Abbreviated node names - https://www.home-assistant.io/docs/mqtt/discovery/
@@ -117,7 +118,7 @@ cJSON* hass_build_device_node(cJSON* ids) {
 /// @param payload_off The payload that represents disabled state. This is not added for ENTITY_SENSOR.
 /// @return 
 HassDeviceInfo* hass_init_device_info(ENTITY_TYPE type, int index, char* payload_on, char* payload_off) {
-	HassDeviceInfo* info = os_malloc(sizeof(HassDeviceInfo));
+	HassDeviceInfo* info = Pool_Malloc(sizeof(HassDeviceInfo));
 	addLogAdv(LOG_DEBUG, LOG_FEATURE_HASS, "hass_init_device_info=%p", info);
 
 	hass_populate_unique_id(type, index, info->unique_id);
@@ -314,5 +315,5 @@ void hass_free_device_info(HassDeviceInfo* info) {
 		cJSON_Delete(info->root);
 	}
 
-	os_free(info);
+	Pool_Free(info);
 }
@@ -13,6 +13,7 @@
 #include "../logging/logging.h"
 #include "../devicegroups/deviceGroups_public.h"
 #include "../mqtt/new_mqtt.h"
+#include "../mem_pool.h"
 #include "hass.h"
 #include "../cJSON/cJSON.h"
 #include <time.h>
@@ -222,7 +223,7 @@ int http_fn_index(http_request_t* request) {
 	http_setup(request, httpMimeTypeHTML);	//Add mimetype regardless of the request
 
 	// use ?state URL parameter to only request current state
-	if (!http_getArg(request->url, "state", tmpA, sizeof(tmpA))) {
+	if (!http_getRequestArg(request, "state", tmpA, sizeof(tmpA))) {
 		http_html_start(request, NULL);
 
 		poststr(request, "<div id=\"changed\">");
@@ -236,7 +237,7 @@ int http_fn_index(http_request_t* request) {
 			DRV_HTTPButtons_ProcessChanges(request);
 		}
 #endif
-		if (http_getArg(request->url, "tgl", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "tgl", tmpA, sizeof(tmpA))) {
 			j = atoi(tmpA);
 			if (j == SPECIAL_CHANNEL_LEDPOWER) {
 				hprintf255(request, "<h3>Toggled LED power!</h3>", j);
@@ -246,12 +247,12 @@ int http_fn_index(http_request_t* request) {
 			}
 			CHANNEL_Toggle(j);
 		}
-		if (http_getArg(request->url, "on", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "on", tmpA, sizeof(tmpA))) {
 			j = atoi(tmpA);
 			hprintf255(request, "<h3>Enabled %i!</h3>", j);
 			CHANNEL_Set(j, 255, 1);
 		}
-		if (http_getArg(request->url, "rgb", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "rgb", tmpA, sizeof(tmpA))) {
 			hprintf255(request, "<h3>Set RGB to %s!</h3>", tmpA);
 			LED_SetBaseColor(0, "led_basecolor", tmpA, 0);
 			// auto enable - but only for changes made from WWW panel
@@ -261,14 +262,14 @@ int http_fn_index(http_request_t* request) {
 			}
 		}
 
-		if (http_getArg(request->url, "off", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "off", tmpA, sizeof(tmpA))) {
 			j = atoi(tmpA);
 			hprintf255(request, "<h3>Disabled %i!</h3>", j);
 			CHANNEL_Set(j, 0, 1);
 		}
-		if (http_getArg(request->url, "pwm", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "pwm", tmpA, sizeof(tmpA))) {
 			int newPWMValue = atoi(tmpA);
-			http_getArg(request->url, "pwmIndex", tmpA, sizeof(tmpA));
+			http_getRequestArg(request, "pwmIndex", tmpA, sizeof(tmpA));
 			j = atoi(tmpA);
 			if (j == SPECIAL_CHANNEL_TEMPERATURE) {
 				hprintf255(request, "<h3>Changed Temperature to %i!</h3>", newPWMValue);
@@ -286,9 +287,9 @@ int http_fn_index(http_request_t* request) {
 				}
 			}
 		}
-		if (http_getArg(request->url, "dim", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "dim", tmpA, sizeof(tmpA))) {
 			int newDimmerValue = atoi(tmpA);
-			http_getArg(request->url, "dimIndex", tmpA, sizeof(tmpA));
+			http_getRequestArg(request, "dimIndex", tmpA, sizeof(tmpA));
 			j = atoi(tmpA);
 			if (j == SPECIAL_CHANNEL_BRIGHTNESS) {
 				hprintf255(request, "<h3>Changed LED brightness to %i!</h3>", newDimmerValue);
@@ -306,18 +307,18 @@ int http_fn_index(http_request_t* request) {
 				}
 			}
 		}
-		if (http_getArg(request->url, "set", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "set", tmpA, sizeof(tmpA))) {
 			int newSetValue = atoi(tmpA);
-			http_getArg(request->url, "setIndex", tmpA, sizeof(tmpA));
+			http_getRequestArg(request, "setIndex", tmpA, sizeof(tmpA));
 			j = atoi(tmpA);
 			hprintf255(request, "<h3>Changed channel %i to %i!</h3>", j, newSetValue);
 			CHANNEL_Set(j, newSetValue, 1);
 		}
-		if (http_getArg(request->url, "restart", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "restart", tmpA, sizeof(tmpA))) {
 			poststr(request, "<h5> Module will restart soon</h5>");
 			RESET_ScheduleModuleReset(3);
 		}
-		if (http_getArg(request->url, "unsafe", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "unsafe", tmpA, sizeof(tmpA))) {
 			poststr(request, "<h5> Will try to do unsafe init in few seconds</h5>");
 			MAIN_ScheduleUnsafeInit(3);
 		}
@@ -833,7 +834,7 @@ int http_fn_index(http_request_t* request) {
 
 	}
 	// for normal page loads, show the rest of the HTML
-	if (!http_getArg(request->url, "state", tmpA, sizeof(tmpA))) {
+	if (!http_getRequestArg(request, "state", tmpA, sizeof(tmpA))) {
 		poststr(request, "</div>"); // end div#state
 
 		// Shared UI elements 
@@ -902,22 +903,22 @@ int http_fn_cfg_mqtt_set(http_request_t* request) {
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "Saving MQTT");
 
-	if (http_getArg(request->url, "host", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "host", tmpA, sizeof(tmpA))) {
 		CFG_SetMQTTHost(tmpA);
 	}
-	if (http_getArg(request->url, "port", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "port", tmpA, sizeof(tmpA))) {
 		CFG_SetMQTTPort(atoi(tmpA));
 	}
-	if (http_getArg(request->url, "user", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "user", tmpA, sizeof(tmpA))) {
 		CFG_SetMQTTUserName(tmpA);
 	}
-	if (http_getArg(request->url, "password", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "password", tmpA, sizeof(tmpA))) {
 		CFG_SetMQTTPass(tmpA);
 	}
-	if (http_getArg(request->url, "client", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "client", tmpA, sizeof(tmpA))) {
 		CFG_SetMQTTClientId(tmpA);
 	}
-	if (http_getArg(request->url, "group", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "group", tmpA, sizeof(tmpA))) {
 		CFG_SetMQTTGroupTopic(tmpA);
 	}
 
@@ -953,7 +954,7 @@ int http_fn_cfg_webapp_set(http_request_t* request) {
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "Saving Webapp");
 
-	if (http_getArg(request->url, "url", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "url", tmpA, sizeof(tmpA))) {
 		CFG_SetWebappRoot(tmpA);
 		CFG_Save_IfThereArePendingChanges();
 		hprintf255(request, "Webapp url set to %s", tmpA);
@@ -987,22 +988,22 @@ int http_fn_cfg_ping(http_request_t* request) {
 	poststr(request, " This is why <b>this mechanism</b> has been added.</p>");
 	poststr(request, "<p> This mechanism keeps pinging certain host and reconnects to WiFi if it doesn't respond at all for a certain amount of seconds.</p>");
 	poststr(request, "<p> USAGE: For a host, choose the main address of your router and make sure it responds to a pings. Interval is 1 second or so, timeout can be set by user, to eg. 60 sec</p>");
-	if (http_getArg(request->url, "host", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "host", tmpA, sizeof(tmpA))) {
 		CFG_SetPingHost(tmpA);
 		poststr(request, "<h4> New ping host set!</h4>");
 		bChanged = 1;
 	}
-	/* if(http_getArg(request->url,"interval",tmpA,sizeof(tmpA))) {
+	/* if(http_getRequestArg(request, "interval",tmpA,sizeof(tmpA))) {
 		 CFG_SetPingIntervalSeconds(atoi(tmpA));
 		 poststr(request,"<h4> New ping interval set!</h4>");
 		 bChanged = 1;
 	 }*/
-	if (http_getArg(request->url, "disconnectTime", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "disconnectTime", tmpA, sizeof(tmpA))) {
 		CFG_SetPingDisconnectedSecondsToRestart(atoi(tmpA));
 		poststr(request, "<h4> New ping disconnectTime set!</h4>");
 		bChanged = 1;
 	}
-	if (http_getArg(request->url, "clear", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "clear", tmpA, sizeof(tmpA))) {
 		CFG_SetPingDisconnectedSecondsToRestart(0);
 		CFG_SetPingIntervalSeconds(0);
 		CFG_SetPingHost("");
@@ -1050,7 +1051,7 @@ int http_fn_cfg_wifi(http_request_t* request) {
 		poststr(request,"<h4> Device will reconnect after restarting</h4>");
 	}*/
 	poststr(request, "<h2> Check networks reachable by module</h2> This will lag few seconds.<br>");
-	if (http_getArg(request->url, "scan", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "scan", tmpA, sizeof(tmpA))) {
 #ifdef WINDOWS
 
 		poststr(request, "Not available on Windows<br>");
@@ -1121,10 +1122,10 @@ int http_fn_cfg_name(http_request_t* request) {
 	http_html_start(request, "Set name");
 
 	poststr(request, "<h2> Change device names for display. </h2>");
-	if (http_getArg(request->url, "shortName", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "shortName", tmpA, sizeof(tmpA))) {
 		CFG_SetShortDeviceName(tmpA);
 	}
-	if (http_getArg(request->url, "name", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "name", tmpA, sizeof(tmpA))) {
 		CFG_SetDeviceName(tmpA);
 	}
 	CFG_Save_IfThereArePendingChanges();
@@ -1154,16 +1155,16 @@ int http_fn_cfg_wifi_set(http_request_t* request) {
 
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "Saving Wifi");
-	if (http_getArg(request->url, "open", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "open", tmpA, sizeof(tmpA))) {
 		CFG_SetWiFiSSID("");
 		CFG_SetWiFiPass("");
 		poststr(request, "WiFi mode set: open access point.");
 	}
 	else {
-		if (http_getArg(request->url, "ssid", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "ssid", tmpA, sizeof(tmpA))) {
 			CFG_SetWiFiSSID(tmpA);
 		}
-		if (http_getArg(request->url, "pass", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "pass", tmpA, sizeof(tmpA))) {
 			CFG_SetWiFiPass(tmpA);
 		}
 		poststr(request, "WiFi mode set: connect to WLAN.");
@@ -1188,7 +1189,7 @@ int http_fn_cfg_loglevel_set(http_request_t* request) {
 
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "Set log level");
-	if (http_getArg(request->url, "loglevel", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "loglevel", tmpA, sizeof(tmpA))) {
 #if WINDOWS
 #else
 		loglevel = atoi(tmpA);
@@ -1226,7 +1227,7 @@ int http_fn_cfg_mac(http_request_t* request) {
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "Set MAC address");
 
-	if (http_getArg(request->url, "mac", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "mac", tmpA, sizeof(tmpA))) {
 		for (i = 0; i < 6; i++)
 		{
 			mac[i] = hexbyte(&tmpA[i * 2]);
@@ -1271,15 +1272,15 @@ int http_fn_flash_read_tool(http_request_t* request) {
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "Flash read");
 	poststr(request, "<h4>Flash Read Tool</h4>");
-	if (http_getArg(request->url, "hex", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "hex", tmpA, sizeof(tmpA))) {
 		hex = atoi(tmpA);
 	}
 	else {
 		hex = 0;
 	}
 
-	if (http_getArg(request->url, "offset", tmpA, sizeof(tmpA)) &&
-		http_getArg(request->url, "len", tmpB, sizeof(tmpB))) {
+	if (http_getRequestArg(request, "offset", tmpA, sizeof(tmpA)) &&
+		http_getRequestArg(request, "len", tmpB, sizeof(tmpB))) {
 		unsigned char buffer[128];
 		len = atoi(tmpB);
 		ofs = atoi(tmpA);
@@ -1380,7 +1381,7 @@ int http_fn_cmd_tool(http_request_t* request) {
 	poststr(request, "Please consider using 'Web Application' console with more options and real time log view. <br>");
 	poststr(request, "Remember that some commands are added after a restart when a driver is activated... <br>");
 
-	commandLen = http_getArg(request->url, "cmd", tmpA, sizeof(tmpA));
+	commandLen = http_getRequestArg(request, "cmd", tmpA, sizeof(tmpA));
 	if (commandLen) {
 		poststr(request, "<br>");
 		// all log printfs made by command will be sent also to request
@@ -1389,7 +1390,7 @@ int http_fn_cmd_tool(http_request_t* request) {
 			commandLen += 8;
 			long_str_alloced = (char*)malloc(commandLen);
 			if (long_str_alloced) {
-				http_getArg(request->url, "cmd", long_str_alloced, commandLen);
+				http_getRequestArg(request, "cmd", long_str_alloced, commandLen);
 				res = CMD_ExecuteCommand(long_str_alloced, COMMAND_FLAG_SOURCE_CONSOLE);
 				free(long_str_alloced);
 			}
@@ -1426,7 +1427,7 @@ int http_fn_startup_command(http_request_t* request) {
 		"You can use them to init peripherals and drivers, like BL0942 energy sensor."
 		"Use backlog cmd1; cmd2; cmd3; etc to enter multiple commands</h5>");
 
-	if (http_getArg(request->url, "data", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "data", tmpA, sizeof(tmpA))) {
 		//  hprintf255(request,"<h3>Set command to  %s!</h3>",tmpA);
 		  // tmpA can be longer than 128 bytes and this would crash
 		hprintf255(request, "<h3>Command changed!</h3>");
@@ -1454,7 +1455,7 @@ int http_fn_uart_tool(http_request_t* request) {
 	http_html_start(request, "UART tool");
 	poststr(request, "<h4>UART Tool</h4>");
 
-	if (http_getArg(request->url, "data", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "data", tmpA, sizeof(tmpA))) {
 #ifdef ENABLE_DRIVER_TUYAMCU
 		byte results[128];
 
@@ -1521,7 +1522,7 @@ int http_fn_cfg_quick(http_request_t* request) {
 	poststr(request, "<h3><a href=\"https://openbekeniot.github.io/webapp/devicesList.html\">Also please see here</a></h3>");
 
 
-	/*if (http_getArg(request->url, "dev", tmpA, sizeof(tmpA))) {
+	/*if (http_getRequestArg(request, "dev", tmpA, sizeof(tmpA))) {
 		j = atoi(tmpA);
 		hprintf255(request, "<h3>Set dev %i!</h3>", j);
 		g_templates[j].setter();
@@ -1610,8 +1611,9 @@ void doHomeAssistantDiscovery(const char *topic, http_request_t *request) {
 		return;
 	}
 
-	hooks.malloc_fn = os_malloc;
-	hooks.free_fn = os_free;
+	// discovery creates and deletes lots of small nodes
+	hooks.malloc_fn = Pool_Malloc;
+	hooks.free_fn = Pool_Free;
 	cJSON_InitHooks(&hooks);
 
 	if (relayCount > 0) {
@@ -1718,7 +1720,7 @@ int http_fn_ha_discovery(http_request_t* request) {
 
 	// even if it returns the empty HA topic,
 	// the function call below will set default
-	http_getArg(request->url, "prefix", topic, sizeof(topic));
+	http_getRequestArg(request, "prefix", topic, sizeof(topic));
 	doHomeAssistantDiscovery(topic, request);
 
 	poststr(request, "MQTT discovery queued.");
@@ -2482,13 +2484,13 @@ int http_fn_cm(http_request_t* request) {
 
 	http_setup(request, httpMimeTypeJson);
 	// exec command
-	commandLen = http_getArg(request->url, "cmnd", tmpA, sizeof(tmpA));
+	commandLen = http_getRequestArg(request, "cmnd", tmpA, sizeof(tmpA));
 	if (commandLen) {
 		if (commandLen > (sizeof(tmpA) - 5)) {
 			commandLen += 8;
 			long_str_alloced = (char*)malloc(commandLen);
 			if (long_str_alloced) {
-				http_getArg(request->url, "cmnd", long_str_alloced, commandLen);
+				http_getRequestArg(request, "cmnd", long_str_alloced, commandLen);
 				CMD_ExecuteCommand(long_str_alloced, COMMAND_FLAG_SOURCE_HTTP);
 				free(long_str_alloced);
 			}
@@ -2578,7 +2580,7 @@ int http_fn_cfg_pins(http_request_t* request) {
 #endif
 	for (i = 0; i < PLATFORM_GPIO_MAX; i++) {
 		sprintf(tmpA, "%i", i);
-		if (http_getArg(request->url, tmpA, tmpB, sizeof(tmpB))) {
+		if (http_getRequestArg(request, tmpA, tmpB, sizeof(tmpB))) {
 			int role;
 			int pr;
 
@@ -2593,7 +2595,7 @@ int http_fn_cfg_pins(http_request_t* request) {
 			}
 		}
 		sprintf(tmpA, "r%i", i);
-		if (http_getArg(request->url, tmpA, tmpB, sizeof(tmpB))) {
+		if (http_getRequestArg(request, tmpA, tmpB, sizeof(tmpB))) {
 			int rel;
 			int prevRel;
 
@@ -2608,7 +2610,7 @@ int http_fn_cfg_pins(http_request_t* request) {
 			}
 		}
 		sprintf(tmpA, "e%i", i);
-		if (http_getArg(request->url, tmpA, tmpB, sizeof(tmpB))) {
+		if (http_getRequestArg(request, tmpA, tmpB, sizeof(tmpB))) {
 			int rel;
 			int prevRel;
 
@@ -2738,7 +2740,7 @@ const char* g_obk_flagNames[] = {
 	"[UART] Use alternate UART for BL0942, CSE, TuyaMCU, etc",
 #endif
 	"[HASS] Invoke HomeAssistant discovery on change to ip address, configuration",
-	"error",
+	"[BTN] Use GPIO edge interrupts for buttons where supported, instead of polling (applied on pin setup)",
 	"error",
 	"error",
 };
@@ -2750,7 +2752,7 @@ int http_fn_cfg_generic(http_request_t* request) {
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "Generic config");
 
-	if (http_getArg(request->url, "boot_ok_delay", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "boot_ok_delay", tmpA, sizeof(tmpA))) {
 		i = atoi(tmpA);
 		if (i <= 0) {
 			poststr(request, "<h5>Boot ok delay must be at least 1 second<h5>");
@@ -2760,12 +2762,12 @@ int http_fn_cfg_generic(http_request_t* request) {
 		CFG_SetBootOkSeconds(i);
 	}
 
-	if (http_getArg(request->url, "setFlags", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "setFlags", tmpA, sizeof(tmpA))) {
 		for (i = 0; i < OBK_TOTAL_FLAGS; i++) {
 			int ni;
 			sprintf(tmpB, "flag%i", i);
 
-			if (http_getArg(request->url, tmpB, tmpA, sizeof(tmpA))) {
+			if (http_getRequestArg(request, tmpB, tmpA, sizeof(tmpA))) {
 				ni = atoi(tmpA);
 			}
 			else {
@@ -2824,9 +2826,9 @@ int http_fn_cfg_startup(http_request_t* request) {
 	hprintf255(request, "<h5><color=red>Remembering last state of LED driver also fully you can set it in");
 	hprintf255(request, "Options->General, set Flag 12 - [LED] remember LED driver state (RGBCW, enable, brightness, temperature) after reboot!</color></h5>");
 
-	if (http_getArg(request->url, "idx", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "idx", tmpA, sizeof(tmpA))) {
 		channelIndex = atoi(tmpA);
-		if (http_getArg(request->url, "value", tmpA, sizeof(tmpA))) {
+		if (http_getRequestArg(request, "value", tmpA, sizeof(tmpA))) {
 			newValue = atoi(tmpA);
 
 
@@ -2874,24 +2876,24 @@ int http_fn_cfg_dgr(http_request_t* request) {
 	hprintf255(request, "<h5>Here you can configure Tasmota Device Groups<h5>");
 
 
-	if (http_getArg(request->url, "name", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "name", tmpA, sizeof(tmpA))) {
 		int newSendFlags;
 		int newRecvFlags;
 
 		newSendFlags = 0;
 		newRecvFlags = 0;
 
-		if (http_getArgInteger(request->url, "s_pwr"))
+		if (http_getRequestArgInteger(request, "s_pwr"))
 			newSendFlags |= DGR_SHARE_POWER;
-		if (http_getArgInteger(request->url, "r_pwr"))
+		if (http_getRequestArgInteger(request, "r_pwr"))
 			newRecvFlags |= DGR_SHARE_POWER;
-		if (http_getArgInteger(request->url, "s_lbr"))
+		if (http_getRequestArgInteger(request, "s_lbr"))
 			newSendFlags |= DGR_SHARE_LIGHT_BRI;
-		if (http_getArgInteger(request->url, "r_lbr"))
+		if (http_getRequestArgInteger(request, "r_lbr"))
 			newRecvFlags |= DGR_SHARE_LIGHT_BRI;
-		if (http_getArgInteger(request->url, "s_lcl"))
+		if (http_getRequestArgInteger(request, "s_lcl"))
 			newSendFlags |= DGR_SHARE_LIGHT_COLOR;
-		if (http_getArgInteger(request->url, "r_lcl"))
+		if (http_getRequestArgInteger(request, "r_lcl"))
 			newRecvFlags |= DGR_SHARE_LIGHT_COLOR;
 
 		CFG_DeviceGroups_SetName(tmpA);
@@ -2974,7 +2976,7 @@ int http_fn_ota_exec(http_request_t* request) {
 
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "OTA request");
-	if (http_getArg(request->url, "host", tmpA, sizeof(tmpA))) {
+	if (http_getRequestArg(request, "host", tmpA, sizeof(tmpA))) {
 		hprintf255(request, "<h3>OTA requested for %s!</h3>", tmpA);
 		addLogAdv(LOG_INFO, LOG_FEATURE_HTTP, "http_fn_ota_exec: will try to do OTA for %s \r\n", tmpA);
 		OTA_RequestDownloadFromHTTP(tmpA);
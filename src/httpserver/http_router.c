@@ -0,0 +1,209 @@
+#include "../new_common.h"
+#include "../logging/logging.h"
+#include "http_router.h"
+
+#define ROUTE_LITERAL 0
+#define ROUTE_PARAM 1
+#define ROUTE_WILDCARD 2
+
+typedef struct httpRouteNode_s {
+	// segment as in pattern, ":name" or "*" for params
+	char* segment;
+	unsigned short segmentLen;
+	byte type;
+	struct httpRouteNode_s* children;
+	struct httpRouteNode_s* next;
+	httpRoute_t* routes;
+} httpRouteNode_t;
+
+static httpRouteNode_t g_routeRoot;
+static int g_routesCount;
+
+extern const char* methodNames[];
+
+static httpRouteNode_t* HTTP_GetRouteChild(httpRouteNode_t* node, const char* segment, int len, bool bCreate) {
+	httpRouteNode_t* c;
+
+	for (c = node->children; c; c = c->next) {
+		if (c->segmentLen == len && !strncmp(c->segment, segment, len))
+			return c;
+	}
+	if (bCreate == false)
+		return 0;
+	c = (httpRouteNode_t*)os_malloc(sizeof(httpRouteNode_t));
+	if (c == 0)
+		return 0;
+	memset(c, 0, sizeof(httpRouteNode_t));
+	c->segment = (char*)os_malloc(len + 1);
+	if (c->segment == 0) {
+		os_free(c);
+		return 0;
+	}
+	memcpy(c->segment, segment, len);
+	c->segment[len] = 0;
+	c->segmentLen = len;
+	if (*segment == ':')
+		c->type = ROUTE_PARAM;
+	else if (*segment == '*')
+		c->type = ROUTE_WILDCARD;
+	else
+		c->type = ROUTE_LITERAL;
+	c->next = node->children;
+	node->children = c;
+	return c;
+}
+
+int HTTP_AddRoute(const char* pattern, int method, http_callback_fn callback, bool bKeepExisting) {
+	httpRouteNode_t* node;
+	httpRoute_t* r;
+	const char* s;
+	const char* e;
+
+	if (!pattern || !callback) {
+		return -1;
+	}
+	node = &g_routeRoot;
+	s = pattern;
+	if (*s == '/')
+		s++;
+	while (*s) {
+		e = s;
+		while (*e && *e != '/')
+			e++;
+		node = HTTP_GetRouteChild(node, s, e - s, true);
+		if (node == 0) {
+			return -2;
+		}
+		// nothing can follow wildcard
+		if (node->type == ROUTE_WILDCARD || *e == 0)
+			break;
+		s = e + 1;
+		// trailing slash is a segment of its own, "/api/" is not "/api"
+		if (*s == 0) {
+			node = HTTP_GetRouteChild(node, s, 0, true);
+			if (node == 0) {
+				return -2;
+			}
+		}
+	}
+	for (r = node->routes; r; r = r->next) {
+		if (r->method == method) {
+			if (bKeepExisting == false) {
+				r->callback = callback;
+			}
+			return 0;
+		}
+	}
+	r = (httpRoute_t*)os_malloc(sizeof(httpRoute_t));
+	if (r == 0) {
+		return -2;
+	}
+	memset(r, 0, sizeof(httpRoute_t));
+	r->method = method;
+	r->callback = callback;
+	snprintf(r->perfName, sizeof(r->perfName), "%s %s",
+		method == HTTP_ANY ? "ANY" : methodNames[method], pattern);
+	r->next = node->routes;
+	node->routes = r;
+	g_routesCount++;
+	return 0;
+}
+
+static httpRoute_t* HTTP_GetRouteForMethod(httpRouteNode_t* node, int method) {
+	httpRoute_t* r;
+	httpRoute_t* any = 0;
+
+	for (r = node->routes; r; r = r->next) {
+		if (r->method == method)
+			return r;
+		if (r->method == HTTP_ANY)
+			any = r;
+	}
+	return any;
+}
+static void HTTP_PushRouteParam(http_request_t* request, const char* name, const char* value, int len) {
+	if (request->numRouteParams >= HTTP_MAX_ROUTE_PARAMS)
+		return;
+	request->routeParams[request->numRouteParams].name = name;
+	request->routeParams[request->numRouteParams].value = value;
+	request->routeParams[request->numRouteParams].len = len;
+	request->numRouteParams++;
+}
+// seg is start of segment to match, 0 if whole path was consumed
+static httpRoute_t* HTTP_MatchRoute(httpRouteNode_t* node, http_request_t* request, const char* seg, const char* end) {
+	httpRouteNode_t* c;
+	httpRoute_t* r;
+	const char* segEnd;
+	const char* next;
+	int savedParams;
+	int pass;
+
+	if (seg == 0) {
+		return HTTP_GetRouteForMethod(node, request->method);
+	}
+	segEnd = seg;
+	while (segEnd < end && *segEnd != '/')
+		segEnd++;
+	next = segEnd < end ? segEnd + 1 : 0;
+	savedParams = request->numRouteParams;
+	// literal first, then param, then wildcard
+	for (pass = ROUTE_LITERAL; pass <= ROUTE_WILDCARD; pass++) {
+		for (c = node->children; c; c = c->next) {
+			if (c->type != pass)
+				continue;
+			if (pass == ROUTE_LITERAL) {
+				if (c->segmentLen != segEnd - seg || strncmp(c->segment, seg, segEnd - seg))
+					continue;
+				r = HTTP_MatchRoute(c, request, next, end);
+			}
+			else if (pass == ROUTE_PARAM) {
+				if (segEnd == seg)
+					continue;
+				HTTP_PushRouteParam(request, c->segment + 1, seg, segEnd - seg);
+				r = HTTP_MatchRoute(c, request, next, end);
+			}
+			else {
+				r = HTTP_GetRouteForMethod(c, request->method);
+				if (r) {
+					HTTP_PushRouteParam(request, c->segment, seg, end - seg);
+				}
+			}
+			if (r)
+				return r;
+			request->numRouteParams = savedParams;
+		}
+	}
+	return 0;
+}
+httpRoute_t* HTTP_FindRoute(http_request_t* request, const char* url) {
+	const char* end;
+
+	request->numRouteParams = 0;
+	end = url;
+	while (*end && *end != '?' && *end != ' ')
+		end++;
+	if (end == url) {
+		return HTTP_MatchRoute(&g_routeRoot, request, 0, end);
+	}
+	return HTTP_MatchRoute(&g_routeRoot, request, url, end);
+}
+int HTTP_GetRoutesCount() {
+	return g_routesCount;
+}
+
+int HTTP_GetRouteParam(http_request_t* request, const char* name, char* o, int maxSize) {
+	int i, len;
+
+	*o = 0;
+	for (i = 0; i < request->numRouteParams; i++) {
+		if (strcmp(request->routeParams[i].name, name))
+			continue;
+		len = request->routeParams[i].len;
+		if (len > maxSize - 1)
+			len = maxSize - 1;
+		memcpy(o, request->routeParams[i].value, len);
+		o[len] = 0;
+		return request->routeParams[i].len;
+	}
+	return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef __HTTP_ROUTER_H__
+#define __HTTP_ROUTER_H__
+
+#include "../new_common.h"
+#include "new_http.h"
+#include "../perf.h"
+
+// Routes are kept in a trie of path segments, so finding handler costs
+// one step per segment of url, no matter how many routes there are.
+// Segment of pattern can be:
+// - literal, like "api" or "cfg_pins",
+// - ":name", matches any single non-empty segment, see HTTP_GetRouteParam,
+// - "*", only as last one, matches rest of path (also empty), param name is "*".
+// Literal segments are tried first, then ":name", then "*".
+// Examples: "/", "/index", "/api/channels", "/api/lfs/*", "/api/dev/:id/state"
+
+typedef struct httpRoute_s {
+	int method;
+	http_callback_fn callback;
+	// registered on first call, so /api/perf lists only routes that were used
+	perfSection_t perf;
+	// method and url, so GET and POST handlers of same url are told apart in /api/perf
+	char perfName[32];
+	struct httpRoute_s* next;
+} httpRoute_t;
+
+// adds handler for pattern and method (or HTTP_ANY),
+// handler of same pattern and method is replaced, unless bKeepExisting is set
+// returns 0 on success
+int HTTP_AddRoute(const char* pattern, int method, http_callback_fn callback, bool bKeepExisting);
+// finds handler for url (without leading '/', query is ignored), fills request route params
+httpRoute_t* HTTP_FindRoute(http_request_t* request, const char* url);
+int HTTP_GetRoutesCount();
+
+#endif // __HTTP_ROUTER_H__
@@ -5,9 +5,10 @@
 #include "lwip/inet.h"
 #include "../logging/logging.h"
 #include "new_http.h"
+#include "../mem_pool.h"
 
 #define HTTP_SERVER_PORT            80
-#define REPLY_BUFFER_SIZE			2048
+#define REPLY_BUFFER_SIZE			HTTP_SEND_WINDOW
 #define INCOMING_BUFFER_SIZE		1024
 
 
@@ -76,8 +77,8 @@ static void tcp_client_thread(beken_thread_arg_t arg)
   //my_fd = fd;
 	rtos_delay_milliseconds(20);
 
-	reply = (char*)os_malloc(replyBufferSize);
-	buf = (char*)os_malloc(INCOMING_BUFFER_SIZE);
+	reply = (char*)Pool_Malloc(replyBufferSize);
+	buf = (char*)Pool_Malloc(INCOMING_BUFFER_SIZE);
 
 	if (buf == 0 || reply == 0)
 	{
@@ -99,6 +100,7 @@ static void tcp_client_thread(beken_thread_arg_t arg)
 	reply[0] = '\0';
 
 	request.replymaxlen = replyBufferSize - 1;
+	request.bChunkedAllowed = 1;
 
 	if (request.receivedLen <= 0)
 	{
@@ -122,9 +124,9 @@ exit:
 		ADDLOG_ERROR(LOG_FEATURE_HTTP, "TCP client thread exit with err: %d", err);
 
 	if (buf != NULL)
-		os_free(buf);
+		Pool_Free(buf);
 	if (reply != NULL)
-		os_free(reply);
+		Pool_Free(reply);
 
 	lwip_close(fd);;
 #if DISABLE_SEPARATE_THREAD_FOR_EACH_TCP_CLIENT
@@ -255,6 +257,7 @@ static void tcp_client_thread(int fd, char* buf, char* reply)
 	reply[0] = '\0';
 
 	request.replymaxlen = REPLY_BUFFER_SIZE - 1;
+	request.bChunkedAllowed = 1;
 
 	if (request.receivedLen <= 0)
 	{
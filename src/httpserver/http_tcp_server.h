@@ -1,2 +1,4 @@
 
 void HTTPServer_Start();
+// http_tcp_server_nonblocking.c, simulator
+void HTTPServer_RunQuickTick();
@@ -132,6 +132,7 @@ void HTTPServer_RunQuickTick() {
 				request.replylen = 0;
 
 				request.replymaxlen = DEFAULT_BUFLEN;
+				request.bChunkedAllowed = 1;
 
 				//printf("HTTP Server for Windows: Bytes received: %d \n", iResult);
 				len = HTTP_ProcessPacket(&request);
@@ -145,7 +146,7 @@ void HTTPServer_RunQuickTick() {
 					if (iSendResult == SOCKET_ERROR) {
 						printf("send failed with error: %d\n", WSAGetLastError());
 						closesocket(ClientSocket);
-						return 1;
+						return;
 					}
 					printf("HTTP Server for Windows: Bytes sent: %d\n", iSendResult);
 				}
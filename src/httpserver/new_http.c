@@ -9,6 +9,9 @@
 #include "../new_cfg.h"
 #include "../ota/ota.h"
 #include "../hal/hal_wifi.h"
+#include "../perf.h"
+#include "http_router.h"
+#include "../mem_pool.h"
 
 
 // define the feature ADDLOGF_XXX will use
@@ -70,40 +73,73 @@ const char* methodNames[] = {
 void misc_formatUpTimeString(int totalSeconds, char* o);
 int Time_getUpTimeSeconds();
 
-typedef struct http_callback_tag {
-	char* url;
-	int method;
-	http_callback_fn callback;
-} http_callback_t;
-
-#define MAX_HTTP_CALLBACKS 32
-static http_callback_t* callbacks[MAX_HTTP_CALLBACKS];
-static int numCallbacks = 0;
-
 int HTTP_RegisterCallback(const char* url, int method, http_callback_fn callback) {
+	char tmp[64];
+	int len;
+
 	if (!url || !callback) {
 		return -1;
 	}
-	if (numCallbacks >= MAX_HTTP_CALLBACKS) {
-		return -4;
+	// url ending with slash handles everything below it
+	len = strlen(url);
+	if (len > 0 && url[len - 1] == '/' && len + 2 <= sizeof(tmp)) {
+		memcpy(tmp, url, len);
+		tmp[len] = '*';
+		tmp[len + 1] = 0;
+		return HTTP_AddRoute(tmp, method, callback, false);
 	}
-	callbacks[numCallbacks] = (http_callback_t*)os_malloc(sizeof(http_callback_t));
-	if (!callbacks[numCallbacks]) {
-		return -2;
-	}
-	callbacks[numCallbacks]->url = (char*)os_malloc(strlen(url) + 1);
-	if (!callbacks[numCallbacks]->url) {
-		os_free(callbacks[numCallbacks]);
-		return -3;
-	}
-	strcpy(callbacks[numCallbacks]->url, url);
-	callbacks[numCallbacks]->callback = callback;
-	callbacks[numCallbacks]->method = method;
+	return HTTP_AddRoute(url, method, callback, false);
+}
 
-	numCallbacks++;
+typedef struct httpPage_s {
+	const char* url;
+	http_callback_fn callback;
+} httpPage_t;
+
+static const httpPage_t g_httpPages[] = {
+	{ "/", http_fn_empty_url },
+	{ "/testmsg", http_fn_testmsg },
+	{ "/index", http_fn_index },
+	{ "/about", http_fn_about },
+	{ "/cfg_mqtt", http_fn_cfg_mqtt },
+	{ "/cfg_mqtt_set", http_fn_cfg_mqtt_set },
+	{ "/cfg_webapp", http_fn_cfg_webapp },
+	{ "/cfg_webapp_set", http_fn_cfg_webapp_set },
+	{ "/cfg_wifi", http_fn_cfg_wifi },
+	{ "/cfg_name", http_fn_cfg_name },
+	{ "/cfg_wifi_set", http_fn_cfg_wifi_set },
+	{ "/cfg_loglevel_set", http_fn_cfg_loglevel_set },
+	{ "/cfg_mac", http_fn_cfg_mac },
+	{ "/flash_read_tool", http_fn_flash_read_tool },
+	{ "/uart_tool", http_fn_uart_tool },
+	{ "/cmd_tool", http_fn_cmd_tool },
+	{ "/startup_command", http_fn_startup_command },
+	{ "/cfg_generic", http_fn_cfg_generic },
+	{ "/cfg_startup", http_fn_cfg_startup },
+	{ "/cfg_dgr", http_fn_cfg_dgr },
+	{ "/cfg_quick", http_fn_cfg_quick },
+	{ "/ha_cfg", http_fn_ha_cfg },
+	{ "/ha_discovery", http_fn_ha_discovery },
+	{ "/cfg", http_fn_cfg },
+	{ "/cfg_pins", http_fn_cfg_pins },
+	{ "/cfg_ping", http_fn_cfg_ping },
+	{ "/ota", http_fn_ota },
+	{ "/ota_exec", http_fn_ota_exec },
+	{ "/cm", http_fn_cm },
+};
 
-	// success
-	return 0;
+// built in pages are added on first request, and never replace
+// callbacks registered by drivers for same url
+static void HTTP_AddBuiltInPages() {
+	static bool bAdded = false;
+	int i;
+
+	if (bAdded)
+		return;
+	bAdded = true;
+	for (i = 0; i < sizeof(g_httpPages) / sizeof(g_httpPages[0]); i++) {
+		HTTP_AddRoute(g_httpPages[i].url, HTTP_ANY, g_httpPages[i].callback, true);
+	}
 }
 
 int my_strnicmp(const char* a, const char* b, int len) {
@@ -203,6 +239,10 @@ bool http_checkUrlBase(const char* base, const char* fileName) {
 	return true;
 }
 
+#if !PLATFORM_BL602
+static void http_beginChunked(http_request_t* request);
+#endif
+
 void http_setup(http_request_t* request, const char* type) {
 	hprintf255(request, httpHeader, request->responseCode, type);
 	poststr(request, "\r\n"); // next header
@@ -221,9 +261,18 @@ void http_setup(http_request_t* request, const char* type) {
 	poststr(request, "Transfer-Encoding: chunked");
 #endif
 	poststr(request, "\r\n");
+#if !PLATFORM_BL602
+	if (request->bChunkedAllowed && request->fd != 0) {
+		poststr(request, "Transfer-Encoding: chunked");
+		poststr(request, "\r\n");
+	}
+#endif
 	poststr(request, "Connection: close");
 	poststr(request, "\r\n"); // end headers with double CRLF
 	poststr(request, "\r\n");
+#if !PLATFORM_BL602
+	http_beginChunked(request);
+#endif
 }
 
 void http_html_start(http_request_t* request, const char* pagename) {
@@ -338,6 +387,129 @@ int http_copyCarg(const char* atin, char* to, int maxSize) {
 	return realSize;
 }
 
+// Arguments of request are indexed once, by HTTP_IndexArgs, so handlers
+// asking for many fields (like cfg_pins) don't rescan whole query for each
+// of them. Index belongs to request, so requests served by separate threads
+// don't share it. Names and values point into received buffer, value is
+// decoded only when asked for, straight into caller buffer.
+#define HTTP_MAX_ARGS 96
+// power of two, more than HTTP_MAX_ARGS
+#define HTTP_ARGS_HASH_SIZE 256
+
+typedef struct httpArg_s {
+	const char* name;
+	const char* value;
+	unsigned short nameLen;
+} httpArg_t;
+
+struct httpArgsIndex_s {
+	httpArg_t args[HTTP_MAX_ARGS];
+	// index + 1 of arg in args, 0 is empty slot
+	byte hash[HTTP_ARGS_HASH_SIZE];
+	int count;
+	bool bOverflow;
+};
+
+static unsigned int http_hashArgName(const char* name, int len) {
+	unsigned int h = 2166136261u;
+	while (len--) {
+		h ^= (byte)*name++;
+		h *= 16777619u;
+	}
+	return h;
+}
+static httpArg_t* http_findArg(httpArgsIndex_t* index, const char* name, int len) {
+	unsigned int slot;
+	httpArg_t* a;
+
+	slot = http_hashArgName(name, len);
+	while (1) {
+		slot &= (HTTP_ARGS_HASH_SIZE - 1);
+		if (index->hash[slot] == 0)
+			return 0;
+		a = &index->args[index->hash[slot] - 1];
+		if (a->nameLen == len && !memcmp(a->name, name, len))
+			return a;
+		slot++;
+	}
+}
+// adds name=value pairs separated by & from s, up to end
+static void http_indexArgs(httpArgsIndex_t* index, const char* s, const char* end) {
+	const char* name;
+	const char* value;
+	unsigned int slot;
+	int len;
+
+	while (s < end && *s) {
+		name = s;
+		value = 0;
+		while (s < end && *s && *s != '&' && *s != ' ') {
+			if (*s == '=' && value == 0)
+				value = s + 1;
+			s++;
+		}
+		len = (value ? value - 1 : s) - name;
+		if (len > 0) {
+			// first one wins, like it did with scanning
+			if (http_findArg(index, name, len) == 0) {
+				if (index->count >= HTTP_MAX_ARGS) {
+					index->bOverflow = true;
+					return;
+				}
+				slot = http_hashArgName(name, len);
+				while (index->hash[slot & (HTTP_ARGS_HASH_SIZE - 1)])
+					slot++;
+				index->args[index->count].name = name;
+				index->args[index->count].value = value ? value : s;
+				index->args[index->count].nameLen = len;
+				index->count++;
+				index->hash[slot & (HTTP_ARGS_HASH_SIZE - 1)] = index->count;
+			}
+		}
+		if (s >= end || *s != '&')
+			break;
+		s++;
+	}
+}
+// builds index of query arguments of request url and, for urlencoded forms, of body
+void HTTP_IndexArgs(http_request_t* request, const char* form, int formLen) {
+	httpArgsIndex_t* index;
+	const char* q;
+
+	HTTP_ClearArgsIndex(request);
+	q = strchr(request->url, '?');
+	if (q == 0 && (form == 0 || formLen <= 0))
+		return;
+	// taken only by requests that have arguments, if there is no memory they are scanned
+	index = (httpArgsIndex_t*)Pool_Malloc(sizeof(httpArgsIndex_t));
+	if (index == 0)
+		return;
+	memset(index, 0, sizeof(httpArgsIndex_t));
+	if (q) {
+		q++;
+		http_indexArgs(index, q, q + strlen(q));
+	}
+	if (form && formLen > 0) {
+		http_indexArgs(index, form, form + formLen);
+	}
+	// too many to index, fall back to scanning
+	if (index->bOverflow) {
+		Pool_Free(index);
+		return;
+	}
+	request->args = index;
+}
+void HTTP_ClearArgsIndex(http_request_t* request) {
+	if (request->args) {
+		Pool_Free(request->args);
+		request->args = 0;
+	}
+}
+int HTTP_GetArgsCount(http_request_t* request) {
+	return request->args ? request->args->count : 0;
+}
+
+// scans url, request arguments should be taken with http_getRequestArg
 int http_getArg(const char* base, const char* name, char* o, int maxSize) {
 	*o = '\0';
 	while (*base != '?') {
@@ -362,6 +534,24 @@ int http_getArg(const char* base, const char* name, char* o, int maxSize) {
 	}
 	return 0;
 }
+int http_getRequestArg(http_request_t* request, const char* name, char* o, int maxSize) {
+	httpArg_t* a;
+
+	if (request->args == 0) {
+		return http_getArg(request->url, name, o, maxSize);
+	}
+	*o = '\0';
+	a = http_findArg(request->args, name, strlen(name));
+	if (a == 0)
+		return 0;
+	return http_copyCarg(a->value, o, maxSize);
+}
+int http_getRequestArgInteger(http_request_t* request, const char* name) {
+	char tmp[16];
+	if (http_getRequestArg(request, name, tmp, sizeof(tmp)) == 0)
+		return 0;
+	return atoi(tmp);
+}
 int http_getArgInteger(const char* base, const char* name) {
 	char tmp[16];
 	if (http_getArg(base, name, tmp, sizeof(tmp)) == 0)
@@ -462,6 +652,91 @@ void setupAllWB2SPinsAsButtons() {
 // add some more output safely, sending if necessary.
 // call with str == NULL to force send. - can be binary.
 // supply length
+#if !PLATFORM_BL602
+#ifdef WINDOWS
+static void (*g_httpSendHook)(const char* data, int len) = 0;
+
+void HTTP_SetSendHook(void (*hook)(const char* data, int len)) {
+	g_httpSendHook = hook;
+}
+#endif
+// sends all of data, send can take less than asked for
+static void http_sendAll(http_request_t* request, const char* data, int len) {
+	int r;
+
+#ifdef WINDOWS
+	if (g_httpSendHook) {
+		g_httpSendHook(data, len);
+		return;
+	}
+#endif
+	// fd 0 is used by selftests, nobody to send to
+	if (request->fd == 0) {
+		return;
+	}
+	while (len > 0) {
+		r = send(request->fd, data, len, 0);
+		if (r <= 0) {
+			return;
+		}
+		data += r;
+		len -= r;
+	}
+}
+// sends window, in chunked mode it is framed in place - size line goes to
+// space reserved at start of window, CRLF after data
+static void http_flushWindow(http_request_t* request) {
+	char sizeLine[HTTP_CHUNK_RESERVE + 1];
+	int dataLen;
+
+	if (request->bChunked) {
+		dataLen = request->replylen - HTTP_CHUNK_RESERVE;
+		if (dataLen > 0) {
+			sprintf(sizeLine, "%04X\r\n", dataLen);
+			memcpy(request->reply, sizeLine, HTTP_CHUNK_RESERVE);
+			request->reply[request->replylen] = '\r';
+			request->reply[request->replylen + 1] = '\n';
+			http_sendAll(request, request->reply, request->replylen + 2);
+		}
+		request->replylen = HTTP_CHUNK_RESERVE;
+		return;
+	}
+	if (request->replylen > 0) {
+		http_sendAll(request, request->reply, request->replylen);
+	}
+	request->reply[0] = 0;
+	request->replylen = 0;
+}
+// room left in window, chunked mode keeps 2 bytes for CRLF
+static int http_windowFree(http_request_t* request) {
+	return request->replymaxlen - request->replylen - (request->bChunked ? 2 : 0);
+}
+// called by http_setup when headers are in window, rest of reply is chunked
+static void http_beginChunked(http_request_t* request) {
+	if (request->fd == 0 || request->bChunkedAllowed == 0 || request->replymaxlen < 64) {
+		return;
+	}
+	http_flushWindow(request);
+	// bigger buffer than size line can tell is used only in part
+	if (request->replymaxlen > HTTP_CHUNK_RESERVE + HTTP_CHUNK_MAX + 2) {
+		request->replymaxlen = HTTP_CHUNK_RESERVE + HTTP_CHUNK_MAX + 2;
+	}
+	request->bChunked = 1;
+	request->replylen = HTTP_CHUNK_RESERVE;
+}
+// sends rest of window and last, empty chunk
+static void http_endChunked(http_request_t* request) {
+	if (request->bChunked == 0) {
+		return;
+	}
+	http_flushWindow(request);
+	http_sendAll(request, "0\r\n\r\n", 5);
+	request->bChunked = 0;
+	request->reply[0] = 0;
+	request->replylen = 0;
+}
+#endif
+
 int postany(http_request_t* request, const char* str, int len) {
 #if PLATFORM_BL602
 	send(request->fd, str, len, 0);
@@ -469,37 +744,34 @@ int postany(http_request_t* request, const char* str, int len) {
 #else
 	int currentlen;
 	int addlen = len;
+	char sizeLine[16];
 
 	if (NULL == str) {
 		// fd will be NULL for unit tests where HTTP packet is faked locally
 		if (request->fd == 0) {
 			return request->replylen;
 		}
-		if (request->replylen > 0) {
-			send(request->fd, request->reply, request->replylen, 0);
-		}
-		request->reply[0] = 0;
-		request->replylen = 0;
+		http_flushWindow(request);
 		return 0;
 	}
 
 	currentlen = request->replylen;
-	if (currentlen + addlen >= request->replymaxlen) {
-		send(request->fd, request->reply, request->replylen, 0);
-		request->reply[0] = 0;
-		request->replylen = 0;
-		currentlen = 0;
-	}
-	while (addlen >= request->replymaxlen) {
-		if (request->replylen > 0) {
-			send(request->fd, request->reply, request->replylen, 0);
-			request->replylen = 0;
+	if (addlen >= http_windowFree(request)) {
+		http_flushWindow(request);
+		currentlen = request->replylen;
+	}
+	// too big for window, sent straight from caller memory
+	if (addlen >= http_windowFree(request)) {
+		if (request->bChunked) {
+			sprintf(sizeLine, "%X\r\n", addlen);
+			http_sendAll(request, sizeLine, strlen(sizeLine));
+			http_sendAll(request, str, addlen);
+			http_sendAll(request, "\r\n", 2);
 		}
-		send(request->fd, str, (request->replymaxlen - 1), 0);
-		addlen -= (request->replymaxlen - 1);
-		str += (request->replymaxlen - 1);
-
-		rtos_delay_milliseconds(1);
+		else {
+			http_sendAll(request, str, addlen);
+		}
+		return currentlen;
 	}
 
 	memcpy(request->reply + request->replylen, str, addlen);
@@ -518,10 +790,28 @@ int poststr(http_request_t* request, const char* str) {
 	return postany(request, str, strlen(str));
 }
 
+// formats straight into send window, result is limited to 255 characters
 int hprintf255(http_request_t* request, const char* fmt, ...) {
 	va_list argList;
-	//BaseType_t taken;
 	char tmp[256];
+	int len;
+
+#if !PLATFORM_BL602
+	if (http_windowFree(request) <= (int)sizeof(tmp) && request->fd != 0) {
+		http_flushWindow(request);
+	}
+	if (http_windowFree(request) > (int)sizeof(tmp)) {
+		va_start(argList, fmt);
+		len = vsnprintf(request->reply + request->replylen, sizeof(tmp), fmt, argList);
+		va_end(argList);
+		if (len < 0)
+			len = 0;
+		if (len > (int)sizeof(tmp) - 1)
+			len = sizeof(tmp) - 1;
+		request->replylen += len;
+		return request->replylen;
+	}
+#endif
 	memset(tmp, 0, sizeof(tmp));
 	va_start(argList, fmt);
 	vsnprintf(tmp, 255, fmt, argList);
@@ -530,7 +820,7 @@ int hprintf255(http_request_t* request, const char* fmt, ...) {
 }
 
 
-int HTTP_ProcessPacket(http_request_t* request) {
+static int HTTP_ProcessPacket_Internal(http_request_t* request) {
 	int i;
 	char* p;
 	char* headers;
@@ -538,6 +828,8 @@ int HTTP_ProcessPacket(http_request_t* request) {
 	//int bChanged = 0;
 	char* urlStr = "";
 	char* recvbuf;
+	bool bForm = false;
+	httpRoute_t* route;
 
 	if (request->received == 0) {
 		ADDLOGF_ERROR("You gave request with NULL input");
@@ -603,6 +895,10 @@ int HTTP_ProcessPacket(http_request_t* request) {
 			return 0;
 		}
 	}
+	// chunked transfer encoding is HTTP/1.1 only
+	if (protocol == 0 || strcmp(protocol, "HTTP/1.1")) {
+		request->bChunkedAllowed = 0;
+	}
 	// i.e. not received
 	request->contentLength = -1;
 	headers = p;
@@ -619,6 +915,12 @@ int HTTP_ProcessPacket(http_request_t* request) {
 					if (!my_strnicmp(headers, "Content-Length:", 15)) {
 						request->contentLength = atoi(headers + 15);
 					}
+					if (!my_strnicmp(headers, "Content-Type:", 13)) {
+						const char* type = headers + 13;
+						while (*type == ' ')
+							type++;
+						bForm = !my_strnicmp(type, "application/x-www-form-urlencoded", 33);
+					}
 
 					*p = 0;
 					p++; // past \r
@@ -647,6 +949,12 @@ int HTTP_ProcessPacket(http_request_t* request) {
 		request->bodystart = p;
 		request->bodylen = request->receivedLen - (p - request->received);
 	}
+	if (bForm) {
+		HTTP_IndexArgs(request, request->bodystart, request->bodylen);
+	}
+	else {
+		HTTP_IndexArgs(request, 0, 0);
+	}
 #if 0
 	postany(request, "test", 4);
 	return 0;
@@ -654,58 +962,39 @@ int HTTP_ProcessPacket(http_request_t* request) {
 	return http_fn_empty_url(request);
 #endif
 
-	// look for a callback with this URL and method, or HTTP_ANY
-	for (i = 0; i < numCallbacks; i++) {
-		char* url = callbacks[i]->url;
-		if (http_startsWith(urlStr, &url[1])) {
-			int method = callbacks[i]->method;
-			if (method == HTTP_ANY || method == request->method) {
-				return callbacks[i]->callback(request);
-			}
-		}
-	}
-	if (http_checkUrlBase(urlStr, "")) return http_fn_empty_url(request);
-
-	if (http_checkUrlBase(urlStr, "testmsg")) return http_fn_testmsg(request);
-	if (http_checkUrlBase(urlStr, "index")) return http_fn_index(request);
+	// look for a route with this URL and method, or HTTP_ANY
+	HTTP_AddBuiltInPages();
+	route = HTTP_FindRoute(request, urlStr);
+	if (route) {
+		uint32_t start;
+		int ret;
 
-	if (http_checkUrlBase(urlStr, "about")) return http_fn_about(request);
-
-	if (http_checkUrlBase(urlStr, "cfg_mqtt")) return http_fn_cfg_mqtt(request);
-	if (http_checkUrlBase(urlStr, "cfg_mqtt_set")) return http_fn_cfg_mqtt_set(request);
-
-	if (http_checkUrlBase(urlStr, "cfg_webapp")) return http_fn_cfg_webapp(request);
-	if (http_checkUrlBase(urlStr, "cfg_webapp_set")) return http_fn_cfg_webapp_set(request);
-
-	if (http_checkUrlBase(urlStr, "cfg_wifi")) return http_fn_cfg_wifi(request);
-	if (http_checkUrlBase(urlStr, "cfg_name")) return http_fn_cfg_name(request);
-	if (http_checkUrlBase(urlStr, "cfg_wifi_set")) return http_fn_cfg_wifi_set(request);
-
-	if (http_checkUrlBase(urlStr, "cfg_loglevel_set")) return http_fn_cfg_loglevel_set(request);
-	if (http_checkUrlBase(urlStr, "cfg_mac")) return http_fn_cfg_mac(request);
-
-	if (http_checkUrlBase(urlStr, "flash_read_tool")) return http_fn_flash_read_tool(request);
-	if (http_checkUrlBase(urlStr, "uart_tool")) return http_fn_uart_tool(request);
-	if (http_checkUrlBase(urlStr, "cmd_tool")) return http_fn_cmd_tool(request);
-	if (http_checkUrlBase(urlStr, "startup_command")) return http_fn_startup_command(request);
-	if (http_checkUrlBase(urlStr, "cfg_generic")) return http_fn_cfg_generic(request);
-	if (http_checkUrlBase(urlStr, "cfg_startup")) return http_fn_cfg_startup(request);
-	if (http_checkUrlBase(urlStr, "cfg_dgr")) return http_fn_cfg_dgr(request);
-
-	if (http_checkUrlBase(urlStr, "cfg_quick")) return http_fn_cfg_quick(request);
-	if (http_checkUrlBase(urlStr, "ha_cfg")) return http_fn_ha_cfg(request);
-	if (http_checkUrlBase(urlStr, "ha_discovery")) return http_fn_ha_discovery(request);
-	if (http_checkUrlBase(urlStr, "cfg")) return http_fn_cfg(request);
-
-	if (http_checkUrlBase(urlStr, "cfg_pins")) return http_fn_cfg_pins(request);
-	if (http_checkUrlBase(urlStr, "cfg_ping")) return http_fn_cfg_ping(request);
-
-	if (http_checkUrlBase(urlStr, "ota")) return http_fn_ota(request);
-	if (http_checkUrlBase(urlStr, "ota_exec")) return http_fn_ota_exec(request);
-	if (http_checkUrlBase(urlStr, "cm")) return http_fn_cm(request);
+		PERF_Register(&route->perf, route->perfName);
+		PERF_BEGIN(start);
+		ret = route->callback(request);
+		PERF_End(&route->perf, start);
+		return ret;
+	}
 
 	return http_fn_other(request);
 }
+int HTTP_ProcessPacket(http_request_t* request) {
+	uint32_t start;
+	int ret;
+
+	PERF_BEGIN(start);
+	request->args = 0;
+	ret = HTTP_ProcessPacket_Internal(request);
+	HTTP_ClearArgsIndex(request);
+#if !PLATFORM_BL602
+	if (request->bChunked) {
+		http_endChunked(request);
+		ret = 0;
+	}
+#endif
+	PERF_END(PERF_HTTP, start);
+	return ret;
+}
 
 /*
 NOTE:
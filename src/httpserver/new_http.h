@@ -28,8 +28,30 @@ extern const char ha_discovery_script[];
 #define HTTP_RESPONSE_NOT_FOUND 404
 #define HTTP_RESPONSE_SERVER_ERROR 500
 
-#define MAX_QUERY 16
 #define MAX_HEADERS 16
+// size of reply buffer given by server, it is sent when full
+#ifndef HTTP_SEND_WINDOW
+#define HTTP_SEND_WINDOW 2048
+#endif
+// chunk size line kept at start of window, "XXXX\r\n"
+#define HTTP_CHUNK_RESERVE 6
+// size line has four hex digits, so chunk can't be bigger
+#if HTTP_SEND_WINDOW > 0xFFFF
+#error HTTP_SEND_WINDOW must fit in chunk size line, 0xFFFF at most
+#endif
+#define HTTP_CHUNK_MAX 0xFFFF
+#define HTTP_MAX_ROUTE_PARAMS 4
+
+// ":name" or "*" segment of route matched by url, value is not terminated
+typedef struct httpRouteParam_s {
+	const char* name;
+	const char* value;
+	int len;
+} httpRouteParam_t;
+
+// arguments of request, see HTTP_IndexArgs
+typedef struct httpArgsIndex_s httpArgsIndex_t;
+
 typedef struct http_request_tag {
 	char* received; // partial or whole received data, up to 1024
 	int receivedLen;
@@ -38,25 +60,36 @@ typedef struct http_request_tag {
 	// filled by HTTP_ProcessPacket
 	int method;
 	char* url;
-	int numqueryitems;
-	char* querynames[MAX_QUERY];
-	char* queryvalues[MAX_QUERY];
 	int numheaders;
 	char* headers[MAX_HEADERS];
 	char* bodystart; /// start start of the body (maybe all of it)
 	int bodylen;
 	int contentLength;
 	int responseCode;
+	// filled by router, see HTTP_GetRouteParam
+	int numRouteParams;
+	httpRouteParam_t routeParams[HTTP_MAX_ROUTE_PARAMS];
+	// filled by HTTP_ProcessPacket, 0 if there are no arguments
+	httpArgsIndex_t* args;
 
 	// used to respond
 	char* reply;
 	int replylen;
 	int replymaxlen;
 	int fd;
+	// set by server, cleared by HTTP_ProcessPacket for HTTP/1.0 clients
+	int bChunkedAllowed;
+	// body after http_setup headers is sent with chunked transfer encoding
+	int bChunked;
 } http_request_t;
 
 
 int HTTP_ProcessPacket(http_request_t* request);
+#ifdef WINDOWS
+// selftests get what would be sent to socket, without one;
+// request needs fd other than 0, it's not used while hook is set
+void HTTP_SetSendHook(void (*hook)(const char* data, int len));
+#endif
 void http_setup(http_request_t* request, const char* type);
 void http_html_start(http_request_t* request, const char* pagename);
 void http_html_end(http_request_t* request);
@@ -68,6 +101,13 @@ void misc_formatUpTimeString(int totalSeconds, char* o);
 // void HTTP_AddHeader(http_request_t *request);
 int http_getArg(const char* base, const char* name, char* o, int maxSize);
 int http_getArgInteger(const char* base, const char* name);
+// argument of request, from index built by HTTP_ProcessPacket,
+// which also has fields of application/x-www-form-urlencoded POST body
+int http_getRequestArg(http_request_t* request, const char* name, char* o, int maxSize);
+int http_getRequestArgInteger(http_request_t* request, const char* name);
+void HTTP_IndexArgs(http_request_t* request, const char* form, int formLen);
+void HTTP_ClearArgsIndex(http_request_t* request);
+int HTTP_GetArgsCount(http_request_t* request);
 
 // poststr with format - for results LESS THAN 128
 int hprintf255(http_request_t* request, const char* fmt, ...);
@@ -82,9 +122,12 @@ typedef enum {
 
 // callback function for http
 typedef int (*http_callback_fn)(http_request_t* request);
-// url MUST start with '/'
-// urls must be unique (i.e. you can't have /about and /aboutme or /about/me)
+// url MUST start with '/', it can have ":name" and "*" segments, see http_router.h
+// url ending with '/' handles all urls below it, "/api/" is the same as "/api/*"
+// registering same url and method again replaces callback
 int HTTP_RegisterCallback(const char* url, int method, http_callback_fn callback);
+// copies value of ":name" (or "*") segment of matched route, returns its length
+int HTTP_GetRouteParam(http_request_t* request, const char* name, char* o, int maxSize);
 
 #endif
 
@@ -38,6 +38,9 @@ extern UINT32 flash_read(char* user_buf, UINT32 count, UINT32 address);
 #include "../new_cfg.h"
 // Commands register, execution API and cmd tokenizer
 #include "../cmnds/cmd_public.h"
+#include "../perf.h"
+#include "../new_ping.h"
+#include "../mem_pool.h"
 
 #ifndef OBK_DISABLE_ALL_DRIVERS
 #include "../driver/drv_local.h"
@@ -85,10 +88,44 @@ static int http_rest_get_flash_vars_test(http_request_t* request);
 static int http_rest_post_cmd(http_request_t* request);
 
 
+#ifdef BK_LITTLEFS
+static int http_rest_get_fsblock(http_request_t* request);
+static int http_rest_post_fsblock(http_request_t* request);
+#endif
+static int http_rest_post_ota(http_request_t* request);
+
+
 void init_rest() {
 	HTTP_RegisterCallback("/api/", HTTP_GET, http_rest_get);
 	HTTP_RegisterCallback("/api/", HTTP_POST, http_rest_post);
 	HTTP_RegisterCallback("/app", HTTP_GET, http_rest_app);
+
+	HTTP_RegisterCallback("/api/channels", HTTP_GET, http_rest_get_channels);
+	HTTP_RegisterCallback("/api/channels", HTTP_POST, http_rest_post_channels);
+	HTTP_RegisterCallback("/api/pins", HTTP_GET, http_rest_get_pins);
+	HTTP_RegisterCallback("/api/pins", HTTP_POST, http_rest_post_pins);
+	HTTP_RegisterCallback("/api/logconfig", HTTP_GET, http_rest_get_logconfig);
+	HTTP_RegisterCallback("/api/logconfig", HTTP_POST, http_rest_post_logconfig);
+	HTTP_RegisterCallback("/api/seriallog", HTTP_GET, http_rest_get_seriallog);
+	HTTP_RegisterCallback("/api/info", HTTP_GET, http_rest_get_info);
+	HTTP_RegisterCallback("/api/flash/*", HTTP_GET, http_rest_get_flash_advanced);
+	HTTP_RegisterCallback("/api/flash/*", HTTP_POST, http_rest_post_flash_advanced);
+	HTTP_RegisterCallback("/api/dumpconfig", HTTP_GET, http_rest_get_dumpconfig);
+	HTTP_RegisterCallback("/api/testconfig", HTTP_GET, http_rest_get_testconfig);
+	HTTP_RegisterCallback("/api/testflashvars", HTTP_GET, http_rest_get_flash_vars_test);
+	HTTP_RegisterCallback("/api/perf", HTTP_GET, PERF_WriteJSON);
+	HTTP_RegisterCallback("/api/heap", HTTP_GET, Pool_WriteJSON);
+	HTTP_RegisterCallback("/api/ping", HTTP_GET, Ping_WriteJSON);
+	HTTP_RegisterCallback("/api/reboot", HTTP_POST, http_rest_post_reboot);
+	HTTP_RegisterCallback("/api/ota", HTTP_POST, http_rest_post_ota);
+	HTTP_RegisterCallback("/api/cmnd", HTTP_POST, http_rest_post_cmd);
+#ifdef BK_LITTLEFS
+	HTTP_RegisterCallback("/api/fsblock", HTTP_GET, http_rest_get_fsblock);
+	HTTP_RegisterCallback("/api/fsblock", HTTP_POST, http_rest_post_fsblock);
+	HTTP_RegisterCallback("/api/lfs/*", HTTP_GET, http_rest_get_lfs_file);
+	HTTP_RegisterCallback("/api/lfs/*", HTTP_POST, http_rest_post_lfs_file);
+	HTTP_RegisterCallback("/api/del/*", HTTP_GET, http_rest_get_lfs_delete);
+#endif
 }
 
 /* Extracts string token value into outBuffer (128 char). Returns true if the operation was successful. */
@@ -110,73 +147,69 @@ bool tryGetTokenString(const char* json, jsmntok_t* tok, char* outBuffer) {
 	return true;
 }
 
-static int http_rest_get(http_request_t* request) {
-	ADDLOG_DEBUG(LOG_FEATURE_API, "GET of %s", request->url);
+#ifdef BK_LITTLEFS
+static int http_rest_get_fsblock(http_request_t* request) {
+	uint32_t newsize = CFG_GetLFS_Size();
+	uint32_t newstart = (LFS_BLOCKS_END - newsize);
 
-	if (!strcmp(request->url, "api/channels")) {
-		return http_rest_get_channels(request);
-	}
+	newsize = (newsize / LFS_BLOCK_SIZE) * LFS_BLOCK_SIZE;
 
-	if (!strcmp(request->url, "api/pins")) {
-		return http_rest_get_pins(request);
+	// double check again that we're within bounds - don't want
+	// boot overwrite or anything nasty....
+	if (newstart < LFS_BLOCKS_START_MIN) {
+		return http_rest_error(request, -20, "LFS Size mismatch");
 	}
-	if (!strcmp(request->url, "api/logconfig")) {
-		return http_rest_get_logconfig(request);
-	}
-
-	if (!strncmp(request->url, "api/seriallog", 13)) {
-		return http_rest_get_seriallog(request);
+	if ((newstart + newsize > LFS_BLOCKS_END) ||
+		(newstart + newsize < LFS_BLOCKS_START_MIN)) {
+		return http_rest_error(request, -20, "LFS Size mismatch");
 	}
 
-#ifdef BK_LITTLEFS
-	if (!strcmp(request->url, "api/fsblock")) {
-		uint32_t newsize = CFG_GetLFS_Size();
-		uint32_t newstart = (LFS_BLOCKS_END - newsize);
-
-		newsize = (newsize / LFS_BLOCK_SIZE) * LFS_BLOCK_SIZE;
-
-		// double check again that we're within bounds - don't want
-		// boot overwrite or anything nasty....
-		if (newstart < LFS_BLOCKS_START_MIN) {
-			return http_rest_error(request, -20, "LFS Size mismatch");
-		}
-		if ((newstart + newsize > LFS_BLOCKS_END) ||
-			(newstart + newsize < LFS_BLOCKS_START_MIN)) {
-			return http_rest_error(request, -20, "LFS Size mismatch");
-		}
-
-		return http_rest_get_flash(request, newstart, newsize);
+	return http_rest_get_flash(request, newstart, newsize);
+}
+static int http_rest_post_fsblock(http_request_t* request) {
+	if (lfs_present()) {
+		release_lfs();
 	}
-#endif
+	uint32_t newsize = CFG_GetLFS_Size();
+	uint32_t newstart = (LFS_BLOCKS_END - newsize);
 
-#ifdef BK_LITTLEFS
-	if (!strncmp(request->url, "api/lfs/", 8)) {
-		return http_rest_get_lfs_file(request);
-	}
-	if (!strncmp(request->url, "api/del/", 8)) {
-		return http_rest_get_lfs_delete(request);
-	}
-#endif
+	newsize = (newsize / LFS_BLOCK_SIZE) * LFS_BLOCK_SIZE;
 
-	if (!strcmp(request->url, "api/info")) {
-		return http_rest_get_info(request);
+	// double check again that we're within bounds - don't want
+	// boot overwrite or anything nasty....
+	if (newstart < LFS_BLOCKS_START_MIN) {
+		return http_rest_error(request, -20, "LFS Size mismatch");
 	}
-
-	if (!strncmp(request->url, "api/flash/", 10)) {
-		return http_rest_get_flash_advanced(request);
+	if ((newstart + newsize > LFS_BLOCKS_END) ||
+		(newstart + newsize < LFS_BLOCKS_START_MIN)) {
+		return http_rest_error(request, -20, "LFS Size mismatch");
 	}
 
-	if (!strcmp(request->url, "api/dumpconfig")) {
-		return http_rest_get_dumpconfig(request);
-	}
+	// we are writing the lfs block
+	int res = http_rest_post_flash(request, newstart, LFS_BLOCKS_END);
+	// initialise the filesystem, it should be there now.
+	// don't create if it does not mount
+	init_lfs(0);
+	return res;
+}
+#endif
 
-	if (!strcmp(request->url, "api/testconfig")) {
-		return http_rest_get_testconfig(request);
-	}
+static int http_rest_post_ota(http_request_t* request) {
+#if PLATFORM_BK7231T
+	return http_rest_post_flash(request, START_ADR_OF_BK_PARTITION_OTA, LFS_BLOCKS_END);
+#elif PLATFORM_BK7231N
+	return http_rest_post_flash(request, START_ADR_OF_BK_PARTITION_OTA, LFS_BLOCKS_END);
+#elif PLATFORM_W600
+	return http_rest_post_flash(request, -1, -1);
+#else
+	// TODO
+	return http_rest_post(request);
+#endif
+}
 
-	if (!strncmp(request->url, "api/testflashvars", 17)) {
-		return http_rest_get_flash_vars_test(request);
-	}
+// fallback for /api/ urls that have no route
+static int http_rest_get(http_request_t* request) {
+	ADDLOG_DEBUG(LOG_FEATURE_API, "GET of %s", request->url);
 
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "GET REST API");
@@ -191,72 +224,6 @@ static int http_rest_post(http_request_t* request) {
 	char tmp[20];
 	ADDLOG_DEBUG(LOG_FEATURE_API, "POST to %s", request->url);
 
-	if (!strcmp(request->url, "api/channels")) {
-		return http_rest_post_channels(request);
-	}
-
-	if (!strcmp(request->url, "api/pins")) {
-		return http_rest_post_pins(request);
-	}
-	if (!strcmp(request->url, "api/logconfig")) {
-		return http_rest_post_logconfig(request);
-	}
-
-	if (!strcmp(request->url, "api/reboot")) {
-		return http_rest_post_reboot(request);
-	}
-	if (!strcmp(request->url, "api/ota")) {
-#if PLATFORM_BK7231T
-		return http_rest_post_flash(request, START_ADR_OF_BK_PARTITION_OTA, LFS_BLOCKS_END);
-#elif PLATFORM_BK7231N
-		return http_rest_post_flash(request, START_ADR_OF_BK_PARTITION_OTA, LFS_BLOCKS_END);
-#elif PLATFORM_W600
-		return http_rest_post_flash(request, -1, -1);
-#else
-		// TODO
-#endif
-	}
-	if (!strncmp(request->url, "api/flash/", 10)) {
-		return http_rest_post_flash_advanced(request);
-	}
-
-	if (!strcmp(request->url, "api/cmnd")) {
-		return http_rest_post_cmd(request);
-	}
-
-
-#ifdef BK_LITTLEFS
-	if (!strcmp(request->url, "api/fsblock")) {
-		if (lfs_present()) {
-			release_lfs();
-		}
-		uint32_t newsize = CFG_GetLFS_Size();
-		uint32_t newstart = (LFS_BLOCKS_END - newsize);
-
-		newsize = (newsize / LFS_BLOCK_SIZE) * LFS_BLOCK_SIZE;
-
-		// double check again that we're within bounds - don't want
-		// boot overwrite or anything nasty....
-		if (newstart < LFS_BLOCKS_START_MIN) {
-			return http_rest_error(request, -20, "LFS Size mismatch");
-		}
-		if ((newstart + newsize > LFS_BLOCKS_END) ||
-			(newstart + newsize < LFS_BLOCKS_START_MIN)) {
-			return http_rest_error(request, -20, "LFS Size mismatch");
-		}
-
-		// we are writing the lfs block
-		int res = http_rest_post_flash(request, newstart, LFS_BLOCKS_END);
-		// initialise the filesystem, it should be there now.
-		// don't create if it does not mount
-		init_lfs(0);
-		return res;
-	}
-	if (!strncmp(request->url, "api/lfs/", 8)) {
-		return http_rest_post_lfs_file(request);
-	}
-#endif
-
 	http_setup(request, httpMimeTypeHTML);
 	http_html_start(request, "POST REST API");
 	poststr(request, "POST to ");
@@ -683,10 +650,10 @@ static int http_rest_post_logconfig(http_request_t* request) {
 
 	//https://github.com/zserge/jsmn/blob/master/example/simple.c
 	//jsmn_parser p;
-	jsmn_parser* p = os_malloc(sizeof(jsmn_parser));
+	jsmn_parser* p = Pool_Malloc(sizeof(jsmn_parser));
 	//jsmntok_t t[128]; /* We expect no more than 128 tokens */
 #define TOKEN_COUNT 128
-	jsmntok_t* t = os_malloc(sizeof(jsmntok_t) * TOKEN_COUNT);
+	jsmntok_t* t = Pool_Malloc(sizeof(jsmntok_t) * TOKEN_COUNT);
 	char* json_str = request->bodystart;
 	int json_len = strlen(json_str);
 
@@ -699,8 +666,8 @@ static int http_rest_post_logconfig(http_request_t* request) {
 	if (r < 0) {
 		ADDLOG_ERROR(LOG_FEATURE_API, "Failed to parse JSON: %d", r);
 		poststr(request, NULL);
-		os_free(p);
-		os_free(t);
+		Pool_Free(p);
+		Pool_Free(t);
 		return 0;
 	}
 
@@ -708,8 +675,8 @@ static int http_rest_post_logconfig(http_request_t* request) {
 	if (r < 1 || t[0].type != JSMN_OBJECT) {
 		ADDLOG_ERROR(LOG_FEATURE_API, "Object expected", r);
 		poststr(request, NULL);
-		os_free(p);
-		os_free(t);
+		Pool_Free(p);
+		Pool_Free(t);
 		return 0;
 	}
 
@@ -743,8 +710,8 @@ static int http_rest_post_logconfig(http_request_t* request) {
 	}
 
 	poststr(request, NULL);
-	os_free(p);
-	os_free(t);
+	Pool_Free(p);
+	Pool_Free(t);
 	return 0;
 }
 
@@ -784,10 +751,10 @@ static int http_rest_post_pins(http_request_t* request) {
 
 	//https://github.com/zserge/jsmn/blob/master/example/simple.c
 	//jsmn_parser p;
-	jsmn_parser* p = os_malloc(sizeof(jsmn_parser));
+	jsmn_parser* p = Pool_Malloc(sizeof(jsmn_parser));
 	//jsmntok_t t[128]; /* We expect no more than 128 tokens */
 #define TOKEN_COUNT 128
-	jsmntok_t* t = os_malloc(sizeof(jsmntok_t) * TOKEN_COUNT);
+	jsmntok_t* t = Pool_Malloc(sizeof(jsmntok_t) * TOKEN_COUNT);
 	char* json_str = request->bodystart;
 	int json_len = strlen(json_str);
 
@@ -799,8 +766,8 @@ static int http_rest_post_pins(http_request_t* request) {
 	if (r < 0) {
 		ADDLOG_ERROR(LOG_FEATURE_API, "Failed to parse JSON: %d", r);
 		sprintf(tmp, "Failed to parse JSON: %d\n", r);
-		os_free(p);
-		os_free(t);
+		Pool_Free(p);
+		Pool_Free(t);
 		return http_rest_error(request, 400, tmp);
 	}
 
@@ -808,8 +775,8 @@ static int http_rest_post_pins(http_request_t* request) {
 	if (r < 1 || t[0].type != JSMN_OBJECT) {
 		ADDLOG_ERROR(LOG_FEATURE_API, "Object expected", r);
 		sprintf(tmp, "Object expected\n");
-		os_free(p);
-		os_free(t);
+		Pool_Free(p);
+		Pool_Free(t);
 		return http_rest_error(request, 400, tmp);
 	}
 
@@ -891,8 +858,8 @@ static int http_rest_post_pins(http_request_t* request) {
 		ADDLOG_DEBUG(LOG_FEATURE_API, "Changed %d - saved to flash", iChanged);
 	}
 
-	os_free(p);
-	os_free(t);
+	Pool_Free(p);
+	Pool_Free(t);
 	return http_rest_error(request, 200, "OK");
 	return 0;
 }
@@ -1249,10 +1216,10 @@ static int http_rest_post_channels(http_request_t* request) {
 
 	//https://github.com/zserge/jsmn/blob/master/example/simple.c
 	//jsmn_parser p;
-	jsmn_parser* p = os_malloc(sizeof(jsmn_parser));
+	jsmn_parser* p = Pool_Malloc(sizeof(jsmn_parser));
 	//jsmntok_t t[128]; /* We expect no more than 128 tokens */
 #define TOKEN_COUNT 128
-	jsmntok_t* t = os_malloc(sizeof(jsmntok_t) * TOKEN_COUNT);
+	jsmntok_t* t = Pool_Malloc(sizeof(jsmntok_t) * TOKEN_COUNT);
 	char* json_str = request->bodystart;
 	int json_len = strlen(json_str);
 
@@ -1264,8 +1231,8 @@ static int http_rest_post_channels(http_request_t* request) {
 	if (r < 0) {
 		ADDLOG_ERROR(LOG_FEATURE_API, "Failed to parse JSON: %d", r);
 		sprintf(tmp, "Failed to parse JSON: %d\n", r);
-		os_free(p);
-		os_free(t);
+		Pool_Free(p);
+		Pool_Free(t);
 		return http_rest_error(request, 400, tmp);
 	}
 
@@ -1273,8 +1240,8 @@ static int http_rest_post_channels(http_request_t* request) {
 	if (r < 1 || t[0].type != JSMN_ARRAY) {
 		ADDLOG_ERROR(LOG_FEATURE_API, "Array expected", r);
 		sprintf(tmp, "Object expected\n");
-		os_free(p);
-		os_free(t);
+		Pool_Free(p);
+		Pool_Free(t);
 		return http_rest_error(request, 400, tmp);
 	}
 
@@ -1288,8 +1255,8 @@ static int http_rest_post_channels(http_request_t* request) {
 			chanval);
 	}
 
-	os_free(p);
-	os_free(t);
+	Pool_Free(p);
+	Pool_Free(t);
 	return http_rest_error(request, 200, "OK");
 	return 0;
 }
@@ -165,35 +165,20 @@ static void PCF8574_LCD_BL(i2cDevice_PCF8574_t *lcd, byte status)
     PCF8574_LCD_Write_Byte(lcd,0x00, 0x00);
 }
 
-static int PCF8574_LCD_Init(i2cDevice_PCF8574_t *lcd)
-{
-    int s = PCF8574_LCD_Open(lcd);
-     if(s == 0)
-     return 0;
-    // return 1;
-    // Following bytes are all Command bytes, i.e. address = 0x00
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x03);   // Write Nibble 0x03 three times (per HD44780U initialization spec)
-    delay_ms(5);                // (per HD44780U initialization spec)
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x03);   //
-    delay_ms(5);                // (per HD44780U initialization spec)
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x03);   //
-    delay_ms(5);                // (per HD44780U initialization spec)
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x02);   // Write Nibble 0x02 once (per HD44780U initialization spec)
-    delay_ms(5);
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x02);   // Write Nibble 0x02 once (per HD44780U initialization spec)
-    delay_ms(5);                // (per HD44780U initialization spec)
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x01);   // Set mode: 4-bit, 2+lines, 5x8 dots
-    delay_ms(5);                // (per HD44780U initialization spec)
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x0C);   // Display ON 0x0C
-    delay_ms(5);                // (per HD44780U initialization spec)
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x01);   // Clear display
-    delay_ms(5);                // (per HD44780U initialization spec)
-    PCF8574_LCD_Write_Byte(lcd,0x00, 0x06);   // Set cursor to increment
-    delay_ms(5);                // (per HD44780U initialization spec)
-
-  //  PCF8574_LCD_Close();
-     return 1;
-}
+// HD44780U initialization, command bytes with delay after each (ms),
+// done one by one by I2C scheduler so the quick tick is never stalled
+static const byte g_lcdInitCommands[] = {
+	0x03, 0x03, 0x03,	// Write Nibble 0x03 three times (per HD44780U initialization spec)
+	0x02, 0x02,			// Write Nibble 0x02 (per HD44780U initialization spec)
+	0x01,				// Set mode: 4-bit, 2+lines, 5x8 dots
+	0x0C,				// Display ON 0x0C
+	0x01,				// Clear display
+	0x06,				// Set cursor to increment
+};
+#define LCD_INIT_COMMANDS	(sizeof(g_lcdInitCommands)/sizeof(g_lcdInitCommands[0]))
+#define LCD_INIT_DELAY		5
+#define LCD_WELCOME_DELAY	115
+
 static void PCF8574_LCD_Clear(i2cDevice_PCF8574_t *lcd)
 {
     PCF8574_LCD_Write_Byte(lcd,0x00,0x01);
@@ -351,10 +336,12 @@ void DRV_I2C_Commands_Init() {
 // lcd_print I2C1 0x23 Hello123
 // backlog lcd_goto I2C1 0x23 2 2; lcd_print I2C1 0x23 Teste123
 // lcd_clear I2C1 0x23
-int c = 0;
+// I2C scheduler job, bus is open and device selected.
+// Every run does one step and queues itself again with the delay that step needs.
 void DRV_I2C_LCD_PCF8574_RunDevice(i2cDevice_t *dev)
 {
 	i2cDevice_PCF8574_t *lcd;
+	int delay;
 
 	if(g_i2c_cmds_lcd_init==0) {
 		DRV_I2C_Commands_Init();
@@ -362,21 +349,27 @@ void DRV_I2C_LCD_PCF8574_RunDevice(i2cDevice_t *dev)
 	}
 	lcd = (i2cDevice_PCF8574_t*)dev;
 
-	if(c == 0){
-		PCF8574_LCD_Init(lcd);
-		 delay_ms(115);
-		PCF8574_LCD_Clear(lcd);
-		delay_ms(115);
+	if(lcd->initStep < LCD_INIT_COMMANDS) {
+		PCF8574_LCD_Write_Byte(lcd,0x00, g_lcdInitCommands[lcd->initStep]);
+		delay = LCD_INIT_DELAY;
+		if(lcd->initStep == LCD_INIT_COMMANDS - 1)
+			delay += LCD_WELCOME_DELAY;
+	} else if(lcd->initStep == LCD_INIT_COMMANDS) {
+		PCF8574_LCD_Write_Byte(lcd,0x00,0x01);
+		delay = LCD_INIT_DELAY + LCD_WELCOME_DELAY;
+	} else if(lcd->initStep == LCD_INIT_COMMANDS + 1) {
 		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"Testing lcd\n" );
-
 		PCF8574_LCD_Write_String(lcd,"OpenBeken BK7231T LCD");
-		delay_ms(115);
+		delay = LCD_WELCOME_DELAY;
+	} else if(lcd->initStep == LCD_INIT_COMMANDS + 2) {
 		PCF8574_LCD_Goto(lcd,2,2);
 		PCF8574_LCD_Write_String(lcd,"Elektroda.com");
-		delay_ms(115);
-		PCF8574_LCD_Close(lcd);
+		delay = 0;
+	} else {
+		return;
+	}
+	lcd->initStep++;
+	if(delay > 0) {
+		DRV_I2C_AddJobDelayed(dev, DRV_I2C_LCD_PCF8574_RunDevice, delay, I2C_PRIORITY_NORMAL);
 	}
-	c++;
-
 }
-
@@ -44,15 +44,24 @@ typedef struct i2cDevice_TC74_s {
 //	int sourceChannel_W;
 //} i2cDevice_SM2135_t;
 
-// Right now, MCP23017 port expander supports only output mode
-// (map channel to MCP23017 output)
+// MCP23017 port expander, pins are mapped to channels either as outputs
+// (channel drives pin) or as inputs (pin polled and written to channel)
 typedef struct i2cDevice_MCP23017_s {
 	i2cDevice_t base;
 	// private MCP23017 variables
 	// Channel indices (0xff = none)
 	byte pinMapping[16];
-	// is pin an output or input?
-	//int pinDirections;
+	// bit set means pin is an input
+	unsigned short inputMask;
+	// shadow of output latches, so we don't have to read them back
+	unsigned short outputs;
+	// last polled input levels
+	unsigned short inputs;
+	// inputs that must be reported to channels on next poll, even if not changed
+	unsigned short inputsStale;
+	// direction and outputs are waiting for flush job
+	byte bDirty;
+	byte bPolling;
 } i2cDevice_MCP23017_t;
 
 typedef struct i2cDevice_PCF8574_s {
@@ -68,13 +77,55 @@ typedef struct i2cDevice_PCF8574_s {
 	byte  pin_D6;//  =    I2C_BYTE.6
 	byte  pin_D7;//  =    I2C_BYTE.7
 	byte  pin_BL;//  =    I2C_BYTE.3
+	// next step of init and welcome text, see DRV_I2C_LCD_PCF8574_RunDevice
+	byte  initStep;
 } i2cDevice_PCF8574_t;
 
 void DRV_I2C_Write(byte addr, byte data);
 void DRV_I2C_WriteBytes(byte addr, byte *data, int len);
 void DRV_I2C_Read(byte addr, byte *data);
+void DRV_I2C_ReadBytes(byte addr, byte *data, int len);
 int DRV_I2C_Begin(int dev_adr, int busID);
 void DRV_I2C_Close();
+// Begin is OpenBus + SelectDevice, scheduler opens bus once for many devices
+int DRV_I2C_OpenBus(int busID);
+void DRV_I2C_SelectDevice(int dev_adr);
+
+// Transaction scheduler.
+// Devices submit jobs, job is called with bus already open and device selected.
+// Due jobs are run in priority order, grouped per bus, so bus is opened only once per tick.
+typedef void (*i2cJobFunc_t)(i2cDevice_t *dev);
+
+#define I2C_PRIORITY_HIGH		0
+#define I2C_PRIORITY_NORMAL		1
+#define I2C_PRIORITY_LOW		2
+
+#define I2C_MAX_JOBS			32
+
+typedef struct i2cJob_s {
+	i2cDevice_t *dev;
+	i2cJobFunc_t func;
+	// 0 means job is run only once
+	int period;
+	int priority;
+	int timeLeft;
+} i2cJob_t;
+
+typedef struct i2cStats_s {
+	int busOpens;
+	int busErrors;
+	int jobsRun;
+	int jobsDropped;
+} i2cStats_t;
+
+extern i2cStats_t g_i2c_stats;
+
+// returns 0 if queue is full
+int DRV_I2C_AddJob(i2cDevice_t *dev, i2cJobFunc_t func, int periodMS, int priority);
+// one-shot job, first due after delayMS; job may queue itself again, so it can wait without blocking the bus
+int DRV_I2C_AddJobDelayed(i2cDevice_t *dev, i2cJobFunc_t func, int delayMS, int priority);
+void DRV_I2C_RemoveJobs(i2cDevice_t *dev);
+int DRV_I2C_GetJobsCount();
 
 i2cBusType_t DRV_I2C_ParseBusType(const char *s);
 i2cDevice_t *DRV_I2C_FindDevice(int busType,int address);
@@ -82,8 +133,8 @@ i2cDevice_t *DRV_I2C_FindDeviceExt(int busType,int address, int devType);
 
 
 // drv_i2c_mcp23017.c
-void DRV_I2C_MCP23017_RunDevice(i2cDevice_t *dev);
 commandResult_t DRV_I2C_MCP23017_MapPinToChannel(const void *context, const char *cmd, const char *args, int cmdFlags);
+commandResult_t DRV_I2C_MCP23017_MapInputToChannel(const void *context, const char *cmd, const char *args, int cmdFlags);
 void DRV_I2C_MCP23017_OnChannelChanged(i2cDevice_t *dev, int channel, int iVal);
 
 // drv_i2c_tc74.c
@@ -42,7 +42,12 @@ void DRV_I2C_Read(byte addr, byte *data)
     i2c_operater.op_addr = addr;
     ddev_read(i2c_hdl, (char*)data, 1, (UINT32)&i2c_operater);
 }
-int DRV_I2C_Begin(int dev_adr, int busID) {
+void DRV_I2C_ReadBytes(byte addr, byte *data, int len)
+{
+    i2c_operater.op_addr = addr;
+    ddev_read(i2c_hdl, (char*)data, len, (UINT32)&i2c_operater);
+}
+int DRV_I2C_OpenBus(int busID) {
 
     UINT32 status;
 	UINT32 oflag;
@@ -53,23 +58,129 @@ int DRV_I2C_Begin(int dev_adr, int busID) {
 	} else if(busID == I2C_BUS_I2C2) {
 		i2c_hdl = ddev_open("i2c2", &status, oflag);
 	} else {
-		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_Begin bus type %i not supported!\n",busID);
+		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_OpenBus bus type %i not supported!\n",busID);
 		return 1;
 	}
     if(DD_HANDLE_UNVALID == i2c_hdl){
-		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_Begin ddev_open failed, status %i!\n",status);
+		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_OpenBus ddev_open failed, status %i!\n",status);
 		return 1;
 	}
-	addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_Begin ddev_open OK, adr %i!\n",dev_adr);
-
-    i2c_operater.salve_id = dev_adr;
-
 	return 0;
 }
+void DRV_I2C_SelectDevice(int dev_adr) {
+    i2c_operater.salve_id = dev_adr;
+}
 void DRV_I2C_Close() {
 
 	ddev_close(i2c_hdl);
 }
+#elif WINDOWS
+
+// Simulated bus for selftests, every device is just a 256 byte register file.
+// Register pointer auto-increments on multi byte transfers, like on most chips.
+#define SIM_I2C_MAX_DEVICES		8
+
+typedef struct simI2CDevice_s {
+	int busID;
+	int addr;
+	byte regs[256];
+} simI2CDevice_t;
+
+static simI2CDevice_t g_simI2C_devices[SIM_I2C_MAX_DEVICES];
+static int g_simI2C_numDevices = 0;
+static simI2CDevice_t *g_simI2C_selected = 0;
+static int g_simI2C_openBus = -1;
+static int g_simI2C_busOpens = 0;
+
+static simI2CDevice_t *SIM_I2C_Find(int busID, int addr) {
+	int i;
+
+	for(i = 0; i < g_simI2C_numDevices; i++) {
+		if(g_simI2C_devices[i].busID == busID && g_simI2C_devices[i].addr == addr)
+			return &g_simI2C_devices[i];
+	}
+	return 0;
+}
+void SIM_I2C_Reset() {
+	g_simI2C_numDevices = 0;
+	g_simI2C_selected = 0;
+	g_simI2C_openBus = -1;
+	g_simI2C_busOpens = 0;
+}
+void SIM_I2C_AddDevice(int busID, int addr) {
+	simI2CDevice_t *d;
+
+	if(SIM_I2C_Find(busID, addr) || g_simI2C_numDevices >= SIM_I2C_MAX_DEVICES)
+		return;
+	d = &g_simI2C_devices[g_simI2C_numDevices++];
+	memset(d, 0, sizeof(*d));
+	d->busID = busID;
+	d->addr = addr;
+}
+void SIM_I2C_SetRegister(int busID, int addr, int reg, int value) {
+	simI2CDevice_t *d;
+
+	d = SIM_I2C_Find(busID, addr);
+	if(d)
+		d->regs[reg & 0xFF] = value;
+}
+int SIM_I2C_GetRegister(int busID, int addr, int reg) {
+	simI2CDevice_t *d;
+
+	d = SIM_I2C_Find(busID, addr);
+	if(d == 0)
+		return -1;
+	return d->regs[reg & 0xFF];
+}
+int SIM_I2C_GetBusOpensCount() {
+	return g_simI2C_busOpens;
+}
+void DRV_I2C_Write(byte addr, byte data)
+{
+	DRV_I2C_WriteBytes(addr, &data, 1);
+}
+void DRV_I2C_WriteBytes(byte addr, byte *data, int len) {
+	int i;
+
+	if(g_simI2C_selected == 0)
+		return;
+	for(i = 0; i < len; i++) {
+		g_simI2C_selected->regs[(addr + i) & 0xFF] = data[i];
+	}
+}
+void DRV_I2C_Read(byte addr, byte *data)
+{
+	DRV_I2C_ReadBytes(addr, data, 1);
+}
+void DRV_I2C_ReadBytes(byte addr, byte *data, int len)
+{
+	int i;
+
+	for(i = 0; i < len; i++) {
+		// missing device - no ACK, lines stay pulled up
+		if(g_simI2C_selected == 0)
+			data[i] = 0xFF;
+		else
+			data[i] = g_simI2C_selected->regs[(addr + i) & 0xFF];
+	}
+}
+int DRV_I2C_OpenBus(int busID) {
+	if(busID != I2C_BUS_I2C1 && busID != I2C_BUS_I2C2) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_OpenBus bus type %i not supported!\n",busID);
+		return 1;
+	}
+	g_simI2C_openBus = busID;
+	g_simI2C_selected = 0;
+	g_simI2C_busOpens++;
+	return 0;
+}
+void DRV_I2C_SelectDevice(int dev_adr) {
+	g_simI2C_selected = SIM_I2C_Find(g_simI2C_openBus, dev_adr);
+}
+void DRV_I2C_Close() {
+	g_simI2C_openBus = -1;
+	g_simI2C_selected = 0;
+}
 #else
 
 void DRV_I2C_Write(byte addr, byte data)
@@ -82,15 +193,27 @@ void DRV_I2C_WriteBytes(byte addr, byte *data, int len) {
 void DRV_I2C_Read(byte addr, byte *data)
 {
 }
-int DRV_I2C_Begin(int dev_adr, int busID) {
+void DRV_I2C_ReadBytes(byte addr, byte *data, int len)
+{
+}
+int DRV_I2C_OpenBus(int busID) {
 
 	return 1; // error
+}
+void DRV_I2C_SelectDevice(int dev_adr) {
+
 }
 void DRV_I2C_Close() {
 
 }
 #endif
 
+int DRV_I2C_Begin(int dev_adr, int busID) {
+	if(DRV_I2C_OpenBus(busID))
+		return 1;
+	DRV_I2C_SelectDevice(dev_adr);
+	return 0;
+}
 
 i2cDevice_t *g_i2c_devices = 0;
 
@@ -118,8 +241,11 @@ void DRV_I2C_AddDevice_PCF8574_Internal(int busType,int address, byte lcd_cols,
 	dev->lcd_rows = lcd_rows;
 	dev->charsize = charsize;
 	dev->LCD_BL_Status = 1;
+	dev->initStep = 0;
 
 	DRV_I2C_AddNextDevice((i2cDevice_t*)dev);
+	// LCD init and welcome text
+	DRV_I2C_AddJob((i2cDevice_t*)dev, DRV_I2C_LCD_PCF8574_RunDevice, 0, I2C_PRIORITY_NORMAL);
 }
 void DRV_I2C_AddDevice_MCP23017_Internal(int busType,int address) {
 	i2cDevice_MCP23017_t *dev;
@@ -131,7 +257,14 @@ void DRV_I2C_AddDevice_MCP23017_Internal(int busType,int address) {
 	dev->base.type = I2CDEV_MCP23017;
 	dev->base.next = 0;
 	memset(dev->pinMapping,0xff,sizeof(dev->pinMapping));
-
+	dev->inputMask = 0;
+	dev->outputs = 0;
+	dev->inputs = 0;
+	dev->inputsStale = 0;
+	dev->bDirty = 0;
+	dev->bPolling = 0;
+
+	// MCP23017 jobs are added once pins are mapped
 	DRV_I2C_AddNextDevice((i2cDevice_t*)dev);
 }
 i2cDevice_t *DRV_I2C_FindDevice(int busType,int address) {
@@ -168,6 +301,8 @@ void DRV_I2C_AddDevice_TC74_Internal(int busType,int address, int targetChannel)
 	dev->targetChannel = targetChannel;
 
 	DRV_I2C_AddNextDevice((i2cDevice_t*)dev);
+	// temperature changes slowly, don't let it delay outputs
+	DRV_I2C_AddJob((i2cDevice_t*)dev, DRV_I2C_TC74_RunDevice, 1000, I2C_PRIORITY_LOW);
 }
 commandResult_t DRV_I2C_AddDevice_TC74(const void *context, const char *cmd, const char *args, int cmdFlags) {
 	const char *i2cModuleStr;
@@ -277,7 +412,7 @@ commandResult_t DRV_I2C_AddDevice_LCM1602(const void *context, const char *cmd,
 // addI2CDevice_TC74 I2C1 0x4A 6
 
 //
-//	MCP23017 - I2C 16 bit port expander - both inputs and outputs, right now we use it only as outputs
+//	MCP23017 - I2C 16 bit port expander - both inputs and outputs
 //
 // MCP23017 with A0=1, A1=1, A2=1
 // addI2CDevice_MCP23017 I2C1 0x27
@@ -285,6 +420,9 @@ commandResult_t DRV_I2C_AddDevice_LCM1602(const void *context, const char *cmd,
 // maps channels 5 and 6 to GPIO A7 and A6 of MCP23017
 // backlog setChannelType 5 toggle; setChannelType 6 toggle; addI2CDevice_MCP23017 I2C1 0x27; MCP23017_MapPinToChannel I2C1 0x27 7 5; MCP23017_MapPinToChannel I2C1 0x27 6 6
 
+// reads GPIO B0 of MCP23017 into channel 12
+// backlog setChannelType 12 toggle; addI2CDevice_MCP23017 I2C1 0x27; MCP23017_MapInputToChannel I2C1 0x27 8 12
+
 // maps channels 5 6 7 8 etc
 // backlog setChannelType 5 toggle; setChannelType 6 toggle; setChannelType 7 toggle; setChannelType 8 toggle; setChannelType 9 toggle; setChannelType 10 toggle; setChannelType 11 toggle; addI2CDevice_MCP23017 I2C1 0x27; MCP23017_MapPinToChannel I2C1 0x27 7 5; MCP23017_MapPinToChannel I2C1 0x27 6 6; MCP23017_MapPinToChannel I2C1 0x27 5 7; MCP23017_MapPinToChannel I2C1 0x27 4 8; MCP23017_MapPinToChannel I2C1 0x27 3 9; MCP23017_MapPinToChannel I2C1 0x27 2 10; MCP23017_MapPinToChannel I2C1 0x27 1 11
 
@@ -315,38 +453,176 @@ void DRV_I2C_Init()
 	//cmddetail:"fn":"DRV_I2C_MCP23017_MapPinToChannel","file":"i2c/drv_i2c_main.c","requires":"",
 	//cmddetail:"examples":""}
 	CMD_RegisterCommand("MCP23017_MapPinToChannel","",DRV_I2C_MCP23017_MapPinToChannel, NULL, NULL);
+	//cmddetail:{"name":"MCP23017_MapInputToChannel","args":"[I2CBus] [Address] [Pin] [Channel]",
+	//cmddetail:"descr":"Configures port expander bit as input with pull-up, pin is polled and its level is written to OBK channel",
+	//cmddetail:"fn":"DRV_I2C_MCP23017_MapInputToChannel","file":"i2c/drv_i2c_mcp23017.c","requires":"",
+	//cmddetail:"examples":"MCP23017_MapInputToChannel I2C1 0x27 8 12"}
+	CMD_RegisterCommand("MCP23017_MapInputToChannel","",DRV_I2C_MCP23017_MapInputToChannel, NULL, NULL);
 
 }
-void DRC_I2C_RunDevice(i2cDevice_t *dev)
-{
-	switch(dev->type)
-	{
-	case I2CDEV_TC74:
-		DRV_I2C_TC74_RunDevice(dev);
-		break;
-	case I2CDEV_MCP23017:
-		DRV_I2C_MCP23017_RunDevice(dev);
-		break;
-	case I2CDEV_LCD_PCF8574:
-		DRV_I2C_LCD_PCF8574_RunDevice(dev);
-		break;
-	default:
-		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRC_I2C_RunDevice: error, device of type %i at adr %i not handled\n", dev->type, dev->addr);
-		break;
+static i2cJob_t g_i2c_jobs[I2C_MAX_JOBS];
+static int g_i2c_numJobs = 0;
+// set while jobs are executed, jobs may queue new jobs (eg. input changes channel, channel drives output)
+static int g_i2c_bRunningJobs = 0;
+i2cStats_t g_i2c_stats;
+
+// stable insertion sort, so jobs of the same priority keep their submit order
+static void DRV_I2C_SortJobs() {
+	int i, j;
+	i2cJob_t tmp;
+
+	for(i = 1; i < g_i2c_numJobs; i++) {
+		tmp = g_i2c_jobs[i];
+		j = i;
+		while(j > 0 && g_i2c_jobs[j-1].priority > tmp.priority) {
+			g_i2c_jobs[j] = g_i2c_jobs[j-1];
+			j--;
+		}
+		g_i2c_jobs[j] = tmp;
+	}
+}
+// removes jobs marked with NULL func
+static void DRV_I2C_CompactJobs() {
+	int i, j;
+
+	j = 0;
+	for(i = 0; i < g_i2c_numJobs; i++) {
+		if(g_i2c_jobs[i].func == 0)
+			continue;
+		if(i != j)
+			g_i2c_jobs[j] = g_i2c_jobs[i];
+		j++;
+	}
+	g_i2c_numJobs = j;
+}
+static int DRV_I2C_AddJobInternal(i2cDevice_t *dev, i2cJobFunc_t func, int periodMS, int delayMS, int priority) {
+	int i;
+	i2cJob_t *job;
+
+	// same job is already queued, so for example many channel changes give a single flush
+	for(i = 0; i < g_i2c_numJobs; i++) {
+		job = &g_i2c_jobs[i];
+		if(job->dev == dev && job->func == func && job->period == periodMS)
+			return 1;
+	}
+	if(g_i2c_numJobs >= I2C_MAX_JOBS) {
+		g_i2c_stats.jobsDropped++;
+		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_AddJob: queue full, job for adr %i dropped\n", dev->addr);
+		return 0;
+	}
+	job = &g_i2c_jobs[g_i2c_numJobs++];
+	job->dev = dev;
+	job->func = func;
+	job->period = periodMS;
+	job->priority = priority;
+	// 0 - first run on next tick
+	job->timeLeft = delayMS;
+	if(g_i2c_bRunningJobs == 0) {
+		DRV_I2C_SortJobs();
+	}
+	return 1;
+}
+int DRV_I2C_AddJob(i2cDevice_t *dev, i2cJobFunc_t func, int periodMS, int priority) {
+	return DRV_I2C_AddJobInternal(dev, func, periodMS, 0, priority);
+}
+int DRV_I2C_AddJobDelayed(i2cDevice_t *dev, i2cJobFunc_t func, int delayMS, int priority) {
+	return DRV_I2C_AddJobInternal(dev, func, 0, delayMS, priority);
+}
+void DRV_I2C_RemoveJobs(i2cDevice_t *dev) {
+	int i;
 
+	for(i = 0; i < g_i2c_numJobs; i++) {
+		if(g_i2c_jobs[i].dev == dev)
+			g_i2c_jobs[i].func = 0;
+	}
+	if(g_i2c_bRunningJobs == 0) {
+		DRV_I2C_CompactJobs();
+	}
+}
+int DRV_I2C_GetJobsCount() {
+	return g_i2c_numJobs;
+}
+static void DRV_I2C_RunBusJobs(int busType, int count) {
+	int i;
+	int bOpen;
+	int selected;
+	i2cJob_t *job;
+	i2cJobFunc_t func;
+
+	bOpen = 0;
+	selected = -1;
+	for(i = 0; i < count; i++) {
+		job = &g_i2c_jobs[i];
+		if(job->func == 0 || job->timeLeft > 0 || job->dev->busType != busType)
+			continue;
+		if(bOpen == 0) {
+			if(DRV_I2C_OpenBus(busType)) {
+				g_i2c_stats.busErrors++;
+				bOpen = -1;
+			} else {
+				g_i2c_stats.busOpens++;
+				bOpen = 1;
+			}
+		}
+		if(bOpen == 1) {
+			// consecutive jobs for the same chip share the addressing
+			if(job->dev->addr != selected) {
+				DRV_I2C_SelectDevice(job->dev->addr);
+				selected = job->dev->addr;
+			}
+			func = job->func;
+			// one-shot job is done before it's run, so it can queue itself again
+			if(job->period == 0)
+				job->func = 0;
+			func(job->dev);
+			g_i2c_stats.jobsRun++;
+		}
+		// if bus failed to open, job is skipped until next period, so we don't spam the log
+		if(job->period > 0) {
+			job->timeLeft += job->period;
+			if(job->timeLeft <= 0)
+				job->timeLeft = job->period;
+		} else {
+			job->func = 0;
+		}
+	}
+	if(bOpen == 1) {
+		DRV_I2C_Close();
+	}
+}
+void DRV_I2C_RunQuickTick(int deltaMS) {
+	int i;
+	int count;
+
+	if(g_i2c_numJobs == 0)
+		return;
 
+	for(i = 0; i < g_i2c_numJobs; i++) {
+		g_i2c_jobs[i].timeLeft -= deltaMS;
 	}
+	// jobs queued by running jobs are appended past count and run on next tick
+	count = g_i2c_numJobs;
+	g_i2c_bRunningJobs = 1;
+	DRV_I2C_RunBusJobs(I2C_BUS_I2C1, count);
+	DRV_I2C_RunBusJobs(I2C_BUS_I2C2, count);
+	g_i2c_bRunningJobs = 0;
+
+	DRV_I2C_CompactJobs();
+	DRV_I2C_SortJobs();
 }
-void DRV_I2C_EverySecond()
+void DRV_I2C_Shutdown()
 {
 	i2cDevice_t *cur;
+	i2cDevice_t *next;
 
+	g_i2c_numJobs = 0;
 	cur = g_i2c_devices;
 	while(cur) {
-		//addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_EverySecond: going to run device of type %i with addr %i\n", cur->type, cur->addr);
-		DRC_I2C_RunDevice(cur);
-		cur = cur->next;
+		next = cur->next;
+		free(cur);
+		cur = next;
 	}
+	g_i2c_devices = 0;
 }
 void I2C_OnChannelChanged_Device(i2cDevice_t *dev, int channel, int iVal)
 {
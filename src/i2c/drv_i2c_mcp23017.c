@@ -8,152 +8,164 @@
 // addresses, banks, etc, defines
 #include "drv_i2c_mcp23017.h"
 
-static byte MCP23017_readByte(i2cDevice_MCP23017_t *mcp, byte tgRegAddr )
+// All MCP23017 accesses are done from I2C scheduler jobs, so bus is already open
+// and device selected. Direction and output latches are kept in shadow registers,
+// so there is no read-modify-write and many channel changes end up in a single flush.
+// With IOCON.SEQOP = 0 (default) register pointer increments, so A and B
+// registers are written in one transaction.
+static void MCP23017_writePair(byte tgRegAddr, unsigned short value)
 {
-    byte bufferRead;
+	byte data[2];
 
-	DRV_I2C_Begin(mcp->base.addr, mcp->base.busType);
-    DRV_I2C_Read( tgRegAddr, &bufferRead );
-	DRV_I2C_Close();
-
-    return bufferRead;
-}
-static void MCP23017_writeByte( i2cDevice_MCP23017_t *mcp, byte tgRegAddr, byte toWrite )
-{
-	DRV_I2C_Begin(mcp->base.addr, mcp->base.busType);
-    DRV_I2C_Write( tgRegAddr, toWrite );
-	DRV_I2C_Close();
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+	DRV_I2C_WriteBytes(tgRegAddr, data, 2);
 }
-static void MCP23017_setBits( i2cDevice_MCP23017_t *mcp, byte tgRegAddr, byte bitMask )
+static unsigned short MCP23017_readPair(byte tgRegAddr)
 {
-    byte temp;
-
-    temp = MCP23017_readByte( mcp, tgRegAddr );
+	byte data[2];
 
-    temp |= bitMask;
-
-    MCP23017_writeByte( mcp, tgRegAddr, temp );
+	DRV_I2C_ReadBytes(tgRegAddr, data, 2);
+	return data[0] | (data[1] << 8);
 }
-static void MCP23017_clearBits( i2cDevice_MCP23017_t *mcp, byte tgRegAddr, byte bitMask )
+static void MCP23017_Flush(i2cDevice_t *dev)
 {
-    byte temp;
-
-    temp = MCP23017_readByte( mcp, tgRegAddr );
-
-    temp &= ~bitMask;
+	i2cDevice_MCP23017_t *mcp;
 
-    MCP23017_writeByte( mcp, tgRegAddr, temp );
+	mcp = (i2cDevice_MCP23017_t*)dev;
+	if(mcp->bDirty == 0)
+		return;
+	mcp->bDirty = 0;
+
+	// bit set in IODIR is input, inputs get pull-ups
+	MCP23017_writePair(_MCP23017_IODIRA_BANK0, mcp->inputMask);
+	MCP23017_writePair(_MCP23017_GPPUA_BANK0, mcp->inputMask);
+	MCP23017_writePair(_MCP23017_OLATA_BANK0, mcp->outputs);
 }
-static void MCP23017_toggleBits( i2cDevice_MCP23017_t *mcp, byte tgRegAddr, byte bitMask )
+static void MCP23017_Poll(i2cDevice_t *dev)
 {
-    byte temp;
-
-    temp = MCP23017_readByte( mcp, tgRegAddr );
+	i2cDevice_MCP23017_t *mcp;
+	unsigned short levels;
+	unsigned short changed;
+	int i;
 
-    temp ^= bitMask;
+	mcp = (i2cDevice_MCP23017_t*)dev;
 
-    MCP23017_writeByte( mcp, tgRegAddr, temp );
-}
-static void MCP23017_setDirectionPortA( i2cDevice_MCP23017_t *mcp, byte toWrite )
-{
-    MCP23017_writeByte( mcp, _MCP23017_IODIRA_BANK0, toWrite );
-}
+	levels = MCP23017_readPair(_MCP23017_GPIOA_BANK0) & mcp->inputMask;
+	changed = ((levels ^ mcp->inputs) | mcp->inputsStale) & mcp->inputMask;
+	mcp->inputs = levels;
+	mcp->inputsStale = 0;
+	if(changed == 0)
+		return;
 
-static void MCP23017_setDirectionPortB( i2cDevice_MCP23017_t *mcp, byte toWrite )
-{
-    MCP23017_writeByte( mcp, _MCP23017_IODIRB_BANK0, toWrite );
-}
-static void MCP23017_writePortA( i2cDevice_MCP23017_t *mcp, byte toWrite )
-{
-    MCP23017_writeByte( mcp, _MCP23017_OLATA_BANK0, toWrite );
+	for(i = 0; i < 16; i++) {
+		if((changed & (1 << i)) && mcp->pinMapping[i] != 0xff) {
+			addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"MCP23017_Poll: pin %i is now %i, setting ch %i\n", i, (levels >> i) & 1, mcp->pinMapping[i]);
+			CHANNEL_Set(mcp->pinMapping[i], (levels >> i) & 1, 0);
+		}
+	}
 }
-static void MCP23017_toggleBitPortA(  i2cDevice_MCP23017_t *mcp, byte bitMask )
+static void MCP23017_QueueFlush(i2cDevice_MCP23017_t *mcp)
 {
-    MCP23017_toggleBits( mcp, _MCP23017_OLATA_BANK0, bitMask );
+	mcp->bDirty = 1;
+	DRV_I2C_AddJob((i2cDevice_t*)mcp, MCP23017_Flush, 0, I2C_PRIORITY_HIGH);
 }
 
-
 void DRV_I2C_MCP23017_OnChannelChanged(i2cDevice_t *dev, int channel, int iVal)
 {
 	i2cDevice_MCP23017_t *mcp;
 	int i;
-	int bank;
-	int localBitIndex;
-	int mask;
+	unsigned short outputs;
 
 	mcp = (i2cDevice_MCP23017_t*)dev;
 
-	MCP23017_setDirectionPortA(mcp, _MCP23017_PORT_DIRECTION_OUTPUT);
-	MCP23017_setDirectionPortB(mcp, _MCP23017_PORT_DIRECTION_OUTPUT);
-
-	// test only
-	//MCP23017_toggleBitPortA(mcp, 0xFF);
-
+	outputs = mcp->outputs;
 	for(i = 0; i < 16; i++) {
-		if(mcp->pinMapping[i] == channel) {
+		if(mcp->pinMapping[i] == channel && (mcp->inputMask & (1 << i)) == 0) {
 			addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_MCP23017_OnChannelChanged: will set pin %i to %i for ch %i\n", i, iVal, channel);
 
-			// split 0-16 indices into two 8 bit ports - port A and port B
-			if(i>=8) {
-				localBitIndex = i - 8;
-				bank = _MCP23017_OLATB_BANK0;
-			} else {
-				localBitIndex = i;
-				bank = _MCP23017_OLATA_BANK0;
-			}
-			mask = 1 << localBitIndex;
 			if(iVal) {
-				//addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_MCP23017_OnChannelChanged: calling MCP23017_setBits mask %i\n", mask);
-				MCP23017_setBits(mcp, bank, mask);
+				outputs |= (1 << i);
 			} else {
-				//addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_MCP23017_OnChannelChanged: calling MCP23017_clearBits mask %i\n", mask);
-				MCP23017_clearBits(mcp, bank, mask);
+				outputs &= ~(1 << i);
 			}
 		}
 	}
+	if(outputs != mcp->outputs) {
+		mcp->outputs = outputs;
+		MCP23017_QueueFlush(mcp);
+	}
 }
-commandResult_t DRV_I2C_MCP23017_MapPinToChannel(const void *context, const char *cmd, const char *args, int cmdFlags) {
+static i2cDevice_MCP23017_t *MCP23017_ParseMapCommand(const char *cmd, const char *args, int *targetPin, int *targetChannel) {
 	const char *i2cModuleStr;
 	int address;
-	int targetPin;
-	int targetChannel;
 	i2cBusType_t busType;
 	i2cDevice_MCP23017_t *mcp;
 
 	Tokenizer_TokenizeString(args,0);
 	i2cModuleStr = Tokenizer_GetArg(0);
 	address = Tokenizer_GetArgInteger(1);
-	targetPin = Tokenizer_GetArgInteger(2);
-	targetChannel = Tokenizer_GetArgInteger(3);
+	*targetPin = Tokenizer_GetArgInteger(2);
+	*targetChannel = Tokenizer_GetArgInteger(3);
 
-	addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_MCP23017_MapPinToChannel: module %s, address %i, pin %i, ch %i\n", i2cModuleStr, address,targetPin,targetChannel );
+	addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"%s: module %s, address %i, pin %i, ch %i\n", cmd, i2cModuleStr, address,*targetPin,*targetChannel );
 
+	if(*targetPin < 0 || *targetPin >= 16) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"%s: pin must be in 0-15 range\n", cmd);
+		return 0;
+	}
 	busType = DRV_I2C_ParseBusType(i2cModuleStr);
 
 	mcp = (i2cDevice_MCP23017_t *)DRV_I2C_FindDeviceExt( busType, address,I2CDEV_MCP23017);
 	if(mcp == 0) {
-		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_MCP23017_MapPinToChannel: no such device exists\n" );
+		addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"%s: no such device exists\n", cmd);
+		return 0;
+	}
+	return mcp;
+}
+commandResult_t DRV_I2C_MCP23017_MapPinToChannel(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	int targetPin;
+	int targetChannel;
+	i2cDevice_MCP23017_t *mcp;
+
+	mcp = MCP23017_ParseMapCommand(cmd, args, &targetPin, &targetChannel);
+	if(mcp == 0) {
 		return CMD_RES_BAD_ARGUMENT;
 	}
 
 	mcp->pinMapping[targetPin] = targetChannel;
+	mcp->inputMask &= ~(1 << targetPin);
+	if(CHANNEL_Get(targetChannel)) {
+		mcp->outputs |= (1 << targetPin);
+	} else {
+		mcp->outputs &= ~(1 << targetPin);
+	}
 
 	// send refresh
-	DRV_I2C_MCP23017_OnChannelChanged((i2cDevice_t*)mcp, targetChannel, CHANNEL_Get(targetChannel));
+	MCP23017_QueueFlush(mcp);
 
 	return CMD_RES_OK;
 }
-void DRV_I2C_MCP23017_RunDevice(i2cDevice_t *dev)
-{
+commandResult_t DRV_I2C_MCP23017_MapInputToChannel(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	int targetPin;
+	int targetChannel;
 	i2cDevice_MCP23017_t *mcp;
 
-	mcp = (i2cDevice_MCP23017_t*)dev;
+	mcp = MCP23017_ParseMapCommand(cmd, args, &targetPin, &targetChannel);
+	if(mcp == 0) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
 
-	// old test code, used only to make MCP23017 blink
-#if 0
-	MCP23017_setDirectionPortA(mcp, _MCP23017_PORT_DIRECTION_OUTPUT);
-	MCP23017_toggleBitPortA(mcp, 0xFF);
-#endif
+	mcp->pinMapping[targetPin] = targetChannel;
+	mcp->inputMask |= (1 << targetPin);
+	mcp->inputsStale |= (1 << targetPin);
+
+	MCP23017_QueueFlush(mcp);
+	if(mcp->bPolling == 0) {
+		// fast enough for buttons, bus is shared with other devices anyway
+		DRV_I2C_AddJob((i2cDevice_t*)mcp, MCP23017_Poll, 50, I2C_PRIORITY_HIGH);
+		mcp->bPolling = 1;
+	}
 
-	// Nothing to do here right now, as we are using on change pin callback
+	return CMD_RES_OK;
 }
@@ -2,7 +2,8 @@
 
 
 void DRV_I2C_Init();
-void DRV_I2C_EverySecond();
+void DRV_I2C_RunQuickTick(int deltaMS);
+void DRV_I2C_Shutdown();
 void I2C_OnChannelChanged(int channel,int iVal);
 
 
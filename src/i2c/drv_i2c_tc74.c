@@ -6,18 +6,15 @@
 #include "../logging/logging.h"
 #include "drv_i2c_local.h"
 
-int DRV_I2C_TC74_readTemperature(int dev_adr, int busID)
+// called by I2C scheduler, bus is already open and device selected
+int DRV_I2C_TC74_readTemperature(int dev_adr)
 {
 	byte temp;
 
-	addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_TC74_readTemperature: called for addr %i\n", dev_adr);
-
-	DRV_I2C_Begin(dev_adr,busID);
-	DRV_I2C_Write(0,0x00);
+	// read sends register address (RTR = 0) itself, no need for a separate write
 	DRV_I2C_Read(0x00,&temp);
-	DRV_I2C_Close();
 
-	addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_TC74_readTemperature: result is %i\n", temp);
+	addLogAdv(LOG_INFO, LOG_FEATURE_I2C,"DRV_I2C_TC74_readTemperature: result for addr %i is %i\n", dev_adr, temp);
 
 	return temp;
 
@@ -29,7 +26,7 @@ void DRV_I2C_TC74_RunDevice(i2cDevice_t *dev)
 
 	tc74 = (i2cDevice_TC74_t*)dev;
 
-	temp = DRV_I2C_TC74_readTemperature(tc74->base.addr, tc74->base.busType);
+	temp = DRV_I2C_TC74_readTemperature(tc74->base.addr);
 
 	CHANNEL_Set(tc74->targetChannel, temp, 0);
-}
\ No newline at end of file
+}
@@ -558,7 +558,7 @@ void log_server_thread(beken_thread_arg_t arg)
                         "Logging TCP Client",
                         (beken_thread_function_t)log_client_thread,
                         0x800,
-                        (beken_thread_arg_t)client_fd))
+                        (beken_thread_arg_t)(intptr_t)client_fd))
                 {
 					close(client_fd);
 					client_fd = -1;
@@ -617,7 +617,7 @@ static void send_to_tcp(){
 // non-beken
 static void log_client_thread(beken_thread_arg_t arg)
 {
-	int fd = (int)arg;
+	int fd = (int)(intptr_t)arg;
 	while (1) {
 		int count = getTcp(tcplogbuf, TCPLOGBUFSIZE);
 		if (count) {
@@ -15,6 +15,7 @@
 #define _OBK_LOGGING_H
 
 void addLogAdv(int level, int feature, const char *fmt, ...);
+void LOG_DeInit();
 void LOG_SetRawSocketCallback(int newFD);
 
 #define ADDLOG_ERROR(x, fmt, ...) addLogAdv(LOG_ERROR, x, fmt, ##__VA_ARGS__)
@@ -0,0 +1,249 @@
+#include "new_common.h"
+#include "logging/logging.h"
+#include "mem_pool.h"
+#ifdef PLATFORM_BK7231T
+#include "memory/memtest.h"
+#endif
+
+typedef struct memPool_s {
+	unsigned short blockSize;
+	unsigned short blockCount;
+	// allocated on first use
+	byte *arena;
+	void *freeList;
+	unsigned short used;
+	unsigned short highWater;
+	unsigned int allocs;
+	unsigned int failures;
+	byte bArenaFailed;
+} memPool_t;
+
+// sorted by block size, sizes must be multiples of 8 (alignment) and at least a pointer
+static memPool_t g_pools[] = {
+	// short strings - MQTT topics
+	{ 16, 32 },
+	{ 32, 32 },
+	// cJSON nodes
+	{ 64, 24 },
+	{ 128, 12 },
+	{ 256, 6 },
+	// HTTP request buffer
+	{ 1024, 2 },
+	// HTTP reply buffer, jsmn tokens for REST
+	{ 2048, 2 },
+};
+#define POOL_COUNT (sizeof(g_pools) / sizeof(g_pools[0]))
+
+static unsigned int g_heapAllocs = 0;
+static unsigned int g_heapFailures = 0;
+static SemaphoreHandle_t g_poolMutex = 0;
+
+static bool Pool_Mutex_Take() {
+	int taken;
+
+	if (g_poolMutex == 0) {
+		g_poolMutex = xSemaphoreCreateMutex();
+	}
+	taken = xSemaphoreTake(g_poolMutex, 100);
+	if (taken == pdTRUE) {
+		return true;
+	}
+	return false;
+}
+static void Pool_Mutex_Free() {
+	xSemaphoreGive(g_poolMutex);
+}
+static bool Pool_InitArena(memPool_t *pool) {
+	int i;
+	byte *block;
+
+	if (pool->bArenaFailed) {
+		return false;
+	}
+	pool->arena = (byte*)os_malloc(pool->blockSize * pool->blockCount);
+	if (pool->arena == 0) {
+		// don't retry each time, heap is not going to get better
+		pool->bArenaFailed = 1;
+		addLogAdv(LOG_ERROR, LOG_FEATURE_GENERAL, "Pool_Malloc: no memory for %i x %i pool",
+			pool->blockCount, pool->blockSize);
+		return false;
+	}
+	pool->freeList = 0;
+	for (i = pool->blockCount - 1; i >= 0; i--) {
+		block = pool->arena + i * pool->blockSize;
+		*(void**)block = pool->freeList;
+		pool->freeList = block;
+	}
+	return true;
+}
+static memPool_t *Pool_Find(void *p) {
+	memPool_t *pool;
+	int i;
+
+	for (i = 0; i < POOL_COUNT; i++) {
+		pool = &g_pools[i];
+		if (pool->arena && (byte*)p >= pool->arena
+			&& (byte*)p < pool->arena + pool->blockSize * pool->blockCount) {
+			return pool;
+		}
+	}
+	return 0;
+}
+static void *Pool_TakeBlock(memPool_t *pool) {
+	void *p;
+
+	p = pool->freeList;
+	pool->freeList = *(void**)p;
+	pool->used++;
+	pool->allocs++;
+	if (pool->used > pool->highWater) {
+		pool->highWater = pool->used;
+	}
+	return p;
+}
+void *Pool_Malloc(size_t size) {
+	memPool_t *pool;
+	void *p;
+	int i;
+
+	if (Pool_Mutex_Take()) {
+		for (i = 0; i < POOL_COUNT; i++) {
+			if (g_pools[i].blockSize >= size) {
+				break;
+			}
+		}
+		if (i < POOL_COUNT) {
+			pool = &g_pools[i];
+			if (pool->arena == 0) {
+				Pool_InitArena(pool);
+			}
+			if (pool->freeList) {
+				p = Pool_TakeBlock(pool);
+				Pool_Mutex_Free();
+				return p;
+			}
+			pool->failures++;
+			// spill at most one class up, and only to an arena that is already there,
+			// so small requests can't drain (or allocate) big blocks
+			if (i + 1 < POOL_COUNT) {
+				pool = &g_pools[i + 1];
+				if (pool->freeList) {
+					p = Pool_TakeBlock(pool);
+					Pool_Mutex_Free();
+					return p;
+				}
+			}
+		}
+		g_heapAllocs++;
+		Pool_Mutex_Free();
+	}
+	p = os_malloc(size);
+	if (p == 0 && Pool_Mutex_Take()) {
+		g_heapFailures++;
+		Pool_Mutex_Free();
+	}
+	return p;
+}
+void Pool_Free(void *p) {
+	memPool_t *pool;
+
+	if (p == 0) {
+		return;
+	}
+	// arenas are never freed, so this is safe without mutex
+	pool = Pool_Find(p);
+	if (pool == 0) {
+		os_free(p);
+		return;
+	}
+	if (Pool_Mutex_Take() == false) {
+		// block stays taken, better than corrupting free list
+		addLogAdv(LOG_ERROR, LOG_FEATURE_GENERAL, "Pool_Free: mutex timeout, %i byte block lost",
+			pool->blockSize);
+		return;
+	}
+	*(void**)p = pool->freeList;
+	pool->freeList = p;
+	pool->used--;
+	Pool_Mutex_Free();
+}
+char *Pool_StrDup(const char *s) {
+	char *r;
+	int len;
+
+	len = strlen(s) + 1;
+	r = (char*)Pool_Malloc(len);
+	if (r) {
+		memcpy(r, s, len);
+	}
+	return r;
+}
+int Pool_GetClassCount() {
+	return POOL_COUNT;
+}
+void Pool_GetStats(int index, memPoolStats_t *out) {
+	memPool_t *pool;
+
+	memset(out, 0, sizeof(*out));
+	if (index < 0 || index >= POOL_COUNT) {
+		return;
+	}
+	pool = &g_pools[index];
+	out->blockSize = pool->blockSize;
+	out->blockCount = pool->blockCount;
+	out->used = pool->used;
+	out->highWater = pool->highWater;
+	out->allocs = pool->allocs;
+	out->failures = pool->failures;
+}
+void Pool_ResetStats() {
+	int i;
+
+	for (i = 0; i < POOL_COUNT; i++) {
+		g_pools[i].highWater = g_pools[i].used;
+		g_pools[i].allocs = 0;
+		g_pools[i].failures = 0;
+	}
+	g_heapAllocs = 0;
+	g_heapFailures = 0;
+}
+void Pool_GetHeapStats(memHeapStats_t *out) {
+	memset(out, 0, sizeof(*out));
+	out->freeBytes = xPortGetFreeHeapSize();
+#ifdef PLATFORM_BK7231T
+	out->freeBytes = getHeapFreeBlocks(&out->freeBlocks, &out->largestFreeBlock);
+#else
+	// allocator doesn't tell, and probing with malloc would starve other tasks
+	out->freeBlocks = -1;
+	out->largestFreeBlock = -1;
+	out->fragmentation = -1;
+#endif
+	if (out->freeBytes > 0 && out->largestFreeBlock >= 0) {
+		out->fragmentation = (int)(100LL * (out->freeBytes - out->largestFreeBlock) / out->freeBytes);
+		if (out->fragmentation < 0) {
+			out->fragmentation = 0;
+		}
+	}
+	out->heapAllocs = g_heapAllocs;
+	out->heapFailures = g_heapFailures;
+}
+int Pool_WriteJSON(http_request_t *request) {
+	memHeapStats_t heap;
+	memPoolStats_t s;
+	int i;
+
+	Pool_GetHeapStats(&heap);
+	http_setup(request, httpMimeTypeJson);
+	hprintf255(request, "{\"free\":%i,\"largest_free\":%i,\"free_blocks\":%i,\"fragmentation\":%i,",
+		heap.freeBytes, heap.largestFreeBlock, heap.freeBlocks, heap.fragmentation);
+	hprintf255(request, "\"heap_allocs\":%u,\"heap_failures\":%u,\"pools\":[",
+		heap.heapAllocs, heap.heapFailures);
+	for (i = 0; i < POOL_COUNT; i++) {
+		Pool_GetStats(i, &s);
+		hprintf255(request, "%s{\"size\":%i,\"count\":%i,\"used\":%i,\"high_water\":%i,\"allocs\":%u,\"failures\":%u}",
+			i ? "," : "", s.blockSize, s.blockCount, s.used, s.highWater, s.allocs, s.failures);
+	}
+	poststr(request, "]}");
+	poststr(request, NULL);
+	return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef __MEM_POOL_H__
+#define __MEM_POOL_H__
+
+#include "new_common.h"
+#include "httpserver/new_http.h"
+
+// Fixed-block pools for small, short-lived allocations (MQTT topics, cJSON
+// nodes, jsmn tokens, HTTP buffers). Each size class has its
+// own arena, taken from heap in one piece on first use and never given back,
+// so these allocations don't fragment the heap. A request goes to the smallest
+// class it fits; if that one is empty, to the next class up if its arena
+// already exists; otherwise (or if it doesn't fit any class) to os_malloc.
+// Long-lived data should use os_malloc directly, so it doesn't hold blocks.
+// Pool_Free accepts both, so it can be used as free for anything from Pool_Malloc.
+// Stats are available via /api/heap.
+
+typedef struct memPoolStats_s {
+	int blockSize;
+	int blockCount;
+	int used;
+	int highWater;
+	unsigned int allocs;
+	// times this class was empty (request went to next class or heap)
+	unsigned int failures;
+} memPoolStats_t;
+
+typedef struct memHeapStats_s {
+	int freeBytes;
+	// this one, freeBlocks and fragmentation are -1 if platform can't tell
+	int largestFreeBlock;
+	int freeBlocks;
+	// 0 - all free memory is one block, 100 - free memory is all in small pieces
+	int fragmentation;
+	// allocations that did not fit any pool
+	unsigned int heapAllocs;
+	unsigned int heapFailures;
+} memHeapStats_t;
+
+void *Pool_Malloc(size_t size);
+void Pool_Free(void *p);
+char *Pool_StrDup(const char *s);
+int Pool_GetClassCount();
+void Pool_GetStats(int index, memPoolStats_t *out);
+void Pool_GetHeapStats(memHeapStats_t *out);
+// resets counters and high-water marks, not the blocks in use
+void Pool_ResetStats();
+// pools and heap state as JSON reply, used by /api/heap
+int Pool_WriteJSON(http_request_t *request);
+
+#endif // __MEM_POOL_H__
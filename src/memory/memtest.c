@@ -325,6 +325,50 @@
         }
     }
 
+    ///////////////////////////////////////////////////////////
+    // walk all blocks and count the free ones, used by /api/heap
+    // returns total free bytes
+    ///////////////////////////////////////////////////////////
+    int getHeapFreeBlocks(int *pCount, int *pLargest){
+        *pCount = 0;
+        *pLargest = 0;
+        if (!ucHeap) {
+            return 0;
+        }
+        size_t uxAddress = (size_t)ucHeap;
+        if( ( uxAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+        {
+            uxAddress += ( portBYTE_ALIGNMENT - 1 );
+            uxAddress &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+        }
+        BlockLink_t *pxBlock = (BlockLink_t *)uxAddress;
+        uint8_t *pucHeapEnd = HEAP_END_ADDRESS;
+        int maxblocks = 5000;
+        int total = 0;
+
+        vTaskSuspendAll();
+        while (pxBlock && maxblocks){
+            maxblocks--;
+            int size = pxBlock->xBlockSize & ~xBlockAllocatedBit;
+            if (size == 0){
+                break;
+            }
+            if (!(pxBlock->xBlockSize & xBlockAllocatedBit)){
+                (*pCount)++;
+                total += size;
+                if (*pLargest < size - sizeof(BlockLink_t)){
+                    *pLargest = size - sizeof(BlockLink_t);
+                }
+            }
+            pxBlock = (BlockLink_t *)((( uint8_t * )pxBlock) + size);
+            if ((uint32_t)pxBlock >= (uint32_t)pucHeapEnd){
+                break;
+            }
+        }
+        ( void ) xTaskResumeAll();
+        return total;
+    }
+
     #ifdef OBK_HEAPGUARD
 
     extern void *__real_pvPortMalloc(size_t size);
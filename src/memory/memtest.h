@@ -58,6 +58,12 @@ int stackCheck(int percentMax);
 ///////////////////////////////////////////////////
 void mallocTest(int logall);
 
+///////////////////////////////////////////////////
+// count free heap blocks and find the largest one
+// returns total free bytes (T only, see src/mem_pool.c)
+///////////////////////////////////////////////////
+int getHeapFreeBlocks(int *pCount, int *pLargest);
+
 
 #ifdef PLATFORM_BK7231T
 
@@ -7,6 +7,8 @@
 #include "hal/hal_wifi.h"
 #include "hal/hal_flashConfig.h"
 #include "cmnds/cmd_public.h"
+#include "crc.h"
+#include <stddef.h>
 #ifdef BK_LITTLEFS
 #include "littlefs/our_lfs.h"
 #endif
@@ -104,10 +106,293 @@ static byte CFG_CalcChecksum(mainConfig_t *inf) {
 		header_size, sizeof(mainConfig_t), remaining_size);
 
 	// This is more flexible method and won't be affected by field offsets
-	crc = Tiny_CRC8((const char*)&inf->version,remaining_size);
+	crc = CRC8_Update(0, &inf->version, remaining_size);
 
 	return crc;
 }
+// Config sections.
+// Config is still saved as one mainConfig_t image, so older firmware and flash
+// tools can read it, but the image is split into sections which cover it from
+// the version field to the end (only g_cfg.sections directory is not a part of
+// any section). Each section has its own version (stored in the directory),
+// dirty flag and CRC. If HAL gives raw access to config flash area, changed
+// sections are appended as records to a journal placed after the image, and the
+// area is erased and whole image written again only when journal is full.
+// Records are replayed over the image on load.
+
+typedef struct cfgSection_s {
+	const char *name;
+	unsigned short offset;
+	unsigned short size;
+	byte version;
+	// version of this section in configs saved before sections existed
+	byte legacyVersion;
+	// called on load when saved section is older than current version
+	void (*migrate)(int fromVersion);
+} cfgSection_t;
+
+typedef struct cfgRecordHeader_s {
+	byte magic;
+	byte tag;
+	byte version;
+	// CRC8 of tag, version, length and data
+	byte crc;
+	unsigned short length;
+} cfgRecordHeader_t;
+
+#define CFG_RECORD_MAGIC		0xC5
+#define CFG_JOURNAL_START		((sizeof(mainConfig_t) + 3) & ~3)
+#define CFG_RECORD_SIZE(len)	((sizeof(cfgRecordHeader_t) + (len) + 3) & ~3)
+
+#define CFG_SECTION(name, first, endOffset, version, legacyVersion, migrate) \
+	{ name, offsetof(mainConfig_t, first), (endOffset) - offsetof(mainConfig_t, first), version, legacyVersion, migrate }
+
+static void CFG_MigrateMQTT(int fromVersion);
+
+// must be sorted by offset, order must match enum cfgSection_e
+static const cfgSection_t g_cfgSections[CFG_SECTION_COUNT] = {
+	CFG_SECTION("system", version, offsetof(mainConfig_t, wifi_ssid), 1, 1, NULL),
+	CFG_SECTION("wifi", wifi_ssid, offsetof(mainConfig_t, mqtt_host), 1, 1, NULL),
+	CFG_SECTION("mqtt", mqtt_host, offsetof(mainConfig_t, webappRoot), 2, 2, CFG_MigrateMQTT),
+	CFG_SECTION("device", webappRoot, offsetof(mainConfig_t, pins), 1, 1, NULL),
+	CFG_SECTION("pins", pins, offsetof(mainConfig_t, startChannelValues), 1, 1, NULL),
+	CFG_SECTION("channels", startChannelValues, offsetof(mainConfig_t, dgr_sendFlags), 1, 1, NULL),
+	CFG_SECTION("dgr", dgr_sendFlags, offsetof(mainConfig_t, ntpServer), 1, 1, NULL),
+	CFG_SECTION("ntp", ntpServer, offsetof(mainConfig_t, cal), 1, 1, NULL),
+	CFG_SECTION("power", cal, offsetof(mainConfig_t, buttonShortPress), 1, 1, NULL),
+	CFG_SECTION("buttons", buttonShortPress, offsetof(mainConfig_t, LFS_Size), 1, 1, NULL),
+	CFG_SECTION("lfs", LFS_Size, offsetof(mainConfig_t, sections), 1, 1, NULL),
+	CFG_SECTION("mqtt_group", mqtt_group, offsetof(mainConfig_t, unused_bytefill), 1, 1, NULL),
+	CFG_SECTION("ping", unused_bytefill, offsetof(mainConfig_t, initCommandLine), 1, 1, NULL),
+	CFG_SECTION("startup", initCommandLine, sizeof(mainConfig_t), 1, 1, NULL),
+};
+
+static byte g_cfgSectionCRC[CFG_SECTION_COUNT];
+// CRC32 of each section as it is in flash (image and journal), every save
+// compares sections against it, so g_cfg writes that were not reported
+// with CFG_MarkSectionChanged (or at all) are saved too
+static uint32_t g_cfgSectionSaved[CFG_SECTION_COUNT];
+static int g_cfgDirtySections = 0;
+// where next record goes, 0 if journal can't be used and next save is a full one
+static int g_cfgJournalOffset = 0;
+static cfgSaveStats_t g_cfgSaveStats;
+
+// MQTT section v2 - MAIN_CFG_VERSION 3 moved shortName to MQTT Client ID
+static void CFG_MigrateMQTT(int fromVersion) {
+	if (fromVersion < 2) {
+		addLogAdv(LOG_WARN, LOG_FEATURE_CFG, "CFG_InitAndLoad: Old config version found, updating to v3.");
+		strcpy_safe(g_cfg.mqtt_clientId, g_cfg.shortDeviceName, sizeof(g_cfg.mqtt_clientId));
+	}
+}
+static byte CFG_Sections_CalcSectionCRC(int i) {
+	return CRC8_Update(0, ((byte*)&g_cfg) + g_cfgSections[i].offset, g_cfgSections[i].size);
+}
+static uint32_t CFG_Sections_CalcSectionCRC32(int i) {
+	return CRC32_Update(0, ((byte*)&g_cfg) + g_cfgSections[i].offset, g_cfgSections[i].size);
+}
+// section in g_cfg is the same as in flash
+static void CFG_Sections_UpdateCRC(int i) {
+	g_cfgSectionCRC[i] = CFG_Sections_CalcSectionCRC(i);
+	g_cfgSectionSaved[i] = CFG_Sections_CalcSectionCRC32(i);
+}
+static void CFG_Sections_UpdateAllCRCs() {
+	int i;
+
+	for (i = 0; i < CFG_SECTION_COUNT; i++) {
+		CFG_Sections_UpdateCRC(i);
+	}
+}
+// same value as CFG_CalcChecksum gives, but made from section CRCs,
+// so only bytes between sections are hashed again
+static byte CFG_Sections_CalcChecksum() {
+	const cfgSection_t *s;
+	int i, pos;
+	byte crc;
+
+	crc = 0;
+	pos = offsetof(mainConfig_t, version);
+	for (i = 0; i < CFG_SECTION_COUNT; i++) {
+		s = &g_cfgSections[i];
+		if (s->offset > pos) {
+			crc = CRC8_Update(crc, ((byte*)&g_cfg) + pos, s->offset - pos);
+		}
+		crc = CRC8_Combine(crc, g_cfgSectionCRC[i], s->size);
+		pos = s->offset + s->size;
+	}
+	return crc;
+}
+void CFG_MarkSectionChanged(int section) {
+	g_cfgDirtySections |= (1 << section);
+	g_cfg_pendingChanges++;
+}
+void CFG_GetSaveStats(cfgSaveStats_t *out) {
+	*out = g_cfgSaveStats;
+	out->journalUsed = g_cfgJournalOffset ? g_cfgJournalOffset - CFG_JOURNAL_START : 0;
+	out->journalSize = g_cfgJournalOffset ? HAL_Configuration_GetConfigAreaSize() - CFG_JOURNAL_START : 0;
+}
+// whole config has changed (defaults loaded), next save must write everything
+static void CFG_Sections_Reset() {
+	g_cfgDirtySections = (1 << CFG_SECTION_COUNT) - 1;
+	g_cfgJournalOffset = 0;
+}
+static byte CFG_Sections_CalcRecordCRC(const cfgRecordHeader_t *h, int dataOffset, const byte *data) {
+	byte chunk[32];
+	byte crc;
+	int done, len;
+
+	crc = CRC8_Update(0, &h->tag, 2);
+	crc = CRC8_Update(crc, &h->length, sizeof(h->length));
+	if (data) {
+		return CRC8_Update(crc, data, h->length);
+	}
+	// record still in flash
+	for (done = 0; done < h->length; done += len) {
+		len = h->length - done;
+		if (len > sizeof(chunk)) {
+			len = sizeof(chunk);
+		}
+		HAL_Configuration_ReadConfigArea(dataOffset + done, chunk, len);
+		crc = CRC8_Update(crc, chunk, len);
+	}
+	return crc;
+}
+static void CFG_Sections_ReplayJournal(byte *versions) {
+	const cfgSection_t *s;
+	cfgRecordHeader_t h;
+	int offset, end, len;
+
+	end = HAL_Configuration_GetConfigAreaSize();
+	offset = CFG_JOURNAL_START;
+	while (offset + (int)sizeof(h) <= end) {
+		HAL_Configuration_ReadConfigArea(offset, &h, sizeof(h));
+		if (h.magic != CFG_RECORD_MAGIC) {
+			// erased flash is where next record goes, anything else needs a full save
+			if (h.magic == 0xFF) {
+				g_cfgJournalOffset = offset;
+			}
+			return;
+		}
+		if (h.tag >= CFG_SECTION_COUNT || offset + CFG_RECORD_SIZE(h.length) > end
+			|| CFG_Sections_CalcRecordCRC(&h, offset + sizeof(h), 0) != h.crc) {
+			addLogAdv(LOG_WARN, LOG_FEATURE_CFG, "CFG_InitAndLoad: broken config record at %i, journal will be rewritten", offset);
+			return;
+		}
+		s = &g_cfgSections[h.tag];
+		len = h.length;
+		if (len > s->size) {
+			len = s->size;
+		}
+		HAL_Configuration_ReadConfigArea(offset + sizeof(h), ((byte*)&g_cfg) + s->offset, len);
+		CFG_Sections_UpdateCRC(h.tag);
+		versions[h.tag] = h.version;
+		offset += CFG_RECORD_SIZE(h.length);
+	}
+}
+// called after image was loaded and verified
+static void CFG_Sections_Load() {
+	const cfgSection_t *s;
+	byte versions[CFG_SECTION_COUNT];
+	bool bHasDirectory;
+	int i;
+
+	g_cfgDirtySections = 0;
+	g_cfgJournalOffset = 0;
+
+	bHasDirectory = g_cfg.sections.magic == CFG_SECTIONS_MAGIC;
+	for (i = 0; i < CFG_SECTION_COUNT; i++) {
+		if (bHasDirectory) {
+			// 0 - section was added after this config was saved
+			versions[i] = i < g_cfg.sections.count ? g_cfg.sections.versions[i] : 0;
+		}
+		else if (g_cfg.version < 3) {
+			versions[i] = 1;
+		}
+		else {
+			versions[i] = g_cfgSections[i].legacyVersion;
+		}
+	}
+	// journal is only used after image with directory was written,
+	// so old configs are converted with the first full save
+	if (bHasDirectory && HAL_Configuration_GetConfigAreaSize() > CFG_JOURNAL_START) {
+		CFG_Sections_ReplayJournal(versions);
+	}
+	for (i = 0; i < CFG_SECTION_COUNT; i++) {
+		s = &g_cfgSections[i];
+		if (versions[i] < s->version) {
+			addLogAdv(LOG_INFO, LOG_FEATURE_CFG, "CFG_InitAndLoad: section %s updated from v%i to v%i", s->name, versions[i], s->version);
+			if (s->migrate) {
+				s->migrate(versions[i]);
+			}
+			CFG_MarkSectionChanged(i);
+		}
+	}
+}
+static void CFG_Sections_AppendRecords() {
+	const cfgSection_t *s;
+	cfgRecordHeader_t h;
+	const byte *data;
+	int i;
+
+	for (i = 0; i < CFG_SECTION_COUNT; i++) {
+		if ((g_cfgDirtySections & (1 << i)) == 0) {
+			continue;
+		}
+		s = &g_cfgSections[i];
+		data = ((const byte*)&g_cfg) + s->offset;
+		h.magic = CFG_RECORD_MAGIC;
+		h.tag = i;
+		h.version = s->version;
+		h.length = s->size;
+		h.crc = CFG_Sections_CalcRecordCRC(&h, 0, data);
+		HAL_Configuration_WriteConfigArea(g_cfgJournalOffset, &h, sizeof(h));
+		HAL_Configuration_WriteConfigArea(g_cfgJournalOffset + sizeof(h), data, s->size);
+		g_cfgJournalOffset += CFG_RECORD_SIZE(s->size);
+		g_cfgSaveStats.sectionWrites++;
+		g_cfgSaveStats.bytesWritten += sizeof(h) + s->size;
+	}
+}
+static void CFG_Sections_Save() {
+	int i, needed;
+
+	// not every writer of g_cfg marks its section (or even pending change),
+	// so whole config is compared with what is in flash
+	for (i = 0; i < CFG_SECTION_COUNT; i++) {
+		if (CFG_Sections_CalcSectionCRC32(i) != g_cfgSectionSaved[i]) {
+			g_cfgDirtySections |= (1 << i);
+		}
+	}
+	needed = 0;
+	for (i = 0; i < CFG_SECTION_COUNT; i++) {
+		if (g_cfgDirtySections & (1 << i)) {
+			CFG_Sections_UpdateCRC(i);
+			needed += CFG_RECORD_SIZE(g_cfgSections[i].size);
+		}
+	}
+	if (g_cfgJournalOffset && g_cfgJournalOffset + needed <= HAL_Configuration_GetConfigAreaSize()) {
+		CFG_Sections_AppendRecords();
+		g_cfg.crc = CFG_Sections_CalcChecksum();
+	}
+	else {
+		// rewriting everything, so also catch changes that were not reported at all
+		CFG_Sections_UpdateAllCRCs();
+		g_cfg.sections.magic = CFG_SECTIONS_MAGIC;
+		g_cfg.sections.count = CFG_SECTION_COUNT;
+		memset(g_cfg.sections.reserved, 0, sizeof(g_cfg.sections.reserved));
+		memset(g_cfg.sections.versions, 0, sizeof(g_cfg.sections.versions));
+		for (i = 0; i < CFG_SECTION_COUNT; i++) {
+			g_cfg.sections.versions[i] = g_cfgSections[i].version;
+		}
+		g_cfg.crc = CFG_Sections_CalcChecksum();
+		HAL_Configuration_SaveConfigMemory(&g_cfg, sizeof(g_cfg));
+		g_cfgSaveStats.fullSaves++;
+		g_cfgSaveStats.bytesWritten += sizeof(g_cfg);
+		g_cfgJournalOffset = 0;
+		if (HAL_Configuration_GetConfigAreaSize() > CFG_JOURNAL_START) {
+			g_cfgJournalOffset = CFG_JOURNAL_START;
+		}
+	}
+	g_cfgDirtySections = 0;
+}
 void CFG_SetDefaultConfig() {
 	// must be unsigned, else print below prints negatives as e.g. FFFFFFFe
 	unsigned char mac[6] = { 0 };
@@ -121,6 +406,7 @@ void CFG_SetDefaultConfig() {
 	g_configInitialized = 1;
 
 	memset(&g_cfg,0,sizeof(mainConfig_t));
+	PIN_InvalidatePinLists();
 	g_cfg.version = MAIN_CFG_VERSION;
 	g_cfg.mqtt_port = 1883;
 	g_cfg.ident0 = CFG_IDENT_0;
@@ -157,6 +443,7 @@ void CFG_SetDefaultConfig() {
 	// This is helpful for users
 	CFG_SetFlag(OBK_FLAG_MQTT_BROADCASTSELFSTATEONCONNECT,true);
 
+	CFG_Sections_Reset();
 	g_cfg_pendingChanges++;
 }
 
@@ -173,7 +460,7 @@ void CFG_SetBootOkSeconds(int v) {
 		v = 1;
 	if(g_cfg.timeRequiredToMarkBootSuccessfull != v) {
 		g_cfg.timeRequiredToMarkBootSuccessfull = v;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_PING);
 	}
 }
 int CFG_GetBootOkSeconds() {
@@ -198,21 +485,21 @@ void CFG_SetPingHost(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.ping_host, s,sizeof(g_cfg.ping_host))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_PING);
 	}
 }
 void CFG_SetPingDisconnectedSecondsToRestart(int i) {
 	if(g_cfg.ping_seconds != i) {
 		g_cfg.ping_seconds = i;
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_PING);
 	}
 }
 void CFG_SetPingIntervalSeconds(int i) {
 	if(g_cfg.ping_interval != i) {
 		g_cfg.ping_interval = i;
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_PING);
 	}
 }
 void CFG_SetShortStartupCommand_AndExecuteNow(const char *s) {
@@ -223,14 +510,14 @@ void CFG_SetShortStartupCommand(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.initCommandLine, s,sizeof(g_cfg.initCommandLine))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_STARTUP);
 	}
 }
 int CFG_SetWebappRoot(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.webappRoot, s,sizeof(g_cfg.webappRoot))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_DEVICE);
 	}
 	return 1;
 }
@@ -253,14 +540,14 @@ void CFG_SetShortDeviceName(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.shortDeviceName, s,sizeof(g_cfg.shortDeviceName))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_DEVICE);
 	}
 }
 void CFG_SetDeviceName(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.longDeviceName, s,sizeof(g_cfg.longDeviceName))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_DEVICE);
 	}
 }
 void CFG_SetMQTTPort(int p) {
@@ -268,7 +555,7 @@ void CFG_SetMQTTPort(int p) {
 	if(g_cfg.mqtt_port != p) {
 		g_cfg.mqtt_port = p;
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_MQTT);
 	}
 }
 void CFG_SetOpenAccessPoint() {
@@ -279,7 +566,7 @@ void CFG_SetOpenAccessPoint() {
 	g_cfg.wifi_ssid[0] = 0;
 	g_cfg.wifi_pass[0] = 0;
 	// mark as dirty (value has changed)
-	g_cfg_pendingChanges++;
+	CFG_MarkSectionChanged(CFG_SECTION_WIFI);
 }
 const char *CFG_GetWiFiSSID(){
 	return g_cfg.wifi_ssid;
@@ -295,7 +582,7 @@ void CFG_SetWiFiSSID(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.wifi_ssid, s,sizeof(g_cfg.wifi_ssid))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_WIFI);
 	}
 }
 void CFG_SetWiFiPass(const char *s) {
@@ -307,7 +594,7 @@ void CFG_SetWiFiPass(const char *s) {
 	if(memcmp(g_cfg.wifi_pass, s, len)) {
 		memcpy(g_cfg.wifi_pass, s, len);
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_WIFI);
 	}
 }
 const char *CFG_GetMQTTHost() {
@@ -329,57 +616,58 @@ void CFG_SetMQTTHost(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.mqtt_host, s,sizeof(g_cfg.mqtt_host))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_MQTT);
 	}
 }
 void CFG_SetMQTTClientId(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.mqtt_clientId, s,sizeof(g_cfg.mqtt_clientId))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_MQTT);
 	}
 }
 void CFG_SetMQTTGroupTopic(const char *s) {
 	// this will return non-zero if there were any changes
 	if (strcpy_safe_checkForChanges(g_cfg.mqtt_group, s, sizeof(g_cfg.mqtt_group))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_MQTT_GROUP);
 	}
 }
 void CFG_SetMQTTUserName(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.mqtt_userName, s,sizeof(g_cfg.mqtt_userName))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_MQTT);
 	}
 }
 void CFG_SetMQTTPass(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.mqtt_pass, s,sizeof(g_cfg.mqtt_pass))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_MQTT);
 	}
 }
 void CFG_ClearPins() {
 	memset(&g_cfg.pins,0,sizeof(g_cfg.pins));
-	g_cfg_pendingChanges++;
+	CFG_MarkSectionChanged(CFG_SECTION_PINS);
+	PIN_InvalidatePinLists();
 }
 void CFG_IncrementOTACount() {
 	g_cfg.otaCounter++;
-	g_cfg_pendingChanges++;
+	CFG_MarkSectionChanged(CFG_SECTION_SYSTEM);
 }
 void CFG_SetMac(char *mac) {
 	if(memcmp(mac,g_cfg.mac,6)) {
 		memcpy(g_cfg.mac,mac,6);
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_DEVICE);
 	}
 }
 void CFG_Save_IfThereArePendingChanges() {
 	if(g_cfg_pendingChanges > 0) {
 		g_cfg.version = MAIN_CFG_VERSION;
 		g_cfg.changeCounter++;
-		g_cfg.crc = CFG_CalcChecksum(&g_cfg);
-		HAL_Configuration_SaveConfigMemory(&g_cfg,sizeof(g_cfg));
+		g_cfgDirtySections |= (1 << CFG_SECTION_SYSTEM);
+		CFG_Sections_Save();
 		g_cfg_pendingChanges = 0;
 	}
 }
@@ -387,19 +675,19 @@ void CFG_DeviceGroups_SetName(const char *s) {
 	// this will return non-zero if there were any changes
 	if(strcpy_safe_checkForChanges(g_cfg.dgr_name, s,sizeof(g_cfg.dgr_name))) {
 		// mark as dirty (value has changed)
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_DGR);
 	}
 }
 void CFG_DeviceGroups_SetSendFlags(int newSendFlags) {
 	if(g_cfg.dgr_sendFlags != newSendFlags) {
 		g_cfg.dgr_sendFlags = newSendFlags;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_DGR);
 	}
 }
 void CFG_DeviceGroups_SetRecvFlags(int newRecvFlags) {
 	if(g_cfg.dgr_recvFlags != newRecvFlags) {
 		g_cfg.dgr_recvFlags = newRecvFlags;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_DGR);
 	}
 }
 const char *CFG_DeviceGroups_GetName() {
@@ -415,7 +703,7 @@ void CFG_SetFlags(int first4bytes, int second4bytes) {
 	if (g_cfg.genericFlags != first4bytes || g_cfg.genericFlags2 != second4bytes) {
 		g_cfg.genericFlags = first4bytes;
 		g_cfg.genericFlags2 = second4bytes;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_SYSTEM);
 	}
 }
 void CFG_SetFlag(int flag, bool bValue) {
@@ -436,7 +724,7 @@ void CFG_SetFlag(int flag, bool bValue) {
 	}
 	if(nf != *cfgValue) {
 		*cfgValue = nf;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_SYSTEM);
 		// this will start only if it wasnt running
 		if(bValue && flag == OBK_FLAG_CMD_ENABLETCPRAWPUTTYSERVER) {
 			CMD_StartTCPCommandLine();
@@ -461,7 +749,7 @@ void CFG_SetChannelStartupValue(int channelIndex,short newValue) {
 	}
 	if(g_cfg.startChannelValues[channelIndex] != newValue) {
 		g_cfg.startChannelValues[channelIndex] = newValue;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_CHANNELS);
 	}
 }
 short CFG_GetChannelStartupValue(int channelIndex) {
@@ -481,8 +769,9 @@ void PIN_SetPinChannelForPinIndex(int index, int ch) {
 		return;
 	}
 	if(g_cfg.pins.channels[index] != ch) {
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_PINS);
 		g_cfg.pins.channels[index] = ch;
+		PIN_InvalidatePinLists();
 	}
 }
 void PIN_SetPinChannel2ForPinIndex(int index, int ch) {
@@ -491,8 +780,9 @@ void PIN_SetPinChannel2ForPinIndex(int index, int ch) {
 		return;
 	}
 	if(g_cfg.pins.channels2[index] != ch) {
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_PINS);
 		g_cfg.pins.channels2[index] = ch;
+		PIN_InvalidatePinLists();
 	}
 }
 //void CFG_ApplyStartChannelValues() {
@@ -511,7 +801,7 @@ const char *CFG_GetNTPServer() {
 }
 void CFG_SetNTPServer(const char *s) {	
 	if(strcpy_safe_checkForChanges(g_cfg.ntpServer, s,sizeof(g_cfg.ntpServer))) {
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_NTP);
 	}
 }
 int CFG_GetPowerMeasurementCalibrationInteger(int index, int def) {
@@ -523,7 +813,7 @@ int CFG_GetPowerMeasurementCalibrationInteger(int index, int def) {
 void CFG_SetPowerMeasurementCalibrationInteger(int index, int value) {
 	if(g_cfg.cal.values[index].i != value) {
 		g_cfg.cal.values[index].i = value;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_POWER);
 	}
 }
 float CFG_GetPowerMeasurementCalibrationFloat(int index, float def) {
@@ -535,25 +825,25 @@ float CFG_GetPowerMeasurementCalibrationFloat(int index, float def) {
 void CFG_SetPowerMeasurementCalibrationFloat(int index, float value) {
 	if(g_cfg.cal.values[index].f != value) {
 		g_cfg.cal.values[index].f = value;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_POWER);
 	}
 }
 void CFG_SetButtonLongPressTime(int value) {
 	if(g_cfg.buttonLongPress != value) {
 		g_cfg.buttonLongPress = value;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_BUTTONS);
 	}
 }
 void CFG_SetButtonShortPressTime(int value) {
 	if(g_cfg.buttonShortPress != value) {
 		g_cfg.buttonShortPress = value;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_BUTTONS);
 	}
 }
 void CFG_SetButtonRepeatPressTime(int value) {
 	if(g_cfg.buttonHoldRepeat != value) {
 		g_cfg.buttonHoldRepeat = value;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_BUTTONS);
 	}
 }
 
@@ -561,7 +851,7 @@ void CFG_SetButtonRepeatPressTime(int value) {
 void CFG_SetLFS_Size(uint32_t value) {
 	if(g_cfg.LFS_Size != value) {
 		g_cfg.LFS_Size = value;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_LFS);
 	}
 }
 
@@ -578,7 +868,15 @@ void CFG_InitAndLoad() {
 	byte chkSum;
 
 	HAL_Configuration_ReadConfigMemory(&g_cfg,sizeof(g_cfg));
-	chkSum = CFG_CalcChecksum(&g_cfg);
+	PIN_InvalidatePinLists();
+	// section CRCs are needed later anyway, so whole CRC is made from them
+	CFG_Sections_UpdateAllCRCs();
+	if (g_cfg.version <= 1) {
+		chkSum = CFG_CalcChecksum(&g_cfg);
+	}
+	else {
+		chkSum = CFG_Sections_CalcChecksum();
+	}
 	if(g_cfg.ident0 != CFG_IDENT_0 || g_cfg.ident1 != CFG_IDENT_1 || g_cfg.ident2 != CFG_IDENT_2
 		|| chkSum != g_cfg.crc) {
 			addLogAdv(LOG_WARN, LOG_FEATURE_CFG, "CFG_InitAndLoad: Config crc or ident mismatch. Default config will be loaded.");
@@ -590,14 +888,8 @@ void CFG_InitAndLoad() {
 		WiFI_SetMacAddress(g_cfg.mac);
 #endif
 		addLogAdv(LOG_WARN, LOG_FEATURE_CFG, "CFG_InitAndLoad: Correct config has been loaded with %i changes count.",g_cfg.changeCounter);
-	}
-
-	// copy shortDeviceName to MQTT Client ID, set version=3
-	if (g_cfg.version<3) {
-		addLogAdv(LOG_WARN, LOG_FEATURE_CFG, "CFG_InitAndLoad: Old config version found, updating to v3.");
-		strcpy_safe(g_cfg.mqtt_clientId, g_cfg.shortDeviceName, sizeof(g_cfg.mqtt_clientId));
-		g_cfg.version = 3;
-		g_cfg_pendingChanges++;
+		// replays journal and upgrades old sections
+		CFG_Sections_Load();
 	}
 
 	if(g_cfg.buttonHoldRepeat == 0) {
@@ -8,6 +8,40 @@
 
 extern int g_cfg_pendingChanges;
 
+// Config is split into sections, each with its own version, dirty flag and CRC.
+// Only changed sections are written on save, see g_cfgSections in new_cfg.c.
+// Order must match g_cfgSections, indexes are stored in flash.
+enum cfgSection_e {
+	CFG_SECTION_SYSTEM,
+	CFG_SECTION_WIFI,
+	CFG_SECTION_MQTT,
+	CFG_SECTION_DEVICE,
+	CFG_SECTION_PINS,
+	CFG_SECTION_CHANNELS,
+	CFG_SECTION_DGR,
+	CFG_SECTION_NTP,
+	CFG_SECTION_POWER,
+	CFG_SECTION_BUTTONS,
+	CFG_SECTION_LFS,
+	CFG_SECTION_MQTT_GROUP,
+	CFG_SECTION_PING,
+	CFG_SECTION_STARTUP,
+	CFG_SECTION_COUNT,
+};
+
+typedef struct cfgSaveStats_s {
+	int fullSaves;
+	int sectionWrites;
+	int bytesWritten;
+	// journal offset and size, 0 if journal is not used
+	int journalUsed;
+	int journalSize;
+} cfgSaveStats_t;
+
+// use instead of g_cfg_pendingChanges++, so only this section is saved
+void CFG_MarkSectionChanged(int section);
+void CFG_GetSaveStats(cfgSaveStats_t *out);
+
 const char *CFG_GetDeviceName();
 const char *CFG_GetShortDeviceName();
 void CFG_SetShortDeviceName(const char *s);
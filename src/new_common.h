@@ -169,7 +169,8 @@ typedef unsigned short u16_t;
 typedef long portTickType;
 #define portTICK_PERIOD_MS 1
 #define configTICK_RATE_HZ 1
-typedef int SemaphoreHandle_t;
+// holds mutex HANDLE, must be pointer sized
+typedef intptr_t SemaphoreHandle_t;
 #define pdTRUE 1
 #define pdFALSE 0
 typedef int OSStatus;
@@ -182,6 +183,25 @@ typedef void * beken_thread_arg_t;
 typedef int (*beken_thread_function_t)(void *p);
 #define BEKEN_APPLICATION_PRIORITY 1
 
+// win32/stubs/win_rtos_stub.c
+SemaphoreHandle_t xSemaphoreCreateMutex();
+int xSemaphoreTake(SemaphoreHandle_t semaphore, int blockTime);
+int xSemaphoreGive(SemaphoreHandle_t semaphore);
+int rtos_create_thread(void *out, int prio, const char *name, void *function, int stackSize, void *arg);
+void rtos_delete_thread(void *thread);
+int rtos_delay_milliseconds(int ms);
+int delay_ms(int ms);
+int xTaskGetTickCount();
+int xPortGetFreeHeapSize();
+int lwip_fcntl(int s, int cmd, int val);
+int lwip_close(int socket);
+int lwip_close_force(int socket);
+int hal_machw_time();
+int hal_machw_time_past(int tt);
+void doNothing();
+// win_main.c
+int rtos_get_time();
+
 #elif PLATFORM_BL602
 
 #include <FreeRTOS.h>
@@ -391,8 +411,11 @@ int Main_HasMQTTConnected();
 int Main_HasWiFiConnected();
 int Main_GetLastRebootBootFailures();
 void Main_OnPingCheckerReply(int ms);
+void Main_OnWiFiStatusChange(int code);
+void QuickTick(void *param);
+void Main_ReconnectWiFi();
 
-// new_ping.c
+// new_ping_monitor.c
 void Main_SetupPingWatchDog(const char *target/*, int delayBetweenPings_Seconds*/);
 int PingWatchDog_GetTotalLost();
 int PingWatchDog_GetTotalReceived();
@@ -5,9 +5,9 @@
  *  Author: RICHARD
  */
 //
-//	TODO: convert it to structure-based code instead of using global variables
-// so we can have multiple ping instances running.
-// One ping for "ping watchdog", second ran from console by user, etc etc
+// lwIP raw PCB backend of ping monitor, see new_ping.h and new_ping_monitor.c.
+// Monitor is ticked from lwIP timer, so sending and receiving is all done
+// in TCP/IP thread.
 //
 
 #include "lwip/mem.h"
@@ -15,6 +15,7 @@
 #include "lwip/icmp.h"
 #include "lwip/netif.h"
 #include "lwip/sys.h"
+#include "lwip/tcpip.h"
 #ifdef PLATFORM_XR809
 
 #else
@@ -27,172 +28,118 @@
 #include "lwip/inet.h"
 #include "logging/logging.h"
 #include "new_common.h"
+#include "new_ping.h"
 #include <string.h>
 
-#ifndef PING_DEBUG
-#define PING_DEBUG     LWIP_DBG_ON
-#endif
-
-#define PING_DELAY 1000
+// how often monitor checks for echoes to send and timeouts
+#define PING_TICK_MS 50
 
-/** ping identifier - must fit on a u16_t */
-#ifndef PING_ID
-#define PING_ID        0xAFAF
-#endif
-
-/** ping additional data size to include in the packet */
-#ifndef PING_DATA_SIZE
-#define PING_DATA_SIZE 32
-#endif
-
-/** ping result action - no default action */
-#ifndef PING_RESULT
-#define PING_RESULT(ping_ok)
-#endif
-
-static unsigned int ping_time;
-static ip_addr_t ping_target;
-static unsigned short ping_seq_num;
 static struct raw_pcb *ping_pcb;
-static unsigned int ping_lost = 0;
-static unsigned int ping_received = 0;
-static int bReceivedLastOneSend = -1;
-static bool ping_handler_active = false;
-static bool ping_handler_silent = false;
+// converted once, when target is added
+static ip_addr_t ping_addrs[PING_MAX_TARGETS];
 
-//static int g_delayBetweenPings_MS = 1000 / portTICK_PERIOD_MS;
+typedef struct ping_call_s {
+	void (*fn)(void *arg);
+	void *arg;
+	sys_sem_t done;
+} ping_call_t;
 
-static void ping_prepare_echo( struct icmp_echo_hdr *iecho, u16_t len)
+static void ping_tick(void *arg)
 {
-  size_t i;
-  size_t data_len = len - sizeof(struct icmp_echo_hdr);
-
-  ICMPH_TYPE_SET(iecho, ICMP_ECHO);
-  ICMPH_CODE_SET(iecho, 0);
-  iecho->chksum = 0;
-  iecho->id     = PING_ID;
-  iecho->seqno  = lwip_htons(++ping_seq_num);
-
-  /* fill the additional data buffer with some data */
-  for(i = 0; i < data_len; i++) {
-    ((char*)iecho)[sizeof(struct icmp_echo_hdr) + i] = (char)i;
-  }
-
-  iecho->chksum = inet_chksum(iecho, len);
+	Ping_RunTick(sys_now());
+	sys_timeout(PING_TICK_MS, ping_tick, arg);
 }
 
-static void ping_send(struct raw_pcb *raw, const ip_addr_t *addr)
+static u8_t ping_recv(void *arg, struct raw_pcb *pcb, struct pbuf *p, const ip_addr_t *addr)
 {
-  struct pbuf *p;
-  struct icmp_echo_hdr *iecho;
-  size_t ping_size = sizeof(struct icmp_echo_hdr) + PING_DATA_SIZE;
-
-  //LWIP_DEBUGF( PING_DEBUG, ("ping: send "));
-  //ip_addr_debug_print(PING_DEBUG, addr);
-  //LWIP_DEBUGF( PING_DEBUG, ("\n"));
-  LWIP_ASSERT("ping_size <= 0xffff", ping_size <= 0xffff);
-
-  p = pbuf_alloc(PBUF_IP, (u16_t)ping_size, PBUF_RAM);
-  if (!p) {
-    return;
-  }
-  if ((p->len == p->tot_len) && (p->next == NULL)) {
-    iecho = (struct icmp_echo_hdr *)p->payload;
-
-    ping_prepare_echo(iecho, (u16_t)ping_size);
-
-	if(bReceivedLastOneSend == 0) {
-		//addLogAdv(LOG_INFO,LOG_FEATURE_MAIN,"Ping lost: (total lost %i, recv %i)\r\n",ping_lost,ping_received);
-		ping_lost++;
-
+	byte packet[PBUF_IP_HLEN + PING_PACKET_SIZE];
+	int len;
+	LWIP_UNUSED_ARG(arg);
+	LWIP_UNUSED_ARG(pcb);
+	LWIP_UNUSED_ARG(addr);
+	LWIP_ASSERT("p != NULL", p != NULL);
+
+	if (p->tot_len < PBUF_IP_HLEN + 8) {
+		return 0; /* don't eat the packet */
 	}
-	bReceivedLastOneSend = 0;
+	len = p->tot_len < sizeof(packet) ? p->tot_len : sizeof(packet);
+	pbuf_copy_partial(p, packet, len, 0);
+	// source address is taken from IP header, same for every lwIP version
+	if (Ping_OnEchoReply(packet + 12, packet + PBUF_IP_HLEN, len - PBUF_IP_HLEN, sys_now())) {
+		pbuf_free(p);
+		return 1; /* eat the packet */
+	}
+	return 0; /* don't eat the packet */
+}
 
-    raw_sendto(raw, p, addr);
+int PingBackend_Open()
+{
+	if (ping_pcb != NULL) {
+		return 1;
+	}
+	ping_pcb = raw_new(IP_PROTO_ICMP);
+	if (ping_pcb == NULL) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Ping: raw_new failed\n");
+		return 0;
+	}
+	raw_recv(ping_pcb, ping_recv, NULL);
+	raw_bind(ping_pcb, IP_ADDR_ANY);
+	sys_timeout(PING_TICK_MS, ping_tick, ping_pcb);
+	return 1;
+}
 
-    ping_time = sys_now();
+static void ping_call(void *arg)
+{
+	ping_call_t *c = (ping_call_t*)arg;
 
-  }
-  pbuf_free(p);
+	c->fn(c->arg);
+	sys_sem_signal(&c->done);
 }
 
-static void ping_timeout(void *arg)
+void PingBackend_Call(void (*fn)(void *arg), void *arg)
 {
-  struct raw_pcb *pcb = (struct raw_pcb*)arg;
+	ping_call_t c;
 
- // if (ping_handler_silent == false)
-  {
-    LWIP_ASSERT("ping_timeout: no pcb given!", pcb != NULL);
-
-    ping_send(pcb, &ping_target);
-  }
-  // void 	sys_timeout (u32_t msecs, sys_timeout_handler handler, void *arg)
-  sys_timeout(PING_DELAY, ping_timeout, pcb);
+	c.fn = fn;
+	c.arg = arg;
+	if (sys_sem_new(&c.done, 0) != ERR_OK) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Ping: sys_sem_new failed\n");
+		return;
+	}
+	// raw PCB, timer and targets are only touched in TCP/IP thread
+	if (tcpip_callback(ping_call, &c) == ERR_OK) {
+		sys_sem_wait(&c.done);
+	} else {
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Ping: tcpip_callback failed\n");
+	}
+	sys_sem_free(&c.done);
 }
 
-static u8_t ping_recv(void *arg, struct raw_pcb *pcb, struct pbuf *p, const ip_addr_t *addr)
+uint32_t PingBackend_GetTime()
 {
-	unsigned int ms;
-  struct icmp_echo_hdr *iecho;
-  LWIP_UNUSED_ARG(arg);
-  LWIP_UNUSED_ARG(pcb);
-  LWIP_UNUSED_ARG(addr);
-  LWIP_ASSERT("p != NULL", p != NULL);
-
-  if ((p->tot_len >= (PBUF_IP_HLEN + sizeof(struct icmp_echo_hdr))) &&
-      pbuf_header(p, -PBUF_IP_HLEN) == 0) {
-    iecho = (struct icmp_echo_hdr *)p->payload;
-
-    if ((iecho->id == PING_ID) && (iecho->seqno == lwip_htons(ping_seq_num))) {
-    //  LWIP_DEBUGF( PING_DEBUG, ("ping: recv "));
-    // ip_addr_debug_print(PING_DEBUG, addr);
-	  ms = (sys_now()-ping_time);
-    //  LWIP_DEBUGF( PING_DEBUG, (" %"U32_F" ms\n", ms));
-	  ping_received++;
-	bReceivedLastOneSend = 1;
-
-	//addLogAdv(LOG_INFO,LOG_FEATURE_MAIN,"Ping recv: %ims (total lost %i, recv %i)\r\n", ms,ping_lost,ping_received);
-
-	//  addLogAdv(LOG_INFO,LOG_FEATURE_MAIN,"Ping recv: %ims\r\n", ms);
-	Main_OnPingCheckerReply(ms);
-      PING_RESULT(1);
-      pbuf_free(p);
-      return 1; /* eat the packet */
-    }
-    /* not eaten, restore original packet */
-    pbuf_header(p, PBUF_IP_HLEN);
-  }
-
-  return 0; /* don't eat the packet */
+	return sys_now();
 }
 
-int PingWatchDog_GetTotalLost() {
-	return ping_lost;
-}
-int PingWatchDog_GetTotalReceived() {
-	return ping_received;
+void PingBackend_SetTarget(int index, const byte *ip)
+{
+#ifdef IP_ADDR4
+	IP_ADDR4(&ping_addrs[index], ip[0], ip[1], ip[2], ip[3]);
+#else
+	IP4_ADDR(&ping_addrs[index], ip[0], ip[1], ip[2], ip[3]);
+#endif
 }
 
-void Main_SetupPingWatchDog(const char *target/*, int delayBetweenPings_Seconds*/) 
+int PingBackend_Send(int index, const byte *packet, int len)
 {
-	// none sent yet.
-	bReceivedLastOneSend = -1;
-    if (ping_handler_active == false)
-    {
-    	//g_delayBetweenPings_MS = delayBetweenPings_Seconds * 1000;
-        ///ipaddr_aton("192.168.0.1",&ping_target)
-        //ipaddr_aton("8.8.8.8",&ping_target);
-        ipaddr_aton(target,&ping_target);
-
-        ping_pcb = raw_new(IP_PROTO_ICMP);
-        LWIP_ASSERT("ping_pcb != NULL", ping_pcb != NULL);
-
-        raw_recv(ping_pcb, ping_recv, NULL);
-        raw_bind(ping_pcb, IP_ADDR_ANY);
-	    // void 	sys_timeout (u32_t msecs, sys_timeout_handler handler, void *arg)
-        sys_timeout(PING_DELAY, ping_timeout, ping_pcb);
-		ping_handler_active = true;
-    }
+	struct pbuf *p;
+	err_t err;
 
+	p = pbuf_alloc(PBUF_IP, (u16_t)len, PBUF_RAM);
+	if (!p) {
+		return 0;
+	}
+	pbuf_take(p, packet, len);
+	err = raw_sendto(ping_pcb, p, &ping_addrs[index]);
+	pbuf_free(p);
+	return err == ERR_OK;
 }
-
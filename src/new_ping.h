@@ -0,0 +1,117 @@
+#ifndef __NEW_PING_H__
+#define __NEW_PING_H__
+
+#include "new_common.h"
+#include "httpserver/new_http.h"
+
+// ICMP health monitor - few targets, each pinged with its own interval.
+// For every target it keeps rolling loss (last PING_LOSS_WINDOW echoes),
+// RTT min/avg/max (last PING_RTT_WINDOW replies) and jitter (RFC 3550).
+// When loss or average RTT goes over threshold, target is in alarm
+// and configured actions are done (event, WiFi reconnect, reboot).
+// Results are available via /api/ping and ping_info.
+//
+// Sending and receiving is done by backend, lwIP raw PCB on devices
+// (new_ping.c), simulated network on Windows (new_ping_sim.c).
+// Backend calls Ping_RunTick and Ping_OnEchoReply, both from same thread,
+// and targets are added and removed in that thread too.
+
+#define PING_MAX_TARGETS	4
+#define PING_DATA_SIZE		32
+// ICMP echo header and data, without IP header
+#define PING_PACKET_SIZE	(8 + PING_DATA_SIZE)
+// identifier of target N is PING_ID + N
+#define PING_ID				0xAFAF
+#define PING_LOSS_WINDOW	32
+#define PING_RTT_WINDOW		16
+// reply that comes later than that (or after interval, if it's shorter) is lost
+#define PING_MAX_TIMEOUT	2000
+#define PING_MIN_INTERVAL	100
+
+// actions done when target goes into alarm, can be combined
+#define PING_ACTION_EVENT		1
+#define PING_ACTION_RECONNECT	2
+#define PING_ACTION_REBOOT		4
+
+typedef struct pingTarget_s {
+	byte ip[4];
+	byte bActive;
+	// legacy ping watchdog target, see Main_SetupPingWatchDog
+	byte bWatchDog;
+	// echo was sent, still waiting for reply
+	byte bWaiting;
+	byte bAlarm;
+	byte actions;
+	unsigned short seq;
+	int interval;
+	int timeout;
+	uint32_t nextSend;
+	uint32_t sentAt;
+	// 1 - lost, newest echo in bit 0, lossCount bits are valid
+	uint32_t lossBits;
+	byte lossCount;
+	byte rttPos;
+	byte rttCount;
+	unsigned short rtt[PING_RTT_WINDOW];
+	int lastRtt;
+	// RFC 3550 interarrival jitter, scaled by 16
+	int jitter16;
+	uint32_t sent;
+	uint32_t received;
+	uint32_t lost;
+	// percent and ms, 0 - not checked
+	int lossThreshold;
+	int rttThreshold;
+	int alarms;
+	// prebuilt echo request, only sequence number and checksum change
+	byte echo[PING_PACKET_SIZE];
+} pingTarget_t;
+
+// new_ping_monitor.c
+void Ping_InitCommands();
+// returns target index or -1 if there is no free slot or IP is bad
+int Ping_AddTarget(const char *host, int intervalMs);
+bool Ping_RemoveTarget(const char *host);
+// removes all targets except ping watchdog one
+void Ping_ClearTargets();
+pingTarget_t *Ping_FindTarget(const char *host);
+int Ping_GetLossPercent(pingTarget_t *t);
+int Ping_GetAverageRtt(pingTarget_t *t);
+int Ping_GetMinRtt(pingTarget_t *t);
+int Ping_GetMaxRtt(pingTarget_t *t);
+int Ping_GetJitter(pingTarget_t *t);
+// checks thresholds and does actions, called from main loop every second
+void Ping_RunEverySecond();
+// sends echoes that are due and marks ones without reply as lost
+void Ping_RunTick(uint32_t nowMs);
+// ip - source of reply, icmp - ICMP header and data, returns 1 if reply was ours
+int Ping_OnEchoReply(const byte *ip, const byte *icmp, int len, uint32_t nowMs);
+// Internet checksum (RFC 1071) of data, big endian
+unsigned short Ping_Checksum(const byte *data, int len);
+// checksum after 16-bit field changed from oldValue to newValue, RFC 1624 eqn. 3
+unsigned short Ping_ChecksumUpdate(unsigned short checksum, unsigned short oldValue, unsigned short newValue);
+// all targets and statistics as JSON reply, used by /api/ping
+int Ping_WriteJSON(http_request_t *request);
+
+// backend, new_ping.c or new_ping_sim.c
+// returns 1 if backend is ready, it's called every time target is added
+int PingBackend_Open();
+// runs fn in thread that ticks monitor and waits for it, fn is not run if that fails
+void PingBackend_Call(void (*fn)(void *arg), void *arg);
+// address of target is converted once, when it's added; ip is 4 bytes in network order
+void PingBackend_SetTarget(int index, const byte *ip);
+// packet is ICMP echo request
+int PingBackend_Send(int index, const byte *packet, int len);
+// ms, same clock as time given to Ping_RunTick and Ping_OnEchoReply
+uint32_t PingBackend_GetTime();
+
+#ifdef WINDOWS
+// new_ping_sim.c, simulated hosts answer after rtt +/- jitter ms
+// and lose lossPercent of echoes, evenly spread
+void PingSim_SetHost(const char *host, int rtt, int jitter, int lossPercent);
+void PingSim_Reset();
+void PingSim_RunQuickTick();
+int PingSim_GetBadChecksums();
+#endif
+
+#endif // __NEW_PING_H__
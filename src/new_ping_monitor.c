@@ -0,0 +1,534 @@
+#include "new_common.h"
+#include "new_ping.h"
+#include "logging/logging.h"
+#include "cmnds/cmd_public.h"
+
+// see new_ping.h
+static pingTarget_t g_pingTargets[PING_MAX_TARGETS];
+// target needs that many echoes in window before it can go into (or out of) alarm
+#define PING_MIN_SAMPLES	4
+
+unsigned short Ping_Checksum(const byte *data, int len) {
+	uint32_t sum = 0;
+
+	while (len > 1) {
+		sum += (data[0] << 8) | data[1];
+		data += 2;
+		len -= 2;
+	}
+	if (len) {
+		sum += data[0] << 8;
+	}
+	while (sum >> 16) {
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	}
+	return ~sum & 0xFFFF;
+}
+// HC' = ~(~HC + ~m + m'), so only changed field is summed, not whole packet
+unsigned short Ping_ChecksumUpdate(unsigned short checksum, unsigned short oldValue, unsigned short newValue) {
+	uint32_t sum;
+
+	sum = (~checksum & 0xFFFF) + (~oldValue & 0xFFFF) + newValue;
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	return ~sum & 0xFFFF;
+}
+static bool Ping_ParseIP(const char *s, byte *ip) {
+	int a, b, c, d;
+	char extra;
+
+	if (s == 0 || sscanf(s, "%d.%d.%d.%d%c", &a, &b, &c, &d, &extra) != 4)
+		return false;
+	if (a < 0 || a > 255 || b < 0 || b > 255 || c < 0 || c > 255 || d < 0 || d > 255)
+		return false;
+	ip[0] = a;
+	ip[1] = b;
+	ip[2] = c;
+	ip[3] = d;
+	return true;
+}
+// echo request with ID of target and payload, checksum is computed once here
+static void Ping_BuildEcho(pingTarget_t *t, int index) {
+	unsigned short id = PING_ID + index;
+	unsigned short sum;
+	int i;
+
+	memset(t->echo, 0, sizeof(t->echo));
+	// ICMP echo request, code 0
+	t->echo[0] = 8;
+	t->echo[4] = id >> 8;
+	t->echo[5] = id & 0xFF;
+	t->echo[6] = t->seq >> 8;
+	t->echo[7] = t->seq & 0xFF;
+	for (i = 0; i < PING_DATA_SIZE; i++) {
+		t->echo[8 + i] = i;
+	}
+	sum = Ping_Checksum(t->echo, PING_PACKET_SIZE);
+	t->echo[2] = sum >> 8;
+	t->echo[3] = sum & 0xFF;
+}
+static void Ping_ResetWindow(pingTarget_t *t) {
+	t->lossBits = 0;
+	t->lossCount = 0;
+	t->rttPos = 0;
+	t->rttCount = 0;
+	t->jitter16 = 0;
+	t->bWaiting = 0;
+}
+// Targets are added, changed and removed in backend thread (see PingBackend_Call),
+// so a slot is never cleared or reused while Ping_RunTick is reading it.
+typedef struct pingTargetCall_s {
+	byte ip[4];
+	int interval;
+	byte bWatchDog;
+	// index of target, -1 if it failed
+	int result;
+} pingTargetCall_t;
+
+static int Ping_FindTargetIndex(const byte *ip) {
+	int i;
+
+	for (i = 0; i < PING_MAX_TARGETS; i++) {
+		if (g_pingTargets[i].bActive && !memcmp(g_pingTargets[i].ip, ip, 4))
+			return i;
+	}
+	return -1;
+}
+pingTarget_t *Ping_FindTarget(const char *host) {
+	byte ip[4];
+	int i;
+
+	if (Ping_ParseIP(host, ip) == false)
+		return 0;
+	i = Ping_FindTargetIndex(ip);
+	return i >= 0 ? &g_pingTargets[i] : 0;
+}
+static void Ping_AddTargetCall(void *arg) {
+	pingTargetCall_t *c = (pingTargetCall_t*)arg;
+	pingTarget_t *t;
+	int i;
+
+	if (PingBackend_Open() == 0) {
+		return;
+	}
+	i = Ping_FindTargetIndex(c->ip);
+	if (i >= 0) {
+		t = &g_pingTargets[i];
+		t->interval = c->interval;
+		t->timeout = c->interval < PING_MAX_TIMEOUT ? c->interval : PING_MAX_TIMEOUT;
+		if (c->bWatchDog)
+			t->bWatchDog = 1;
+		c->result = i;
+		return;
+	}
+	for (i = 0; i < PING_MAX_TARGETS; i++) {
+		if (g_pingTargets[i].bActive == 0)
+			break;
+	}
+	if (i == PING_MAX_TARGETS) {
+		return;
+	}
+	t = &g_pingTargets[i];
+	memset(t, 0, sizeof(pingTarget_t));
+	memcpy(t->ip, c->ip, 4);
+	t->interval = c->interval;
+	t->timeout = c->interval < PING_MAX_TIMEOUT ? c->interval : PING_MAX_TIMEOUT;
+	t->nextSend = PingBackend_GetTime();
+	t->bWatchDog = c->bWatchDog;
+	Ping_BuildEcho(t, i);
+	PingBackend_SetTarget(i, t->ip);
+	t->bActive = 1;
+	c->result = i;
+}
+static int Ping_AddTargetInternal(const char *host, int intervalMs, bool bWatchDog) {
+	pingTargetCall_t c;
+
+	if (Ping_ParseIP(host, c.ip) == false) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Ping: bad IP %s\n", host);
+		return -1;
+	}
+	if (intervalMs < PING_MIN_INTERVAL)
+		intervalMs = PING_MIN_INTERVAL;
+	c.interval = intervalMs;
+	c.bWatchDog = bWatchDog;
+	c.result = -1;
+	PingBackend_Call(Ping_AddTargetCall, &c);
+	if (c.result < 0) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Ping: can't add %s, no free slot or no backend\n", host);
+	}
+	return c.result;
+}
+int Ping_AddTarget(const char *host, int intervalMs) {
+	return Ping_AddTargetInternal(host, intervalMs, false);
+}
+static void Ping_RemoveTargetCall(void *arg) {
+	pingTargetCall_t *c = (pingTargetCall_t*)arg;
+
+	c->result = Ping_FindTargetIndex(c->ip);
+	if (c->result >= 0)
+		g_pingTargets[c->result].bActive = 0;
+}
+bool Ping_RemoveTarget(const char *host) {
+	pingTargetCall_t c;
+
+	if (Ping_ParseIP(host, c.ip) == false)
+		return false;
+	c.result = -1;
+	PingBackend_Call(Ping_RemoveTargetCall, &c);
+	return c.result >= 0;
+}
+static void Ping_ClearTargetsCall(void *arg) {
+	int i;
+
+	for (i = 0; i < PING_MAX_TARGETS; i++) {
+		if (g_pingTargets[i].bWatchDog == 0)
+			g_pingTargets[i].bActive = 0;
+	}
+}
+void Ping_ClearTargets() {
+	PingBackend_Call(Ping_ClearTargetsCall, 0);
+}
+
+int Ping_GetLossPercent(pingTarget_t *t) {
+	uint32_t bits;
+	int lost;
+
+	if (t->lossCount == 0)
+		return 0;
+	bits = t->lossBits;
+	if (t->lossCount < PING_LOSS_WINDOW)
+		bits &= (1u << t->lossCount) - 1;
+	for (lost = 0; bits; bits &= bits - 1) {
+		lost++;
+	}
+	return lost * 100 / t->lossCount;
+}
+int Ping_GetAverageRtt(pingTarget_t *t) {
+	int i, sum;
+
+	if (t->rttCount == 0)
+		return 0;
+	sum = 0;
+	for (i = 0; i < t->rttCount; i++) {
+		sum += t->rtt[i];
+	}
+	return sum / t->rttCount;
+}
+int Ping_GetMinRtt(pingTarget_t *t) {
+	int i, r;
+
+	r = t->rttCount ? t->rtt[0] : 0;
+	for (i = 1; i < t->rttCount; i++) {
+		if (t->rtt[i] < r)
+			r = t->rtt[i];
+	}
+	return r;
+}
+int Ping_GetMaxRtt(pingTarget_t *t) {
+	int i, r;
+
+	r = 0;
+	for (i = 0; i < t->rttCount; i++) {
+		if (t->rtt[i] > r)
+			r = t->rtt[i];
+	}
+	return r;
+}
+int Ping_GetJitter(pingTarget_t *t) {
+	return (t->jitter16 + 8) >> 4;
+}
+
+static void Ping_AddResult(pingTarget_t *t, bool bLost) {
+	t->lossBits = (t->lossBits << 1) | (bLost ? 1 : 0);
+	if (t->lossCount < PING_LOSS_WINDOW)
+		t->lossCount++;
+	if (bLost)
+		t->lost++;
+}
+static void Ping_AddRtt(pingTarget_t *t, int rtt) {
+	int d;
+
+	if (t->received) {
+		d = rtt - t->lastRtt;
+		if (d < 0)
+			d = -d;
+		t->jitter16 += d - ((t->jitter16 + 8) >> 4);
+	}
+	t->lastRtt = rtt;
+	t->rtt[t->rttPos] = rtt > 0xFFFF ? 0xFFFF : rtt;
+	t->rttPos = (t->rttPos + 1) % PING_RTT_WINDOW;
+	if (t->rttCount < PING_RTT_WINDOW)
+		t->rttCount++;
+	t->received++;
+}
+static void Ping_Send(pingTarget_t *t, uint32_t nowMs) {
+	unsigned short sum;
+	unsigned short seq;
+
+	seq = t->seq + 1;
+	sum = (t->echo[2] << 8) | t->echo[3];
+	sum = Ping_ChecksumUpdate(sum, t->seq, seq);
+	t->seq = seq;
+	t->echo[2] = sum >> 8;
+	t->echo[3] = sum & 0xFF;
+	t->echo[6] = seq >> 8;
+	t->echo[7] = seq & 0xFF;
+	t->sentAt = nowMs;
+	t->bWaiting = 1;
+	t->sent++;
+	// if it can't be sent, it's lost on timeout like any other
+	PingBackend_Send(t - g_pingTargets, t->echo, PING_PACKET_SIZE);
+}
+void Ping_RunTick(uint32_t nowMs) {
+	pingTarget_t *t;
+	int i;
+
+	for (i = 0; i < PING_MAX_TARGETS; i++) {
+		t = &g_pingTargets[i];
+		if (t->bActive == 0)
+			continue;
+		if (t->bWaiting && nowMs - t->sentAt >= t->timeout) {
+			t->bWaiting = 0;
+			Ping_AddResult(t, true);
+		}
+		if ((int)(nowMs - t->nextSend) < 0)
+			continue;
+		t->nextSend += t->interval;
+		// long stall, don't send burst to catch up
+		if ((int)(nowMs - t->nextSend) >= 0)
+			t->nextSend = nowMs + t->interval;
+		// no network, don't count as loss
+		if (Main_HasWiFiConnected() == 0)
+			continue;
+		Ping_Send(t, nowMs);
+	}
+}
+int Ping_OnEchoReply(const byte *ip, const byte *icmp, int len, uint32_t nowMs) {
+	pingTarget_t *t;
+	int index;
+	int rtt;
+
+	// ICMP echo reply
+	if (len < 8 || icmp[0] != 0)
+		return 0;
+	index = ((icmp[4] << 8) | icmp[5]) - PING_ID;
+	if (index < 0 || index >= PING_MAX_TARGETS)
+		return 0;
+	t = &g_pingTargets[index];
+	if (t->bActive == 0 || memcmp(t->ip, ip, 4))
+		return 0;
+	// late or duplicated reply
+	if (t->bWaiting == 0 || ((icmp[6] << 8) | icmp[7]) != t->seq)
+		return 1;
+	t->bWaiting = 0;
+	rtt = nowMs - t->sentAt;
+	Ping_AddResult(t, false);
+	Ping_AddRtt(t, rtt);
+	if (t->bWatchDog) {
+		Main_OnPingCheckerReply(rtt);
+	}
+	return 1;
+}
+
+// window is updated by Ping_RunTick, so it's cleared in backend thread too
+static void Ping_RestartTargetCall(void *arg) {
+	pingTarget_t *t = (pingTarget_t*)arg;
+
+	Ping_ResetWindow(t);
+	t->bAlarm = 0;
+}
+static bool Ping_IsOverThreshold(pingTarget_t *t) {
+	if (t->lossThreshold && Ping_GetLossPercent(t) >= t->lossThreshold)
+		return true;
+	if (t->rttThreshold && t->rttCount && Ping_GetAverageRtt(t) >= t->rttThreshold)
+		return true;
+	return false;
+}
+static void Ping_OnAlarm(pingTarget_t *t) {
+	addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Ping: %i.%i.%i.%i alarm, loss %i%%, avg %ims\n",
+		t->ip[0], t->ip[1], t->ip[2], t->ip[3], Ping_GetLossPercent(t), Ping_GetAverageRtt(t));
+	t->alarms++;
+	if (t->actions & PING_ACTION_EVENT) {
+		EventHandlers_FireEvent(CMD_EVENT_PING_ALARM, t->ip[3]);
+	}
+	if (t->actions & PING_ACTION_REBOOT) {
+		RESET_ScheduleModuleReset(3);
+	}
+	if (t->actions & PING_ACTION_RECONNECT) {
+		Main_ReconnectWiFi();
+		// start over with fresh window, so it reconnects again if that didn't help
+		PingBackend_Call(Ping_RestartTargetCall, t);
+	}
+}
+void Ping_RunEverySecond() {
+	pingTarget_t *t;
+	bool bOver;
+	int i;
+
+	for (i = 0; i < PING_MAX_TARGETS; i++) {
+		t = &g_pingTargets[i];
+		if (t->bActive == 0 || t->lossCount < PING_MIN_SAMPLES)
+			continue;
+		if (t->lossThreshold == 0 && t->rttThreshold == 0)
+			continue;
+		bOver = Ping_IsOverThreshold(t);
+		if (bOver && t->bAlarm == 0) {
+			t->bAlarm = 1;
+			Ping_OnAlarm(t);
+		}
+		else if (bOver == false && t->bAlarm) {
+			t->bAlarm = 0;
+			addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Ping: %i.%i.%i.%i recovered\n",
+				t->ip[0], t->ip[1], t->ip[2], t->ip[3]);
+			if (t->actions & PING_ACTION_EVENT) {
+				EventHandlers_FireEvent(CMD_EVENT_PING_RECOVERED, t->ip[3]);
+			}
+		}
+	}
+}
+
+int Ping_WriteJSON(http_request_t *request) {
+	pingTarget_t *t;
+	int i, n;
+
+	http_setup(request, httpMimeTypeJson);
+	poststr(request, "{\"targets\":[");
+	n = 0;
+	for (i = 0; i < PING_MAX_TARGETS; i++) {
+		t = &g_pingTargets[i];
+		if (t->bActive == 0)
+			continue;
+		hprintf255(request, "%s{\"ip\":\"%i.%i.%i.%i\",\"interval\":%i,\"sent\":%u,\"received\":%u,\"lost\":%u,",
+			n ? "," : "", t->ip[0], t->ip[1], t->ip[2], t->ip[3], t->interval, t->sent, t->received, t->lost);
+		hprintf255(request, "\"loss\":%i,\"last\":%i,\"min\":%i,\"avg\":%i,\"max\":%i,\"jitter\":%i,\"alarm\":%i,\"alarms\":%i}",
+			Ping_GetLossPercent(t), t->lastRtt, Ping_GetMinRtt(t), Ping_GetAverageRtt(t), Ping_GetMaxRtt(t),
+			Ping_GetJitter(t), t->bAlarm, t->alarms);
+		n++;
+	}
+	poststr(request, "]}");
+	poststr(request, NULL);
+	return 0;
+}
+
+// legacy ping watchdog, see user_main.c
+void Main_SetupPingWatchDog(const char *target) {
+	Ping_AddTargetInternal(target, 1000, true);
+}
+static pingTarget_t *Ping_GetWatchDogTarget() {
+	int i;
+
+	for (i = 0; i < PING_MAX_TARGETS; i++) {
+		if (g_pingTargets[i].bActive && g_pingTargets[i].bWatchDog)
+			return &g_pingTargets[i];
+	}
+	return 0;
+}
+int PingWatchDog_GetTotalLost() {
+	pingTarget_t *t = Ping_GetWatchDogTarget();
+
+	return t ? t->lost : 0;
+}
+int PingWatchDog_GetTotalReceived() {
+	pingTarget_t *t = Ping_GetWatchDogTarget();
+
+	return t ? t->received : 0;
+}
+
+static commandResult_t CMD_PingAddTarget(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	Tokenizer_TokenizeString(args, 0);
+	if (Tokenizer_GetArgsCount() < 1) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "ping_addTarget: requires IP\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	if (Ping_AddTarget(Tokenizer_GetArg(0), Tokenizer_GetArgsCount() > 1 ? Tokenizer_GetArgInteger(1) : 1000) < 0) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	return CMD_RES_OK;
+}
+static commandResult_t CMD_PingRemoveTarget(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	Tokenizer_TokenizeString(args, 0);
+	if (Tokenizer_GetArgsCount() < 1) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "ping_removeTarget: requires IP\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	if (Ping_RemoveTarget(Tokenizer_GetArg(0)) == false) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	return CMD_RES_OK;
+}
+// ping_setAlarm [IP] [LossPercent] [AvgRttMs] [event] [reconnect] [reboot]
+static commandResult_t CMD_PingSetAlarm(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	pingTarget_t *t;
+	const char *s;
+	int actions;
+	int i;
+
+	Tokenizer_TokenizeString(args, 0);
+	if (Tokenizer_GetArgsCount() < 3) {
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "ping_setAlarm: requires IP, loss and RTT\n");
+		return CMD_RES_NOT_ENOUGH_ARGUMENTS;
+	}
+	t = Ping_FindTarget(Tokenizer_GetArg(0));
+	if (t == 0) {
+		return CMD_RES_BAD_ARGUMENT;
+	}
+	actions = 0;
+	for (i = 3; i < Tokenizer_GetArgsCount(); i++) {
+		s = Tokenizer_GetArg(i);
+		if (!stricmp(s, "event"))
+			actions |= PING_ACTION_EVENT;
+		else if (!stricmp(s, "reconnect"))
+			actions |= PING_ACTION_RECONNECT;
+		else if (!stricmp(s, "reboot"))
+			actions |= PING_ACTION_REBOOT;
+		else {
+			addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "ping_setAlarm: unknown action %s\n", s);
+			return CMD_RES_BAD_ARGUMENT;
+		}
+	}
+	if (actions == 0)
+		actions = PING_ACTION_EVENT;
+	t->lossThreshold = Tokenizer_GetArgInteger(1);
+	t->rttThreshold = Tokenizer_GetArgInteger(2);
+	t->actions = actions;
+	t->bAlarm = 0;
+	return CMD_RES_OK;
+}
+static commandResult_t CMD_PingInfo(const void *context, const char *cmd, const char *args, int cmdFlags) {
+	pingTarget_t *t;
+	int i;
+
+	for (i = 0; i < PING_MAX_TARGETS; i++) {
+		t = &g_pingTargets[i];
+		if (t->bActive == 0)
+			continue;
+		addLogAdv(LOG_INFO, LOG_FEATURE_MAIN, "Ping %i.%i.%i.%i every %ims: sent %u, recv %u, loss %i%%, rtt %i/%i/%i ms, jitter %i ms%s\n",
+			t->ip[0], t->ip[1], t->ip[2], t->ip[3], t->interval, t->sent, t->received,
+			Ping_GetLossPercent(t), Ping_GetMinRtt(t), Ping_GetAverageRtt(t), Ping_GetMaxRtt(t),
+			Ping_GetJitter(t), t->bAlarm ? ", ALARM" : "");
+	}
+	return CMD_RES_OK;
+}
+
+void Ping_InitCommands() {
+	//cmddetail:{"name":"ping_addTarget","args":"[IP][IntervalMS]",
+	//cmddetail:"descr":"Starts pinging given host, default interval is 1000ms. Loss, RTT and jitter are at /api/ping and ping_info",
+	//cmddetail:"fn":"CMD_PingAddTarget","file":"new_ping_monitor.c","requires":"",
+	//cmddetail:"examples":"ping_addTarget 192.168.0.1 5000"}
+	CMD_RegisterCommand("ping_addTarget", "", CMD_PingAddTarget, NULL, NULL);
+	//cmddetail:{"name":"ping_removeTarget","args":"[IP]",
+	//cmddetail:"descr":"Stops pinging given host",
+	//cmddetail:"fn":"CMD_PingRemoveTarget","file":"new_ping_monitor.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("ping_removeTarget", "", CMD_PingRemoveTarget, NULL, NULL);
+	//cmddetail:{"name":"ping_setAlarm","args":"[IP][LossPercent][AvgRttMS][Actions]",
+	//cmddetail:"descr":"Sets alarm thresholds of ping target, 0 disables given check. Actions are any of event, reconnect and reboot, default is event. Events are PingAlarm and PingRecovered, argument is last byte of IP",
+	//cmddetail:"fn":"CMD_PingSetAlarm","file":"new_ping_monitor.c","requires":"",
+	//cmddetail:"examples":"ping_setAlarm 192.168.0.1 50 0 event reconnect"}
+	CMD_RegisterCommand("ping_setAlarm", "", CMD_PingSetAlarm, NULL, NULL);
+	//cmddetail:{"name":"ping_info","args":"",
+	//cmddetail:"descr":"Logs statistics of all ping targets",
+	//cmddetail:"fn":"CMD_PingInfo","file":"new_ping_monitor.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("ping_info", "", CMD_PingInfo, NULL, NULL);
+}
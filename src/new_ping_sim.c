@@ -0,0 +1,153 @@
+#ifdef WINDOWS
+
+// Simulated network for ping monitor, so selftests don't need raw sockets
+// (and privileges). Hosts are set with PingSim_SetHost, echo to any other
+// address is never answered. Replies are made like real IP stack does,
+// type is changed and checksum updated, then delivered after RTT.
+
+#include "new_common.h"
+#include "new_ping.h"
+#include "hal/hal_generic.h"
+
+#define PINGSIM_MAX_HOSTS	4
+#define PINGSIM_MAX_PENDING	16
+
+typedef struct pingSimHost_s {
+	byte ip[4];
+	int rtt;
+	int jitter;
+	int lossPercent;
+	// evenly spreads losses, echo is lost when it goes over 100
+	int lossAccumulator;
+	int count;
+} pingSimHost_t;
+
+typedef struct pingSimReply_s {
+	byte ip[4];
+	byte packet[PING_PACKET_SIZE];
+	uint32_t due;
+	byte bUsed;
+} pingSimReply_t;
+
+static pingSimHost_t g_pingSimHosts[PINGSIM_MAX_HOSTS];
+static int g_pingSimHostsCount = 0;
+static pingSimReply_t g_pingSimReplies[PINGSIM_MAX_PENDING];
+static byte g_pingSimTargets[PING_MAX_TARGETS][4];
+static int g_pingSimBadChecksums = 0;
+
+void PingSim_Reset() {
+	g_pingSimHostsCount = 0;
+	g_pingSimBadChecksums = 0;
+	memset(g_pingSimReplies, 0, sizeof(g_pingSimReplies));
+}
+void PingSim_SetHost(const char *host, int rtt, int jitter, int lossPercent) {
+	pingSimHost_t *h;
+	int a, b, c, d;
+	int i;
+
+	if (sscanf(host, "%d.%d.%d.%d", &a, &b, &c, &d) != 4)
+		return;
+	for (i = 0; i < g_pingSimHostsCount; i++) {
+		h = &g_pingSimHosts[i];
+		if (h->ip[0] == a && h->ip[1] == b && h->ip[2] == c && h->ip[3] == d)
+			break;
+	}
+	if (i == PINGSIM_MAX_HOSTS)
+		return;
+	if (i == g_pingSimHostsCount)
+		g_pingSimHostsCount++;
+	h = &g_pingSimHosts[i];
+	memset(h, 0, sizeof(pingSimHost_t));
+	h->ip[0] = a;
+	h->ip[1] = b;
+	h->ip[2] = c;
+	h->ip[3] = d;
+	h->rtt = rtt;
+	h->jitter = jitter;
+	h->lossPercent = lossPercent;
+}
+int PingSim_GetBadChecksums() {
+	return g_pingSimBadChecksums;
+}
+
+int PingBackend_Open() {
+	return 1;
+}
+// commands and quick tick run in same thread in simulator
+void PingBackend_Call(void (*fn)(void *arg), void *arg) {
+	fn(arg);
+}
+uint32_t PingBackend_GetTime() {
+	return HAL_GetTimeMs();
+}
+void PingBackend_SetTarget(int index, const byte *ip) {
+	memcpy(g_pingSimTargets[index], ip, 4);
+}
+int PingBackend_Send(int index, const byte *packet, int len) {
+	pingSimHost_t *h;
+	pingSimReply_t *r;
+	unsigned short sum;
+	const byte *ip;
+	int i;
+
+	if (len != PING_PACKET_SIZE)
+		return 0;
+	ip = g_pingSimTargets[index];
+	// checksum over whole packet, with checksum, is 0 when it's right
+	if (Ping_Checksum(packet, len) != 0) {
+		g_pingSimBadChecksums++;
+		return 0;
+	}
+	for (i = 0; i < g_pingSimHostsCount; i++) {
+		if (!memcmp(g_pingSimHosts[i].ip, ip, 4))
+			break;
+	}
+	if (i == g_pingSimHostsCount)
+		return 1;
+	h = &g_pingSimHosts[i];
+	h->count++;
+	h->lossAccumulator += h->lossPercent;
+	if (h->lossAccumulator >= 100) {
+		h->lossAccumulator -= 100;
+		return 1;
+	}
+	for (i = 0; i < PINGSIM_MAX_PENDING; i++) {
+		if (g_pingSimReplies[i].bUsed == 0)
+			break;
+	}
+	if (i == PINGSIM_MAX_PENDING)
+		return 1;
+	r = &g_pingSimReplies[i];
+	memcpy(r->ip, ip, 4);
+	memcpy(r->packet, packet, len);
+	// echo request -> echo reply, type is high byte of first word
+	r->packet[0] = 0;
+	sum = Ping_ChecksumUpdate((packet[2] << 8) | packet[3], packet[0] << 8, 0);
+	r->packet[2] = sum >> 8;
+	r->packet[3] = sum & 0xFF;
+	// every other one is late
+	r->due = HAL_GetTimeMs() + h->rtt + ((h->count & 1) ? h->jitter : -h->jitter);
+	r->bUsed = 1;
+	return 1;
+}
+void PingSim_RunQuickTick() {
+	pingSimReply_t *r;
+	uint32_t now;
+	int i;
+
+	now = HAL_GetTimeMs();
+	for (i = 0; i < PINGSIM_MAX_PENDING; i++) {
+		r = &g_pingSimReplies[i];
+		if (r->bUsed == 0 || (int)(now - r->due) < 0)
+			continue;
+		r->bUsed = 0;
+		if (Ping_Checksum(r->packet, PING_PACKET_SIZE) != 0) {
+			g_pingSimBadChecksums++;
+			continue;
+		}
+		Ping_OnEchoReply(r->ip, r->packet, PING_PACKET_SIZE, now);
+	}
+	Ping_RunTick(now);
+}
+
+#endif
@@ -89,6 +89,174 @@ static byte g_timesDown[PLATFORM_GPIO_MAX];
 static byte g_timesUp[PLATFORM_GPIO_MAX];
 static byte g_lastValidState[PLATFORM_GPIO_MAX];
 
+// Reverse index from channel to the pins bound to it, so that a channel
+// change only visits its own pins instead of scanning every GPIO.
+// Links are grouped by channel (first link of channel ch is at
+// g_channelLinksStart[ch], links end at g_channelLinksStart[ch+1]).
+// Second channel of a pin is only linked for DHT, because that is the only
+// role that cares about channels2 (humidity).
+typedef struct channelPinLink_s {
+	byte pin;
+	byte role;
+	byte bSecondChannel;
+} channelPinLink_t;
+
+static channelPinLink_t g_channelLinks[PLATFORM_GPIO_MAX * 2];
+static byte g_channelLinksStart[CHANNEL_MAX + 1];
+static byte g_channelLinksDirty = 1;
+// list of pins that PIN_ticks must service, see PIN_RebuildActivePins
+static byte g_activePinsDirty = 1;
+
+void PIN_InvalidatePinLists() {
+	g_channelLinksDirty = 1;
+	g_activePinsDirty = 1;
+}
+
+// last value written to PWM, so that hardware is only touched on change
+#define PWM_VALUE_UNKNOWN -1
+static short g_pwmValues[PLATFORM_GPIO_MAX];
+
+static void PIN_PWM_Set(int index, int value) {
+	if(g_pwmValues[index] == value)
+		return;
+	g_pwmValues[index] = value;
+	HAL_PIN_PWM_Update(index,value);
+}
+
+// time of the current/last PIN_ticks, in ms
+static uint32_t g_time = 0;
+static uint32_t g_last_time = 0;
+
+// Edge interrupt path for buttons (OBK_FLAG_BTN_USE_INTERRUPTS).
+// HAL calls PIN_OnEdgeInterrupt from ISR, which only appends a timestamped
+// edge to a single producer/single consumer queue. PIN_ticks drains it,
+// debounces edges and feeds the button state machine with exact times.
+// Pins for which HAL has no interrupt support are polled as before.
+#define PIN_EDGE_QUEUE_SIZE 32 // must be power of 2
+#define PIN_EDGE_QUEUE_MASK (PIN_EDGE_QUEUE_SIZE - 1)
+
+typedef struct pinEdge_s {
+	uint32_t time;
+	byte index;
+	byte level;
+} pinEdge_t;
+
+typedef struct pinEdgeDebounce_s {
+	// last raw edge that is not yet stable
+	uint32_t pendingTime;
+	byte pendingLevel;
+	byte bPending;
+	// button state machine has been run up to this time
+	uint32_t lastStepTime;
+} pinEdgeDebounce_t;
+
+static pinEdge_t g_edgeQueue[PIN_EDGE_QUEUE_SIZE];
+// head is only written by ISR, tail only by PIN_ticks
+static volatile uint32_t g_edgeQueueHead = 0;
+static volatile uint32_t g_edgeQueueTail = 0;
+static volatile byte g_edgeQueueOverflow = 0;
+static pinEdgeDebounce_t g_edgeDebounce[PLATFORM_GPIO_MAX];
+// bitfield of pins served from edge queue instead of polling
+static uint32_t g_edgePinsMap = 0;
+static int g_edgeQueueOverflows = 0;
+
+// NOTE: ISR context
+static void PIN_OnEdgeInterrupt(int index, int level, uint32_t time) {
+	uint32_t head = g_edgeQueueHead;
+	pinEdge_t *e;
+
+	if(head - g_edgeQueueTail >= PIN_EDGE_QUEUE_SIZE) {
+		g_edgeQueueOverflow = 1;
+		return;
+	}
+	e = &g_edgeQueue[head & PIN_EDGE_QUEUE_MASK];
+	e->time = time;
+	e->index = index;
+	e->level = level;
+	// publish entry only after it's filled
+	g_edgeQueueHead = head + 1;
+}
+static void PIN_Edge_Attach(int index) {
+	if(CFG_HasFlag(OBK_FLAG_BTN_USE_INTERRUPTS) == 0)
+		return;
+	if(HAL_PIN_AttachEdgeInterrupt(index, PIN_OnEdgeInterrupt) == 0) {
+		// not supported, button will be polled
+		return;
+	}
+	memset(&g_edgeDebounce[index], 0, sizeof(g_edgeDebounce[index]));
+	g_edgeDebounce[index].lastStepTime = g_time;
+	g_edgePinsMap |= (1 << index);
+}
+static void PIN_Edge_Detach(int index) {
+	if((g_edgePinsMap & (1 << index)) == 0)
+		return;
+	HAL_PIN_DetachEdgeInterrupt(index);
+	g_edgePinsMap &= ~(1 << index);
+}
+int PIN_IsUsingEdgeInterrupt(int index) {
+	if(index < 0 || index >= PLATFORM_GPIO_MAX)
+		return 0;
+	return (g_edgePinsMap & (1 << index)) != 0;
+}
+static void PIN_RebuildChannelIndex() {
+	int i, ch;
+	int count;
+	int role;
+	byte counts[CHANNEL_MAX];
+
+	memset(counts, 0, sizeof(counts));
+	for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
+		role = g_cfg.pins.roles[i];
+		if(role == IOR_None)
+			continue;
+		ch = g_cfg.pins.channels[i];
+		if(ch < CHANNEL_MAX) {
+			counts[ch]++;
+		}
+		if(IS_PIN_DHT_ROLE(role) && g_cfg.pins.channels2[i] != ch && g_cfg.pins.channels2[i] < CHANNEL_MAX) {
+			counts[g_cfg.pins.channels2[i]]++;
+		}
+	}
+	count = 0;
+	for(ch = 0; ch < CHANNEL_MAX; ch++) {
+		g_channelLinksStart[ch] = count;
+		count += counts[ch];
+		// reuse as write position
+		counts[ch] = g_channelLinksStart[ch];
+	}
+	g_channelLinksStart[CHANNEL_MAX] = count;
+	// pins are added in ascending order, so per-channel order matches the old full scan
+	for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
+		channelPinLink_t *l;
+
+		role = g_cfg.pins.roles[i];
+		if(role == IOR_None)
+			continue;
+		ch = g_cfg.pins.channels[i];
+		if(ch < CHANNEL_MAX) {
+			l = &g_channelLinks[counts[ch]++];
+			l->pin = i;
+			l->role = role;
+			l->bSecondChannel = 0;
+		}
+		if(IS_PIN_DHT_ROLE(role) && g_cfg.pins.channels2[i] != ch && g_cfg.pins.channels2[i] < CHANNEL_MAX) {
+			l = &g_channelLinks[counts[g_cfg.pins.channels2[i]]++];
+			l->pin = i;
+			l->role = role;
+			l->bSecondChannel = 1;
+		}
+	}
+	g_channelLinksDirty = 0;
+}
+// returns links of given channel and stores their count in *count
+static const channelPinLink_t *PIN_GetChannelLinks(int ch, int *count) {
+	if(g_channelLinksDirty) {
+		PIN_RebuildChannelIndex();
+	}
+	*count = g_channelLinksStart[ch + 1] - g_channelLinksStart[ch];
+	return &g_channelLinks[g_channelLinksStart[ch]];
+}
+
 
 // a bitfield indicating which GPI are inputs.
 // could be used to control edge triggered interrupts...
@@ -577,6 +745,7 @@ void PIN_SetPinRoleForPinIndex(int index, int role) {
 			{
 				//pinButton_s *bt = &g_buttons[index];
 				// TODO: disable button
+				PIN_Edge_Detach(index);
 			}
 			break;
 		case IOR_LED:
@@ -615,8 +784,10 @@ void PIN_SetPinRoleForPinIndex(int index, int role) {
 			}
 		}
 		g_cfg.pins.roles[index] = role;
-		g_cfg_pendingChanges++;
+		CFG_MarkSectionChanged(CFG_SECTION_PINS);
 	}
+	// always rebuild, someone might have changed g_cfg.pins directly
+	PIN_InvalidatePinLists();
 
 	if (g_enable_pins) {
 		int falling = 0;
@@ -649,6 +820,8 @@ void PIN_SetPinRoleForPinIndex(int index, int role) {
 
 				// init button after initializing pin role
 				NEW_button_init(bt, button_generic_get_gpio_value, 0);
+				// use edge interrupts if enabled and supported by HAL
+				PIN_Edge_Attach(index);
 			}
 			break;
 
@@ -741,12 +914,14 @@ void PIN_SetPinRoleForPinIndex(int index, int role) {
 				channelIndex = PIN_GetPinChannelForPinIndex(index);
 				channelValue = g_channelValues[channelIndex];
 				HAL_PIN_PWM_Start(index);
+				// force first update
+				g_pwmValues[index] = PWM_VALUE_UNKNOWN;
 
 				if(role == IOR_PWM_n) {
 					// inversed PWM
-					HAL_PIN_PWM_Update(index,100-channelValue);
+					PIN_PWM_Set(index,100-channelValue);
 				} else {
-					HAL_PIN_PWM_Update(index,channelValue);
+					PIN_PWM_Set(index,channelValue);
 				}
 			}
 			break;
@@ -781,6 +956,9 @@ static void Channel_OnChanged(int ch, int prevValue, int iFlags) {
 	int iVal;
 	int bOn;
 	int bCallCb = 0;
+	int pin, role;
+	int linksCount;
+	const channelPinLink_t *links;
 
 
 	//bOn = BIT_CHECK(g_channelStates,ch);
@@ -799,40 +977,39 @@ static void Channel_OnChanged(int ch, int prevValue, int iFlags) {
 	TuyaMCU_OnChannelChanged(ch, iVal);
 #endif
 
-	for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
-		if(g_cfg.pins.channels[i] == ch) {
-			if(g_cfg.pins.roles[i] == IOR_Relay || g_cfg.pins.roles[i] == IOR_LED) {
-				RAW_SetPinValue(i,bOn);
-				bCallCb = 1;
-			}
-			else if(g_cfg.pins.roles[i] == IOR_Relay_n || g_cfg.pins.roles[i] == IOR_LED_n) {
-				RAW_SetPinValue(i,!bOn);
-				bCallCb = 1;
-			}
-			else if(g_cfg.pins.roles[i] == IOR_DigitalInput || g_cfg.pins.roles[i] == IOR_DigitalInput_n
-				|| g_cfg.pins.roles[i] == IOR_DigitalInput_NoPup || g_cfg.pins.roles[i] == IOR_DigitalInput_NoPup_n) {
-				bCallCb = 1;
-			}
-			else if(g_cfg.pins.roles[i] == IOR_ToggleChannelOnToggle) {
-				bCallCb = 1;
-			}
-			else if(g_cfg.pins.roles[i] == IOR_PWM) {
-				HAL_PIN_PWM_Update(i,iVal);
-				bCallCb = 1;
-			}
-			else if(g_cfg.pins.roles[i] == IOR_PWM_n) {
-				HAL_PIN_PWM_Update(i,100-iVal);
-				bCallCb = 1;
-			}
-			else if(IS_PIN_DHT_ROLE(g_cfg.pins.roles[i])) {
-				bCallCb = 1;
-			}
-		}
-		else if(g_cfg.pins.channels2[i] == ch) {
+	links = PIN_GetChannelLinks(ch, &linksCount);
+	for(i = 0; i < linksCount; i++) {
+		pin = links[i].pin;
+		role = links[i].role;
+		if(links[i].bSecondChannel) {
 			//DHT setup uses 2 channels
-			if(IS_PIN_DHT_ROLE(g_cfg.pins.roles[i])) {
-				bCallCb = 1;
-			}
+			bCallCb = 1;
+		}
+		else if(role == IOR_Relay || role == IOR_LED) {
+			RAW_SetPinValue(pin,bOn);
+			bCallCb = 1;
+		}
+		else if(role == IOR_Relay_n || role == IOR_LED_n) {
+			RAW_SetPinValue(pin,!bOn);
+			bCallCb = 1;
+		}
+		else if(role == IOR_DigitalInput || role == IOR_DigitalInput_n
+			|| role == IOR_DigitalInput_NoPup || role == IOR_DigitalInput_NoPup_n) {
+			bCallCb = 1;
+		}
+		else if(role == IOR_ToggleChannelOnToggle) {
+			bCallCb = 1;
+		}
+		else if(role == IOR_PWM) {
+			PIN_PWM_Set(pin,iVal);
+			bCallCb = 1;
+		}
+		else if(role == IOR_PWM_n) {
+			PIN_PWM_Set(pin,100-iVal);
+			bCallCb = 1;
+		}
+		else if(IS_PIN_DHT_ROLE(role)) {
+			bCallCb = 1;
 		}
 	}
 	if(g_cfg.pins.channelTypes[ch] != ChType_Default) {
@@ -956,18 +1133,9 @@ void CHANNEL_Add(int ch, int iVal) {
 }
 
 int CHANNEL_FindMaxValueForChannel(int ch) {
-	int i;
-	for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
-		// is pin tied to this channel?
-		if(g_cfg.pins.channels[i] == ch) {
-			// is it PWM?
-			if(g_cfg.pins.roles[i] == IOR_PWM) {
-				return 100;
-			}
-			if(g_cfg.pins.roles[i] == IOR_PWM_n) {
-				return 100;
-			}
-		}
+	// is there a PWM pin tied to this channel?
+	if(CHANNEL_HasChannelPinWithRoleOrRole(ch, IOR_PWM, IOR_PWM_n)) {
+		return 100;
 	}
 	if(g_cfg.pins.channelTypes[ch] == ChType_Dimmer)
 		return 100;
@@ -1001,33 +1169,39 @@ void CHANNEL_Toggle(int ch) {
 }
 int CHANNEL_HasChannelPinWithRoleOrRole(int ch, int iorType, int iorType2) {
 	int i;
+	int linksCount;
+	const channelPinLink_t *links;
 
 	if(ch < 0 || ch >= CHANNEL_MAX) {
 		addLogAdv(LOG_ERROR, LOG_FEATURE_GENERAL,"CHANNEL_HasChannelPinWithRole: Channel index %i is out of range <0,%i)\n\r",ch,CHANNEL_MAX);
 		return 0;
 	}
-	for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
-		if(g_cfg.pins.channels[i] == ch) {
-			if(g_cfg.pins.roles[i] == iorType)
-				return 1;
-			else if(g_cfg.pins.roles[i] == iorType2)
-				return 1;
-		}
+	links = PIN_GetChannelLinks(ch, &linksCount);
+	for(i = 0; i < linksCount; i++) {
+		if(links[i].bSecondChannel)
+			continue;
+		if(links[i].role == iorType)
+			return 1;
+		else if(links[i].role == iorType2)
+			return 1;
 	}
 	return 0;
 }
 int CHANNEL_HasChannelPinWithRole(int ch, int iorType) {
 	int i;
+	int linksCount;
+	const channelPinLink_t *links;
 
 	if(ch < 0 || ch >= CHANNEL_MAX) {
 		addLogAdv(LOG_ERROR, LOG_FEATURE_GENERAL,"CHANNEL_HasChannelPinWithRole: Channel index %i is out of range <0,%i)\n\r",ch,CHANNEL_MAX);
 		return 0;
 	}
-	for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
-		if(g_cfg.pins.channels[i] == ch) {
-			if(g_cfg.pins.roles[i] == iorType)
-				return 1;
-		}
+	links = PIN_GetChannelLinks(ch, &linksCount);
+	for(i = 0; i < linksCount; i++) {
+		if(links[i].bSecondChannel)
+			continue;
+		if(links[i].role == iorType)
+			return 1;
 	}
 	return 0;
 }
@@ -1123,6 +1297,8 @@ int CHANNEL_GetRoleForOutputChannel(int ch){
 #define ADC_SAMPLING_TICK_COUNT PIN_TMR_LOOPS_PER_SECOND
 
 
+static void PIN_Button_RunStateMachine(int pinIndex, uint32_t ms_since_last);
+
 void PIN_Input_Handler(int pinIndex, uint32_t ms_since_last)
 {
 	pinButton_s *handle;
@@ -1135,10 +1311,6 @@ void PIN_Input_Handler(int pinIndex, uint32_t ms_since_last)
 		read_gpio_level = handle->button_level;
 	}
 
-	//ticks counter working..
-	if((handle->state) > 0)
-		handle->ticks += ms_since_last;
-
 	/*------------button debounce handle---------------*/
 	if(read_gpio_level != handle->button_level) { //not equal to prev one
 		//continue read 3 times same new level change
@@ -1152,6 +1324,19 @@ void PIN_Input_Handler(int pinIndex, uint32_t ms_since_last)
 		handle->debounce_cnt = 0;
 	}
 
+	PIN_Button_RunStateMachine(pinIndex, ms_since_last);
+}
+// advances button state machine by given time, using already debounced handle->button_level
+static void PIN_Button_RunStateMachine(int pinIndex, uint32_t ms_since_last)
+{
+	pinButton_s *handle;
+
+	handle = &g_buttons[pinIndex];
+
+	//ticks counter working..
+	if((handle->state) > 0)
+		handle->ticks += ms_since_last;
+
 	/*-----------------State machine-------------------*/
 	switch (handle->state) {
 	case 0: 
@@ -1260,16 +1445,221 @@ void PIN_set_wifi_led(int value){
 	}
 }
 
-static uint32_t g_time = 0;
-static uint32_t g_last_time = 0;
 static int activepoll_time = 0; // time to keep polling active until
 
+static void PIN_Edge_AdvanceTo(int index, uint32_t time) {
+	pinEdgeDebounce_t *d = &g_edgeDebounce[index];
+
+	// edges are committed in order, but never step back in time
+	if((int)(time - d->lastStepTime) <= 0)
+		return;
+	PIN_Button_RunStateMachine(index, time - d->lastStepTime);
+	d->lastStepTime = time;
+}
+// commits pending edge if it was stable for BTN_DEBOUNCE_MS before 'now'
+static void PIN_Edge_Flush(int index, uint32_t now) {
+	pinEdgeDebounce_t *d = &g_edgeDebounce[index];
+	uint32_t stableTime;
+
+	if(d->bPending == 0)
+		return;
+	stableTime = d->pendingTime + BTN_DEBOUNCE_MS;
+	if((int)(now - stableTime) < 0)
+		return;
+	d->bPending = 0;
+	if(g_buttons[index].button_level == d->pendingLevel)
+		return;
+	PIN_Edge_AdvanceTo(index, stableTime);
+	g_buttons[index].button_level = d->pendingLevel;
+	PIN_Button_RunStateMachine(index, 0);
+}
+static void PIN_Edge_Feed(int index, int level, uint32_t time) {
+	pinEdgeDebounce_t *d = &g_edgeDebounce[index];
+
+	// a new edge within debounce time replaces the previous one (bounce)
+	PIN_Edge_Flush(index, time);
+	d->pendingLevel = level;
+	d->pendingTime = time;
+	d->bPending = 1;
+}
+static void PIN_ProcessEdgeQueue(uint32_t now) {
+	uint32_t tail;
+	uint32_t map;
+	pinEdge_t *e;
+	int i;
+	int level;
+
+	if(g_edgeQueueOverflow) {
+		// edges were lost, drop the queue and resync with current pin states
+		g_edgeQueueOverflows++;
+		g_edgeQueueTail = g_edgeQueueHead;
+		g_edgeQueueOverflow = 0;
+		for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
+			if(g_edgePinsMap & (1 << i)) {
+				PIN_Edge_Feed(i, PIN_ReadDigitalInputValue_WithInversionIncluded(i), now);
+			}
+		}
+	}
+	tail = g_edgeQueueTail;
+	while(tail != g_edgeQueueHead) {
+		e = &g_edgeQueue[tail & PIN_EDGE_QUEUE_MASK];
+		// simulator may queue edges ahead of time
+		if((int)(e->time - now) > 0)
+			break;
+		if(g_edgePinsMap & (1 << e->index)) {
+			level = e->level;
+			// support inverted button
+			if(BTN_ShouldInvert(e->index)) {
+				level = !level;
+			}
+			PIN_Edge_Feed(e->index, level, e->time);
+		}
+		tail++;
+		g_edgeQueueTail = tail;
+	}
+	map = g_edgePinsMap;
+	for(i = 0; map != 0 && i < PLATFORM_GPIO_MAX; i++, map >>= 1) {
+		if(map & 1) {
+			PIN_Edge_Flush(i, now);
+			// run timers (long press, hold, click timeout)
+			PIN_Edge_AdvanceTo(i, now);
+		}
+	}
+}
+
 #define TOGGLE_PIN_DEBOUNCE_CYCLES 50
+
+// per-role handler called by PIN_ticks for pins on the active list
+typedef void (*pinTickHandler_t)(int index, uint32_t t_diff);
+
+typedef struct activePin_s {
+	byte index;
+	pinTickHandler_t handler;
+} activePin_t;
+
+static activePin_t g_activePins[PLATFORM_GPIO_MAX];
+static int g_activePinsCount = 0;
+
+static void PIN_Tick_Button(int index, uint32_t t_diff) {
+	//addLogAdv(LOG_INFO, LOG_FEATURE_GENERAL,"Test hold %i\r\n",index);
+	PIN_Input_Handler(index, t_diff);
+}
+// debounces input and returns 1 if stable value has changed
+static int PIN_Debounce(int index, int value) {
+	if(value) {
+		if(g_timesUp[index] > TOGGLE_PIN_DEBOUNCE_CYCLES) {
+			if(g_lastValidState[index] != value) {
+				// became up
+				g_lastValidState[index] = value;
+				return 1;
+			}
+		} else {
+			g_timesUp[index]++;
+		}
+		g_timesDown[index] = 0;
+	} else {
+		if(g_timesDown[index] > TOGGLE_PIN_DEBOUNCE_CYCLES) {
+			if(g_lastValidState[index] != value) {
+				// became down
+				g_lastValidState[index] = value;
+				return 1;
+			}
+		} else {
+			g_timesDown[index]++;
+		}
+		g_timesUp[index] = 0;
+	}
+	return 0;
+}
+static void PIN_Tick_DigitalInput(int index, uint32_t t_diff) {
+	// read pin digital value (and already invert it if needed)
+	int value = PIN_ReadDigitalInputValue_WithInversionIncluded(index);
+
+	if(PIN_Debounce(index, value)) {
+		CHANNEL_Set(g_cfg.pins.channels[index], value,0);
+	}
+}
+static void PIN_Tick_ToggleChannelOnToggle(int index, uint32_t t_diff) {
+	// we must detect a toggle, but with debouncing
+	int value = PIN_ReadDigitalInputValue_WithInversionIncluded(index);
+
+	if(PIN_Debounce(index, value)) {
+		CHANNEL_Toggle(g_cfg.pins.channels[index]);
+		// fire event - IOR_ToggleChannelOnToggle has been toggle
+		// Argument is a pin number (NOT channel)
+		EventHandlers_FireEvent(CMD_EVENT_PIN_ONTOGGLE,index);
+	}
+}
+static void PIN_Tick_PWM(int index, uint32_t t_diff) {
+	PIN_PWM_Set(index,g_channelValues[g_cfg.pins.channels[index]]);
+}
+static void PIN_Tick_PWM_n(int index, uint32_t t_diff) {
+	// invert PWM value
+	PIN_PWM_Set(index,100-g_channelValues[g_cfg.pins.channels[index]]);
+}
+static pinTickHandler_t PIN_GetTickHandlerForRole(int role) {
+	switch(role) {
+	case IOR_Button:
+	case IOR_Button_n:
+	case IOR_Button_ToggleAll:
+	case IOR_Button_ToggleAll_n:
+	case IOR_Button_NextColor:
+	case IOR_Button_NextColor_n:
+	case IOR_Button_NextDimmer:
+	case IOR_Button_NextDimmer_n:
+	case IOR_Button_NextTemperature:
+	case IOR_Button_NextTemperature_n:
+	case IOR_Button_ScriptOnly:
+	case IOR_Button_ScriptOnly_n:
+		return PIN_Tick_Button;
+	case IOR_DigitalInput:
+	case IOR_DigitalInput_n:
+	case IOR_DigitalInput_NoPup:
+	case IOR_DigitalInput_NoPup_n:
+		return PIN_Tick_DigitalInput;
+	case IOR_ToggleChannelOnToggle:
+		return PIN_Tick_ToggleChannelOnToggle;
+	case IOR_PWM:
+		return PIN_Tick_PWM;
+	case IOR_PWM_n:
+		return PIN_Tick_PWM_n;
+	}
+	// ADC is sampled once per second in Main_OnEverySecond
+	return 0;
+}
+static void PIN_RebuildActivePins() {
+	int i;
+	pinTickHandler_t handler;
+
+	g_activePinsCount = 0;
+	for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
+		handler = PIN_GetTickHandlerForRole(g_cfg.pins.roles[i]);
+		if(g_edgePinsMap & (1 << i)) {
+			if(handler == PIN_Tick_Button)
+				continue;
+			// role was changed without PIN_SetPinRoleForPinIndex
+			PIN_Edge_Detach(i);
+		}
+		if(handler == 0)
+			continue;
+		g_activePins[g_activePinsCount].index = i;
+		g_activePins[g_activePinsCount].handler = handler;
+		g_activePinsCount++;
+	}
+	g_activePinsDirty = 0;
+}
+int PIN_GetActivePinsCount() {
+	if(g_activePinsDirty) {
+		PIN_RebuildActivePins();
+	}
+	return g_activePinsCount;
+}
+
 //  background ticks, timer repeat invoking interval defined by PIN_TMR_DURATION.
 void PIN_ticks(void *param)
 {
 	int i;
-	int value;
+	uint32_t map;
 
 #if defined(PLATFORM_BEKEN) || defined(WINDOWS)
 	g_time = rtos_get_time();
@@ -1294,12 +1684,14 @@ void PIN_ticks(void *param)
 
 	int activepins = 0;
 	uint32_t pinvalues = 0;
-	for(i = 0; i < PLATFORM_GPIO_MAX; i++) {
-		// note pins which are active - i.e. would not trigger an edge interrupt on change.
-		// if we have any, then we must poll until none
-		// TODO: this will only be used when GPI interrupt triggeringis used.
-		// but it's useful info anyway...
-		if (g_gpio_index_map & (1<<i)){
+	// note pins which are active - i.e. would not trigger an edge interrupt on change.
+	// if we have any, then we must poll until none
+	// TODO: this will only be used when GPI interrupt triggeringis used.
+	// but it's useful info anyway...
+	// only visit pins marked in g_gpio_index_map
+	map = g_gpio_index_map;
+	for(i = 0; map != 0 && i < PLATFORM_GPIO_MAX; i++, map >>= 1) {
+		if (map & 1){
 			uint32_t level = 1;
 			if (g_gpio_edge_map & (1<<i)){
 				level = 0;
@@ -1314,95 +1706,20 @@ void PIN_ticks(void *param)
 				pinvalues |= (1 << i);
 			}
 		}
-		// activepins is count of pins which are 'active', i.e. match thier expected active level
-		if (activepins){
-			activepoll_time = 1000; //20 x 50ms = 1s of polls after button release
-		}
-
-#if 1
-		if(g_cfg.pins.roles[i] == IOR_PWM) {
-			HAL_PIN_PWM_Update(i,g_channelValues[g_cfg.pins.channels[i]]);
-		} else if(g_cfg.pins.roles[i] == IOR_PWM_n) {
-			// invert PWM value
-			HAL_PIN_PWM_Update(i,100-g_channelValues[g_cfg.pins.channels[i]]);
-		} else
-#endif
-		if(g_cfg.pins.roles[i] == IOR_Button || g_cfg.pins.roles[i] == IOR_Button_n
-			|| g_cfg.pins.roles[i] == IOR_Button_ToggleAll || g_cfg.pins.roles[i] == IOR_Button_ToggleAll_n
-			|| g_cfg.pins.roles[i] == IOR_Button_NextColor || g_cfg.pins.roles[i] == IOR_Button_NextColor_n
-			|| g_cfg.pins.roles[i] == IOR_Button_NextDimmer || g_cfg.pins.roles[i] == IOR_Button_NextDimmer_n
-			|| g_cfg.pins.roles[i] == IOR_Button_NextTemperature || g_cfg.pins.roles[i] == IOR_Button_NextTemperature_n
-			|| g_cfg.pins.roles[i] == IOR_Button_ScriptOnly || g_cfg.pins.roles[i] == IOR_Button_ScriptOnly_n) {
-			//addLogAdv(LOG_INFO, LOG_FEATURE_GENERAL,"Test hold %i\r\n",i);
-			PIN_Input_Handler(i, t_diff);
-		}
-		else if(g_cfg.pins.roles[i] == IOR_DigitalInput || g_cfg.pins.roles[i] == IOR_DigitalInput_n
-			||
-			g_cfg.pins.roles[i] == IOR_DigitalInput_NoPup || g_cfg.pins.roles[i] == IOR_DigitalInput_NoPup_n) {
-			// read pin digital value (and already invert it if needed)
-			value = PIN_ReadDigitalInputValue_WithInversionIncluded(i);
-#if 0
-			CHANNEL_Set(g_cfg.pins.channels[i], value,0);
-#else
-			// debouncing
-			if(value) {
-				if(g_timesUp[i] > TOGGLE_PIN_DEBOUNCE_CYCLES) {
-					if(g_lastValidState[i] != value) {
-						// became up
-						g_lastValidState[i] = value;
-						CHANNEL_Set(g_cfg.pins.channels[i], value,0);
-					}
-				} else {
-					g_timesUp[i]++;
-				}
-				g_timesDown[i] = 0;
-			} else {
-				if(g_timesDown[i] > TOGGLE_PIN_DEBOUNCE_CYCLES) {
-					if(g_lastValidState[i] != value) {
-						// became down
-						g_lastValidState[i] = value;
-						CHANNEL_Set(g_cfg.pins.channels[i], value,0);
-					}
-				} else {
-					g_timesDown[i]++;
-				}
-				g_timesUp[i] = 0;
-			}
+	}
+	// activepins is count of pins which are 'active', i.e. match thier expected active level
+	if (activepins){
+		activepoll_time = 1000; //20 x 50ms = 1s of polls after button release
+	}
 
-#endif
-		} else if(g_cfg.pins.roles[i] == IOR_ToggleChannelOnToggle) {
-			// we must detect a toggle, but with debouncing
-			value = PIN_ReadDigitalInputValue_WithInversionIncluded(i);
-			if(value) {
-				if(g_timesUp[i] > TOGGLE_PIN_DEBOUNCE_CYCLES) {
-					if(g_lastValidState[i] != value) {
-						// became up
-						g_lastValidState[i] = value;
-						CHANNEL_Toggle(g_cfg.pins.channels[i]);
-						// fire event - IOR_ToggleChannelOnToggle has been toggle
-						// Argument is a pin number (NOT channel)
-						EventHandlers_FireEvent(CMD_EVENT_PIN_ONTOGGLE,i);
-					}
-				} else {
-					g_timesUp[i]++;
-				}
-				g_timesDown[i] = 0;
-			} else {
-				if(g_timesDown[i] > TOGGLE_PIN_DEBOUNCE_CYCLES) {
-					if(g_lastValidState[i] != value) {
-						// became down
-						g_lastValidState[i] = value;
-						CHANNEL_Toggle(g_cfg.pins.channels[i]);
-						// fire event - IOR_ToggleChannelOnToggle has been toggle
-						// Argument is a pin number (NOT channel)
-						EventHandlers_FireEvent(CMD_EVENT_PIN_ONTOGGLE,i);
-					}
-				} else {
-					g_timesDown[i]++;
-				}
-				g_timesUp[i] = 0;
-			}
-		}
+	if(g_activePinsDirty) {
+		PIN_RebuildActivePins();
+	}
+	for(i = 0; i < g_activePinsCount; i++) {
+		g_activePins[i].handler(g_activePins[i].index, t_diff);
+	}
+	if(g_edgePinsMap) {
+		PIN_ProcessEdgeQueue(g_time);
 	}
 
 #ifdef PLATFORM_BEKEN
@@ -185,8 +185,9 @@ typedef struct pinsState_s {
 #define OBK_FLAG_POWER_ALLOW_NEGATIVE				25
 #define OBK_FLAG_USE_SECONDARY_UART					26
 #define OBK_FLAG_AUTOMAIC_HASS_DISCOVERY			27
+#define OBK_FLAG_BTN_USE_INTERRUPTS					28
 
-#define OBK_TOTAL_FLAGS 28
+#define OBK_TOTAL_FLAGS 29
 
 
 #define CGF_MQTT_CLIENT_ID_SIZE			64
@@ -223,6 +224,18 @@ enum {
 // We should not worry about flash memory wear in this case.
 // The saved-every-reboot values are stored elsewhere
 // (i.e. saved channel states, reboot counter?)
+// config is saved as a set of sections, each one has its own version
+#define CFG_SECTIONS_MAX		16
+#define CFG_SECTIONS_MAGIC		0x54434553
+
+typedef struct cfgSectionDirectory_s {
+	// CFG_SECTIONS_MAGIC, zero in configs saved before sections were introduced
+	unsigned int magic;
+	byte count;
+	byte reserved[3];
+	byte versions[CFG_SECTIONS_MAX];
+} cfgSectionDirectory_t;
+
 typedef struct mainConfig_s {
 	byte ident0;
 	byte ident1;
@@ -279,8 +292,12 @@ typedef struct mainConfig_s {
 	byte buttonHoldRepeat;
 	byte unused_fill1;
 
-	unsigned long LFS_Size; // szie of LFS volume.  it's aligned against the end of OTA
-	byte unusedSectorAB[148];
+	// was unsigned long, which is 8 bytes on 64 bit hosts
+	uint32_t LFS_Size; // szie of LFS volume.  it's aligned against the end of OTA
+	byte unusedSectorAB[124];
+	// offs 0x0000053C
+	// versions of config sections, see new_cfg.c
+	cfgSectionDirectory_t sections;
 	// alternate topic name for receiving MQTT commands
 	char mqtt_group[64];
 	// offs 0x00000594
@@ -320,6 +337,12 @@ const char* PIN_GetPinNameAlias(int index);
 void PIN_SetPinRoleForPinIndex(int index, int role);
 void PIN_SetPinChannelForPinIndex(int index, int ch);
 void PIN_SetPinChannel2ForPinIndex(int index, int ch);
+// must be called after g_cfg.pins roles/channels are modified directly
+void PIN_InvalidatePinLists();
+// number of pins serviced by PIN_ticks
+int PIN_GetActivePinsCount();
+// returns 1 if button on this pin is driven by edge interrupts instead of polling
+int PIN_IsUsingEdgeInterrupt(int index);
 void CHANNEL_Toggle(int ch);
 void CHANNEL_DoSpecialToggleAll();
 bool CHANNEL_Check(int ch);
@@ -0,0 +1,193 @@
+#include "new_common.h"
+#include "perf.h"
+#include "logging/logging.h"
+#include "cmnds/cmd_public.h"
+#include "mqtt/new_mqtt.h"
+
+// must match PERF_* enum in perf.h
+perfSection_t g_perfCore[PERF_CORE_SECTIONS] = {
+	{ "quicktick" },
+	{ "qt_pins" },
+	{ "qt_scripts" },
+	{ "qt_drivers" },
+	{ "qt_dht" },
+	{ "qt_i2c" },
+	{ "qt_mqtt" },
+	{ "qt_led" },
+	{ "second" },
+	{ "sec_mqtt" },
+	{ "sec_events" },
+	{ "sec_drivers" },
+	{ "sec_cfg" },
+	{ "sec_adc" },
+	{ "sec_dht" },
+	{ "http" },
+};
+static perfSection_t* g_perfList = 0;
+
+// summary published by perfPublish, sections that don't fit are skipped
+#define PERF_MQTT_BUFFER	1024
+
+void PERF_Register(perfSection_t* s, const char* name) {
+	s->name = name;
+	if (s->bRegistered) {
+		return;
+	}
+	s->bRegistered = 1;
+	s->next = g_perfList;
+	g_perfList = s;
+}
+void PERF_End(perfSection_t* s, uint32_t start) {
+	uint32_t spent, tmp;
+	int bucket;
+
+	s->calls++;
+	// no microsecond timer, only calls are counted
+	if (HAL_HasTimeUs() == 0) {
+		return;
+	}
+	spent = HAL_GetTimeUs() - start;
+	s->totalUs += spent;
+	if (spent > s->maxUs) {
+		s->maxUs = spent;
+	}
+	bucket = 0;
+	tmp = spent;
+	while (tmp && bucket < PERF_HISTOGRAM_BUCKETS - 1) {
+		tmp >>= 1;
+		bucket++;
+	}
+	s->histogram[bucket]++;
+}
+void PERF_ResetSection(perfSection_t* s) {
+	s->calls = 0;
+	s->totalUs = 0;
+	s->maxUs = 0;
+	memset(s->histogram, 0, sizeof(s->histogram));
+}
+void PERF_Reset() {
+	perfSection_t* s;
+	int i;
+
+	for (i = 0; i < PERF_CORE_SECTIONS; i++) {
+		PERF_ResetSection(&g_perfCore[i]);
+	}
+	for (s = g_perfList; s; s = s->next) {
+		PERF_ResetSection(s);
+	}
+}
+perfSection_t* PERF_GetSection(const char* name) {
+	perfSection_t* s;
+	int i;
+
+	for (i = 0; i < PERF_CORE_SECTIONS; i++) {
+		if (!strcmp(g_perfCore[i].name, name)) {
+			return &g_perfCore[i];
+		}
+	}
+	for (s = g_perfList; s; s = s->next) {
+		if (!strcmp(s->name, name)) {
+			return s;
+		}
+	}
+	return 0;
+}
+static uint32_t PERF_GetAverage(perfSection_t* s) {
+	if (s->calls == 0) {
+		return 0;
+	}
+	return (uint32_t)(s->totalUs / s->calls);
+}
+static void PERF_AppendSectionJSON(http_request_t* request, perfSection_t* s, bool bComma) {
+	int i;
+
+	if (HAL_HasTimeUs() == 0) {
+		hprintf255(request, "%s{\"name\":\"%s\",\"calls\":%u}", bComma ? "," : "", s->name, s->calls);
+		return;
+	}
+	hprintf255(request, "%s{\"name\":\"%s\",\"calls\":%u,\"total_ms\":%u,\"avg_us\":%u,\"max_us\":%u,\"hist\":[",
+		bComma ? "," : "", s->name, s->calls, (uint32_t)(s->totalUs / 1000), PERF_GetAverage(s), s->maxUs);
+	for (i = 0; i < PERF_HISTOGRAM_BUCKETS; i++) {
+		hprintf255(request, i ? ",%u" : "%u", s->histogram[i]);
+	}
+	poststr(request, "]}");
+}
+// GET /api/perf
+int PERF_WriteJSON(http_request_t* request) {
+	perfSection_t* s;
+	int i;
+
+	http_setup(request, httpMimeTypeJson);
+	hprintf255(request, "{\"unit\":\"%s\",\"buckets\":%i,\"sections\":[",
+		HAL_HasTimeUs() ? "us" : "unsupported", PERF_HISTOGRAM_BUCKETS);
+	for (i = 0; i < PERF_CORE_SECTIONS; i++) {
+		PERF_AppendSectionJSON(request, &g_perfCore[i], i != 0);
+	}
+	for (s = g_perfList; s; s = s->next) {
+		PERF_AppendSectionJSON(request, s, true);
+	}
+	poststr(request, "]}");
+	poststr(request, NULL);
+	return 0;
+}
+static int PERF_AppendSummary(char* buf, int len, int size, perfSection_t* s) {
+	int r;
+
+	// sections that were never called only waste MQTT payload
+	if (s->calls == 0) {
+		return len;
+	}
+	r = snprintf(buf + len, size - len, "%s\"%s\":[%u,%u,%u]",
+		len > 1 ? "," : "", s->name, s->calls, PERF_GetAverage(s), s->maxUs);
+	if (r < 0 || len + r >= size - 1) {
+		buf[len] = 0;
+		return len;
+	}
+	return len + r;
+}
+// perfPublish
+// Publishes {"section":[calls,avg_us,max_us],...} to [client]/perf/get,
+// or "unsupported" on platforms without microsecond timer
+static commandResult_t CMD_PerfPublish(const void* context, const char* cmd, const char* args, int cmdFlags) {
+	perfSection_t* s;
+	char* buf;
+	int len;
+	int i;
+
+	if (HAL_HasTimeUs() == 0) {
+		MQTT_PublishMain_StringString("perf", "unsupported", 0);
+		return CMD_RES_OK;
+	}
+	buf = (char*)os_malloc(PERF_MQTT_BUFFER);
+	if (buf == 0) {
+		return CMD_RES_ERROR;
+	}
+	strcpy(buf, "{");
+	len = 1;
+	for (i = 0; i < PERF_CORE_SECTIONS; i++) {
+		len = PERF_AppendSummary(buf, len, PERF_MQTT_BUFFER, &g_perfCore[i]);
+	}
+	for (s = g_perfList; s; s = s->next) {
+		len = PERF_AppendSummary(buf, len, PERF_MQTT_BUFFER, s);
+	}
+	strcpy(buf + len, "}");
+	MQTT_PublishMain_StringString("perf", buf, 0);
+	os_free(buf);
+	return CMD_RES_OK;
+}
+static commandResult_t CMD_PerfReset(const void* context, const char* cmd, const char* args, int cmdFlags) {
+	PERF_Reset();
+	return CMD_RES_OK;
+}
+void PERF_InitCommands() {
+	//cmddetail:{"name":"perfPublish","args":"",
+	//cmddetail:"descr":"Publishes profiler summary (calls, average and max time in us for every section) as JSON to [client]/perf/get. Full data with histograms is at /api/perf. Publishes 'unsupported' on platforms without microsecond timer",
+	//cmddetail:"fn":"CMD_PerfPublish","file":"perf.c","requires":"",
+	//cmddetail:"examples":"addRepeatingEvent 60 -1 perfPublish"}
+	CMD_RegisterCommand("perfPublish", "", CMD_PerfPublish, NULL, NULL);
+	//cmddetail:{"name":"perfReset","args":"",
+	//cmddetail:"descr":"Clears all profiler counters and histograms",
+	//cmddetail:"fn":"CMD_PerfReset","file":"perf.c","requires":"",
+	//cmddetail:"examples":""}
+	CMD_RegisterCommand("perfReset", "", CMD_PerfReset, NULL, NULL);
+}
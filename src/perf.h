@@ -0,0 +1,65 @@
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include "new_common.h"
+#include "httpserver/new_http.h"
+#include "hal/hal_generic.h"
+
+// Lightweight profiler - call counts, total/max time and log2 latency
+// histogram per code section, measured with HAL_GetTimeUs.
+// Without microsecond timer (HAL_HasTimeUs) only calls are counted.
+// Results are available via /api/perf, perfPublish (MQTT) and perfReset.
+
+// bucket 0 - 0us, bucket N - [2^(N-1), 2^N) us, last bucket - everything longer
+#define PERF_HISTOGRAM_BUCKETS	16
+
+typedef struct perfSection_s {
+	const char* name;
+	// list of registered sections (drivers, HTTP handlers), core ones are not linked
+	struct perfSection_s* next;
+	uint32_t calls;
+	uint64_t totalUs;
+	uint32_t maxUs;
+	uint32_t histogram[PERF_HISTOGRAM_BUCKETS];
+	byte bRegistered;
+} perfSection_t;
+
+// fixed sections of main loop, see g_perfCore names in perf.c
+enum {
+	PERF_QUICKTICK,
+	PERF_QT_PINS,
+	PERF_QT_SCRIPTS,
+	PERF_QT_DRIVERS,
+	PERF_QT_DHT,
+	PERF_QT_I2C,
+	PERF_QT_MQTT,
+	PERF_QT_LED,
+	PERF_EVERYSECOND,
+	PERF_SEC_MQTT,
+	PERF_SEC_EVENTS,
+	PERF_SEC_DRIVERS,
+	PERF_SEC_CFG,
+	PERF_SEC_ADC,
+	PERF_SEC_DHT,
+	PERF_HTTP,
+	PERF_CORE_SECTIONS,
+};
+
+extern perfSection_t g_perfCore[PERF_CORE_SECTIONS];
+
+// adds section to list printed by /api/perf, can be called many times
+void PERF_Register(perfSection_t* s, const char* name);
+void PERF_End(perfSection_t* s, uint32_t start);
+void PERF_Reset();
+void PERF_ResetSection(perfSection_t* s);
+void PERF_InitCommands();
+// whole profiler state as JSON reply, used by /api/perf
+int PERF_WriteJSON(http_request_t* request);
+// finds core or registered section by name, NULL if there is none
+perfSection_t* PERF_GetSection(const char* name);
+
+// usage: uint32_t start; PERF_BEGIN(start); ... PERF_END(PERF_QT_PINS, start);
+#define PERF_BEGIN(var)			var = HAL_GetTimeUs()
+#define PERF_END(id, var)		PERF_End(&g_perfCore[id], var)
+
+#endif /* __PERF_H__ */
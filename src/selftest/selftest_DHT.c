@@ -1,11 +1,84 @@
 #ifdef WINDOWS
 
-#include "selftest_local.h".
+#include "selftest_local.h"
+#include "../driver/drv_dht_internal.h"
+
+// Builds what sensor sends after host releases the line - 80us low, 80us high
+// and then 40 bits, each is 50us low and 26us (0) or 70us (1) high
+static int Test_DHT_BuildResponse(const byte *data, int *durations) {
+	int i, c;
+
+	c = 0;
+	durations[c++] = 30;
+	durations[c++] = 80;
+	durations[c++] = 80;
+	for (i = 0; i < 40; i++) {
+		durations[c++] = 50;
+		durations[c++] = (data[i / 8] & (0x80 >> (i % 8))) ? 70 : 26;
+	}
+	// sensor releases the line
+	durations[c++] = 50;
+	return c;
+}
+static void Test_DHT_SetResponse(int pin, byte h, byte hd, byte t, byte td, byte sum) {
+	byte data[5];
+	int durations[128];
+	int count;
+
+	data[0] = h;
+	data[1] = hd;
+	data[2] = t;
+	data[3] = td;
+	data[4] = sum;
+	count = Test_DHT_BuildResponse(data, durations);
+	SIM_SetPinPulseResponse(pin, durations, count);
+}
+static void Test_DHT_Decoder() {
+	uint32_t times[DHT_MAX_EDGES];
+	byte levels[DHT_MAX_EDGES];
+	byte expected[5] = { 0x02, 0x8C, 0x80, 0x65, 0x73 };
+	byte data[5];
+	int durations[128];
+	int count, i, c;
+	uint32_t t;
+
+	// recorded waveform has our own release edge first, some jitter,
+	// and timer wraps in the middle of transmission
+	count = Test_DHT_BuildResponse(expected, durations);
+	t = 0xFFFFF000;
+	c = 0;
+	times[c] = t;
+	levels[c] = 1;
+	c++;
+	for (i = 0; i < count; i++) {
+		t += durations[i] + ((i * 7) % 5) - 2;
+		times[c] = t;
+		levels[c] = (i % 2) ? 1 : 0;
+		c++;
+	}
+	SELFTEST_ASSERT(DHT_DecodePulses(times, levels, c, data) == DHT_DECODE_OK);
+	SELFTEST_ASSERT(memcmp(data, expected, 5) == 0);
+	// broken checksum
+	times[c - 2] = times[c - 3] + 20;
+	SELFTEST_ASSERT(DHT_DecodePulses(times, levels, c, data) == DHT_DECODE_CHECKSUM);
+	// edges missing
+	SELFTEST_ASSERT(DHT_DecodePulses(times, levels, 40, data) == DHT_DECODE_TIMEOUT);
+	// lost edge in the middle
+	levels[20] = levels[19];
+	SELFTEST_ASSERT(DHT_DecodePulses(times, levels, c, data) == DHT_DECODE_TIMEOUT);
+}
 
 void Test_DHT() {
+	dht_t *dht;
+
+	Test_DHT_Decoder();
+
 	// reset whole device
 	SIM_ClearOBK();
 
+	// simulated sensor says humidity 67, temperature 19
+	Test_DHT_SetResponse(9, 67, 0, 19, 0, 86);
+
 	PIN_SetPinRoleForPinIndex(9, IOR_DHT11);
 	PIN_SetPinChannelForPinIndex(9, 1);
 	PIN_SetPinChannel2ForPinIndex(9, 2);
@@ -14,6 +87,34 @@ void Test_DHT() {
 
 	SELFTEST_ASSERT_CHANNEL(1, 190);
 	SELFTEST_ASSERT_CHANNEL(2, 67);
+	dht = DHT_FindForPin(9);
+	SELFTEST_ASSERT(dht != 0);
+	SELFTEST_ASSERT(dht->statReads > 0);
+	SELFTEST_ASSERT(dht->statChecksumErrors == 0);
+	SELFTEST_ASSERT(dht->statTimeouts == 0);
+
+	// corrupted transmission, last good value is kept
+	Test_DHT_SetResponse(9, 50, 0, 20, 0, 0);
+	dht->statReads = 0;
+	Sim_RunSeconds(4.0f, false);
+	SELFTEST_ASSERT(dht->statReads > 0);
+	SELFTEST_ASSERT(dht->statChecksumErrors == dht->statReads);
+	SELFTEST_ASSERT_CHANNEL(1, 190);
+	SELFTEST_ASSERT_CHANNEL(2, 67);
+
+	// sensor disconnected
+	SIM_SetPinPulseResponse(9, 0, 0);
+	dht->statReads = 0;
+	Sim_RunSeconds(4.0f, false);
+	SELFTEST_ASSERT(dht->statReads > 0);
+	SELFTEST_ASSERT(dht->statTimeouts == dht->statReads);
+	SELFTEST_ASSERT_CHANNEL(1, 190);
+
+	// and back again
+	Test_DHT_SetResponse(9, 55, 0, 21, 0, 76);
+	Sim_RunSeconds(4.0f, false);
+	SELFTEST_ASSERT_CHANNEL(1, 210);
+	SELFTEST_ASSERT_CHANNEL(2, 55);
 
 	PIN_SetPinRoleForPinIndex(9, IOR_None);
 	PIN_SetPinChannelForPinIndex(9, 1);
@@ -0,0 +1,145 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../httpserver/new_http.h"
+#include "../driver/drv_public.h"
+#include "../driver/drv_local.h"
+#include "../hal/hal_generic.h"
+#include "../logging/logging.h"
+#include "../crc.h"
+#include "../mem_pool.h"
+
+// Micro benchmarks of hot paths, started with -bench command line argument.
+// Prints average time per call, so results can be compared between builds.
+
+typedef struct benchmark_s {
+	const char *name;
+	void (*run)(int i);
+	int iterations;
+} benchmark_t;
+
+static const char *g_benchHTTPTemplate = "GET /%s HTTP/1.1\r\n"
+"Host: 127.0.0.1\r\n"
+"Connection: keep-alive\r\n"
+"Accept: */*\r\n"
+"\r\n";
+
+static char g_benchRequest[2048];
+static char g_benchReply[131072];
+
+static void Bench_HTTP(const char *url) {
+	http_request_t request;
+
+	snprintf(g_benchRequest, sizeof(g_benchRequest), g_benchHTTPTemplate, url);
+	memset(&request, 0, sizeof(request));
+	request.received = g_benchRequest;
+	request.receivedLen = strlen(g_benchRequest);
+	request.reply = g_benchReply;
+	request.replymaxlen = sizeof(g_benchReply);
+	HTTP_ProcessPacket(&request);
+}
+static void Bench_Cmd_SetChannel(int i) {
+	CHANNEL_Set(1, i & 0xff, 0);
+	CMD_ExecuteCommand("setChannel 2 123", 0);
+}
+static void Bench_Cmd_Backlog(int i) {
+	CMD_ExecuteCommand("backlog setChannel 1 1; addChannel 1 2; toggleChannel 3", 0);
+}
+static void Bench_Cmd_Expression(int i) {
+	CMD_ExecuteCommand("setChannel 4 $CH1*2+$CH2-10", 0);
+}
+static void Bench_HTTP_Index(int i) {
+	Bench_HTTP("index");
+}
+static void Bench_HTTP_Channels(int i) {
+	Bench_HTTP("api/channels");
+}
+static void Bench_HTTP_CfgPins(int i) {
+	static char url[1024];
+	int j;
+
+	// form as submitted by cfg_pins page, every field is looked up by name
+	if (url[0] == 0) {
+		strcpy(url, "cfg_pins?");
+		for (j = 0; j < 24; j++) {
+			sprintf(url + strlen(url), "%i=0&r%i=0&e%i=0&", j, j, j);
+		}
+	}
+	Bench_HTTP(url);
+}
+static void Bench_BL_ProcessUpdate(int i) {
+	BL_ProcessUpdate(230.0f + (i & 7), 0.25f, 57.5f);
+}
+
+static void Bench_CRC8_Config_Bitwise(int i) {
+	CRC8_Bitwise(0, &g_cfg, sizeof(g_cfg));
+}
+static void Bench_CRC8_Config(int i) {
+	CRC8_Update(0, &g_cfg, sizeof(g_cfg));
+}
+static void Bench_Pool_Small(int i) {
+	Pool_Free(Pool_Malloc(24 + (i & 31)));
+}
+static void Bench_LED_QuickLerp(int i) {
+	// alternate targets, so lerp has work to do each tick
+	if ((i & 63) == 0) {
+		CMD_ExecuteCommand((i & 64) ? "led_basecolor_rgb FF8000" : "led_basecolor_rgb 0040FF", 0);
+	}
+	LED_RunQuickColorLerp(5);
+}
+static void Bench_LED_Effect(int i) {
+	if (LED_Effect_IsRunning() == 0) {
+		CMD_ExecuteCommand("led_enableAll 1", 0);
+		CMD_ExecuteCommand("led_effect cycle 10000", 0);
+	}
+	// one frame each call
+	LED_Effect_RunQuickTick(20);
+}
+
+static benchmark_t g_benchmarks[] = {
+	{ "CMD_ExecuteCommand setChannel", Bench_Cmd_SetChannel, 20000 },
+	{ "CMD_ExecuteCommand backlog", Bench_Cmd_Backlog, 10000 },
+	{ "CMD_ExecuteCommand expression", Bench_Cmd_Expression, 10000 },
+	{ "HTTP_ProcessPacket index", Bench_HTTP_Index, 1000 },
+	{ "HTTP_ProcessPacket api/channels", Bench_HTTP_Channels, 5000 },
+	{ "HTTP_ProcessPacket cfg_pins form", Bench_HTTP_CfgPins, 1000 },
+	{ "BL_ProcessUpdate", Bench_BL_ProcessUpdate, 5000 },
+	{ "CRC8 mainConfig_t bitwise", Bench_CRC8_Config_Bitwise, 1000 },
+	{ "CRC8 mainConfig_t", Bench_CRC8_Config, 1000 },
+	{ "Pool_Malloc/Pool_Free small", Bench_Pool_Small, 100000 },
+	{ "LED_RunQuickColorLerp", Bench_LED_QuickLerp, 50000 },
+	{ "LED effect frame (cycle)", Bench_LED_Effect, 50000 },
+};
+
+void Win_DoBenchmarks() {
+	int i, j;
+	int prevLogLevel;
+	uint32_t start, delta;
+	benchmark_t *b;
+
+	SIM_ClearOBK();
+	CMD_ExecuteCommand("startDriver TESTPOWER", 0);
+	// logging would dominate the results
+	prevLogLevel = loglevel;
+	loglevel = LOG_NONE;
+
+	for (i = 0; i < sizeof(g_benchmarks) / sizeof(g_benchmarks[0]); i++) {
+		b = &g_benchmarks[i];
+		// warm up
+		for (j = 0; j < b->iterations / 10; j++) {
+			b->run(j);
+		}
+		start = HAL_GetTimeUs();
+		for (j = 0; j < b->iterations; j++) {
+			b->run(j);
+		}
+		delta = HAL_GetTimeUs() - start;
+		printf("BENCH %-34s %8i calls %10.0f ns/call\n", b->name, b->iterations,
+			(double)delta * 1000.0 / b->iterations);
+	}
+
+	loglevel = prevLogLevel;
+	CMD_ExecuteCommand("stopDriver TESTPOWER", 0);
+}
+
+#endif
@@ -1,6 +1,6 @@
 #ifdef WINDOWS
 
-#include "selftest_local.h".
+#include "selftest_local.h"
 
 void Test_ButtonEvents() {
 	// reset whole device
@@ -96,6 +96,93 @@ void Test_ButtonEvents() {
 	SELFTEST_ASSERT_CHANNEL(12, 22);
 	SELFTEST_ASSERT_CHANNEL(13, 1201);
 }
+void Test_ButtonEvents_EdgeInterrupts() {
+	// press with contact bounce, ending low
+	int bouncyPress[] = { 0, 1, 0, 1, 0 };
+	int bouncyPressDelays[] = { 1, 2, 1, 3, 2 };
+	// release with contact bounce, ending high
+	int bouncyRelease[] = { 1, 0, 1 };
+	int bouncyReleaseDelays[] = { 1, 3, 2 };
+	// two clean clicks, 80ms apart
+	int doubleClick[] = { 0, 1, 0, 1 };
+	int doubleClickDelays[] = { 1, 60, 80, 60 };
+	int manyEdges[64];
+	int manyEdgesDelays[64];
+	int i;
+
+	// reset whole device
+	SIM_ClearOBK();
+	CFG_SetFlag(OBK_FLAG_BTN_USE_INTERRUPTS, 1);
+
+	// by default, we have a pull up resistor - so high level
+	SIM_SetSimulatedPinValue(9, true);
+	PIN_SetPinRoleForPinIndex(9, IOR_Button);
+	SELFTEST_ASSERT(PIN_IsUsingEdgeInterrupt(9));
+	// button is not polled anymore
+	SELFTEST_ASSERT(PIN_GetActivePinsCount() == 0);
+
+	CMD_ExecuteCommand("addEventHandler OnPress 9 addChannel 10 1", 0);
+	CMD_ExecuteCommand("addEventHandler OnRelease 9 addChannel 11 1", 0);
+	CMD_ExecuteCommand("addEventHandler OnClick 9 addChannel 12 1", 0);
+	CMD_ExecuteCommand("addEventHandler OnDblClick 9 addChannel 13 1", 0);
+	CMD_ExecuteCommand("addEventHandler OnHold 9 addChannel 14 1", 0);
+	Sim_RunFrames(15, false);
+
+	// bouncing gives a single press
+	SIM_InjectPinEdges(9, bouncyPress, bouncyPressDelays, 5);
+	Sim_RunFrames(10, false);
+	SELFTEST_ASSERT_CHANNEL(10, 1);
+	SELFTEST_ASSERT_CHANNEL(11, 0);
+	SIM_InjectPinEdges(9, bouncyRelease, bouncyReleaseDelays, 3);
+	Sim_RunFrames(10, false);
+	SELFTEST_ASSERT_CHANNEL(10, 1);
+	SELFTEST_ASSERT_CHANNEL(11, 1);
+	SELFTEST_ASSERT_CHANNEL(12, 0);
+	// wait for click timeout
+	Sim_RunFrames(100, false);
+	SELFTEST_ASSERT_CHANNEL(12, 1);
+	SELFTEST_ASSERT_CHANNEL(13, 0);
+
+	// double click
+	Sim_RunFrames(100, false);
+	SIM_InjectPinEdges(9, doubleClick, doubleClickDelays, 4);
+	Sim_RunFrames(200, false);
+	// OnPress is only fired for first press of a multi click
+	SELFTEST_ASSERT_CHANNEL(10, 2);
+	SELFTEST_ASSERT_CHANNEL(11, 3);
+	SELFTEST_ASSERT_CHANNEL(12, 1);
+	SELFTEST_ASSERT_CHANNEL(13, 1);
+	SELFTEST_ASSERT_CHANNEL(14, 0);
+
+	// long press, hold is repeated while pressed
+	SIM_SetSimulatedPinValue(9, false);
+	Sim_RunFrames(500, false);
+	SELFTEST_ASSERT(CHANNEL_Get(14) > 1);
+	SIM_SetSimulatedPinValue(9, true);
+	Sim_RunFrames(100, false);
+	SELFTEST_ASSERT_CHANNEL(10, 3);
+	SELFTEST_ASSERT_CHANNEL(11, 4);
+
+	// more edges than queue can hold, state is resynced from pin
+	for (i = 0; i < 64; i++) {
+		manyEdges[i] = i % 2;
+		manyEdgesDelays[i] = 1;
+	}
+	manyEdges[63] = 0;
+	SIM_InjectPinEdges(9, manyEdges, manyEdgesDelays, 64);
+	Sim_RunFrames(20, false);
+	SELFTEST_ASSERT_CHANNEL(10, 4);
+	SIM_SetSimulatedPinValue(9, true);
+	Sim_RunFrames(100, false);
+	SELFTEST_ASSERT_CHANNEL(11, 5);
+
+	// without flag, button is polled again
+	CFG_SetFlag(OBK_FLAG_BTN_USE_INTERRUPTS, 0);
+	PIN_SetPinRoleForPinIndex(9, IOR_None);
+	PIN_SetPinRoleForPinIndex(9, IOR_Button);
+	SELFTEST_ASSERT(PIN_IsUsingEdgeInterrupt(9) == 0);
+	SELFTEST_ASSERT(PIN_GetActivePinsCount() == 1);
+}
 
 
 #endif
@@ -0,0 +1,104 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../crc.h"
+#include "../hal/hal_flashConfig.h"
+
+static byte Test_Cfg_WholeChecksum() {
+	// the same as CFG_CalcChecksum for current config version
+	return CRC8_Update(0, &g_cfg.version, sizeof(g_cfg) - offsetof(mainConfig_t, version));
+}
+
+void Test_CfgSections() {
+	cfgSaveStats_t before, after;
+	char buffer[64];
+	int i;
+
+	// fresh config, first save writes whole image and starts journal
+	CFG_SetDefaultConfig();
+	CFG_GetSaveStats(&before);
+	CFG_Save_IfThereArePendingChanges();
+	CFG_GetSaveStats(&after);
+	SELFTEST_ASSERT_INTEGER(after.fullSaves, before.fullSaves + 1);
+	SELFTEST_ASSERT(after.journalSize > 0);
+	SELFTEST_ASSERT_INTEGER(after.journalUsed, 0);
+	SELFTEST_ASSERT_INTEGER(g_cfg.sections.magic, CFG_SECTIONS_MAGIC);
+	SELFTEST_ASSERT_INTEGER(g_cfg.crc, Test_Cfg_WholeChecksum());
+
+	// single change appends only changed section and system section (change counter)
+	before = after;
+	CFG_SetMQTTHost("192.168.0.123");
+	CFG_Save_IfThereArePendingChanges();
+	CFG_GetSaveStats(&after);
+	SELFTEST_ASSERT_INTEGER(after.fullSaves, before.fullSaves);
+	SELFTEST_ASSERT_INTEGER(after.sectionWrites, before.sectionWrites + 2);
+	SELFTEST_ASSERT(after.journalUsed > 0);
+	SELFTEST_ASSERT(after.bytesWritten - before.bytesWritten < sizeof(g_cfg));
+	SELFTEST_ASSERT_INTEGER(g_cfg.crc, Test_Cfg_WholeChecksum());
+
+	// change without section info is still found and saved
+	before = after;
+	strcpy(g_cfg.ntpServer, "10.0.0.1");
+	g_cfg_pendingChanges++;
+	CFG_Save_IfThereArePendingChanges();
+	CFG_GetSaveStats(&after);
+	SELFTEST_ASSERT_INTEGER(after.fullSaves, before.fullSaves);
+	SELFTEST_ASSERT_INTEGER(after.sectionWrites, before.sectionWrites + 2);
+
+	// change that was not reported at all goes with next save of anything
+	before = after;
+	strcpy(g_cfg.webappRoot, "http://10.0.0.2/");
+	CFG_SetShortStartupCommand("echo unreported");
+	CFG_Save_IfThereArePendingChanges();
+	CFG_GetSaveStats(&after);
+	SELFTEST_ASSERT_INTEGER(after.fullSaves, before.fullSaves);
+	SELFTEST_ASSERT_INTEGER(after.sectionWrites, before.sectionWrites + 3);
+
+	// reload from flash replays journal
+	memset(&g_cfg, 0, sizeof(g_cfg));
+	CFG_InitAndLoad();
+	SELFTEST_ASSERT_STRING(CFG_GetMQTTHost(), "192.168.0.123");
+	SELFTEST_ASSERT_STRING(CFG_GetNTPServer(), "10.0.0.1");
+	SELFTEST_ASSERT_STRING(CFG_GetWebappRoot(), "http://10.0.0.2/");
+	SELFTEST_ASSERT_INTEGER(g_cfg_pendingChanges, 0);
+
+	// full journal falls back to erase and full save, values survive
+	CFG_GetSaveStats(&before);
+	for (i = 0; i < 20; i++) {
+		sprintf(buffer, "echo startup %i", i);
+		CFG_SetShortStartupCommand(buffer);
+		CFG_Save_IfThereArePendingChanges();
+	}
+	CFG_GetSaveStats(&after);
+	SELFTEST_ASSERT(after.fullSaves > before.fullSaves);
+	memset(&g_cfg, 0, sizeof(g_cfg));
+	CFG_InitAndLoad();
+	SELFTEST_ASSERT_STRING(CFG_GetShortStartupCommand(), "echo startup 19");
+	SELFTEST_ASSERT_STRING(CFG_GetMQTTHost(), "192.168.0.123");
+
+	// config saved by older firmware: no directory, version 2, so MQTT section must be upgraded
+	CFG_SetDefaultConfig();
+	CFG_Save_IfThereArePendingChanges();
+	memset(&g_cfg.sections, 0, sizeof(g_cfg.sections));
+	g_cfg.version = 2;
+	strcpy(g_cfg.mqtt_clientId, "oldClientId");
+	strcpy(g_cfg.shortDeviceName, "myShortName");
+	g_cfg.crc = Test_Cfg_WholeChecksum();
+	HAL_Configuration_SaveConfigMemory(&g_cfg, sizeof(g_cfg));
+	memset(&g_cfg, 0, sizeof(g_cfg));
+	// loading saves upgraded config at once, and it has to be a full save
+	CFG_GetSaveStats(&before);
+	CFG_InitAndLoad();
+	CFG_GetSaveStats(&after);
+	SELFTEST_ASSERT_STRING(CFG_GetShortDeviceName(), "myShortName");
+	SELFTEST_ASSERT_STRING(CFG_GetMQTTClientId(), "myShortName");
+	SELFTEST_ASSERT_INTEGER(after.fullSaves, before.fullSaves + 1);
+	SELFTEST_ASSERT(g_cfg.version >= 3);
+	SELFTEST_ASSERT_INTEGER(g_cfg.sections.magic, CFG_SECTIONS_MAGIC);
+
+	// leave clean config for other tests
+	CFG_SetDefaultConfig();
+	CFG_Save_IfThereArePendingChanges();
+}
+
+#endif
@@ -0,0 +1,151 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../driver/drv_ntp.h"
+
+// 2023-06-01 00:00:00 UTC, Thursday
+#define T0 1685577600
+#define HOUR 3600
+#define DAY 86400
+
+static void Test_ClockEvents_SetTime(unsigned int utc) {
+	char cmd[64];
+
+	sprintf(cmd, "ntp_setTime %u", utc);
+	CMD_ExecuteCommand(cmd, 0);
+}
+static void Test_ClockEvents_Start() {
+	CMD_ExecuteCommand("startDriver NTP", 0);
+	// nothing answers there, so clock is only set by hand
+	CMD_ExecuteCommand("ntp_setServer 127.0.0.1:1", 0);
+	CMD_ExecuteCommand("ntp_timeZoneOfs 0", 0);
+}
+
+void Test_ClockEvents() {
+	char cmd[96];
+	int i;
+	unsigned int sunrise, sunset;
+
+	SIM_ClearOBK();
+	CMD_ExecuteCommand("lfs_format", 0);
+	Test_ClockEvents_Start();
+
+	CMD_ExecuteCommand("addClockEvent 07:00 Mon-Fri 1 addChannel 10 1", 0);
+	CMD_ExecuteCommand("addCronEvent 2 */15 * * * * addChannel 11 1", 0);
+	CMD_ExecuteCommand("addClockEvent 12:30:15 Sat,Sun 3 addChannel 12 1", 0);
+	// bad ones are rejected
+	CMD_ExecuteCommand("addCronEvent 4 61 * * * * addChannel 13 1", 0);
+	CMD_ExecuteCommand("addClockEvent 7:00 Someday 4 addChannel 13 1", 0);
+	CMD_ExecuteCommand("addClockEvent 25:00 * 4 addChannel 13 1", 0);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetCount(), 3);
+	// same one again, like from autoexec.bat, is not added twice
+	CMD_ExecuteCommand("addClockEvent 07:00 Mon-Fri 1 addChannel 10 1", 0);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetCount(), 3);
+	// nothing is scheduled without time
+	Sim_RunSeconds(2, false);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(1), 0);
+
+	// Thursday 06:59:55
+	Test_ClockEvents_SetTime(T0 + 7 * HOUR - 5);
+	Sim_RunSeconds(1, false);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(1), T0 + 7 * HOUR);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(2), T0 + 7 * HOUR);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(3), T0 + 2 * DAY + 12 * HOUR + 30 * 60 + 15);
+	Sim_RunSeconds(10, false);
+	SELFTEST_ASSERT_CHANNEL(10, 1);
+	SELFTEST_ASSERT_CHANNEL(11, 1);
+	SELFTEST_ASSERT_CHANNEL(12, 0);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(1), T0 + DAY + 7 * HOUR);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(2), T0 + 7 * HOUR + 15 * 60);
+
+	// wall clock time stays, UTC of next run moves with time zone
+	CMD_ExecuteCommand("ntp_timeZoneOfs 2", 0);
+	Sim_RunSeconds(1, false);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(1), T0 + DAY + 5 * HOUR);
+	CMD_ExecuteCommand("ntp_timeZoneOfs 0", 0);
+	Sim_RunSeconds(1, false);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(1), T0 + DAY + 7 * HOUR);
+
+	// cron - either 13th or Friday, whichever is first
+	CMD_ExecuteCommand("addCronEvent 4 0,30 12 13 * Fri addChannel 13 1", 0);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(4), T0 + DAY + 12 * HOUR);
+	CMD_ExecuteCommand("addCronEvent 4 0 12 13 Jul-Dec * addChannel 13 1", 0);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(4), T0 + 42 * DAY + 12 * HOUR);
+	CMD_ExecuteCommand("removeClockEvent 4", 0);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(4), 0);
+
+	// sunrise and sunset in Warsaw, around 02:17 and 18:50 UTC
+	CMD_ExecuteCommand("ntp_setLatlong 52.23 21.01", 0);
+	CMD_ExecuteCommand("addClockEvent sunrise * 5 addChannel 14 1", 0);
+	CMD_ExecuteCommand("addClockEvent sunset-30 * 6 addChannel 14 1", 0);
+	sunrise = ClockEvents_GetNextRun(5);
+	sunset = ClockEvents_GetNextRun(6);
+	SELFTEST_ASSERT(sunrise > T0 + DAY + 2 * HOUR + 12 * 60 && sunrise < T0 + DAY + 2 * HOUR + 22 * 60);
+	SELFTEST_ASSERT(sunset > T0 + 18 * HOUR + 15 * 60 && sunset < T0 + 18 * HOUR + 25 * 60);
+	// polar night, sun never rises
+	CMD_ExecuteCommand("ntp_setLatlong -85 0", 0);
+	SELFTEST_ASSERT(ClockEvents_GetNextRun(5) > T0 + 60 * DAY);
+	CMD_ExecuteCommand("ntp_setLatlong 52.23 21.01", 0);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(5), sunrise);
+
+	// clock step forward, by default missed runs are skipped
+	// Monday 06:00
+	Test_ClockEvents_SetTime(T0 + 4 * DAY + 6 * HOUR);
+	Sim_RunSeconds(1, false);
+	SELFTEST_ASSERT_CHANNEL(10, 1);
+	SELFTEST_ASSERT_CHANNEL(11, 1);
+	SELFTEST_ASSERT_CHANNEL(14, 0);
+	// but they can ask to be run once or all of them
+	CMD_ExecuteCommand("clockEventCatchUp 1 once", 0);
+	CMD_ExecuteCommand("clockEventCatchUp 2 all", 0);
+	// Monday 08:00, 07:00 and 06:15 ... 08:00 were missed
+	Test_ClockEvents_SetTime(T0 + 4 * DAY + 8 * HOUR);
+	Sim_RunSeconds(1, false);
+	SELFTEST_ASSERT_CHANNEL(10, 2);
+	SELFTEST_ASSERT_CHANNEL(11, 9);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(2), T0 + 4 * DAY + 8 * HOUR + 15 * 60);
+
+	// reboot, events and time of last run were saved
+	SIM_ClearOBK();
+	Test_ClockEvents_Start();
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetCount(), 5);
+	SELFTEST_ASSERT_CHANNEL(11, 0);
+	// Monday 10:00:30, 08:15 ... 10:00 were missed while device was off
+	Test_ClockEvents_SetTime(T0 + 4 * DAY + 10 * HOUR + 30);
+	Sim_RunSeconds(1, false);
+	SELFTEST_ASSERT_CHANNEL(11, 8);
+	SELFTEST_ASSERT_CHANNEL(10, 0);
+	// sunset moves by few minutes in four days
+	SELFTEST_ASSERT(ClockEvents_GetNextRun(6) > sunset + 4 * DAY - 10 * 60 && ClockEvents_GetNextRun(6) < sunset + 4 * DAY + 10 * 60);
+
+	// many events, each runs once a minute
+	for (i = 0; i < 200; i++) {
+		sprintf(cmd, "addCronEvent %i * * * * * addChannel 15 1", 100 + i);
+		CMD_ExecuteCommand(cmd, 0);
+	}
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetCount(), 205);
+	CMD_ExecuteCommand("clockEventCatchUp 100 once", 0);
+	Sim_RunSeconds(60, false);
+	SELFTEST_ASSERT_CHANNEL(15, 200);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetNextRun(299), T0 + 4 * DAY + 10 * HOUR + 2 * 60);
+	// time of last run written on clock step stays, it's not rewritten on each run
+	sprintf(cmd, "%u\r\n", T0 + 4 * DAY + 10 * HOUR + 30);
+	Test_FakeHTTPClientPacket_GET("api/lfs/clockLastRun.txt");
+	SELFTEST_ASSERT_HTML_REPLY(cmd);
+	// but it is on driver stop
+	CMD_ExecuteCommand("stopDriver NTP", 0);
+	sprintf(cmd, "%u\r\n", T0 + 4 * DAY + 10 * HOUR + 60);
+	Test_FakeHTTPClientPacket_GET("api/lfs/clockLastRun.txt");
+	SELFTEST_ASSERT_HTML_REPLY(cmd);
+	Test_ClockEvents_Start();
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetCount(), 205);
+
+	CMD_ExecuteCommand("clearClockEvents", 0);
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetCount(), 0);
+	SIM_ClearOBK();
+	Test_ClockEvents_Start();
+	SELFTEST_ASSERT_INTEGER(ClockEvents_GetCount(), 0);
+	CMD_ExecuteCommand("stopDriver NTP", 0);
+}
+
+#endif
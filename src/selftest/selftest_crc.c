@@ -0,0 +1,50 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../crc.h"
+
+static byte g_crcData[1024];
+
+void Test_CRC() {
+	int i, len, split;
+	unsigned int seed = 12345;
+	byte crc, crcA, crcB;
+	uint32_t crc32A, crc32B;
+
+	for (i = 0; i < sizeof(g_crcData); i++) {
+		seed = seed * 1103515245 + 12345;
+		g_crcData[i] = seed >> 16;
+	}
+
+	// table version must give exactly the same results as the old bitwise one,
+	// including bytes with top bit set, else existing configs would be rejected
+	for (len = 0; len < 300; len += 7) {
+		SELFTEST_ASSERT_INTEGER(CRC8_Update(0, g_crcData, len), CRC8_Bitwise(0, g_crcData, len));
+		SELFTEST_ASSERT_INTEGER(CRC8_Update(0x5A, g_crcData + len, len), CRC8_Bitwise(0x5A, g_crcData + len, len));
+	}
+	SELFTEST_ASSERT_INTEGER(CRC8_Update(0, g_crcData, sizeof(g_crcData)), CRC8_Bitwise(0, g_crcData, sizeof(g_crcData)));
+	SELFTEST_ASSERT_INTEGER(CRC8_Update(0, &g_cfg, sizeof(g_cfg)), CRC8_Bitwise(0, &g_cfg, sizeof(g_cfg)));
+	SELFTEST_ASSERT_INTEGER((byte)Tiny_CRC8((const char*)&g_cfg, sizeof(g_cfg)), CRC8_Bitwise(0, &g_cfg, sizeof(g_cfg)));
+
+	// incremental update and combine
+	crc = CRC8_Update(0, g_crcData, sizeof(g_crcData));
+	for (split = 0; split <= sizeof(g_crcData); split += 101) {
+		crcA = CRC8_Update(0, g_crcData, split);
+		SELFTEST_ASSERT_INTEGER(CRC8_Update(crcA, g_crcData + split, sizeof(g_crcData) - split), crc);
+		crcB = CRC8_Update(0, g_crcData + split, sizeof(g_crcData) - split);
+		SELFTEST_ASSERT_INTEGER(CRC8_Combine(crcA, crcB, sizeof(g_crcData) - split), crc);
+	}
+
+	// standard check value
+	SELFTEST_ASSERT_INTEGER(CRC32_Update(0, "123456789", 9), 0xCBF43926);
+	SELFTEST_ASSERT_INTEGER(CRC32_Update(CRC32_Update(0, "1234", 4), "56789", 5), 0xCBF43926);
+	SELFTEST_ASSERT_INTEGER(CRC32_Update(0, "", 0), 0);
+	for (split = 0; split <= sizeof(g_crcData); split += 101) {
+		crc32A = CRC32_Update(0, g_crcData, split);
+		crc32B = CRC32_Update(0, g_crcData + split, sizeof(g_crcData) - split);
+		SELFTEST_ASSERT_INTEGER(CRC32_Combine(crc32A, crc32B, sizeof(g_crcData) - split),
+			CRC32_Update(0, g_crcData, sizeof(g_crcData)));
+	}
+}
+
+#endif
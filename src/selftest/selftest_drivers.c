@@ -0,0 +1,46 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../driver/drv_public.h"
+
+void Test_Drivers() {
+	driverStats_t st;
+
+	// reset whole device
+	SIM_ClearOBK();
+
+	SELFTEST_ASSERT(DRV_IsRunning("TESTLED") == false);
+	SELFTEST_ASSERT(DRV_GetStats("NoSuchDriver", &st) == false);
+	// names are case insensitive
+	CMD_ExecuteCommand("startDriver testled", 0);
+	SELFTEST_ASSERT(DRV_IsRunning("TESTLED"));
+	SELFTEST_ASSERT(DRV_IsRunning("TestLed"));
+	SELFTEST_ASSERT(DRV_IsRunning("TESTPOWER") == false);
+
+	Sim_RunSeconds(3.5f, false);
+	SELFTEST_ASSERT(DRV_GetStats("TESTLED", &st));
+	SELFTEST_ASSERT(st.everySecondCalls >= 3);
+	// TESTLED has no quick tick hook, so it must not be called from there
+	SELFTEST_ASSERT_INTEGER(st.quickTickCalls, 0);
+	SELFTEST_ASSERT_INTEGER(st.channelChangedCalls, 0);
+
+	CMD_ExecuteCommand("setChannel 1 50", 0);
+	SELFTEST_ASSERT(DRV_GetStats("TESTLED", &st));
+	SELFTEST_ASSERT_INTEGER(st.channelChangedCalls, 1);
+	CMD_ExecuteCommand("driverStats", 0);
+
+	// stopped driver is removed from hook lists
+	CMD_ExecuteCommand("stopDriver TESTLED", 0);
+	SELFTEST_ASSERT(DRV_IsRunning("TESTLED") == false);
+	CMD_ExecuteCommand("setChannel 1 60", 0);
+	SELFTEST_ASSERT(DRV_GetStats("TESTLED", &st));
+	SELFTEST_ASSERT_INTEGER(st.channelChangedCalls, 1);
+
+	// restart resets counters
+	CMD_ExecuteCommand("startDriver TESTLED", 0);
+	SELFTEST_ASSERT(DRV_GetStats("TESTLED", &st));
+	SELFTEST_ASSERT_INTEGER(st.everySecondCalls, 0);
+	CMD_ExecuteCommand("stopDriver TESTLED", 0);
+}
+
+#endif
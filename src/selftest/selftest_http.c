@@ -5,6 +5,7 @@
 //#define JSMN_HEADER
 ///#include "../jsmn/jsmn.h"
 #include "../cJSON/cJSON.h"
+#include "../mqtt/new_mqtt.h"
 
 // "GET /index?tgl=1 HTTP/1.1\r\n"
 const char *http_get_template1 = "GET /%s HTTP/1.1\r\n"
@@ -42,6 +43,16 @@ const char *http_post_template1 = "POST /%s HTTP/1.1\r\n"
 "\r\n"
 "%s";
 
+const char *http_post_form_template1 = "POST /%s HTTP/1.1\r\n"
+"Host: 127.0.0.1\r\n"
+"Connection: keep - alive\r\n"
+"Content-Length: %i\r\n"
+"Content-Type: application/x-www-form-urlencoded\r\n"
+"Accept: */*\r\n"
+"Referer: http://127.0.0.1/cfg_pins\r\n"
+"\r\n"
+"%s";
+
 //jsmn_parser parser;
 cJSON *g_json;
 cJSON *g_sec_power;
@@ -107,6 +118,12 @@ void Test_FakeHTTPClientPacket_POST(const char *tg, const char *data) {
 	sprintf(buffer, http_post_template1, tg, dataLen, data);
 	Test_FakeHTTPClientPacket_Generic();
 }
+void Test_FakeHTTPClientPacket_POST_Form(const char *tg, const char *data) {
+	int dataLen = strlen(data);
+
+	sprintf(buffer, http_post_form_template1, tg, dataLen, data);
+	Test_FakeHTTPClientPacket_Generic();
+}
 void Test_FakeHTTPClientPacket_JSON(const char *tg) {
 	/*char bufferTemp[8192];
 	va_list argList;
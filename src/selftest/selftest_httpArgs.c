@@ -0,0 +1,78 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../httpserver/new_http.h"
+
+static int Test_HTTP_Args_Callback(http_request_t* request) {
+	char tmp[64];
+	int len;
+
+	http_setup(request, httpMimeTypeText);
+	len = http_getRequestArg(request, "a", tmp, sizeof(tmp));
+	hprintf255(request, "a=[%s]%i ", tmp, len);
+	len = http_getRequestArg(request, "b", tmp, sizeof(tmp));
+	hprintf255(request, "b=[%s]%i ", tmp, len);
+	len = http_getRequestArg(request, "missing", tmp, sizeof(tmp));
+	hprintf255(request, "missing=[%s]%i ", tmp, len);
+	hprintf255(request, "indexed=%i", HTTP_GetArgsCount(request));
+	poststr(request, NULL);
+	return 0;
+}
+
+void Test_HTTP_Args() {
+	static bool bRegistered = false;
+	char url[1024];
+	int i;
+
+	SIM_ClearOBK();
+	if (bRegistered == false) {
+		HTTP_RegisterCallback("/argtest", HTTP_ANY, Test_HTTP_Args_Callback);
+		bRegistered = true;
+	}
+
+	// decoding, bare names, first one wins
+	Test_FakeHTTPClientPacket_GET("argtest?c&a=hello+world%21&b=%3D%26x&a=second");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "a=[hello world!]12 ") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "b=[=&x]3 ") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "missing=[]0 ") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "indexed=3") != 0);
+	// index belongs to request, next one doesn't see it
+	Test_FakeHTTPClientPacket_GET("argtest");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "a=[]0 ") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "indexed=0") != 0);
+
+	// value is clipped to buffer, but real length is returned
+	Test_FakeHTTPClientPacket_GET("argtest?b=0123456789012345678901234567890123456789012345678901234567890123456789");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "b=[012345678901234567890123456789012345678901234567890123456789012]70 ") != 0);
+
+	// urlencoded form body is indexed as well, query goes first
+	Test_FakeHTTPClientPacket_POST_Form("argtest?a=1", "b=two+words&a=3");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "a=[1]1 ") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "b=[two words]9 ") != 0);
+	// other bodies are left for handler
+	Test_FakeHTTPClientPacket_POST("argtest?a=1", "b=2");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "b=[]0 ") != 0);
+
+	// more arguments than index can hold are still found by scanning
+	strcpy(url, "argtest?");
+	for (i = 0; i < 120; i++) {
+		sprintf(url + strlen(url), "x%i=%i&", i, i);
+	}
+	strcat(url, "a=last");
+	Test_FakeHTTPClientPacket_GET(url);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "a=[last]4 ") != 0);
+
+	// real form, every pin field is looked up
+	Test_FakeHTTPClientPacket_GET("cfg_pins?6=1&r6=3&7=2&r7=4&e7=5");
+	SELFTEST_ASSERT_INTEGER(PIN_GetPinRoleForPinIndex(6), 1);
+	SELFTEST_ASSERT_INTEGER(PIN_GetPinChannelForPinIndex(6), 3);
+	SELFTEST_ASSERT_INTEGER(PIN_GetPinRoleForPinIndex(7), 2);
+	SELFTEST_ASSERT_INTEGER(PIN_GetPinChannelForPinIndex(7), 4);
+	SELFTEST_ASSERT_INTEGER(PIN_GetPinChannel2ForPinIndex(7), 5);
+	// same as POSTed form
+	Test_FakeHTTPClientPacket_POST_Form("cfg_pins", "6=0&r6=0&7=0&r7=0&e7=0");
+	SELFTEST_ASSERT_INTEGER(PIN_GetPinRoleForPinIndex(6), 0);
+	SELFTEST_ASSERT_INTEGER(PIN_GetPinChannel2ForPinIndex(7), 0);
+}
+
+#endif
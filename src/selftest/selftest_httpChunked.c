@@ -0,0 +1,137 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../httpserver/new_http.h"
+
+// Check of reply writer - page sent through small window, both plain and
+// chunked, must carry same body as the one selftests get without socket
+// (whole page in one buffer, as it was before writer sent it in parts).
+// What would go to socket is caught by send hook, so no socket is needed.
+
+static char g_chunkRequest[256];
+static char g_chunkWindow[4096];
+static char g_chunkRef[8192];
+static char g_chunkWire[16384];
+static char g_chunkBody[8192];
+static int g_chunkWireLen;
+
+static void Test_HTTP_Chunked_Capture(const char *data, int len) {
+	if (g_chunkWireLen + len > sizeof(g_chunkWire) - 1) {
+		len = sizeof(g_chunkWire) - 1 - g_chunkWireLen;
+	}
+	memcpy(g_chunkWire + g_chunkWireLen, data, len);
+	g_chunkWireLen += len;
+	g_chunkWire[g_chunkWireLen] = 0;
+}
+// page as it is received by client
+static int Test_HTTP_Chunked_Transfer(const char *url, int window, int bChunked) {
+	http_request_t request;
+	int len;
+
+	g_chunkWireLen = 0;
+	g_chunkWire[0] = 0;
+	sprintf(g_chunkRequest, "GET /%s HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", url);
+	memset(&request, 0, sizeof(request));
+	// not used, hook takes everything
+	request.fd = 1;
+	request.received = g_chunkRequest;
+	request.receivedLen = strlen(g_chunkRequest);
+	request.responseCode = HTTP_RESPONSE_OK;
+	request.reply = g_chunkWindow;
+	request.replymaxlen = window;
+	request.bChunkedAllowed = bChunked;
+	HTTP_SetSendHook(Test_HTTP_Chunked_Capture);
+	len = HTTP_ProcessPacket(&request);
+	// same as server does with what is left
+	if (len > 0) {
+		Test_HTTP_Chunked_Capture(g_chunkWindow, len);
+	}
+	HTTP_SetSendHook(0);
+	return g_chunkWireLen;
+}
+// decodes chunked body, returns its length or -1 if framing is broken
+static int Test_HTTP_Chunked_Decode(const char *s, int len, char *out) {
+	const char *end = s + len;
+	int total, size;
+	char *next;
+
+	total = 0;
+	while (s < end) {
+		size = strtol(s, &next, 16);
+		if (next == s || next + 2 > end || next[0] != '\r' || next[1] != '\n')
+			return -1;
+		s = next + 2;
+		if (size == 0) {
+			// last chunk, then empty line
+			if (s + 2 != end || s[0] != '\r' || s[1] != '\n')
+				return -1;
+			return total;
+		}
+		if (s + size + 2 > end || s[size] != '\r' || s[size + 1] != '\n')
+			return -1;
+		memcpy(out + total, s, size);
+		total += size;
+		s += size + 2;
+	}
+	return -1;
+}
+
+static void Test_HTTP_Chunked_Page(const char *url, int window) {
+	int refLen, wireLen, bodyLen;
+	const char *wireBody;
+
+	// reference, same path as all other selftests use
+	Test_FakeHTTPClientPacket_GET(url);
+	SELFTEST_ASSERT(Test_GetLastHTMLReply() != 0);
+	refLen = strlen(Test_GetLastHTMLReply());
+	SELFTEST_ASSERT(refLen > 0);
+	SELFTEST_ASSERT(refLen < sizeof(g_chunkRef));
+	strcpy(g_chunkRef, Test_GetLastHTMLReply());
+
+	// plain, byte for byte the same
+	wireLen = Test_HTTP_Chunked_Transfer(url, window, 0);
+	SELFTEST_ASSERT(strstr(g_chunkWire, "Transfer-Encoding") == 0);
+	wireBody = strstr(g_chunkWire, "\r\n\r\n");
+	SELFTEST_ASSERT(wireBody != 0);
+	wireBody += 4;
+	SELFTEST_ASSERT_INTEGER(wireLen - (wireBody - g_chunkWire), refLen);
+	SELFTEST_ASSERT(memcmp(wireBody, g_chunkRef, refLen) == 0);
+
+	// chunked, same headers with Transfer-Encoding, same body
+	wireLen = Test_HTTP_Chunked_Transfer(url, window, 1);
+	SELFTEST_ASSERT(strstr(g_chunkWire, "\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n\r\n") != 0);
+	wireBody = strstr(g_chunkWire, "\r\n\r\n");
+	SELFTEST_ASSERT(wireBody != 0);
+	wireBody += 4;
+	bodyLen = Test_HTTP_Chunked_Decode(wireBody, wireLen - (wireBody - g_chunkWire), g_chunkBody);
+	SELFTEST_ASSERT_INTEGER(bodyLen, refLen);
+	SELFTEST_ASSERT(memcmp(g_chunkBody, g_chunkRef, refLen) == 0);
+}
+
+void Test_HTTP_Chunked() {
+	const char *tail;
+
+	SIM_ClearOBK();
+	PIN_SetPinRoleForPinIndex(9, IOR_Relay);
+	PIN_SetPinChannelForPinIndex(9, 1);
+	PIN_SetPinRoleForPinIndex(24, IOR_PWM);
+	PIN_SetPinChannelForPinIndex(24, 2);
+	CMD_ExecuteCommand("setChannel 2 50", 0);
+
+	// small window, so there are many flushes, long strings bypass it
+	// and formatted output must wrap around it
+	Test_HTTP_Chunked_Page("index", 300);
+	Test_HTTP_Chunked_Page("index", 2047);
+	Test_HTTP_Chunked_Page("cfg", 512);
+	Test_HTTP_Chunked_Page("ha_cfg", 700);
+	Test_HTTP_Chunked_Page("api/channels", 64);
+	Test_HTTP_Chunked_Page("api/info", 100);
+
+	// exact framing, body is the same as before chunked writer
+	Test_HTTP_Chunked_Transfer("api/channels", HTTP_SEND_WINDOW, 1);
+	tail = "\r\n\r\n000E\r\n{\"1\":0,\"2\":50}\r\n0\r\n\r\n";
+	SELFTEST_ASSERT(g_chunkWireLen > strlen(tail));
+	SELFTEST_ASSERT(strcmp(g_chunkWire + g_chunkWireLen - strlen(tail), tail) == 0);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../httpserver/new_http.h"
+#include "../httpserver/http_router.h"
+
+static int Test_HTTP_Router_Reply(http_request_t* request, const char* handler) {
+	char id[32];
+	char rest[64];
+
+	http_setup(request, httpMimeTypeText);
+	HTTP_GetRouteParam(request, "id", id, sizeof(id));
+	HTTP_GetRouteParam(request, "*", rest, sizeof(rest));
+	hprintf255(request, "%s id=[%s] rest=[%s]", handler, id, rest);
+	poststr(request, NULL);
+	return 0;
+}
+static int Test_HTTP_Router_Get(http_request_t* request) {
+	return Test_HTTP_Router_Reply(request, "get");
+}
+static int Test_HTTP_Router_Post(http_request_t* request) {
+	return Test_HTTP_Router_Reply(request, "post");
+}
+static int Test_HTTP_Router_Param(http_request_t* request) {
+	return Test_HTTP_Router_Reply(request, "param");
+}
+static int Test_HTTP_Router_Literal(http_request_t* request) {
+	return Test_HTTP_Router_Reply(request, "literal");
+}
+static int Test_HTTP_Router_Files(http_request_t* request) {
+	return Test_HTTP_Router_Reply(request, "files");
+}
+static int Test_HTTP_Router_Many(http_request_t* request) {
+	return Test_HTTP_Router_Reply(request, "many");
+}
+
+#define ROUTER_REPLY_IS(x) SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), x) != 0)
+
+void Test_HTTP_Router() {
+	char url[64];
+	int i, routes;
+
+	SIM_ClearOBK();
+
+	HTTP_RegisterCallback("/rt/dev/:id/state", HTTP_GET, Test_HTTP_Router_Get);
+	HTTP_RegisterCallback("/rt/dev/:id/state", HTTP_POST, Test_HTTP_Router_Post);
+	HTTP_RegisterCallback("/rt/dev/:id/:other", HTTP_GET, Test_HTTP_Router_Param);
+	HTTP_RegisterCallback("/rt/dev/main/info", HTTP_GET, Test_HTTP_Router_Literal);
+	HTTP_RegisterCallback("/rt/files/*", HTTP_ANY, Test_HTTP_Router_Files);
+
+	// method dispatch and param capture
+	Test_FakeHTTPClientPacket_GET("rt/dev/12/state?x=1");
+	ROUTER_REPLY_IS("get id=[12] rest=[]");
+	Test_FakeHTTPClientPacket_POST("rt/dev/lamp/state", "");
+	ROUTER_REPLY_IS("post id=[lamp] rest=[]");
+	// literal wins over param, param over wildcard
+	Test_FakeHTTPClientPacket_GET("rt/dev/main/info");
+	ROUTER_REPLY_IS("literal id=[] rest=[]");
+	Test_FakeHTTPClientPacket_GET("rt/dev/main/state");
+	ROUTER_REPLY_IS("get id=[main] rest=[]");
+	Test_FakeHTTPClientPacket_GET("rt/dev/7/info");
+	ROUTER_REPLY_IS("param id=[7] rest=[]");
+	// backtracking - literal "main" has no POST route for "info", nothing else matches
+	Test_FakeHTTPClientPacket_POST("rt/dev/main/info", "");
+	ROUTER_REPLY_IS("Not found");
+	// param must not be empty, and path must be complete
+	Test_FakeHTTPClientPacket_GET("rt/dev//state");
+	ROUTER_REPLY_IS("Not found");
+	Test_FakeHTTPClientPacket_GET("rt/dev/12");
+	ROUTER_REPLY_IS("Not found");
+	// wildcard takes rest of path
+	Test_FakeHTTPClientPacket_GET("rt/files/a/b/c.txt?raw=1");
+	ROUTER_REPLY_IS("files id=[] rest=[a/b/c.txt]");
+	Test_FakeHTTPClientPacket_GET("rt/files/");
+	ROUTER_REPLY_IS("files id=[] rest=[]");
+	Test_FakeHTTPClientPacket_GET("rt/files");
+	ROUTER_REPLY_IS("Not found");
+
+	// there is no limit of routes, and registering again does not add new ones
+	for (i = 0; i < 48; i++) {
+		sprintf(url, "/rt/many/%i", i);
+		HTTP_RegisterCallback(url, HTTP_GET, Test_HTTP_Router_Many);
+	}
+	routes = HTTP_GetRoutesCount();
+	for (i = 0; i < 48; i++) {
+		sprintf(url, "/rt/many/%i", i);
+		HTTP_RegisterCallback(url, HTTP_GET, Test_HTTP_Router_Many);
+	}
+	SELFTEST_ASSERT_INTEGER(HTTP_GetRoutesCount(), routes);
+	Test_FakeHTTPClientPacket_GET("rt/many/47");
+	ROUTER_REPLY_IS("many id=[] rest=[]");
+
+	// built in pages and REST API still work
+	Test_FakeHTTPClientPacket_GET("index");
+	ROUTER_REPLY_IS("<title>");
+	Test_FakeHTTPClientPacket_GET("cfg_pins_bad");
+	ROUTER_REPLY_IS("Not found");
+	Test_FakeHTTPClientPacket_JSON("api/info");
+	ROUTER_REPLY_IS("\"mqtthost\"");
+	Test_FakeHTTPClientPacket_GET("api/nothing");
+	ROUTER_REPLY_IS("GET of api/nothing");
+}
+
+#endif
@@ -1,6 +1,168 @@
 #ifdef WINDOWS
 
-#include "selftest_local.h".
+#include "selftest_local.h"
+#include "../httpclient/http_client.h"
+
+// Minimal HTTP/1.1 server on loopback, standing in for a webhook target.
+// It's pumped from the test thread, while HTTP client workers run in their own threads.
+#define STANDIN_MAX_CONNS	8
+
+static SOCKET g_standin_listen = INVALID_SOCKET;
+static SOCKET g_standin_conns[STANDIN_MAX_CONNS];
+static char g_standin_buf[STANDIN_MAX_CONNS][512];
+static int g_standin_len[STANDIN_MAX_CONNS];
+static int g_standin_port;
+static int g_standin_accepted;
+static int g_standin_requests;
+// read requests, but never answer them
+static int g_standin_bSilent;
+
+static void Test_HTTPStandIn_Start() {
+	struct sockaddr_in addr;
+	int len = sizeof(addr);
+	u_long nonBlocking = 1;
+	int i;
+
+	for (i = 0; i < STANDIN_MAX_CONNS; i++) {
+		g_standin_conns[i] = INVALID_SOCKET;
+	}
+	g_standin_accepted = 0;
+	g_standin_requests = 0;
+	g_standin_bSilent = 0;
+
+	g_standin_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	// any free port
+	addr.sin_port = 0;
+	bind(g_standin_listen, (struct sockaddr*)&addr, sizeof(addr));
+	listen(g_standin_listen, STANDIN_MAX_CONNS);
+	getsockname(g_standin_listen, (struct sockaddr*)&addr, &len);
+	g_standin_port = ntohs(addr.sin_port);
+	ioctlsocket(g_standin_listen, FIONBIO, &nonBlocking);
+}
+static void Test_HTTPStandIn_Pump() {
+	const char *reply = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK";
+	u_long nonBlocking = 1;
+	SOCKET s;
+	char *end;
+	int i, r;
+
+	while ((s = accept(g_standin_listen, 0, 0)) != INVALID_SOCKET) {
+		ioctlsocket(s, FIONBIO, &nonBlocking);
+		for (i = 0; i < STANDIN_MAX_CONNS; i++) {
+			if (g_standin_conns[i] == INVALID_SOCKET) {
+				g_standin_conns[i] = s;
+				g_standin_len[i] = 0;
+				break;
+			}
+		}
+		if (i == STANDIN_MAX_CONNS) {
+			closesocket(s);
+		}
+		g_standin_accepted++;
+	}
+	for (i = 0; i < STANDIN_MAX_CONNS; i++) {
+		if (g_standin_conns[i] == INVALID_SOCKET)
+			continue;
+		r = recv(g_standin_conns[i], g_standin_buf[i] + g_standin_len[i], sizeof(g_standin_buf[i]) - 1 - g_standin_len[i], 0);
+		if (r == 0) {
+			closesocket(g_standin_conns[i]);
+			g_standin_conns[i] = INVALID_SOCKET;
+			continue;
+		}
+		if (r < 0)
+			continue;
+		g_standin_len[i] += r;
+		g_standin_buf[i][g_standin_len[i]] = 0;
+		// GET requests have no body, so request ends with empty line
+		while ((end = strstr(g_standin_buf[i], "\r\n\r\n")) != 0) {
+			end += 4;
+			g_standin_len[i] -= (end - g_standin_buf[i]);
+			memmove(g_standin_buf[i], end, g_standin_len[i] + 1);
+			g_standin_requests++;
+			if (g_standin_bSilent == 0) {
+				send(g_standin_conns[i], reply, strlen(reply), 0);
+			}
+		}
+	}
+}
+static void Test_HTTPStandIn_Stop() {
+	int i;
+
+	for (i = 0; i < STANDIN_MAX_CONNS; i++) {
+		if (g_standin_conns[i] != INVALID_SOCKET) {
+			closesocket(g_standin_conns[i]);
+			g_standin_conns[i] = INVALID_SOCKET;
+		}
+	}
+	closesocket(g_standin_listen);
+	g_standin_listen = INVALID_SOCKET;
+}
+static void Test_HTTPStandIn_WaitForClient(int requests, int maxMS) {
+	while (g_httpclient_stats.requests < requests && maxMS > 0) {
+		Test_HTTPStandIn_Pump();
+		Sleep(1);
+		maxMS--;
+	}
+}
+static void Test_HTTP_Client_Pool() {
+	char cmd[64];
+	httpclientStats_t base;
+	int i;
+	int queued;
+
+	Test_HTTPStandIn_Start();
+	snprintf(cmd, sizeof(cmd), "SendGet http://127.0.0.1:%i/hook", g_standin_port);
+	CMD_ExecuteCommand("HTTPClient_Config 2000 5000", 0);
+
+	// burst of webhooks - workers reuse kept alive connections
+	base = g_httpclient_stats;
+	for (i = 0; i < 5; i++) {
+		CMD_ExecuteCommand(cmd, 0);
+	}
+	Test_HTTPStandIn_WaitForClient(base.requests + 5, 5000);
+	SELFTEST_ASSERT_INTEGER(g_httpclient_stats.requests - base.requests, 5);
+	SELFTEST_ASSERT_INTEGER(g_httpclient_stats.failures - base.failures, 0);
+	SELFTEST_ASSERT_INTEGER(g_standin_requests, 5);
+	SELFTEST_ASSERT(g_standin_accepted <= HTTPCLIENT_POOL_WORKERS);
+	SELFTEST_ASSERT(g_httpclient_stats.connectionsReused - base.connectionsReused >= 5 - HTTPCLIENT_POOL_WORKERS);
+
+	// silent server - requests time out, queue fills up and the rest is rejected
+	g_standin_bSilent = 1;
+	CMD_ExecuteCommand("HTTPClient_Config 300", 0);
+	base = g_httpclient_stats;
+	for (i = 0; i < HTTPCLIENT_POOL_QUEUE_SIZE + 4; i++) {
+		CMD_ExecuteCommand(cmd, 0);
+	}
+	SELFTEST_ASSERT(g_httpclient_stats.rejected - base.rejected >= 4 - HTTPCLIENT_POOL_WORKERS);
+	queued = HTTPCLIENT_POOL_QUEUE_SIZE + 4 - (g_httpclient_stats.rejected - base.rejected);
+	Test_HTTPStandIn_WaitForClient(base.requests + queued, 10000);
+	SELFTEST_ASSERT_INTEGER(g_httpclient_stats.requests - base.requests, queued);
+	SELFTEST_ASSERT_INTEGER(g_httpclient_stats.failures - base.failures, queued);
+	g_standin_bSilent = 0;
+
+	// and it works again once server answers
+	CMD_ExecuteCommand("HTTPClient_Config 2000", 0);
+	base = g_httpclient_stats;
+	CMD_ExecuteCommand(cmd, 0);
+	Test_HTTPStandIn_WaitForClient(base.requests + 1, 5000);
+	SELFTEST_ASSERT_INTEGER(g_httpclient_stats.failures - base.failures, 0);
+
+	// closed server - kept alive connection is detected as dead and request still succeeds
+	Test_HTTPStandIn_Stop();
+	Test_HTTPStandIn_Start();
+	snprintf(cmd, sizeof(cmd), "SendGet http://127.0.0.1:%i/hook", g_standin_port);
+	base = g_httpclient_stats;
+	CMD_ExecuteCommand(cmd, 0);
+	Test_HTTPStandIn_WaitForClient(base.requests + 1, 5000);
+	SELFTEST_ASSERT_INTEGER(g_httpclient_stats.failures - base.failures, 0);
+	SELFTEST_ASSERT_INTEGER(g_standin_requests, 1);
+	Test_HTTPStandIn_Stop();
+
+	CMD_ExecuteCommand("HTTPClient_Config 10000 5000", 0);
+}
 
 void Test_HTTP_Client() {
 	// reset whole device
@@ -12,6 +174,8 @@ void Test_HTTP_Client() {
 
 	SELFTEST_ASSERT_CHANNEL(1, 0);
 
+	Test_HTTP_Client_Pool();
+
 	// Also nice method of testing: addRepeatingEvent 2 -1 SendGet http://192.168.0.103/cm?cmnd=POWER%20TOGGLE
 	///CMD_ExecuteCommand("SendGet http://192.168.0.103/cm?cmnd=POWER%20TOGGLE", 0);
 	//CMD_ExecuteCommand("SendGet http://192.168.0.104/cm?cmnd=POWER%20TOGGLE", 0);
@@ -0,0 +1,117 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../i2c/drv_i2c_local.h"
+
+// MCP23017 registers, BANK0 layout (drv_i2c_mcp23017.h defines them as variables,
+// so it can be included only once)
+#define MCP_IODIRA	0x00
+#define MCP_IODIRB	0x01
+#define MCP_GPPUB	0x0D
+#define MCP_GPIOB	0x13
+#define MCP_OLATA	0x14
+#define MCP_OLATB	0x15
+
+void Test_I2C() {
+	int opens;
+	int runs;
+	int jobs;
+
+	// reset whole device
+	SIM_ClearOBK();
+	SIM_I2C_Reset();
+	SIM_I2C_AddDevice(I2C_BUS_I2C1, 0x48);
+	SIM_I2C_AddDevice(I2C_BUS_I2C1, 0x27);
+	SIM_I2C_SetRegister(I2C_BUS_I2C1, 0x48, 0, 23);
+
+	CMD_ExecuteCommand("startDriver I2C", 0);
+	CMD_ExecuteCommand("addI2CDevice_TC74 I2C1 0x48 5", 0);
+	SELFTEST_ASSERT_INTEGER(DRV_I2C_GetJobsCount(), 1);
+	Sim_RunFrames(1, false);
+	SELFTEST_ASSERT_CHANNEL(5, 23);
+
+	// TC74 is low duty, it's not read again until its period passes
+	SIM_I2C_SetRegister(I2C_BUS_I2C1, 0x48, 0, 25);
+	Sim_RunMiliseconds(500, false);
+	SELFTEST_ASSERT_CHANNEL(5, 23);
+	Sim_RunMiliseconds(600, false);
+	SELFTEST_ASSERT_CHANNEL(5, 25);
+
+	// outputs - channel changes are written to shadow latch and flushed by a job
+	CMD_ExecuteCommand("addI2CDevice_MCP23017 I2C1 0x27", 0);
+	CMD_ExecuteCommand("setChannel 6 1", 0);
+	CMD_ExecuteCommand("MCP23017_MapPinToChannel I2C1 0x27 7 6", 0);
+	CMD_ExecuteCommand("MCP23017_MapPinToChannel I2C1 0x27 9 7", 0);
+	// nothing is sent synchronously
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_OLATA), 0);
+	Sim_RunFrames(1, false);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_IODIRA), 0);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_IODIRB), 0);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_OLATA), 0x80);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_OLATB), 0);
+
+	// many changes in the same frame give a single flush
+	runs = g_i2c_stats.jobsRun;
+	CMD_ExecuteCommand("setChannel 6 0", 0);
+	CMD_ExecuteCommand("setChannel 7 1", 0);
+	SELFTEST_ASSERT_INTEGER(DRV_I2C_GetJobsCount(), 2);
+	Sim_RunFrames(1, false);
+	SELFTEST_ASSERT_INTEGER(g_i2c_stats.jobsRun - runs, 1);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_OLATA), 0);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_OLATB), 0x02);
+	// setting the same value doesn't touch the bus
+	runs = g_i2c_stats.jobsRun;
+	CMD_ExecuteCommand("setChannel 7 1", 0);
+	Sim_RunFrames(1, false);
+	SELFTEST_ASSERT_INTEGER(g_i2c_stats.jobsRun - runs, 0);
+
+	// inputs - pin is configured as input with pull-up and polled
+	SIM_I2C_SetRegister(I2C_BUS_I2C1, 0x27, MCP_GPIOB, 0x01);
+	CMD_ExecuteCommand("MCP23017_MapInputToChannel I2C1 0x27 8 12", 0);
+	Sim_RunFrames(1, false);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_IODIRB), 0x01);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_GPPUB), 0x01);
+	// latch of the other output is kept
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_OLATB), 0x02);
+	SELFTEST_ASSERT_CHANNEL(12, 1);
+	SIM_I2C_SetRegister(I2C_BUS_I2C1, 0x27, MCP_GPIOB, 0x00);
+	Sim_RunMiliseconds(100, false);
+	SELFTEST_ASSERT_CHANNEL(12, 0);
+	SIM_I2C_SetRegister(I2C_BUS_I2C1, 0x27, MCP_GPIOB, 0x01);
+	Sim_RunMiliseconds(100, false);
+	SELFTEST_ASSERT_CHANNEL(12, 1);
+
+	// batching - all jobs due in the same frame share a single bus open
+	Sim_RunMiliseconds(2000, false);
+	opens = SIM_I2C_GetBusOpensCount();
+	runs = g_i2c_stats.jobsRun;
+	CMD_ExecuteCommand("setChannel 6 1", 0);
+	CMD_ExecuteCommand("MCP23017_MapPinToChannel I2C1 0x27 0 13", 0);
+	Sim_RunFrames(1, false);
+	SELFTEST_ASSERT(g_i2c_stats.jobsRun - runs >= 1);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetBusOpensCount() - opens, 1);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetRegister(I2C_BUS_I2C1, 0x27, MCP_OLATA), 0x80);
+
+	// missing device reads as 0xFF, but bus itself works
+	CMD_ExecuteCommand("addI2CDevice_TC74 I2C1 0x4A 8", 0);
+	Sim_RunFrames(1, false);
+	SELFTEST_ASSERT_CHANNEL(8, 255);
+
+	// LCD init is done step by step, one job per step, so the quick tick doesn't wait on it
+	SIM_I2C_AddDevice(I2C_BUS_I2C1, 0x23);
+	jobs = DRV_I2C_GetJobsCount();
+	CMD_ExecuteCommand("addI2CDevice_LCD_PCF8574 I2C1 0x23 0 0 0", 0);
+	Sim_RunFrames(1, false);
+	SELFTEST_ASSERT_INTEGER(DRV_I2C_GetJobsCount(), jobs + 1);
+	Sim_RunMiliseconds(1000, false);
+	SELFTEST_ASSERT_INTEGER(DRV_I2C_GetJobsCount(), jobs);
+
+	// stopping driver frees devices and jobs
+	CMD_ExecuteCommand("stopDriver I2C", 0);
+	SELFTEST_ASSERT_INTEGER(DRV_I2C_GetJobsCount(), 0);
+	opens = SIM_I2C_GetBusOpensCount();
+	Sim_RunMiliseconds(2000, false);
+	SELFTEST_ASSERT_INTEGER(SIM_I2C_GetBusOpensCount(), opens);
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../driver/drv_ledBus.h"
+#include "../driver/drv_bp5758d.h"
+#include "../driver/drv_bp1658cj.h"
+#include "../driver/drv_sm2135.h"
+
+static ledBusFrame_t g_decoded;
+
+static void Test_LEDBus_Decode() {
+	int errors;
+
+	errors = LEDBus_Capture_Decode(&g_decoded);
+	SELFTEST_ASSERT_INTEGER(errors, 0);
+	LEDBus_Capture_Reset();
+}
+
+void Test_LEDBus() {
+	// reset whole device
+	SIM_ClearOBK();
+	// record waveform instead of driving pins
+	LEDBus_SetDefaultBackend(&g_ledBusBackend_Capture);
+	LEDBus_Capture_Reset();
+
+	CMD_ExecuteCommand("startDriver BP5758D", 0);
+	// init sequence - setup, enable, 5 currents, 10 zero values
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.count, 1);
+	SELFTEST_ASSERT_INTEGER(g_decoded.size, 17);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[0], BP5758D_ADDR_SETUP);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], BP5758D_ENABLE_OUTPUTS_ALL);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[2], BP5758D_14MA);
+
+	CMD_ExecuteCommand("BP5758D_RGBCW FF00000000", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.count, 1);
+	SELFTEST_ASSERT_INTEGER(g_decoded.size, 11);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[0], BP5758D_ADDR_OUT1_GL);
+	// 1023 as two 5 bit parts
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], 0x1F);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[2], 0x1F);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[3], 0);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[4], 0);
+
+	// same color again must not touch the bus
+	CMD_ExecuteCommand("BP5758D_RGBCW FF00000000", 0);
+	SELFTEST_ASSERT_INTEGER(LEDBus_Capture_GetSamplesCount(), 0);
+
+	// all zero is sleep - disable outputs and sleep command
+	CMD_ExecuteCommand("BP5758D_RGBCW 0000000000", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.count, 2);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[0], BP5758D_ADDR_SETUP);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], BP5758D_DISABLE_OUTPUTS_ALL);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[2], BP5758D_ADDR_SLEEP);
+	CMD_ExecuteCommand("BP5758D_RGBCW 0000000000", 0);
+	SELFTEST_ASSERT_INTEGER(LEDBus_Capture_GetSamplesCount(), 0);
+
+	// wake up - enable outputs first, then colors
+	CMD_ExecuteCommand("BP5758D_RGBCW 0000000080", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.count, 2);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[0], BP5758D_ADDR_SETUP);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], BP5758D_ENABLE_OUTPUTS_ALL);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[2], BP5758D_ADDR_OUT1_GL);
+	SELFTEST_ASSERT_INTEGER(g_decoded.size, 13);
+
+	// changing map changes frame, so it's sent even for the same color
+	CMD_ExecuteCommand("BP5758D_RGBCW FF00000000", 0);
+	LEDBus_Capture_Reset();
+	CMD_ExecuteCommand("BP5758D_Map 1 0 2 3 4", 0);
+	CMD_ExecuteCommand("BP5758D_RGBCW FF00000000", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.count, 1);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], 0);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[2], 0);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[3], 0x1F);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[4], 0x1F);
+	CMD_ExecuteCommand("stopDriver BP5758D", 0);
+
+	// BP1658CJ has Green and Red swapped by default
+	CMD_ExecuteCommand("startDriver BP1658CJ", 0);
+	LEDBus_Capture_Reset();
+	CMD_ExecuteCommand("BP1658CJ_RGBCW 00FF000000", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.count, 1);
+	SELFTEST_ASSERT_INTEGER(g_decoded.size, 12);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[0], BP1658CJ_ADDR_OUT);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], BP1658CJ_SUBADDR);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[2], 0x1F);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[3], 0x1F);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[4], 0);
+	CMD_ExecuteCommand("BP1658CJ_RGBCW 00FF000000", 0);
+	SELFTEST_ASSERT_INTEGER(LEDBus_Capture_GetSamplesCount(), 0);
+	CMD_ExecuteCommand("BP1658CJ_RGBCW 0000000000", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.size, 12);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[0], BP1658CJ_ADDR_SLEEP);
+	CMD_ExecuteCommand("stopDriver BP1658CJ", 0);
+
+	// SM2135 uses 8 bit values, default order is BGR WC
+	CMD_ExecuteCommand("startDriver SM2135", 0);
+	LEDBus_Capture_Reset();
+	CMD_ExecuteCommand("SM2135_RGBCW 0A14000000", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.count, 1);
+	SELFTEST_ASSERT_INTEGER(g_decoded.size, 8);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[0], SM2135_ADDR_MC);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], SM2135_20MA);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[2], SM2135_RGB);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[3], 0x00);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[4], 0x14);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[5], 0x0A);
+	// current is a part of frame, so it's resent
+	CMD_ExecuteCommand("SM2135_Current 3 4", 0);
+	CMD_ExecuteCommand("SM2135_RGBCW 0A14000000", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], SM2135_25MA);
+	// separate modes sends CW in two transactions
+	CFG_SetFlag(OBK_FLAG_SM2135_SEPARATE_MODES, true);
+	CMD_ExecuteCommand("SM2135_RGBCW 000000FF10", 0);
+	Test_LEDBus_Decode();
+	SELFTEST_ASSERT_INTEGER(g_decoded.count, 2);
+	SELFTEST_ASSERT_INTEGER(g_decoded.size, 6);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[1], SM2135_30MA);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[2], SM2135_CW);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[3], SM2135_ADDR_C);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[4], 0x10);
+	SELFTEST_ASSERT_INTEGER(g_decoded.data[5], 0xFF);
+	CFG_SetFlag(OBK_FLAG_SM2135_SEPARATE_MODES, false);
+
+	// smooth transitions call driver every quick tick,
+	// but bus must be silent once the fade is done
+	CFG_SetFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS, true);
+	CMD_ExecuteCommand("led_enableAll 1", 0);
+	CMD_ExecuteCommand("led_basecolor_rgb FF0000", 0);
+	Sim_RunSeconds(5, false);
+	LEDBus_Capture_Reset();
+	Sim_RunSeconds(1, false);
+	SELFTEST_ASSERT_INTEGER(LEDBus_Capture_GetSamplesCount(), 0);
+	CFG_SetFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS, false);
+	CMD_ExecuteCommand("stopDriver SM2135", 0);
+
+	LEDBus_SetDefaultBackend(&g_ledBusBackend_GPIO);
+}
+
+#endif
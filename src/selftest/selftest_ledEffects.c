@@ -0,0 +1,131 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+
+void Test_LEDEffects() {
+	int i, candle[10];
+
+	// reset whole device
+	SIM_ClearOBK();
+
+	PIN_SetPinRoleForPinIndex(24, IOR_PWM);
+	PIN_SetPinChannelForPinIndex(24, 1);
+
+	PIN_SetPinRoleForPinIndex(26, IOR_PWM);
+	PIN_SetPinChannelForPinIndex(26, 2);
+
+	PIN_SetPinRoleForPinIndex(9, IOR_PWM);
+	PIN_SetPinChannelForPinIndex(9, 3);
+
+	CMD_ExecuteCommand("led_enableAll 1", 0);
+	CMD_ExecuteCommand("led_dimmer 100", 0);
+
+	// fade red to blue in 1s, first frame is set at once
+	CMD_ExecuteCommand("led_effect fade 1000 FF0000 0000FF", 0);
+	SELFTEST_ASSERT(LED_Effect_IsRunning());
+	SELFTEST_ASSERT_STRING(LED_Effect_GetName(), "fade");
+	SELFTEST_ASSERT_CHANNEL(1, 100);
+	SELFTEST_ASSERT_CHANNEL(3, 0);
+	Sim_RunMiliseconds(500, false);
+	SELFTEST_ASSERT(abs(CHANNEL_Get(1) - 50) <= 1);
+	SELFTEST_ASSERT(abs(CHANNEL_Get(3) - 50) <= 1);
+	// one-shot effect ends on last color
+	Sim_RunMiliseconds(600, false);
+	SELFTEST_ASSERT_CHANNEL(1, 0);
+	SELFTEST_ASSERT_CHANNEL(3, 100);
+	SELFTEST_ASSERT(LED_Effect_IsRunning() == 0);
+
+	// breathe is dimmest at start, full at half of period
+	CMD_ExecuteCommand("led_effect breathe 1000 00FF00", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 0);
+	SELFTEST_ASSERT(CHANNEL_Get(2) > 0 && CHANNEL_Get(2) < 10);
+	Sim_RunMiliseconds(500, false);
+	SELFTEST_ASSERT_CHANNEL(2, 100);
+	Sim_RunMiliseconds(500, false);
+	SELFTEST_ASSERT(CHANNEL_Get(2) < 10);
+	SELFTEST_ASSERT(LED_Effect_IsRunning());
+
+	// colour wheel, red, yellow after 1/6 of period, green after 2/6
+	CMD_ExecuteCommand("led_effect cycle 600", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 100);
+	SELFTEST_ASSERT_CHANNEL(2, 0);
+	Sim_RunMiliseconds(100, false);
+	SELFTEST_ASSERT_CHANNEL(1, 100);
+	SELFTEST_ASSERT_CHANNEL(2, 100);
+	Sim_RunMiliseconds(100, false);
+	SELFTEST_ASSERT_CHANNEL(1, 0);
+	SELFTEST_ASSERT_CHANNEL(2, 100);
+	// loops
+	Sim_RunMiliseconds(400, false);
+	SELFTEST_ASSERT_CHANNEL(1, 100);
+	SELFTEST_ASSERT_CHANNEL(2, 0);
+
+	// frame budget, 10 fps means nothing changes for 100ms
+	CMD_ExecuteCommand("led_effectFPS 10", 0);
+	CMD_ExecuteCommand("led_effect cycle 600", 0);
+	Sim_RunMiliseconds(95, false);
+	SELFTEST_ASSERT_CHANNEL(2, 0);
+	Sim_RunMiliseconds(5, false);
+	SELFTEST_ASSERT_CHANNEL(2, 100);
+	CMD_ExecuteCommand("led_effectFPS 50", 0);
+
+	// effect does not turn light on, but time goes on
+	CMD_ExecuteCommand("led_enableAll 0", 0);
+	Sim_RunMiliseconds(100, false);
+	SELFTEST_ASSERT_CHANNEL(1, 0);
+	SELFTEST_ASSERT_CHANNEL(2, 0);
+	CMD_ExecuteCommand("led_enableAll 1", 0);
+	Sim_RunMiliseconds(20, false);
+	SELFTEST_ASSERT_CHANNEL(1, 0);
+	SELFTEST_ASSERT_CHANNEL(2, 100);
+
+	// candle flickers around given color, the same way each time
+	CMD_ExecuteCommand("led_effect candle 1000 FF0000", 0);
+	for (i = 0; i < 10; i++) {
+		Sim_RunMiliseconds(20, false);
+		candle[i] = CHANNEL_Get(1);
+		SELFTEST_ASSERT(candle[i] >= 50 && candle[i] <= 100);
+		SELFTEST_ASSERT_CHANNEL(2, 0);
+	}
+	CMD_ExecuteCommand("led_effect candle 1000 FF0000", 0);
+	for (i = 0; i < 10; i++) {
+		Sim_RunMiliseconds(20, false);
+		SELFTEST_ASSERT_CHANNEL(1, candle[i]);
+	}
+
+	// sunrise starts dark and ends on given color
+	CMD_ExecuteCommand("led_effect sunrise 2000 FFFFFF", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 0);
+	SELFTEST_ASSERT_CHANNEL(3, 0);
+	Sim_RunMiliseconds(1000, false);
+	SELFTEST_ASSERT_CHANNEL(1, 100);
+	SELFTEST_ASSERT(CHANNEL_Get(2) > 0 && CHANNEL_Get(2) < 100);
+	Sim_RunMiliseconds(1100, false);
+	SELFTEST_ASSERT_CHANNEL(3, 100);
+	SELFTEST_ASSERT(LED_Effect_IsRunning() == 0);
+
+	// frames go only to output, stopped effect gives base color back
+	CMD_ExecuteCommand("led_basecolor_rgb 00FF00", 0);
+	CMD_ExecuteCommand("led_effect cycle 600", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 100);
+	SELFTEST_ASSERT_CHANNEL(2, 0);
+	Sim_RunMiliseconds(100, false);
+	SELFTEST_ASSERT_CHANNEL(1, 100);
+	SELFTEST_ASSERT_CHANNEL(2, 100);
+	SELFTEST_ASSERT(LED_GetRed255() == 0);
+	SELFTEST_ASSERT(LED_GetGreen255() == 255);
+	SELFTEST_ASSERT(LED_GetBlue255() == 0);
+	CMD_ExecuteCommand("led_effect off", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 0);
+	SELFTEST_ASSERT_CHANNEL(2, 100);
+	SELFTEST_ASSERT_CHANNEL(3, 0);
+
+	// also over HTTP
+	Test_FakeHTTPClientPacket_GET("cm?cmnd=led_effect%20breathe");
+	SELFTEST_ASSERT_STRING(LED_Effect_GetName(), "breathe");
+	CMD_ExecuteCommand("led_effect off", 0);
+	SELFTEST_ASSERT(LED_Effect_IsRunning() == 0);
+	SELFTEST_ASSERT(CMD_ExecuteCommand("led_effect nonexistent", 0) == CMD_RES_BAD_ARGUMENT);
+}
+
+#endif
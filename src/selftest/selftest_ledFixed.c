@@ -0,0 +1,110 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+
+static int Test_LEDFixed_Diff(int a, int b) {
+	return a > b ? a - b : b - a;
+}
+
+// fixed point pipeline must stay within 1 LSB of the float one
+static void Test_LEDFixed_Mapping() {
+	static const int raws[] = { 0, 1, 17, 100, 128, 200, 254, 255 };
+	char buffer[32];
+	int mode, dimmer, i;
+	int fixed, reference;
+	float brig;
+
+	for (mode = 0; mode <= 4; mode++) {
+		sprintf(buffer, "led_expoMode %i", mode);
+		CMD_ExecuteCommand(buffer, 0);
+		for (dimmer = 0; dimmer <= 100; dimmer++) {
+			sprintf(buffer, "led_dimmer %i", dimmer);
+			CMD_ExecuteCommand(buffer, 0);
+			brig = dimmer * 0.01f;
+			for (i = 0; i < sizeof(raws) / sizeof(raws[0]); i++) {
+				fixed = LED_BrightnessMappingQ16(raws[i] << LED_Q16_SHIFT) >> LED_Q16_SHIFT;
+				reference = (int)LED_BrightnessMapping(raws[i], brig);
+				SELFTEST_ASSERT(Test_LEDFixed_Diff(fixed, reference) <= 1);
+			}
+			// full red, so channel 1 is what float pipeline used to set
+			reference = (int)(LED_BrightnessMapping(255, brig) * (100.0f / 255.0f));
+			SELFTEST_ASSERT(Test_LEDFixed_Diff(CHANNEL_Get(1), reference) <= 1);
+		}
+	}
+	CMD_ExecuteCommand("led_expoMode 0", 0);
+}
+static void Test_LEDFixed_MoveTowards() {
+	static const int deltas[] = { 1, 5, 16, 33, 100, 250 };
+	float cur, step;
+	int curQ16, stepQ16;
+	int i, j, target;
+
+	for (i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++) {
+		step = deltas[i] * 0.001f * 200.0f;
+		stepQ16 = (int)(step * LED_Q16_ONE);
+		for (target = 0; target <= 255; target += 255) {
+			cur = 255 - target;
+			curQ16 = cur * LED_Q16_ONE;
+			for (j = 0; j < 2000 && (cur != target || curQ16 != (target << LED_Q16_SHIFT)); j++) {
+				cur = Mathf_MoveTowards(cur, target, step);
+				curQ16 = LED_MoveTowardsQ16(curQ16, target << LED_Q16_SHIFT, stepQ16);
+				SELFTEST_ASSERT(Test_LEDFixed_Diff(curQ16 >> LED_Q16_SHIFT, (int)cur) <= 1);
+			}
+			// both reach target
+			SELFTEST_ASSERT(cur == target);
+			SELFTEST_ASSERT_INTEGER(curQ16, target << LED_Q16_SHIFT);
+		}
+	}
+}
+static void Test_LEDFixed_Lerp() {
+	int i, prev;
+
+	CFG_SetFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS, true);
+	CMD_ExecuteCommand("led_basecolor_rgb 000000", 0);
+	CMD_ExecuteCommand("led_finishFullLerp", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 0);
+
+	// 200 units per second, so red goes up 20 per 100ms
+	CMD_ExecuteCommand("led_lerpSpeed 200", 0);
+	CMD_ExecuteCommand("led_dimmer 100", 0);
+	CMD_ExecuteCommand("led_basecolor_rgb FF0000", 0);
+	prev = CHANNEL_Get(1);
+	for (i = 0; i < 5; i++) {
+		LED_RunQuickColorLerp(100);
+		SELFTEST_ASSERT(CHANNEL_Get(1) > prev);
+		prev = CHANNEL_Get(1);
+	}
+	// 5 * 20 = 100 of 255
+	SELFTEST_ASSERT_CHANNEL(1, 39);
+	SELFTEST_ASSERT_CHANNEL(2, 0);
+	CMD_ExecuteCommand("led_finishFullLerp", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 100);
+
+	// halfway down
+	CMD_ExecuteCommand("led_dimmer 50", 0);
+	CMD_ExecuteCommand("led_finishFullLerp", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 50);
+	CFG_SetFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS, false);
+}
+void Test_LEDFixed() {
+	// reset whole device
+	SIM_ClearOBK();
+
+	PIN_SetPinRoleForPinIndex(24, IOR_PWM);
+	PIN_SetPinChannelForPinIndex(24, 1);
+
+	PIN_SetPinRoleForPinIndex(26, IOR_PWM);
+	PIN_SetPinChannelForPinIndex(26, 2);
+
+	PIN_SetPinRoleForPinIndex(9, IOR_PWM);
+	PIN_SetPinChannelForPinIndex(9, 3);
+
+	CMD_ExecuteCommand("led_enableAll 1", 0);
+	CMD_ExecuteCommand("led_basecolor_rgb FF0000", 0);
+
+	Test_LEDFixed_Mapping();
+	Test_LEDFixed_MoveTowards();
+	Test_LEDFixed_Lerp();
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include "../sim/sim_import.h"
 
 void SelfTest_Failed(const char *file, const char *function, int line, const char *exp);
+int SelfTest_GetFailedCount();
 
 #define SELFTEST_ASSERT(expr) \
 	if (!(expr)) \
@@ -32,7 +33,7 @@ void SelfTest_Failed(const char *file, const char *function, int line, const cha
 #define SELFTEST_ASSERT_FLAG(flag, value) SELFTEST_ASSERT(CFG_HasFlag(flag)==value);
 
 //#define FLOAT_EQUALS (a,b) (fabs(a-b)<0.001f)
-inline bool Float_Equals(float a, float b) {
+static inline bool Float_Equals(float a, float b) {
 	float res = fabs(a - b);
 	return res < 0.001f;
 }
@@ -40,7 +41,24 @@ inline bool Float_Equals(float a, float b) {
 
 void Test_Commands_Channels();
 void Test_LEDDriver();
+void Test_LEDBus();
+void Test_I2C();
+void Test_Drivers();
+void Test_Perf();
+void Test_CRC();
+void Test_CfgSections();
+void Test_MemPool();
+void Test_LEDFixed();
+void Test_LEDEffects();
+void Test_PixelBus();
+void Test_HTTP_Args();
+void Test_HTTP_Router();
+void Test_HTTP_Chunked();
 void Test_TuyaMCU_Basic();
+void Test_TuyaMCU_Parser();
+void Test_TuyaMCU_Mappings();
+
+void Win_DoBenchmarks();
 void Test_Command_If();
 void Test_Command_If_Else();
 void Test_LFS();
@@ -52,15 +70,24 @@ void Test_RepeatingEvents();
 void Test_HTTP_Client();
 void Test_DeviceGroups();
 void Test_NTP();
+void Test_ClockEvents();
+void Test_SSDP();
+void Test_Ping();
+void Test_ChangeHandlers();
+void Test_Expressions_RunTests_Basic();
+void Test_Http();
 void Test_MQTT();
 void Test_Tasmota();
 void Test_EnergyMeter();
 void Test_DHT();
 void Test_Flags();
 void Test_MultiplePinsOnChannel();
+void Test_ButtonEvents();
+void Test_ButtonEvents_EdgeInterrupts();
 
 void Test_FakeHTTPClientPacket_GET(const char *tg);
 void Test_FakeHTTPClientPacket_POST(const char *tg, const char *data);
+void Test_FakeHTTPClientPacket_POST_Form(const char *tg, const char *data);
 void Test_FakeHTTPClientPacket_JSON(const char *tg);
 const char *Test_GetLastHTMLReply();
 
@@ -68,6 +95,8 @@ const char *Test_GetLastHTMLReply();
 void Sim_RunMiliseconds(int ms, bool bApplyRealtimeWait);
 void Sim_RunSeconds(float f, bool bApplyRealtimeWait);
 void Sim_RunFrames(int n, bool bApplyRealtimeWait);
+void NewTuyaMCUSimulator_SetData(const char **data, int count, int bytesPerFrame);
+bool NewTuyaMCUSimulator_IsDone();
 
 int Test_GetJSONValue_Integer_Nested2(const char *par1, const char *par2, const char *keyword);
 float Test_GetJSONValue_Float_Nested2(const char *par1, const char *par2, const char *keyword);
@@ -77,6 +106,7 @@ const char *Test_GetJSONValue_String(const char *keyword, const char *obj);
 void SIM_SendFakeMQTTAndRunSimFrame_CMND(const char *command, const char *arguments);
 void SIM_SendFakeMQTTRawChannelSet(int channelIndex, const char *arguments);
 void SIM_ClearMQTTHistory();
+void SIM_ClearAndPrepareForMQTTTesting(const char *clientName);
 bool SIM_CheckMQTTHistoryForString(const char *topic, const char *value, bool bRetain);
 bool SIM_CheckMQTTHistoryForFloat(const char *topic, float value, bool bRetain);
 
@@ -0,0 +1,148 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../mem_pool.h"
+
+static int Test_MemPool_FindClass(int size) {
+	memPoolStats_t s;
+	int i;
+
+	for (i = 0; i < Pool_GetClassCount(); i++) {
+		Pool_GetStats(i, &s);
+		if (s.blockSize >= size) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void Test_MemPool() {
+	memPoolStats_t s, s2, s3;
+	memHeapStats_t heap;
+	void *blocks[80];
+	char *str;
+	void *p;
+	int i, j, cls, usedBefore, usedBefore2, usedBefore3;
+	unsigned int heapAllocs;
+
+	SIM_ClearOBK();
+	Pool_ResetStats();
+
+	// small block comes from the smallest class that fits
+	cls = Test_MemPool_FindClass(10);
+	SELFTEST_ASSERT(cls >= 0);
+	Pool_GetStats(cls, &s);
+	usedBefore = s.used;
+	p = Pool_Malloc(10);
+	SELFTEST_ASSERT(p != 0);
+	memset(p, 0xAB, 10);
+	Pool_GetStats(cls, &s);
+	SELFTEST_ASSERT_INTEGER(s.used, usedBefore + 1);
+	SELFTEST_ASSERT(s.highWater >= s.used);
+	Pool_Free(p);
+	Pool_GetStats(cls, &s);
+	SELFTEST_ASSERT_INTEGER(s.used, usedBefore);
+
+	str = Pool_StrDup("alias text");
+	SELFTEST_ASSERT_STRING(str, "alias text");
+	Pool_Free(str);
+
+	// empty class spills into next one (its arena must exist already) and counts a failure
+	SELFTEST_ASSERT(cls + 2 < Pool_GetClassCount());
+	Pool_GetStats(cls + 1, &s2);
+	Pool_Free(Pool_Malloc(s2.blockSize));
+	Pool_GetStats(cls, &s);
+	Pool_GetStats(cls + 1, &s2);
+	usedBefore = s.used;
+	usedBefore2 = s2.used;
+	SELFTEST_ASSERT(s.blockCount + 1 <= sizeof(blocks) / sizeof(blocks[0]));
+	for (i = 0; i < s.blockCount - usedBefore + 1; i++) {
+		blocks[i] = Pool_Malloc(s.blockSize);
+		SELFTEST_ASSERT(blocks[i] != 0);
+	}
+	Pool_GetStats(cls, &s);
+	Pool_GetStats(cls + 1, &s2);
+	SELFTEST_ASSERT_INTEGER(s.used, s.blockCount);
+	SELFTEST_ASSERT_INTEGER(s.highWater, s.blockCount);
+	SELFTEST_ASSERT_INTEGER(s.failures, 1);
+	SELFTEST_ASSERT_INTEGER(s2.used, usedBefore2 + 1);
+
+	// never more than one class up - when next class is full too, request goes to heap
+	Pool_GetStats(cls + 2, &s3);
+	usedBefore3 = s3.used;
+	Pool_GetHeapStats(&heap);
+	heapAllocs = heap.heapAllocs;
+	j = i + s2.blockCount - s2.used + 1;
+	SELFTEST_ASSERT(j <= sizeof(blocks) / sizeof(blocks[0]));
+	for (; i < j; i++) {
+		blocks[i] = Pool_Malloc(s.blockSize);
+		SELFTEST_ASSERT(blocks[i] != 0);
+	}
+	Pool_GetStats(cls + 1, &s2);
+	Pool_GetStats(cls + 2, &s3);
+	SELFTEST_ASSERT_INTEGER(s2.used, s2.blockCount);
+	SELFTEST_ASSERT_INTEGER(s3.used, usedBefore3);
+	Pool_GetHeapStats(&heap);
+	SELFTEST_ASSERT_INTEGER(heap.heapAllocs, heapAllocs + 1);
+	while (i > 0) {
+		i--;
+		Pool_Free(blocks[i]);
+	}
+	Pool_GetStats(cls, &s);
+	Pool_GetStats(cls + 1, &s2);
+	SELFTEST_ASSERT_INTEGER(s.used, usedBefore);
+	SELFTEST_ASSERT_INTEGER(s2.used, usedBefore2);
+	// high-water mark stays until reset
+	SELFTEST_ASSERT_INTEGER(s.highWater, s.blockCount);
+
+	// too big for any class goes to heap, Pool_Free handles it
+	Pool_GetHeapStats(&heap);
+	heapAllocs = heap.heapAllocs;
+	p = Pool_Malloc(16 * 1024);
+	SELFTEST_ASSERT(p != 0);
+	memset(p, 0, 16 * 1024);
+	Pool_Free(p);
+	Pool_GetHeapStats(&heap);
+	SELFTEST_ASSERT_INTEGER(heap.heapAllocs, heapAllocs + 1);
+	SELFTEST_ASSERT(heap.freeBytes > 0);
+	// simulator heap can't be walked, same as most platforms
+	SELFTEST_ASSERT_INTEGER(heap.largestFreeBlock, -1);
+	SELFTEST_ASSERT_INTEGER(heap.freeBlocks, -1);
+	SELFTEST_ASSERT_INTEGER(heap.fragmentation, -1);
+	Pool_Free(0);
+
+	// jsmn tokens of REST POST come from pool and are returned
+	cls = Test_MemPool_FindClass(2048);
+	Pool_GetStats(cls, &s);
+	usedBefore = s.used;
+	Test_FakeHTTPClientPacket_POST("api/channels", "[1,0,1]");
+	Pool_GetStats(cls, &s2);
+	SELFTEST_ASSERT(s2.allocs > s.allocs);
+	SELFTEST_ASSERT_INTEGER(s2.used, usedBefore);
+
+	// aliases are permanent, so they are kept on heap and don't hold pool blocks
+	cls = Test_MemPool_FindClass(16);
+	Pool_GetStats(cls, &s);
+	Pool_GetStats(cls + 1, &s2);
+	CMD_ExecuteCommand("alias test_pool_alias setChannel 1 5", 0);
+	CMD_ExecuteCommand("test_pool_alias", 0);
+	SELFTEST_ASSERT_CHANNEL(1, 5);
+	Pool_GetStats(cls, &s3);
+	SELFTEST_ASSERT_INTEGER(s3.used, s.used);
+	Pool_GetStats(cls + 1, &s3);
+	SELFTEST_ASSERT_INTEGER(s3.used, s2.used);
+
+	// telemetry over REST
+	Test_FakeHTTPClientPacket_JSON("api/heap");
+	SELFTEST_ASSERT(Test_GetJSONValue_Integer("free", 0) > 0);
+	SELFTEST_ASSERT_INTEGER(Test_GetJSONValue_Integer("largest_free", 0), -1);
+	SELFTEST_ASSERT_INTEGER(Test_GetJSONValue_Integer("fragmentation", 0), -1);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"high_water\":") != 0);
+
+	Pool_ResetStats();
+	Pool_GetStats(Test_MemPool_FindClass(10), &s);
+	SELFTEST_ASSERT_INTEGER(s.failures, 0);
+	SELFTEST_ASSERT_INTEGER(s.highWater, s.used);
+}
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "selftest_local.h"
 #include "../hal/hal_wifi.h"
+#include "../mqtt/new_mqtt.h"
 
 void SIM_ClearAndPrepareForMQTTTesting(const char *clientName) {
 	SIM_ClearOBK();
@@ -1,6 +1,6 @@
 #ifdef WINDOWS
 
-#include "selftest_local.h".
+#include "selftest_local.h"
 
 static int PIN_BUTTON = 10;
 static int PIN_LED_n = 11;
@@ -42,6 +42,8 @@ void Test_MultiplePinsOnChannel() {
 	PIN_SetPinRoleForPinIndex(PIN_RELAY_n, IOR_Relay_n);
 	PIN_SetPinChannelForPinIndex(PIN_RELAY_n, 1);
 
+	// only the button has to be serviced by PIN_ticks
+	SELFTEST_ASSERT(PIN_GetActivePinsCount() == 1);
 
 	SELFTEST_ASSERT_CHANNEL(1, 0);
 
@@ -84,6 +86,40 @@ void Test_MultiplePinsOnChannel() {
 	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_LED_n, false);
 	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_RELAY, true);
 	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_RELAY_n, false);
+
+	// move relay to another channel, channel 1 must not drive it anymore
+	PIN_SetPinChannelForPinIndex(PIN_RELAY, 2);
+	SELFTEST_ASSERT(CHANNEL_HasChannelPinWithRole(1, IOR_Relay) == 0);
+	SELFTEST_ASSERT(CHANNEL_HasChannelPinWithRole(2, IOR_Relay));
+	SELFTEST_ASSERT(CHANNEL_HasChannelPinWithRoleOrRole(1, IOR_Relay, IOR_Relay_n));
+
+	CMD_ExecuteCommand("setChannel 1 0", 0);
+	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_LED_n, true);
+	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_RELAY, true);
+	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_RELAY_n, true);
+
+	CMD_ExecuteCommand("setChannel 2 1", 0);
+	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_RELAY, true);
+	CMD_ExecuteCommand("setChannel 2 0", 0);
+	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_RELAY, false);
+
+	// changing role also updates index
+	PIN_SetPinRoleForPinIndex(PIN_RELAY_n, IOR_None);
+	SELFTEST_ASSERT(CHANNEL_HasChannelPinWithRole(1, IOR_Relay_n) == 0);
+	CMD_ExecuteCommand("setChannel 1 1", 0);
+	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_LED_n, false);
+	SELFTEST_ASSERT_PIN_BOOLEAN(PIN_RELAY_n, true);
+
+	// PWM on channel makes toggle go to 100
+	PIN_SetPinRoleForPinIndex(PIN_RELAY, IOR_PWM);
+	SELFTEST_ASSERT(PIN_GetActivePinsCount() == 2);
+	CMD_ExecuteCommand("setChannel 2 0", 0);
+	CMD_ExecuteCommand("toggleChannel 2", 0);
+	SELFTEST_ASSERT_CHANNEL(2, 100);
+	Sim_RunFrames(5, false);
+	SELFTEST_ASSERT(SIM_GetPWMValue(PIN_RELAY) == 100);
+	CMD_ExecuteCommand("setChannel 2 40", 0);
+	SELFTEST_ASSERT(SIM_GetPWMValue(PIN_RELAY) == 40);
 }
 
 
@@ -1,6 +1,196 @@
 #ifdef WINDOWS
 
-#include "selftest_local.h".
+#include "selftest_local.h"
+#include "../driver/drv_ntp.h"
+#include "../hal/hal_generic.h"
+
+// Minimal NTP server on loopback. Its clock is simulated time plus offset,
+// running off by given ppb, and every reply can be delayed on the way
+// there and back, so offset, round trip and drift handling can be checked.
+#define STANDIN_MAX_PENDING	8
+
+typedef struct ntpStandInReply_s {
+	int sendAt;
+	struct sockaddr_in to;
+	byte packet[48];
+} ntpStandInReply_t;
+
+static SOCKET g_ntpStandIn = INVALID_SOCKET;
+static int g_ntpStandIn_port;
+static int g_ntpStandIn_requests;
+static ntpStandInReply_t g_ntpStandIn_pending[STANDIN_MAX_PENDING];
+static int g_ntpStandIn_numPending;
+// true time is g_ntpStandIn_baseUs at simulated g_ntpStandIn_baseMs
+static long long g_ntpStandIn_baseUs;
+static int g_ntpStandIn_baseMs;
+static int g_ntpStandIn_ppb;
+// every 4th reply has short symmetric delay, others are slow on the way there
+static int g_ntpStandIn_bAsymmetric;
+
+static long long Test_NTPStandIn_TrueUs(int ms) {
+	long long elapsed = ms - g_ntpStandIn_baseMs;
+
+	return g_ntpStandIn_baseUs + elapsed * 1000 + elapsed * g_ntpStandIn_ppb / 1000000;
+}
+static void Test_NTPStandIn_SetClock(long long jumpUs, int ppb) {
+	int now = HAL_GetTimeMs();
+
+	g_ntpStandIn_baseUs = Test_NTPStandIn_TrueUs(now) + jumpUs;
+	g_ntpStandIn_baseMs = now;
+	g_ntpStandIn_ppb = ppb;
+}
+static void Test_NTPStandIn_PutTimestamp(byte *p, long long us) {
+	uint32_t sec = (uint32_t)(us / 1000000 + 2208988800LL);
+	uint32_t frac = (uint32_t)(((us % 1000000) << 32) / 1000000);
+
+	sec = htonl(sec);
+	frac = htonl(frac);
+	memcpy(p, &sec, 4);
+	memcpy(p + 4, &frac, 4);
+}
+// how long client is off, in ms
+static int Test_NTPStandIn_GetError() {
+	return (int)(NTP_GetCurrentTimeMsWithoutOffset() - Test_NTPStandIn_TrueUs(HAL_GetTimeMs()) / 1000);
+}
+static void Test_NTPStandIn_Start() {
+	struct sockaddr_in addr;
+	int len = sizeof(addr);
+	u_long nonBlocking = 1;
+
+	g_ntpStandIn_requests = 0;
+	g_ntpStandIn_numPending = 0;
+	g_ntpStandIn_bAsymmetric = 0;
+	g_ntpStandIn_baseMs = HAL_GetTimeMs();
+	// 2023-11-14 22:13:20.123456 UTC
+	g_ntpStandIn_baseUs = 1700000000123456LL;
+	g_ntpStandIn_ppb = 0;
+
+	g_ntpStandIn = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	// any free port
+	addr.sin_port = 0;
+	bind(g_ntpStandIn, (struct sockaddr*)&addr, sizeof(addr));
+	getsockname(g_ntpStandIn, (struct sockaddr*)&addr, &len);
+	g_ntpStandIn_port = ntohs(addr.sin_port);
+	ioctlsocket(g_ntpStandIn, FIONBIO, &nonBlocking);
+}
+static void Test_NTPStandIn_Pump() {
+	ntpStandInReply_t *r;
+	byte req[48];
+	int now, there, back;
+	int i, len;
+
+	now = HAL_GetTimeMs();
+	len = sizeof(struct sockaddr_in);
+	while (g_ntpStandIn_numPending < STANDIN_MAX_PENDING &&
+		recvfrom(g_ntpStandIn, (char*)req, sizeof(req), 0,
+			(struct sockaddr*)&g_ntpStandIn_pending[g_ntpStandIn_numPending].to, &len) == sizeof(req)) {
+		if (g_ntpStandIn_bAsymmetric) {
+			there = g_ntpStandIn_requests % 4 == 2 ? 20 : 200;
+			back = 20;
+		}
+		else {
+			there = 100;
+			back = 100;
+		}
+		g_ntpStandIn_requests++;
+		r = &g_ntpStandIn_pending[g_ntpStandIn_numPending++];
+		memset(r->packet, 0, sizeof(r->packet));
+		// no leap, version 4, server mode, stratum 2
+		r->packet[0] = 0x24;
+		r->packet[1] = 2;
+		// origin is transmit time of request
+		memcpy(r->packet + 24, req + 40, 8);
+		// received after 'there', sent right away
+		Test_NTPStandIn_PutTimestamp(r->packet + 32, Test_NTPStandIn_TrueUs(now + there));
+		Test_NTPStandIn_PutTimestamp(r->packet + 40, Test_NTPStandIn_TrueUs(now + there));
+		r->sendAt = now + there + back;
+		len = sizeof(struct sockaddr_in);
+	}
+	for (i = 0; i < g_ntpStandIn_numPending; i++) {
+		r = &g_ntpStandIn_pending[i];
+		if (r->sendAt > now)
+			continue;
+		sendto(g_ntpStandIn, (const char*)r->packet, sizeof(r->packet), 0, (struct sockaddr*)&r->to, sizeof(r->to));
+		*r = g_ntpStandIn_pending[--g_ntpStandIn_numPending];
+		i--;
+	}
+}
+static void Test_NTPStandIn_Stop() {
+	closesocket(g_ntpStandIn);
+	g_ntpStandIn = INVALID_SOCKET;
+}
+static void Test_NTPStandIn_Run(int ms) {
+	while (ms > 0) {
+		Sim_RunMiliseconds(5, false);
+		Test_NTPStandIn_Pump();
+		ms -= 5;
+	}
+}
+
+static void Test_NTP_Client() {
+	char cmd[64];
+	long long start;
+	int err;
+
+	Test_NTPStandIn_Start();
+	SIM_ClearOBK();
+	CMD_ExecuteCommand("startDriver NTP", 0);
+	snprintf(cmd, sizeof(cmd), "ntp_setServer 127.0.0.1:%i", g_ntpStandIn_port);
+	CMD_ExecuteCommand(cmd, 0);
+	CMD_ExecuteCommand("ntp_timeZoneOfs 0", 0);
+
+	// first sync is a step, 200 ms round trip is compensated,
+	// error left is half of quick tick period in which reply is received
+	Test_NTPStandIn_Run(8000);
+	SELFTEST_ASSERT(NTP_IsTimeSynced());
+	SELFTEST_ASSERT_INTEGER(g_ntpStandIn_requests, 4);
+	err = Test_NTPStandIn_GetError();
+	SELFTEST_ASSERT(err >= -5 && err <= 5);
+	SELFTEST_ASSERT_INTEGER(NTP_GetCurrentTimeWithoutOffset(), 1700000008);
+	CMD_ExecuteCommand("ntp_timeZoneOfs 2", 0);
+	SELFTEST_ASSERT_INTEGER(NTP_GetCurrentTime() - NTP_GetCurrentTimeWithoutOffset(), 2 * 60 * 60);
+	CMD_ExecuteCommand("ntp_timeZoneOfs 0", 0);
+
+	// time runs with ms resolution between polls
+	start = NTP_GetCurrentTimeMs();
+	Test_NTPStandIn_Run(1235);
+	SELFTEST_ASSERT_INTEGER((int)(NTP_GetCurrentTimeMs() - start), 1235);
+
+	// small offset is slewed, not stepped, and only sample with shortest
+	// round trip is used, others are off by 90 ms
+	g_ntpStandIn_bAsymmetric = 1;
+	Test_NTPStandIn_SetClock(50000, 0);
+	g_ntpStandIn_requests = 0;
+	CMD_ExecuteCommand("ntp_sync", 0);
+	Test_NTPStandIn_Run(3000);
+	SELFTEST_ASSERT_INTEGER(g_ntpStandIn_requests, 4);
+	err = Test_NTPStandIn_GetError();
+	SELFTEST_ASSERT(err <= -45 && err >= -55);
+	Test_NTPStandIn_Run(120000);
+	err = Test_NTPStandIn_GetError();
+	SELFTEST_ASSERT(err >= -5 && err <= 5);
+	g_ntpStandIn_bAsymmetric = 0;
+
+	// tick counter is 100 ppm slow, it's learned, and poll interval grows
+	Test_NTPStandIn_SetClock(0, 100000);
+	Test_NTPStandIn_Run(1800 * 1000);
+	SELFTEST_ASSERT(NTP_GetDriftPpb() > 80000 && NTP_GetDriftPpb() < 120000);
+	SELFTEST_ASSERT(NTP_GetPollInterval() > 64);
+	err = Test_NTPStandIn_GetError();
+	SELFTEST_ASSERT(err >= -5 && err <= 5);
+
+	// no reply is not a disaster, clock keeps running
+	Test_NTPStandIn_Stop();
+	CMD_ExecuteCommand("ntp_sync", 0);
+	Sim_RunSeconds(10, false);
+	SELFTEST_ASSERT(NTP_IsTimeSynced());
+	SELFTEST_ASSERT(NTP_GetCurrentTimeWithoutOffset() > 1700000000);
+
+	CMD_ExecuteCommand("stopDriver NTP", 0);
+}
 
 void Test_NTP() {
 	// reset whole device
@@ -38,7 +228,7 @@ void Test_NTP() {
 	CMD_ExecuteCommand("ntp_timeZoneOfs -12:05", 0);
 	SELFTEST_ASSERT_FLOATCOMPARE(NTP_GetTimesZoneOfsSeconds(), -(12 * 60 * 60 + 5 * 60));
 
-
+	Test_NTP_Client();
 }
 
 
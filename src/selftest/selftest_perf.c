@@ -0,0 +1,80 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../perf.h"
+#include "../cJSON/cJSON.h"
+
+static int Test_Perf_HistogramSum(perfSection_t *s) {
+	int i, sum;
+
+	sum = 0;
+	for (i = 0; i < PERF_HISTOGRAM_BUCKETS; i++) {
+		sum += s->histogram[i];
+	}
+	return sum;
+}
+void Test_Perf() {
+	perfSection_t *s;
+	cJSON *root, *sections, *item;
+	int bFoundDriver;
+
+	SIM_ClearAndPrepareForMQTTTesting("perfDevice");
+	CMD_ExecuteCommand("startDriver TESTLED", 0);
+	CMD_ExecuteCommand("perfReset", 0);
+
+	// nothing was measured yet, so summary is empty
+	CMD_ExecuteCommand("perfPublish", 0);
+	SELFTEST_ASSERT_HAD_MQTT_PUBLISH_STR("perfDevice/perf/get", "{}", false);
+	SIM_ClearMQTTHistory();
+
+	Sim_RunSeconds(2.5f, false);
+	s = PERF_GetSection("quicktick");
+	SELFTEST_ASSERT(s != 0);
+	SELFTEST_ASSERT(s->calls > 100);
+	SELFTEST_ASSERT_INTEGER(Test_Perf_HistogramSum(s), s->calls);
+	SELFTEST_ASSERT(s->maxUs * s->calls >= s->totalUs);
+	// every quick tick runs drivers, mqtt and pins
+	SELFTEST_ASSERT_INTEGER(PERF_GetSection("qt_drivers")->calls, s->calls);
+	SELFTEST_ASSERT_INTEGER(PERF_GetSection("qt_mqtt")->calls, s->calls);
+	s = PERF_GetSection("second");
+	SELFTEST_ASSERT(s->calls >= 2);
+	SELFTEST_ASSERT_INTEGER(PERF_GetSection("sec_drivers")->calls, s->calls);
+	// drivers get own section once started
+	s = PERF_GetSection("TESTLED");
+	SELFTEST_ASSERT(s != 0);
+	SELFTEST_ASSERT_INTEGER(s->calls, PERF_GetSection("second")->calls);
+	SELFTEST_ASSERT(PERF_GetSection("no_such_section") == 0);
+
+	// full data with histograms over REST
+	SELFTEST_ASSERT_INTEGER(PERF_GetSection("http")->calls, 0);
+	Test_FakeHTTPClientPacket_JSON("api/perf");
+	SELFTEST_ASSERT_JSON_VALUE_STRING(0, "unit", "us");
+	SELFTEST_ASSERT_JSON_VALUE_INTEGER(0, "buckets", PERF_HISTOGRAM_BUCKETS);
+	root = cJSON_Parse(Test_GetLastHTMLReply());
+	SELFTEST_ASSERT(root != 0);
+	sections = cJSON_GetObjectItem(root, "sections");
+	SELFTEST_ASSERT(cJSON_GetArraySize(sections) > PERF_CORE_SECTIONS);
+	item = cJSON_GetArrayItem(sections, PERF_QUICKTICK);
+	SELFTEST_ASSERT_STRING(cJSON_GetObjectItem(item, "name")->valuestring, "quicktick");
+	SELFTEST_ASSERT_INTEGER(cJSON_GetObjectItem(item, "calls")->valueint, PERF_GetSection("quicktick")->calls);
+	SELFTEST_ASSERT_INTEGER(cJSON_GetArraySize(cJSON_GetObjectItem(item, "hist")), PERF_HISTOGRAM_BUCKETS);
+	bFoundDriver = 0;
+	cJSON_ArrayForEach(item, sections) {
+		if (!strcmp(cJSON_GetObjectItem(item, "name")->valuestring, "TESTLED")) {
+			bFoundDriver = 1;
+		}
+	}
+	SELFTEST_ASSERT(bFoundDriver);
+	cJSON_Delete(root);
+	// request is accounted once it's done
+	SELFTEST_ASSERT_INTEGER(PERF_GetSection("http")->calls, 1);
+	// every route has own section
+	SELFTEST_ASSERT_INTEGER(PERF_GetSection("GET /api/perf")->calls, 1);
+
+	CMD_ExecuteCommand("perfReset", 0);
+	SELFTEST_ASSERT_INTEGER(PERF_GetSection("quicktick")->calls, 0);
+	SELFTEST_ASSERT_INTEGER(PERF_GetSection("TESTLED")->maxUs, 0);
+	CMD_ExecuteCommand("stopDriver TESTLED", 0);
+}
+
+#endif
@@ -0,0 +1,147 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../new_ping.h"
+
+// Ping monitor against simulated network, see new_ping_sim.c
+
+static void Test_Ping_Checksum() {
+	byte packet[PING_PACKET_SIZE];
+	unsigned short sum, full;
+	int seq, i;
+
+	memset(packet, 0, sizeof(packet));
+	packet[0] = 8;
+	packet[4] = 0xAF;
+	packet[5] = 0xAF;
+	for (i = 0; i < PING_DATA_SIZE; i++) {
+		packet[8 + i] = i;
+	}
+	sum = Ping_Checksum(packet, PING_PACKET_SIZE);
+	// every sequence number, including wrap, incremental update must match full checksum
+	for (seq = 1; seq <= 0x10000; seq++) {
+		sum = Ping_ChecksumUpdate(sum, (seq - 1) & 0xFFFF, seq & 0xFFFF);
+		packet[6] = (seq >> 8) & 0xFF;
+		packet[7] = seq & 0xFF;
+		packet[2] = packet[3] = 0;
+		full = Ping_Checksum(packet, PING_PACKET_SIZE);
+		if (sum != full) {
+			SELFTEST_ASSERT_INTEGER(sum, full);
+			break;
+		}
+	}
+}
+
+void Test_Ping() {
+	pingTarget_t *t;
+
+	Test_Ping_Checksum();
+
+	SIM_ClearOBK();
+	// monitor doesn't send without WiFi
+	Sim_RunSeconds(1, false);
+	PingSim_SetHost("192.168.0.1", 20, 5, 0);
+	PingSim_SetHost("192.168.0.2", 100, 0, 25);
+	// 192.168.0.3 never answers
+
+	CMD_ExecuteCommand("ping_addTarget 192.168.0.1 500", 0);
+	CMD_ExecuteCommand("ping_addTarget 192.168.0.2", 0);
+	CMD_ExecuteCommand("ping_addTarget 192.168.0.3 1000", 0);
+	CMD_ExecuteCommand("ping_addTarget 192.168.0.4 1000", 0);
+	SELFTEST_ASSERT(Ping_FindTarget("192.168.0.4") != 0);
+	// bad IP, and no free slot
+	SELFTEST_ASSERT(CMD_ExecuteCommand("ping_addTarget 192.168.300.1", 0) == CMD_RES_BAD_ARGUMENT);
+	SELFTEST_ASSERT(CMD_ExecuteCommand("ping_addTarget 192.168.0.5", 0) == CMD_RES_BAD_ARGUMENT);
+	CMD_ExecuteCommand("ping_removeTarget 192.168.0.4", 0);
+	SELFTEST_ASSERT(Ping_FindTarget("192.168.0.4") == 0);
+
+	CMD_ExecuteCommand("addEventHandler PingAlarm 3 addChannel 1 1", 0);
+	CMD_ExecuteCommand("addEventHandler PingRecovered 3 addChannel 2 1", 0);
+	CMD_ExecuteCommand("addEventHandler PingAlarm 1 addChannel 3 1", 0);
+	CMD_ExecuteCommand("addEventHandler PingAlarm 2 addChannel 4 1", 0);
+	CMD_ExecuteCommand("ping_setAlarm 192.168.0.1 0 100", 0);
+	CMD_ExecuteCommand("ping_setAlarm 192.168.0.2 50 0 reconnect", 0);
+	CMD_ExecuteCommand("ping_setAlarm 192.168.0.3 50 0 event", 0);
+	SELFTEST_ASSERT(CMD_ExecuteCommand("ping_setAlarm 192.168.0.3 50 0 explode", 0) == CMD_RES_BAD_ARGUMENT);
+
+	Sim_RunSeconds(20, false);
+	// every echo had correct checksum, reply too
+	SELFTEST_ASSERT_INTEGER(PingSim_GetBadChecksums(), 0);
+	// 15 and 25 ms, one after another
+	t = Ping_FindTarget("192.168.0.1");
+	SELFTEST_ASSERT(t->sent >= 39 && t->sent <= 41);
+	SELFTEST_ASSERT(t->received >= t->sent - 1);
+	SELFTEST_ASSERT_INTEGER(Ping_GetLossPercent(t), 0);
+	SELFTEST_ASSERT_INTEGER(Ping_GetMinRtt(t), 15);
+	SELFTEST_ASSERT_INTEGER(Ping_GetMaxRtt(t), 25);
+	SELFTEST_ASSERT_INTEGER(Ping_GetAverageRtt(t), 20);
+	// smoothed, goes to 10 ms
+	SELFTEST_ASSERT(Ping_GetJitter(t) >= 8 && Ping_GetJitter(t) <= 10);
+	SELFTEST_ASSERT_INTEGER(t->bAlarm, 0);
+	// every fourth is lost
+	t = Ping_FindTarget("192.168.0.2");
+	SELFTEST_ASSERT(Ping_GetLossPercent(t) >= 20 && Ping_GetLossPercent(t) <= 30);
+	SELFTEST_ASSERT_INTEGER(Ping_GetAverageRtt(t), 100);
+	SELFTEST_ASSERT_INTEGER(Ping_GetJitter(t), 0);
+	SELFTEST_ASSERT_INTEGER(t->alarms, 0);
+	// unreachable one went into alarm once
+	t = Ping_FindTarget("192.168.0.3");
+	SELFTEST_ASSERT_INTEGER(Ping_GetLossPercent(t), 100);
+	SELFTEST_ASSERT_INTEGER(t->bAlarm, 1);
+	SELFTEST_ASSERT_CHANNEL(1, 1);
+	SELFTEST_ASSERT_CHANNEL(2, 0);
+	SELFTEST_ASSERT_CHANNEL(3, 0);
+
+	Test_FakeHTTPClientPacket_GET("api/ping");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "{\"ip\":\"192.168.0.1\",\"interval\":500,") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"min\":15,\"avg\":20,\"max\":25,\"jitter\":") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "{\"ip\":\"192.168.0.3\",\"interval\":1000,") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"loss\":100,\"last\":0,\"min\":0,\"avg\":0,\"max\":0,\"jitter\":0,\"alarm\":1,\"alarms\":1}") != 0);
+
+	// network got slow, RTT threshold
+	PingSim_SetHost("192.168.0.1", 200, 0, 0);
+	Sim_RunSeconds(10, false);
+	SELFTEST_ASSERT_CHANNEL(3, 1);
+	SELFTEST_ASSERT_INTEGER(Ping_FindTarget("192.168.0.1")->bAlarm, 1);
+
+	// unreachable one came back, it recovers when loss in window goes under 50%
+	PingSim_SetHost("192.168.0.3", 10, 0, 0);
+	Sim_RunSeconds(10, false);
+	SELFTEST_ASSERT_CHANNEL(2, 0);
+	Sim_RunSeconds(10, false);
+	SELFTEST_ASSERT_CHANNEL(2, 1);
+	SELFTEST_ASSERT_CHANNEL(1, 1);
+	SELFTEST_ASSERT_INTEGER(Ping_FindTarget("192.168.0.3")->bAlarm, 0);
+
+	// reconnect action, window starts over so it can act again if that didn't help
+	PingSim_SetHost("192.168.0.2", 100, 0, 100);
+	Sim_RunSeconds(40, false);
+	t = Ping_FindTarget("192.168.0.2");
+	SELFTEST_ASSERT(t->alarms >= 2);
+	SELFTEST_ASSERT(t->lossCount < PING_LOSS_WINDOW);
+	// only reconnect was asked, no event
+	SELFTEST_ASSERT_CHANNEL(4, 0);
+	// WiFi is down for a moment on every reconnect
+	CMD_ExecuteCommand("ping_removeTarget 192.168.0.2", 0);
+
+	// legacy ping watchdog is one of targets
+	PingSim_SetHost("192.168.0.4", 10, 0, 0);
+	CFG_SetPingHost("192.168.0.4");
+	CFG_SetPingDisconnectedSecondsToRestart(30);
+	Main_SetupPingWatchDog("192.168.0.4");
+	g_timeSinceLastPingReply = 20;
+	Sim_RunSeconds(5, false);
+	SELFTEST_ASSERT(g_timeSinceLastPingReply <= 1);
+	SELFTEST_ASSERT(PingWatchDog_GetTotalReceived() >= 4);
+	SELFTEST_ASSERT_INTEGER(PingWatchDog_GetTotalLost(), 0);
+
+	// clearAll keeps watchdog
+	CMD_ExecuteCommand("clearAll", 0);
+	SELFTEST_ASSERT(Ping_FindTarget("192.168.0.1") == 0);
+	SELFTEST_ASSERT(Ping_FindTarget("192.168.0.4") != 0);
+	CMD_ExecuteCommand("ping_removeTarget 192.168.0.4", 0);
+	Test_FakeHTTPClientPacket_GET("api/ping");
+	SELFTEST_ASSERT_HTML_REPLY("{\"targets\":[]}");
+}
+
+#endif
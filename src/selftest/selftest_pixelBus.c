@@ -0,0 +1,122 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../driver/drv_pixelBus.h"
+#include "../hal/hal_generic.h"
+
+static byte g_encoded[2048];
+static byte g_decoded[512];
+
+static int Test_PixelBus_DecodeLast(const pixelBusProtocol_t *protocol) {
+	const byte *data;
+	int len, rate;
+
+	len = SIM_GetSPIData(&data, &rate);
+	SELFTEST_ASSERT_INTEGER(rate, 1000000000 / protocol->spiBitNs);
+	return PixelBus_DecodeSPI(protocol, data, len, g_decoded, sizeof(g_decoded));
+}
+
+void Test_PixelBus() {
+	pixelBus_t bus;
+	int len;
+
+	SIM_ClearOBK();
+	SIM_ClearSPIData();
+	memset(&bus, 0, sizeof(bus));
+
+	// SM16703P/WS2812 - 4 SPI bits per data bit, 1000 is 0, 1110 is 1, MSB first
+	PixelBus_Init(&bus, &g_pixelBusProtocol_SM16703P, 16);
+	SELFTEST_ASSERT_INTEGER(bus.symbolBits, 4);
+	SELFTEST_ASSERT(PixelBus_Setup(&bus, 3, "GRB"));
+	PixelBus_SetPixel(&bus, 0, 0x80, 0x01, 0xFF, 0);
+	PixelBus_SetPixel(&bus, 2, 0x12, 0x34, 0x56, 0);
+	len = PixelBus_Encode(&bus, bus.pixels, g_encoded);
+	// leading zero byte, 9 bytes of 4 SPI bytes, then at least 300us of zeros
+	SELFTEST_ASSERT(len >= 1 + 9 * 4 + 300000 / 2400);
+	SELFTEST_ASSERT_INTEGER(g_encoded[0], 0);
+	// green 0x01 goes first
+	SELFTEST_ASSERT_INTEGER(g_encoded[1], 0x88);
+	SELFTEST_ASSERT_INTEGER(g_encoded[4], 0x8E);
+	// then red 0x80
+	SELFTEST_ASSERT_INTEGER(g_encoded[5], 0xE8);
+	SELFTEST_ASSERT_INTEGER(g_encoded[6], 0x88);
+	// decoder checks every pulse against datasheet timing
+	SELFTEST_ASSERT_INTEGER(PixelBus_DecodeSPI(&g_pixelBusProtocol_SM16703P, g_encoded, len, g_decoded, sizeof(g_decoded)), 9);
+	SELFTEST_ASSERT_INTEGER(g_decoded[0], 0x01);
+	SELFTEST_ASSERT_INTEGER(g_decoded[1], 0x80);
+	SELFTEST_ASSERT_INTEGER(g_decoded[2], 0xFF);
+	SELFTEST_ASSERT_INTEGER(g_decoded[3], 0);
+	SELFTEST_ASSERT_INTEGER(g_decoded[6], 0x34);
+	SELFTEST_ASSERT_INTEGER(g_decoded[7], 0x12);
+	SELFTEST_ASSERT_INTEGER(g_decoded[8], 0x56);
+	// too long pulse is caught
+	g_encoded[5] = 0xF8;
+	SELFTEST_ASSERT_INTEGER(PixelBus_DecodeSPI(&g_pixelBusProtocol_SM16703P, g_encoded, len, g_decoded, sizeof(g_decoded)), -1);
+	// so is missing reset
+	PixelBus_Encode(&bus, bus.pixels, g_encoded);
+	SELFTEST_ASSERT_INTEGER(PixelBus_DecodeSPI(&g_pixelBusProtocol_SM16703P, g_encoded, 1 + 9 * 4 + 4, g_decoded, sizeof(g_decoded)), -1);
+
+	// double buffering - frame sent over (simulated) SPI is never changed,
+	// newer frame waits, and only latest waiting one is sent
+	PixelBus_Fill(&bus, 255, 0, 0, 0);
+	SELFTEST_ASSERT(PixelBus_Show(&bus));
+	SELFTEST_ASSERT(PixelBus_IsBusy(&bus));
+	PixelBus_Fill(&bus, 0, 255, 0, 0);
+	SELFTEST_ASSERT(PixelBus_Show(&bus) == 0);
+	PixelBus_Fill(&bus, 0, 0, 255, 0);
+	SELFTEST_ASSERT(PixelBus_Show(&bus) == 0);
+	SELFTEST_ASSERT_INTEGER(bus.framesDropped, 1);
+	SELFTEST_ASSERT_INTEGER(Test_PixelBus_DecodeLast(&g_pixelBusProtocol_SM16703P), 9);
+	// GRB
+	SELFTEST_ASSERT_INTEGER(g_decoded[0], 0);
+	SELFTEST_ASSERT_INTEGER(g_decoded[1], 255);
+	Sim_RunMiliseconds(10, false);
+	SELFTEST_ASSERT(PixelBus_IsBusy(&bus) == 0);
+	PixelBus_RunQuickTick(&bus);
+	SELFTEST_ASSERT_INTEGER(bus.framesSent, 2);
+	SELFTEST_ASSERT_INTEGER(Test_PixelBus_DecodeLast(&g_pixelBusProtocol_SM16703P), 9);
+	SELFTEST_ASSERT_INTEGER(g_decoded[1], 0);
+	SELFTEST_ASSERT_INTEGER(g_decoded[2], 255);
+	SELFTEST_ASSERT_INTEGER(g_decoded[8], 255);
+
+	// UCS1912 - 5 SPI bits, RGBW
+	PixelBus_Init(&bus, &g_pixelBusProtocol_UCS1912, 16);
+	SELFTEST_ASSERT_INTEGER(bus.symbolBits, 5);
+	SELFTEST_ASSERT(PixelBus_Setup(&bus, 2, "RGBW"));
+	PixelBus_SetPixel(&bus, 1, 1, 2, 3, 200);
+	len = PixelBus_Encode(&bus, bus.pixels, g_encoded);
+	SELFTEST_ASSERT_INTEGER(PixelBus_DecodeSPI(&g_pixelBusProtocol_UCS1912, g_encoded, len, g_decoded, sizeof(g_decoded)), 8);
+	SELFTEST_ASSERT_INTEGER(g_decoded[4], 1);
+	SELFTEST_ASSERT_INTEGER(g_decoded[7], 200);
+	// bad orders are refused, strip stays as it was
+	SELFTEST_ASSERT(PixelBus_Setup(&bus, 2, "RGX") == 0);
+	SELFTEST_ASSERT(PixelBus_Setup(&bus, 2, "RG") == 0);
+	SELFTEST_ASSERT_INTEGER(bus.bpp, 4);
+	PixelBus_Shutdown(&bus);
+
+	// driver with commands
+	CMD_ExecuteCommand("startDriver SM16703P", 0);
+	CMD_ExecuteCommand("SM16703P_Init 100 GRB", 0);
+	CMD_ExecuteCommand("SM16703P_SetPixel all 10 20 30", 0);
+	CMD_ExecuteCommand("SM16703P_SetPixel 99 255 0 0", 0);
+	CMD_ExecuteCommand("SM16703P_Show", 0);
+	SELFTEST_ASSERT_INTEGER(Test_PixelBus_DecodeLast(&g_pixelBusProtocol_SM16703P), 300);
+	SELFTEST_ASSERT_INTEGER(g_decoded[0], 20);
+	SELFTEST_ASSERT_INTEGER(g_decoded[1], 10);
+	SELFTEST_ASSERT_INTEGER(g_decoded[2], 30);
+	SELFTEST_ASSERT_INTEGER(g_decoded[297], 0);
+	SELFTEST_ASSERT_INTEGER(g_decoded[298], 255);
+	// next frame waits in background and is sent by driver quick tick
+	CMD_ExecuteCommand("SM16703P_Send 0102030405", 0);
+	SELFTEST_ASSERT_INTEGER(g_decoded[0], 20);
+	Sim_RunMiliseconds(20, false);
+	SELFTEST_ASSERT_INTEGER(Test_PixelBus_DecodeLast(&g_pixelBusProtocol_SM16703P), 300);
+	SELFTEST_ASSERT_INTEGER(g_decoded[0], 2);
+	SELFTEST_ASSERT_INTEGER(g_decoded[1], 1);
+	SELFTEST_ASSERT_INTEGER(g_decoded[3], 5);
+	SELFTEST_ASSERT_INTEGER(g_decoded[4], 4);
+	CMD_ExecuteCommand("stopDriver SM16703P", 0);
+	SIM_ClearSPIData();
+}
+
+#endif
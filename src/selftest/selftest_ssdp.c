@@ -0,0 +1,181 @@
+#ifdef WINDOWS
+
+#include "selftest_local.h"
+#include "../driver/drv_ssdp.h"
+
+// Packets are sent to SSDP driver on loopback, each from its own 127.0.x.y
+// address, like from other devices in the network.
+
+static void Test_SSDP_Send(const char *fromIP, const char *msg) {
+	struct sockaddr_in addr;
+	SOCKET s;
+
+	s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr(fromIP);
+	addr.sin_port = 0;
+	bind(s, (struct sockaddr*)&addr, sizeof(addr));
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(1900);
+	sendto(s, msg, strlen(msg), 0, (struct sockaddr*)&addr, sizeof(addr));
+	closesocket(s);
+	Sim_RunFrames(2, false);
+}
+static void Test_SSDP_Notify(const char *fromIP, const char *server, const char *uuid, const char *nt,
+	int maxAge, int bootId, const char *nts) {
+	char msg[512];
+
+	sprintf(msg, "NOTIFY * HTTP/1.1\r\n"
+		"HOST: 239.255.255.250:1900\r\n"
+		"CACHE-CONTROL: max-age = %i\r\n"
+		"LOCATION: http://%s:80/desc.xml\r\n"
+		"NT: %s\r\n"
+		"NTS: %s\r\n"
+		"SERVER: %s\r\n"
+		"USN: uuid:%s::%s\r\n"
+		"BOOTID.UPNP.ORG: %i\r\n"
+		"\r\n", maxAge, fromIP, nt, nts, server, uuid, nt, bootId);
+	Test_SSDP_Send(fromIP, msg);
+}
+
+void Test_SSDP() {
+	char tmp[64];
+	char msg[256];
+	char uuid[40];
+	const char *p;
+	int i;
+
+	SIM_ClearOBK();
+	// driver waits for WiFi
+	Sim_RunSeconds(1, false);
+	CMD_ExecuteCommand("startDriver SSDP", 0);
+	// argument is last byte of IP
+	CMD_ExecuteCommand("addEventHandler SSDPNew 2 addChannel 1 1", 0);
+	CMD_ExecuteCommand("addEventHandler SSDPNew 3 addChannel 1 1", 0);
+	CMD_ExecuteCommand("addEventHandler SSDPNew 4 addChannel 1 1", 0);
+	CMD_ExecuteCommand("addEventHandler SSDPLost 4 addChannel 2 1", 0);
+	CMD_ExecuteCommand("addEventHandler SSDPLost 3 addChannel 2 10", 0);
+	CMD_ExecuteCommand("addEventHandler SSDPLost 2 addChannel 2 100", 0);
+	CMD_ExecuteCommand("addEventHandler SSDPChange 3 addChannel 3 1", 0);
+
+	// other OpenBeken device, something else, and reply to M-SEARCH
+	Test_SSDP_Notify("127.0.0.2", "OpenBk", "aaaaaaaa-0000-0000-0000-000000000002", "upnp:rootdevice", 1800, 0, "ssdp:alive");
+	Test_SSDP_Notify("127.0.0.3", "Linux/5.0 UPnP/1.0 \"Hue\"/1.0", "bbbbbbbb-0000-0000-0000-000000000003",
+		"urn:schemas-upnp-org:device:Basic:1", 100, 5, "ssdp:alive");
+	Test_SSDP_Send("127.0.0.4", "HTTP/1.1 200 OK\r\n"
+		"CACHE-CONTROL: max-age=10\r\n"
+		"ST: upnp:rootdevice\r\n"
+		"USN: uuid:cccccccc-0000-0000-0000-000000000004::upnp:rootdevice\r\n"
+		"SERVER: RTOS/1.0 UPnP/1.0\r\n"
+		"\r\n");
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 3);
+	SELFTEST_ASSERT_CHANNEL(1, 3);
+	// again, same ones
+	Test_SSDP_Notify("127.0.0.2", "OpenBk", "aaaaaaaa-0000-0000-0000-000000000002", "upnp:rootdevice", 1800, 0, "ssdp:alive");
+	Test_SSDP_Notify("127.0.0.3", "Linux/5.0 UPnP/1.0 \"Hue\"/1.0", "bbbbbbbb-0000-0000-0000-000000000003",
+		"uuid:bbbbbbbb-0000-0000-0000-000000000003", 100, 5, "ssdp:alive");
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 3);
+	SELFTEST_ASSERT_CHANNEL(1, 3);
+	SELFTEST_ASSERT_CHANNEL(3, 0);
+
+	// our own NOTIFY is not a device
+	Test_FakeHTTPClientPacket_GET("ssdp.xml");
+	p = strstr(Test_GetLastHTMLReply(), "<UDN>uuid:");
+	SELFTEST_ASSERT(p != 0);
+	strcpy_safe(uuid, p + 10, 37);
+	Test_SSDP_Notify("127.0.0.5", "OpenBk", uuid, "upnp:rootdevice", 1800, 0, "ssdp:alive");
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 3);
+
+	// REST, old list has only OpenBeken ones
+	Test_FakeHTTPClientPacket_GET("obkdevicelist");
+	SELFTEST_ASSERT_HTML_REPLY("[{\"ip\":\"127.0.0.2\"}]\n");
+	Test_FakeHTTPClientPacket_GET("api/ssdp/devices");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"ip\":\"127.0.0.3\",\"uuid\":\"bbbbbbbb-0000-0000-0000-000000000003\",\"obk\":0,\"server\":\"Linux/5.0 UPnP/1.0 _Hue_/1.0\"") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"location\":\"http://127.0.0.3:80/desc.xml\",\"type\":\"urn:schemas-upnp-org:device:Basic:1\",\"bootId\":5,\"maxAge\":100") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"ip\":\"127.0.0.2\",\"uuid\":\"aaaaaaaa-0000-0000-0000-000000000002\",\"obk\":1") != 0);
+	Test_FakeHTTPClientPacket_JSON("api/ssdp/events?since=1");
+	SELFTEST_ASSERT_JSON_VALUE_INTEGER(0, "seq", 3);
+	SELFTEST_ASSERT_JSON_VALUE_INTEGER(0, "missed", 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"events\":[{\"seq\":2,\"event\":\"new\",\"ip\":\"127.0.0.3\"") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "{\"seq\":3,\"event\":\"new\",\"ip\":\"127.0.0.4\",\"uuid\":\"cccccccc-0000-0000-0000-000000000004\"}]}") != 0);
+
+	// M-SEARCH reply said max-age=10
+	Sim_RunSeconds(11, false);
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 2);
+	SELFTEST_ASSERT_CHANNEL(2, 1);
+	Test_FakeHTTPClientPacket_JSON("api/ssdp/events?since=3");
+	SELFTEST_ASSERT_JSON_VALUE_INTEGER(0, "seq", 4);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"events\":[{\"seq\":4,\"event\":\"lost\",\"ip\":\"127.0.0.4\"") != 0);
+
+	// device rebooted, boot ID is new
+	Test_SSDP_Notify("127.0.0.3", "Linux/5.0 UPnP/1.0 \"Hue\"/1.0", "bbbbbbbb-0000-0000-0000-000000000003",
+		"upnp:rootdevice", 100, 6, "ssdp:alive");
+	SELFTEST_ASSERT_CHANNEL(3, 1);
+	Test_SSDP_Notify("127.0.0.3", "Linux/5.0 UPnP/1.0 \"Hue\"/1.0", "bbbbbbbb-0000-0000-0000-000000000003",
+		"upnp:rootdevice", 100, 6, "ssdp:byebye");
+	SELFTEST_ASSERT_CHANNEL(2, 11);
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 1);
+
+	// OpenBeken device sends NOTIFY every 30 seconds, so after a minute it's gone
+	Sim_RunSeconds(30, false);
+	Test_SSDP_Notify("127.0.0.2", "OpenBk", "aaaaaaaa-0000-0000-0000-000000000002", "upnp:rootdevice", 1800, 0, "ssdp:alive");
+	Sim_RunSeconds(59, false);
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 1);
+	Sim_RunSeconds(2, false);
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 0);
+	SELFTEST_ASSERT_CHANNEL(2, 111);
+	Test_FakeHTTPClientPacket_GET("obkdevicelist");
+	SELFTEST_ASSERT_HTML_REPLY("[]\n");
+
+	// busy network, table has limited size, ones closest to expiry go first
+	for (i = 0; i < 60; i++) {
+		sprintf(tmp, "127.0.1.%i", i + 1);
+		sprintf(msg, "NOTIFY * HTTP/1.1\r\n"
+			"CACHE-CONTROL: max-age=%i\r\n"
+			"NTS: ssdp:alive\r\n"
+			"USN: uuid:dddddddd-0000-0000-0000-%012i\r\n"
+			"\r\n", 1000 - i, i);
+		Test_SSDP_Send(tmp, msg);
+	}
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 40);
+	Test_FakeHTTPClientPacket_GET("api/ssdp/devices");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"ip\":\"127.0.1.60\"") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"ip\":\"127.0.1.1\"") != 0);
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"ip\":\"127.0.1.59\"") == 0);
+	// feed lost some, client must read list again
+	Test_FakeHTTPClientPacket_JSON("api/ssdp/events?since=4");
+	SELFTEST_ASSERT_JSON_VALUE_INTEGER(0, "missed", 1);
+
+	// mixed network - OpenBeken peers expire in a minute, others in half an hour,
+	// but table being full must not push peers out
+	CMD_ExecuteCommand("stopDriver SSDP", 0);
+	CMD_ExecuteCommand("startDriver SSDP", 0);
+	for (i = 0; i < 60; i++) {
+		sprintf(tmp, "127.0.2.%i", i + 1);
+		sprintf(uuid, "eeeeeeee-0000-0000-0000-%012i", i);
+		// every fourth one is OpenBeken
+		Test_SSDP_Notify(tmp, (i % 4) ? "Linux/5.0 UPnP/1.0" : "OpenBk", uuid, "upnp:rootdevice", 1800, 0, "ssdp:alive");
+	}
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 40);
+	Test_FakeHTTPClientPacket_GET("obkdevicelist");
+	for (i = 0; i < 60; i += 4) {
+		sprintf(tmp, "{\"ip\":\"127.0.2.%i\"}", i + 1);
+		SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), tmp) != 0);
+	}
+	// table full of peers - other device is ignored, another peer replaces oldest peer
+	for (i = 0; i < 40; i++) {
+		sprintf(tmp, "127.0.3.%i", i + 1);
+		sprintf(uuid, "ffffffff-0000-0000-0000-%012i", i);
+		Test_SSDP_Notify(tmp, "OpenBk", uuid, "upnp:rootdevice", 1800, 0, "ssdp:alive");
+	}
+	Test_SSDP_Notify("127.0.4.1", "Linux/5.0 UPnP/1.0", "eeeeeeee-0000-0000-0000-999999999999", "upnp:rootdevice", 1800, 0, "ssdp:alive");
+	Test_FakeHTTPClientPacket_GET("api/ssdp/devices");
+	SELFTEST_ASSERT(strstr(Test_GetLastHTMLReply(), "\"obk\":0") == 0);
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 40);
+
+	CMD_ExecuteCommand("stopDriver SSDP", 0);
+	SELFTEST_ASSERT_INTEGER(DRV_SSDP_GetDevicesCount(), 0);
+}
+
+#endif
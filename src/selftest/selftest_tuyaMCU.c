@@ -1,6 +1,7 @@
 #ifdef WINDOWS
 
-#include "selftest_local.h".
+#include "selftest_local.h"
+#include "../driver/drv_tuyaMCU.h"
 
 void Test_TuyaMCU_Basic() {
 	// reset whole device
@@ -43,4 +44,88 @@ void Test_TuyaMCU_Basic() {
 	//SELFTEST_ASSERT_CHANNEL(15, 666);
 }
 
+void Test_TuyaMCU_Mappings() {
+	const tuyaMCUMapping_t *mappings;
+	tuyaMCUMapping_t saved[4];
+	int count;
+
+	// reset whole device
+	SIM_ClearOBK();
+
+	CMD_ExecuteCommand("startDriver TuyaMCU", 0);
+	// start from empty table
+	TuyaMCU_SetMappings(0, 0);
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(15) == false);
+
+	CMD_ExecuteCommand("linkTuyaMCUOutputToChannel 2 val 15", 0);
+	CMD_ExecuteCommand("linkTuyaMCUOutputToChannel 101 bool 16", 0);
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(15));
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(16));
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(17) == false);
+
+	// remap dpId 2 to another channel - old channel must be freed
+	CMD_ExecuteCommand("linkTuyaMCUOutputToChannel 2 val 17", 0);
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(15) == false);
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(17));
+	// dpId is just one byte
+	SELFTEST_ASSERT(CMD_ExecuteCommand("linkTuyaMCUOutputToChannel 300 val 18", 0) == CMD_RES_BAD_ARGUMENT);
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(18) == false);
+
+	mappings = TuyaMCU_GetMappings(&count);
+	SELFTEST_ASSERT_INTEGER(count, 2);
+	memcpy(saved, mappings, count * sizeof(tuyaMCUMapping_t));
+
+	// clear and load back as a block
+	TuyaMCU_SetMappings(0, 0);
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(17) == false);
+	TuyaMCU_SetMappings(saved, count);
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(16));
+	SELFTEST_ASSERT(TuyaMCU_IsChannelUsedByTuyaMCU(17));
+
+	// This packet sets fnID 2 of type Value to 90, now it goes to channel 17
+	CMD_ExecuteCommand("tuyaMcu_fakeHex 55AA03070008020200040000005A73", 0);
+	Sim_RunFrames(1000, false);
+	SELFTEST_ASSERT_CHANNEL(17, 90);
+}
+
+static const char *g_parserTestData[] = {
+	// garbage before first packet
+	"0102",
+	// fnID 2 set to 100, but with bad checksum (7E instead of 7D)
+	"55AA0307000802020004000000647E",
+	// lonely header byte, then fnID 2 set to 90
+	"55",
+	"55AA03070008020200040000005A73",
+	// header claiming 0xFF bytes of payload, too large for our buffer
+	"55AA030700FF",
+	// fnID 2 set to 110
+	"55AA03070008020200040000006E87",
+};
+
+void Test_TuyaMCU_Parser() {
+	tuyaMCUParserStats_t stats;
+
+	// reset whole device
+	SIM_ClearOBK();
+
+	CMD_ExecuteCommand("startDriver TuyaMCU", 0);
+	CMD_ExecuteCommand("linkTuyaMCUOutputToChannel 2 val 15", 0);
+
+	// stream data through TuyaMCU simulator, just 3 bytes per frame,
+	// so packets are split and parser must continue where it stopped
+	NewTuyaMCUSimulator_SetData(g_parserTestData, sizeof(g_parserTestData) / sizeof(g_parserTestData[0]), 3);
+	Sim_RunSeconds(3, false);
+	SELFTEST_ASSERT(NewTuyaMCUSimulator_IsDone());
+
+	// packet with bad checksum must be ignored, valid ones must be applied
+	SELFTEST_ASSERT_CHANNEL(15, 110);
+
+	TuyaMCU_GetParserStats(&stats);
+	SELFTEST_ASSERT_INTEGER(stats.framesGood, 2);
+	SELFTEST_ASSERT_INTEGER(stats.framesBad, 1);
+	SELFTEST_ASSERT_INTEGER(stats.framesDropped, 1);
+	// 2 garbage bytes, 14 bytes of bad packet, lonely 0x55 and 5 bytes of too large packet
+	SELFTEST_ASSERT_INTEGER(stats.bytesSkipped, 2 + 14 + 1 + 5);
+}
+
 #endif
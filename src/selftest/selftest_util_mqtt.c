@@ -1,6 +1,7 @@
 #ifdef WINDOWS
 
-#include "selftest_local.h".
+#include "selftest_local.h"
+#include "../mqtt/new_mqtt.h"
 
 void SIM_SendFakeMQTTAndRunSimFrame_CMND(const char *command, const char *arguments) {
 
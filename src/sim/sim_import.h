@@ -10,6 +10,14 @@ extern "C" {
 	bool SIM_IsPinADC(int index);
 	void SIM_SetVoltageOnADCPin(int index, float v);
 	int SIM_GetPWMValue(int index);
+	void SIM_InjectPinEdges(int pinIndex, const int *levels, const int *delays, int count);
+	void SIM_SetPinPulseResponse(int pinIndex, const int *durations_us, int count);
+	// I2C bus simulation, busID is I2C_BUS_I2C1 or I2C_BUS_I2C2
+	void SIM_I2C_Reset();
+	void SIM_I2C_AddDevice(int busID, int addr);
+	void SIM_I2C_SetRegister(int busID, int addr, int reg, int value);
+	int SIM_I2C_GetRegister(int busID, int addr, int reg);
+	int SIM_I2C_GetBusOpensCount();
 	// flash control simulation
 	void SIM_SetupFlashFileReading(const char *flashPath);
 	void SIM_SaveFlashData(const char *flashPath);
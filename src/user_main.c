@@ -37,6 +37,14 @@
 
 #include "driver/drv_ntp.h"
 #include "driver/drv_ssdp.h"
+#include "i2c/drv_i2c_public.h"
+#include "perf.h"
+#include "new_ping.h"
+
+#ifdef WINDOWS
+// debug_tuyaMCUsimulator.c
+void NewTuyaMCUSimulator_RunQuickTick(int deltaMS);
+#endif
 
 #ifdef PLATFORM_BEKEN
 #include <mcu_ps.h>
@@ -261,6 +269,16 @@ void Main_OnPingCheckerReply(int ms)
 {
 	g_timeSinceLastPingReply = 0;
 }
+// disconnects and connects again after 10 seconds
+void Main_ReconnectWiFi()
+{
+	if (g_bHasWiFiConnected != 0)
+	{
+		HAL_DisconnectFromWifi();
+		g_bHasWiFiConnected = 0;
+		g_connectToWiFi = 10;
+	}
+}
 
 int g_doHomeAssistantDiscoveryIn = 0;
 int g_bBootMarkedOK = 0;
@@ -336,13 +354,17 @@ void Main_OnEverySecond()
 	int newMQTTState;
 	const char *safe;
 	int i;
+	uint32_t secondStart, start;
 
+	PERF_BEGIN(secondStart);
 #ifdef WINDOWS
 	g_bHasWiFiConnected = 1;
 #endif
 
 	// run_adc_test();
+	PERF_BEGIN(start);
 	newMQTTState = MQTT_RunEverySecondUpdate();
+	PERF_END(PERF_SEC_MQTT, start);
 	if(newMQTTState != bMQTTconnected) {
 		bMQTTconnected = newMQTTState;
 		if(newMQTTState) {
@@ -357,9 +379,13 @@ void Main_OnEverySecond()
 		EventHandlers_FireEvent(CMD_EVENT_WIFI_STATE, g_newWiFiStatus);
 	}
 	MQTT_Dedup_Tick();
+	PERF_BEGIN(start);
 	RepeatingEvents_OnEverySecond();
+	PERF_END(PERF_SEC_EVENTS, start);
 #ifndef OBK_DISABLE_ALL_DRIVERS
+	PERF_BEGIN(start);
 	DRV_OnEverySecond();
+	PERF_END(PERF_SEC_DRIVERS, start);
 #endif
 
 #if WINDOWS
@@ -370,7 +396,9 @@ void Main_OnEverySecond()
     if (ota_progress()==-1)
 #endif
     {
+		PERF_BEGIN(start);
 		CFG_Save_IfThereArePendingChanges();
+		PERF_END(PERF_SEC_CFG, start);
     }
 
 	if (bSafeMode == 0) {
@@ -389,6 +417,8 @@ void Main_OnEverySecond()
 		}
 	}
 
+	Ping_RunEverySecond();
+
 	// some users say that despite our simple reconnect mechanism
 	// there are some rare cases when devices stuck outside network
 	// That is why we can also reconnect them by basing on ping
@@ -401,9 +431,7 @@ void Main_OnEverySecond()
             if (g_bHasWiFiConnected != 0)
             {
     			ADDLOGF_INFO("[Ping watchdog] No ping replies within %i seconds. Will try to reconnect.\n",g_timeSinceLastPingReply);
-                HAL_DisconnectFromWifi();
-		    	g_bHasWiFiConnected = 0;
-			    g_connectToWiFi = 10;
+                Main_ReconnectWiFi();
                 g_timeSinceLastPingReply = -1;
             }
 		}
@@ -411,7 +439,7 @@ void Main_OnEverySecond()
 
 	if(bSafeMode == 0) 
     {
-
+		PERF_BEGIN(start);
 		for(i = 0; i < PLATFORM_GPIO_MAX; i++) 
         {
 			if(g_cfg.pins.roles[i] == IOR_ADC) 
@@ -424,6 +452,7 @@ void Main_OnEverySecond()
 				CHANNEL_Set(g_cfg.pins.channels[i],value, CHANNEL_SET_FLAG_SILENT);
 			}
 		}
+		PERF_END(PERF_SEC_ADC, start);
 	}
 
 	// allow for up to 4 scheduled driver starts.
@@ -587,6 +616,9 @@ void Main_OnEverySecond()
             {
                 BL09XX_SaveEmeteringStatistics();
             }
+			if (DRV_IsRunning("NTP")) {
+				ClockEvents_SaveChanges(true);
+			}
 #endif            
 			ADDLOGF_INFO("Going to call HAL_RebootModule\r\n");
 			HAL_RebootModule();
@@ -599,10 +631,13 @@ void Main_OnEverySecond()
 #if defined(PLATFORM_BEKEN) || defined(PLATFORM_BL602) || defined(PLATFORM_W600) || defined(WINDOWS)
 	if (g_dhtsCount>0) {
 		if (bSafeMode == 0) {
+			PERF_BEGIN(start);
 			DHT_OnEverySecond();
+			PERF_END(PERF_SEC_DHT, start);
 		}
 	}
 #endif
+	PERF_END(PERF_EVERYSECOND, secondStart);
 
 	// force it to sleep...  we MUST have some idle task processing
 	// else task memory doesn't get freed
@@ -629,16 +664,21 @@ int g_bWantDeepSleep;
 // this is what we do in a qucik tick
 void QuickTick(void *param)
 {
+	uint32_t tickStart, start;
+
 	if (g_bWantDeepSleep) {
 		PINS_BeginDeepSleep();
 		g_bWantDeepSleep = 0;
 		return;
 	}
+	PERF_BEGIN(tickStart);
 
 #if defined(PLATFORM_BEKEN) && defined(BEKEN_PIN_GPI_INTERRUPTS)
 	// if using interrupt driven GPI for pins, don't call PIN_ticks() in QuickTick
 #else
+	PERF_BEGIN(start);
 	PIN_ticks(param);
+	PERF_END(PERF_QT_PINS, start);
 #endif
 
 #if defined(PLATFORM_BEKEN) || defined(WINDOWS)
@@ -655,20 +695,45 @@ void QuickTick(void *param)
 
 
 #if (defined WINDOWS) || (defined PLATFORM_BEKEN)
+	PERF_BEGIN(start);
 	SVM_RunThreads(t_diff);
+	PERF_END(PERF_QT_SCRIPTS, start);
 #endif
 #ifndef OBK_DISABLE_ALL_DRIVERS
+	PERF_BEGIN(start);
 	DRV_RunQuickTick();
+	PERF_END(PERF_QT_DRIVERS, start);
+#endif
+#if defined(PLATFORM_BEKEN) || defined(PLATFORM_BL602) || defined(PLATFORM_W600) || defined(WINDOWS)
+	if (g_dhtsCount > 0) {
+		PERF_BEGIN(start);
+		DHT_RunQuickTick(t_diff);
+		PERF_END(PERF_QT_DHT, start);
+	}
+#endif
+#if ENABLE_I2C
+	PERF_BEGIN(start);
+	DRV_I2C_RunQuickTick(t_diff);
+	PERF_END(PERF_QT_I2C, start);
 #endif
 #ifdef WINDOWS
 	NewTuyaMCUSimulator_RunQuickTick(t_diff);
+	PingSim_RunQuickTick();
 #endif
 
 	// process recieved messages here..
+	PERF_BEGIN(start);
 	MQTT_RunQuickTick();
+	PERF_END(PERF_QT_MQTT, start);
 	
-	if(CFG_HasFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS) == true) {
-		LED_RunQuickColorLerp(t_diff);
+	if(LED_Effect_IsRunning() || CFG_HasFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS) == true) {
+		PERF_BEGIN(start);
+		// effect sets new colors first, so smooth transitions see them in the same tick
+		LED_Effect_RunQuickTick(t_diff);
+		if(CFG_HasFlag(OBK_FLAG_LED_SMOOTH_TRANSITIONS) == true) {
+			LED_RunQuickColorLerp(t_diff);
+		}
+		PERF_END(PERF_QT_LED, start);
 	}
 
 	// WiFi LED
@@ -692,7 +757,7 @@ void QuickTick(void *param)
 			PIN_set_wifi_led(g_wifi_ledState);
 		}
 	}
-
+	PERF_END(PERF_QUICKTICK, tickStart);
 }
 
 
@@ -856,6 +921,8 @@ void Main_Init_BeforeDelay_Unsafe(bool bAutoRunScripts) {
 	CMD_InitSendCommands();
 #endif
 	CMD_InitChannelCommands();
+	PERF_InitCommands();
+	Ping_InitCommands();
 	EventHandlers_Init();
 
 	// CMD_Init() is now split into Early and Delayed
@@ -0,0 +1,2 @@
+// placeholder for POSIX host build, see win_posix.h
+#include "win_posix.h"
@@ -0,0 +1,16 @@
+// placeholder for POSIX host build, win_mqtt_stub.c expects lwIP MQTT options
+#ifndef MQTT_VAR_HEADER_BUFFER_LEN
+#define MQTT_VAR_HEADER_BUFFER_LEN	128
+#endif
+#ifndef MQTT_REQ_MAX_IN_FLIGHT
+#define MQTT_REQ_MAX_IN_FLIGHT		4
+#endif
+#ifndef MQTT_CYCLIC_TIMER_INTERVAL
+#define MQTT_CYCLIC_TIMER_INTERVAL	5
+#endif
+#ifndef MQTT_REQ_TIMEOUT
+#define MQTT_REQ_TIMEOUT			30
+#endif
+#ifndef MQTT_CONNECT_TIMOUT
+#define MQTT_CONNECT_TIMOUT			100
+#endif
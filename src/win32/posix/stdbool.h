@@ -0,0 +1,2 @@
+// placeholder for POSIX host build, simulator code defines bool as int
+// (see new_common.h), just like win32/stubs/stdbool.h does for MSVC
@@ -0,0 +1,97 @@
+#ifdef LINUX
+
+// Win32 API subset used by simulator sources, implemented with POSIX calls.
+// See win_posix.h.
+
+#include <time.h>
+#include <pthread.h>
+#include "win_posix.h"
+
+// mutex handles are small indexes into this table, because some callers
+// keep them in int variables
+#define MAX_POSIX_MUTEXES	64
+
+static pthread_mutex_t g_mutexes[MAX_POSIX_MUTEXES];
+static int g_mutexCount = 0;
+
+void Sleep(int ms) {
+	struct timespec t;
+
+	// not usleep - new_common.h has its own usleep, which is a short busy loop
+	t.tv_sec = ms / 1000;
+	t.tv_nsec = (ms % 1000) * 1000000L;
+	nanosleep(&t, 0);
+}
+DWORD timeGetTime(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+DWORD GetTickCount(void) {
+	return timeGetTime();
+}
+HANDLE CreateThread(void *attr, int stackSize, LPTHREAD_START_ROUTINE func, void *arg, int flags, void *threadId) {
+	pthread_t t;
+
+	if (pthread_create(&t, 0, (void*(*)(void*))func, arg) != 0) {
+		return 0;
+	}
+	pthread_detach(t);
+	return (HANDLE)t;
+}
+HANDLE CreateMutex(void *attr, int bInitialOwner, const char *name) {
+	pthread_mutexattr_t a;
+	int i;
+
+	if (g_mutexCount + 1 >= MAX_POSIX_MUTEXES) {
+		return 0;
+	}
+	// index 0 is reserved, so valid handle is never NULL
+	i = ++g_mutexCount;
+	pthread_mutexattr_init(&a);
+	pthread_mutexattr_settype(&a, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&g_mutexes[i], &a);
+	pthread_mutexattr_destroy(&a);
+	if (bInitialOwner) {
+		pthread_mutex_lock(&g_mutexes[i]);
+	}
+	return (HANDLE)(intptr_t)i;
+}
+DWORD WaitForSingleObject(HANDLE h, DWORD ms) {
+	struct timespec t;
+	int i = (int)(intptr_t)h;
+
+	if (i <= 0 || i > g_mutexCount) {
+		return WAIT_TIMEOUT;
+	}
+	clock_gettime(CLOCK_REALTIME, &t);
+	t.tv_sec += ms / 1000;
+	t.tv_nsec += (ms % 1000) * 1000000L;
+	if (t.tv_nsec >= 1000000000L) {
+		t.tv_sec++;
+		t.tv_nsec -= 1000000000L;
+	}
+	return pthread_mutex_timedlock(&g_mutexes[i], &t) == 0 ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+}
+int ReleaseMutex(HANDLE h) {
+	int i = (int)(intptr_t)h;
+
+	if (i <= 0 || i > g_mutexCount) {
+		return 0;
+	}
+	return pthread_mutex_unlock(&g_mutexes[i]) == 0;
+}
+int QueryPerformanceCounter(LARGE_INTEGER *out) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	out->QuadPart = (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+	return 1;
+}
+int QueryPerformanceFrequency(LARGE_INTEGER *out) {
+	out->QuadPart = 1000000000LL;
+	return 1;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef __WIN_POSIX_H__
+#define __WIN_POSIX_H__
+
+// POSIX host build (Linux, macOS) compiles the same WINDOWS simulator sources.
+// This header maps the few Win32 and Winsock calls they use to POSIX.
+// It's pulled in by windows.h, winsock2.h etc. placeholders in this folder.
+
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+
+// unistd.h is not included, because its usleep clashes with one in new_common.h
+int close(int fd);
+
+typedef int SOCKET;
+typedef unsigned long DWORD;
+typedef int BOOL;
+typedef unsigned char UINT8;
+typedef unsigned short UINT16;
+typedef unsigned int UINT32;
+typedef signed char INT8;
+typedef short INT16;
+typedef int INT32;
+typedef intptr_t SSIZE_T;
+typedef void *HANDLE;
+typedef unsigned int (*LPTHREAD_START_ROUTINE)(void *);
+typedef struct WSAData_s {
+	int unused;
+} WSADATA;
+typedef union LARGE_INTEGER_u {
+	struct {
+		unsigned int LowPart;
+		int HighPart;
+	};
+	long long QuadPart;
+} LARGE_INTEGER;
+
+#define INVALID_SOCKET		(-1)
+#define SOCKET_ERROR		(-1)
+#define SD_SEND				SHUT_WR
+#define SD_BOTH				SHUT_RDWR
+#define WSAEWOULDBLOCK		EWOULDBLOCK
+#define WAIT_OBJECT_0		0
+#define WAIT_TIMEOUT		258
+#ifndef FALSE
+#define FALSE				0
+#endif
+#ifndef TRUE
+#define TRUE				1
+#endif
+
+#define closesocket			close
+#define ioctlsocket(s,c,a)	ioctl(s,c,a)
+#define WSAGetLastError()	errno
+#define MAKEWORD(a,b)		((a)|((b)<<8))
+#define WSAStartup(a,b)		0
+#define WSACleanup()
+#define ZeroMemory(p,n)		memset((p),0,(n))
+#define stricmp				strcasecmp
+#define _stricmp			strcasecmp
+#define strnicmp			strncasecmp
+#define _strnicmp			strncasecmp
+#define __cdecl
+#define WINAPI
+
+void Sleep(int ms);
+DWORD timeGetTime(void);
+DWORD GetTickCount(void);
+HANDLE CreateThread(void *attr, int stackSize, LPTHREAD_START_ROUTINE func, void *arg, int flags, void *threadId);
+// mutexes are recursive, like Win32 ones
+HANDLE CreateMutex(void *attr, int bInitialOwner, const char *name);
+DWORD WaitForSingleObject(HANDLE h, DWORD ms);
+int ReleaseMutex(HANDLE h);
+int QueryPerformanceCounter(LARGE_INTEGER *out);
+int QueryPerformanceFrequency(LARGE_INTEGER *out);
+
+#endif /* __WIN_POSIX_H__ */
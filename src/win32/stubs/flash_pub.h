@@ -66,5 +66,8 @@ extern void flash_init(void);
 extern void flash_exit(void);
 extern UINT8 flash_get_line_mode(void);
 extern void flash_set_line_mode(UINT8 );
+// win_flash_stub.c, simulated flash
+extern UINT32 flash_read(char *user_buf, UINT32 count, UINT32 address);
+extern UINT32 flash_write(char *user_buf, UINT32 count, UINT32 address);
 
 #endif //_FLASH_PUB_H
\ No newline at end of file
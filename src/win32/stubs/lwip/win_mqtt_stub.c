@@ -871,7 +871,7 @@ mqtt_create_request(struct mqtt_request_t *r_objs, size_t r_objs_len, u16_t pkt_
 err_t mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_cb_t cb, void *arg, u8_t sub) {
 
 	if (MQTT_IsFakingOnlineMQTT())
-		return;
+		return ERR_OK;
 	size_t topic_strlen;
 	size_t total_len;
 	u16_t topic_len;
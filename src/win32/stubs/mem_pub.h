@@ -0,0 +1,10 @@
+#ifndef _MEM_PUB_H_
+#define _MEM_PUB_H_
+
+// simulator, same as in new_common.h
+#include <stdlib.h>
+
+#define os_malloc malloc
+#define os_free free
+
+#endif
@@ -5,14 +5,22 @@
 
 DWORD startTime = 0;
 
-int xSemaphoreTake(int semaphore, int blockTime) {
-	return 1;
-}
-int xSemaphoreCreateMutex() {
+// real mutexes, simulator runs HTTP client workers and servers in separate threads
+int xSemaphoreTake(SemaphoreHandle_t semaphore, int blockTime) {
+	if (semaphore == 0)
+		return 1;
+	if (WaitForSingleObject((HANDLE)semaphore, blockTime) == WAIT_OBJECT_0)
+		return 1;
 	return 0;
 }
-int xSemaphoreGive(int semaphore) {
-	return 0;
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+	return (SemaphoreHandle_t)CreateMutex(NULL, FALSE, NULL);
+}
+int xSemaphoreGive(SemaphoreHandle_t semaphore) {
+	if (semaphore == 0)
+		return 0;
+	ReleaseMutex((HANDLE)semaphore);
+	return 1;
 }
 int rtos_delay_milliseconds(int sec) {
 	Sleep(sec);
@@ -57,12 +65,11 @@ int hal_machw_time_past(int tt) {
 		return 0;
 	return 1;
 }
-int rtos_create_thread(int *out, int prio, const char *name, LPTHREAD_START_ROUTINE function, int stackSize, void *arg) {
-	int handle;
-	handle = CreateThread(NULL, 0, function, arg, 0, NULL);
+int rtos_create_thread(void *out, int prio, const char *name, void *function, int stackSize, void *arg) {
+	CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)function, arg, 0, NULL);
 	return 0;
 }
-void rtos_delete_thread(int i) {
+void rtos_delete_thread(void *thread) {
 	
 }
 int lwip_fcntl(int s, int cmd, int val) {
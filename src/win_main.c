@@ -10,12 +10,21 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "new_common.h"
-#include "driver\drv_public.h"
-#include "cmnds\cmd_public.h"
-#include "httpserver\new_http.h"
+#include "driver/drv_public.h"
+#include "cmnds/cmd_public.h"
+#include "httpserver/new_http.h"
 #include "new_pins.h"
+#include "new_ping.h"
+#include "logging/logging.h"
+#include "littlefs/our_lfs.h"
+#include "httpserver/http_tcp_server.h"
+#include "selftest/selftest_local.h"
 #include <timeapi.h>
 
+// win32/stubs/lwip/win_mqtt_stub.c
+void WIN_ResetMQTT();
+void WIN_RunMQTTFrame();
+
 #define OFFSETOF(TYPE, ELEMENT) ((size_t)&(((TYPE *)0)->ELEMENT))
 
 // Need to link with Ws2_32.lib
@@ -112,6 +121,7 @@ void SIM_ClearOBK() {
 		release_lfs();
 		SIM_Hack_ClearSimulatedPinRoles();
 		WIN_ResetMQTT();
+		PingSim_Reset();
 		CMD_ExecuteCommand("clearAll", 0);
 		CMD_ExecuteCommand("led_expoMode", 0);
 		Main_Init();
@@ -129,15 +139,32 @@ void Win_DoUnitTests() {
 	Test_EnergyMeter();
 	Test_Tasmota();
 	Test_NTP();
+	Test_ClockEvents();
+	Test_SSDP();
+	Test_Ping();
 	Test_MQTT();
 	Test_HTTP_Client();
 	Test_ExpandConstant();
 	Test_ChangeHandlers();
 	Test_RepeatingEvents();
 	Test_ButtonEvents();
+	Test_ButtonEvents_EdgeInterrupts();
 	Test_Commands_Alias();
 	Test_Expressions_RunTests_Basic();
 	Test_LEDDriver();
+	Test_LEDBus();
+	Test_I2C();
+	Test_Drivers();
+	Test_Perf();
+	Test_CRC();
+	Test_CfgSections();
+	Test_MemPool();
+	Test_LEDFixed();
+	Test_LEDEffects();
+	Test_PixelBus();
+	Test_HTTP_Args();
+	Test_HTTP_Router();
+	Test_HTTP_Chunked();
 	Test_LFS();
 	Test_Scripting();
 	Test_Commands_Channels();
@@ -149,6 +176,8 @@ void Win_DoUnitTests() {
 
 	// this is slowest
 	Test_TuyaMCU_Basic();
+	Test_TuyaMCU_Parser();
+	Test_TuyaMCU_Mappings();
 
 
 
@@ -179,11 +208,32 @@ int rtos_get_time() {
 int g_bDoingUnitTestsNow = 0;
 
 #include "sim/sim_public.h"
+static void SIM_Pause() {
+#ifndef LINUX
+	system("pause");
+#endif
+}
 int __cdecl main(int argc, char **argv)
 {
 	bool bWantsUnitTests = 1;
+	bool bWantsBenchmarks = 0;
+	// POSIX host build has no window, it quits after tests unless -run is given
+	bool bWantsHeadlessRun = 0;
     WSADATA wsaData;
     int iResult;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-bench")) {
+			bWantsBenchmarks = 1;
+		}
+		else if (!strcmp(argv[i], "-notests")) {
+			bWantsUnitTests = 0;
+		}
+		else if (!strcmp(argv[i], "-run")) {
+			bWantsHeadlessRun = 1;
+		}
+	}
 
 	int maxTest = 100;
 	for (int i = 0; i <= maxTest; i++) {
@@ -207,23 +257,23 @@ int __cdecl main(int argc, char **argv)
 	//printf("Offset MQTT Group: %i", OFFSETOF(mainConfig_t, mqtt_group));
 	if (sizeof(mainConfig_t) != MAGIC_CONFIG_SIZE) {
 		printf("sizeof(mainConfig_t) != MAGIC_CONFIG_SIZE!: %i\n", sizeof(mainConfig_t));
-		system("pause");
+		SIM_Pause();
 	}
 	if (OFFSETOF(mainConfig_t, ping_host) != 0x000005A0) {
 		printf("OFFSETOF(mainConfig_t, ping_host) != 0x000005A0: %i\n", OFFSETOF(mainConfig_t, ping_host));
-		system("pause");
+		SIM_Pause();
 	}
 	if (OFFSETOF(mainConfig_t, buttonShortPress) != 0x000004B8) {
 		printf("OFFSETOF(mainConfig_t, buttonShortPress) != 0x000004B8: %i\n", OFFSETOF(mainConfig_t, buttonShortPress));
-		system("pause");
+		SIM_Pause();
 	}
 	if (OFFSETOF(mainConfig_t, pins) != 0x0000033E) {
 		printf("OFFSETOF(mainConfig_t, pins) != 0x0000033E: %i\n", OFFSETOF(mainConfig_t, pins));
-		system("pause");
+		SIM_Pause();
 	}
 	if (OFFSETOF(mainConfig_t, version) != 0x00000004) {
 		printf("OFFSETOF(mainConfig_t, version) != 0x00000004: %i\n", OFFSETOF(mainConfig_t, version));
-		system("pause");
+		SIM_Pause();
 	}
 	if (bWantsUnitTests) {
 		g_bDoingUnitTestsNow = 1;
@@ -235,7 +285,25 @@ int __cdecl main(int argc, char **argv)
 		Sim_RunFrames(50, false);
 		g_bDoingUnitTestsNow = 0;
 	}
-
+	if (bWantsBenchmarks) {
+		if (bObkStarted == false) {
+			SIM_DoFreshOBKBoot();
+		}
+		Win_DoBenchmarks();
+	}
+#ifdef LINUX
+	printf("Selftests finished, %i failed\n", SelfTest_GetFailedCount());
+	if (bWantsHeadlessRun == false) {
+		return SelfTest_GetFailedCount() ? 1 : 0;
+	}
+	if (bObkStarted == false) {
+		SIM_DoFreshOBKBoot();
+	}
+	while (1) {
+		Sleep(DEFAULT_FRAME_TIME);
+		Sim_RunFrame(DEFAULT_FRAME_TIME);
+	}
+#endif
 
 	SIM_CreateWindow(argc, argv);
 	CMD_ExecuteCommand("MQTTHost 192.168.0.113", 0);
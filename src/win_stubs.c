@@ -7,24 +7,16 @@ void CMD_StartTCPCommandLine() {
 
 }
 
-void Main_SetupPingWatchDog(const char *target/*, int delayBetweenPings_Seconds*/) {
-
-}
-int PingWatchDog_GetTotalLost() {
-	return 0;
-}
-int PingWatchDog_GetTotalReceived() {
-	return 0;
-}
-
 
 // placeholder - TODO
 char myIP[] = "127.0.0.1";
 char *getMyIp() {
 	return myIP;
 }
+#ifdef _MSC_VER
 void __asm__(const char *s) {
 
 }
+#endif
 
 #endif
\ No newline at end of file